@@ -7,6 +7,7 @@
  *  of patent rights can be found in the PATENTS file in the same directory.
  */
 
+#include <fatal/container/flat_hash_map.h>
 #include <fatal/container/variant.h>
 #include <fatal/test/string.h>
 #include <fatal/test/type.h>
@@ -175,7 +176,7 @@ struct ytse_jam {
 
 private:
   using built_ins = list<metadata::str::create, metadata::str::json, metadata::str::help>;
-  using instances_map = std::unordered_map<std::string, instance_t>;
+  using instances_map = flat_hash_map<std::string, instance_t>;
 
   template <typename T, typename ArgsList, std::size_t... Indexes>
   static void call_ctor(index_sequence<Indexes...>, instance_t &instance, request_args &args) {
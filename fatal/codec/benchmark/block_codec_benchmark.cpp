@@ -0,0 +1,129 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/codec/block_codec.h>
+#include <fatal/codec/varint.h>
+
+#include <fatal/benchmark/driver.h>
+
+#include <random>
+#include <vector>
+
+#include <cstdint>
+
+namespace fatal {
+
+using count = std::integral_constant<std::size_t, 1 << 20>;
+
+// sorted 64 bit ids with geometrically distributed gaps
+std::vector<std::uint64_t> make_ids() {
+  std::mt19937 rng(count::value);
+  std::geometric_distribution<std::uint64_t> gaps(0.05);
+  std::vector<std::uint64_t> result(count::value);
+  std::uint64_t id = UINT64_C(1) << 48;
+
+  for (auto &i: result) {
+    i = id += gaps(rng);
+  }
+
+  return result;
+}
+
+// millisecond timestamps taken roughly every second
+std::vector<std::uint64_t> make_timestamps() {
+  std::mt19937 rng(count::value);
+  std::vector<std::uint64_t> result(count::value);
+  std::uint64_t timestamp = UINT64_C(1500000000000);
+
+  for (auto &i: result) {
+    i = timestamp += 995 + rng() % 10;
+  }
+
+  return result;
+}
+
+struct varint_codec {
+  using codec = varint<std::uint64_t>;
+
+  static std::size_t max_encoded_size(std::size_t n) {
+    return n * codec::max_size<char>::value;
+  }
+
+  static char *encode_n(std::uint64_t const *values, std::size_t n, char *out) {
+    return codec::encode_n(values, n, out);
+  }
+
+  static void decode_n(
+    char const *begin,
+    char const *end,
+    std::uint64_t *out,
+    std::size_t n
+  ) {
+    codec::decode_n(begin, end, out, n);
+  }
+};
+
+template <typename Codec>
+std::vector<char> encode(std::vector<std::uint64_t> const &values) {
+  std::vector<char> result(Codec::max_encoded_size(values.size()));
+  auto const end = Codec::encode_n(values.data(), values.size(), result.data());
+  result.resize(static_cast<std::size_t>(end - result.data()));
+  return result;
+}
+
+std::vector<std::uint64_t> const ids_values(make_ids());
+std::vector<std::uint64_t> const timestamps_values(make_timestamps());
+
+// output buffers are shared so that allocating them isn't measured
+std::vector<char> encoded_buffer(varint_codec::max_encoded_size(count::value));
+std::vector<std::uint64_t> decoded_buffer(count::value);
+
+#define BENCHMARK_CODEC(Name, Codec, Data) \
+  std::vector<char> const Name##_##Data##_encoded( \
+    encode<Codec>(Data##_values) \
+  ); \
+  \
+  FATAL_BENCHMARK(Data##_encode, Name, n) { \
+    auto &out = encoded_buffer; \
+    std::size_t size = 0; \
+    while (n--) { \
+      auto const i = Codec::encode_n( \
+        Data##_values.data(), Data##_values.size(), out.data() \
+      ); \
+      size += static_cast<std::size_t>(i - out.data()); \
+    } \
+    prevent_optimization(size); \
+  } \
+  \
+  FATAL_BENCHMARK(Data##_decode, Name, n) { \
+    auto const &in = Name##_##Data##_encoded; \
+    auto &out = decoded_buffer; \
+    while (n--) { \
+      Codec::decode_n( \
+        in.data(), in.data() + in.size(), out.data(), out.size() \
+      ); \
+    } \
+    prevent_optimization(out.back()); \
+  }
+
+BENCHMARK_CODEC(varint, varint_codec, ids)
+BENCHMARK_CODEC(delta, delta_codec<std::uint64_t>, ids)
+BENCHMARK_CODEC(
+  frame_of_reference, frame_of_reference_codec<std::uint64_t>, ids
+)
+
+BENCHMARK_CODEC(varint, varint_codec, timestamps)
+BENCHMARK_CODEC(delta, delta_codec<std::uint64_t>, timestamps)
+BENCHMARK_CODEC(
+  delta_of_delta, delta_of_delta_codec<std::uint64_t>, timestamps
+)
+
+#undef BENCHMARK_CODEC
+
+} // namespace fatal {
@@ -0,0 +1,125 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/codec/group_varint.h>
+#include <fatal/codec/stream_vbyte.h>
+#include <fatal/codec/varint.h>
+
+#include <fatal/benchmark/driver.h>
+
+#include <random>
+#include <vector>
+
+#include <cstdint>
+
+namespace fatal {
+
+using count = std::integral_constant<std::size_t, 1 << 20>;
+
+// uniformly distributed 32 bit values
+std::vector<std::uint32_t> make_uniform() {
+  std::mt19937 rng(count::value);
+  std::vector<std::uint32_t> result(count::value);
+
+  for (auto &i: result) {
+    i = static_cast<std::uint32_t>(rng());
+  }
+
+  return result;
+}
+
+// mostly small values, like the gaps of a posting list
+std::vector<std::uint32_t> make_skewed() {
+  std::mt19937 rng(count::value);
+  std::geometric_distribution<std::uint32_t> gaps(0.01);
+  std::vector<std::uint32_t> result(count::value);
+
+  for (auto &i: result) {
+    i = gaps(rng);
+  }
+
+  return result;
+}
+
+struct varint_codec {
+  using codec = varint<std::uint32_t>;
+
+  static std::size_t max_encoded_size(std::size_t n) {
+    return n * codec::max_size<char>::value;
+  }
+
+  static char *encode_n(std::uint32_t const *values, std::size_t n, char *out) {
+    return codec::encode_n(values, n, out);
+  }
+
+  static void decode_n(
+    char const *begin,
+    char const *end,
+    std::uint32_t *out,
+    std::size_t n
+  ) {
+    codec::decode_n(begin, end, out, n);
+  }
+};
+
+template <typename Codec>
+std::vector<char> encode(std::vector<std::uint32_t> const &values) {
+  std::vector<char> result(Codec::max_encoded_size(values.size()));
+  auto const end = Codec::encode_n(values.data(), values.size(), result.data());
+  result.resize(static_cast<std::size_t>(end - result.data()));
+  return result;
+}
+
+std::vector<std::uint32_t> const uniform_values(make_uniform());
+std::vector<std::uint32_t> const skewed_values(make_skewed());
+
+// output buffers are shared so that allocating them isn't measured
+std::vector<char> encoded_buffer(varint_codec::max_encoded_size(count::value));
+std::vector<std::uint32_t> decoded_buffer(count::value);
+
+#define BENCHMARK_CODEC(Name, Codec, Distribution) \
+  std::vector<char> const Name##_##Distribution##_encoded( \
+    encode<Codec>(Distribution##_values) \
+  ); \
+  \
+  FATAL_BENCHMARK(Distribution##_encode, Name, n) { \
+    auto &out = encoded_buffer; \
+    std::size_t size = 0; \
+    while (n--) { \
+      auto const i = Codec::encode_n( \
+        Distribution##_values.data(), Distribution##_values.size(), \
+        out.data() \
+      ); \
+      size += static_cast<std::size_t>(i - out.data()); \
+    } \
+    prevent_optimization(size); \
+  } \
+  \
+  FATAL_BENCHMARK(Distribution##_decode, Name, n) { \
+    auto const &in = Name##_##Distribution##_encoded; \
+    auto &out = decoded_buffer; \
+    while (n--) { \
+      Codec::decode_n( \
+        in.data(), in.data() + in.size(), out.data(), out.size() \
+      ); \
+    } \
+    prevent_optimization(out.back()); \
+  }
+
+BENCHMARK_CODEC(varint, varint_codec, uniform)
+BENCHMARK_CODEC(group_varint, group_varint<std::uint32_t>, uniform)
+BENCHMARK_CODEC(stream_vbyte, stream_vbyte<std::uint32_t>, uniform)
+
+BENCHMARK_CODEC(varint, varint_codec, skewed)
+BENCHMARK_CODEC(group_varint, group_varint<std::uint32_t>, skewed)
+BENCHMARK_CODEC(stream_vbyte, stream_vbyte<std::uint32_t>, skewed)
+
+#undef BENCHMARK_CODEC
+
+} // namespace fatal {
@@ -0,0 +1,120 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/codec/varint.h>
+
+#include <fatal/benchmark/driver.h>
+
+#include <random>
+#include <vector>
+
+#include <cstdint>
+
+namespace fatal {
+
+using count = std::integral_constant<std::size_t, 1 << 20>;
+using codec = varint<std::uint32_t>;
+
+// values taking at most `bits` bits, with a uniformly distributed bit length
+std::vector<std::uint32_t> make_values(unsigned bits) {
+  std::mt19937 rng(bits);
+  std::vector<std::uint32_t> result(count::value);
+
+  for (auto &i: result) {
+    auto const size = rng() % bits + 1;
+    i = static_cast<std::uint32_t>(rng()) >> (32 - size);
+  }
+
+  return result;
+}
+
+std::vector<char> encode(std::vector<std::uint32_t> const &values) {
+  std::vector<char> result(values.size() * codec::max_size<char>::value);
+  auto const end = codec::encode_n(values.data(), values.size(), result.data());
+  result.resize(static_cast<std::size_t>(end - result.data()));
+  return result;
+}
+
+std::vector<std::uint32_t> const small_values(make_values(7));
+std::vector<std::uint32_t> const mixed_values(make_values(32));
+
+std::vector<char> const small_encoded(encode(small_values));
+std::vector<char> const mixed_encoded(encode(mixed_values));
+
+// output buffers are shared so that allocating them isn't measured
+std::vector<char> encoded_buffer(count::value * codec::max_size<char>::value);
+std::vector<std::uint32_t> decoded_buffer(count::value);
+
+#define BENCHMARK_VARINT(Name, Values, Encoded) \
+  FATAL_BENCHMARK(encode, Name##_encode, n) { \
+    auto &out = encoded_buffer; \
+    std::size_t size = 0; \
+    while (n--) { \
+      auto i = out.data(); \
+      for (auto value: Values) { \
+        i = codec::encode(value, i); \
+      } \
+      size += static_cast<std::size_t>(i - out.data()); \
+    } \
+    prevent_optimization(size); \
+  } \
+  \
+  FATAL_BENCHMARK(encode, Name##_encode_n, n) { \
+    auto &out = encoded_buffer; \
+    std::size_t size = 0; \
+    while (n--) { \
+      auto const i = codec::encode_n( \
+        Values.data(), Values.size(), out.data() \
+      ); \
+      size += static_cast<std::size_t>(i - out.data()); \
+    } \
+    prevent_optimization(size); \
+  } \
+  \
+  FATAL_BENCHMARK(decode, Name##_tracking_decode, n) { \
+    auto &out = decoded_buffer; \
+    while (n--) { \
+      auto i = Encoded.data(); \
+      auto const end = i + Encoded.size(); \
+      for (auto &value: out) { \
+        value = codec::tracking_decode(i, end).first; \
+      } \
+    } \
+    prevent_optimization(out.back()); \
+  } \
+  \
+  FATAL_BENCHMARK(decode, Name##_tracking_decode_iterator, n) { \
+    auto &out = decoded_buffer; \
+    while (n--) { \
+      auto i = Encoded.cbegin(); \
+      auto const end = Encoded.cend(); \
+      for (auto &value: out) { \
+        value = codec::tracking_decode(i, end).first; \
+      } \
+    } \
+    prevent_optimization(out.back()); \
+  } \
+  \
+  FATAL_BENCHMARK(decode, Name##_decode_n, n) { \
+    auto &out = decoded_buffer; \
+    while (n--) { \
+      codec::decode_n( \
+        Encoded.data(), Encoded.data() + Encoded.size(), \
+        out.data(), out.size() \
+      ); \
+    } \
+    prevent_optimization(out.back()); \
+  }
+
+BENCHMARK_VARINT(small, small_values, small_encoded)
+BENCHMARK_VARINT(mixed, mixed_values, mixed_encoded)
+
+#undef BENCHMARK_VARINT
+
+} // namespace fatal {
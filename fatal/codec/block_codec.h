@@ -0,0 +1,741 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef FATAL_INCLUDE_fatal_codec_block_codec_h
+#define FATAL_INCLUDE_fatal_codec_block_codec_h
+
+#include <fatal/codec/varint.h>
+#include <fatal/math/numerics.h>
+
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+namespace fatal {
+
+/**
+ * The transformation applied to a block of integers before its residuals
+ * are stored by `block_codec`.
+ *
+ *  - delta: the difference between consecutive values, for sorted (or
+ *    mostly sorted) sequences like ids or offsets
+ *  - delta_of_delta: the difference between consecutive deltas, for
+ *    sequences with a roughly constant stride like timestamps
+ *  - frame_of_reference: the difference to the smallest value in the block,
+ *    for unsorted values within a narrow range
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+enum class block_transform {
+  delta,
+  delta_of_delta,
+  frame_of_reference
+};
+
+namespace detail {
+namespace block_codec_impl {
+
+using block_size = std::integral_constant<std::size_t, 128>;
+
+// the low bits of the block header hold the bit width of the residuals and
+// the high bit tells whether they're stored as varints instead of bit-packed
+using width_mask = std::integral_constant<unsigned, 0x7f>;
+using varint_flag = std::integral_constant<unsigned, 0x80>;
+
+template <typename U>
+U zigzag(U value) noexcept {
+  static_assert(std::is_unsigned<U>::value, "unsigned integral expected");
+  return static_cast<U>(
+    static_cast<U>(value << 1)
+      ^ static_cast<U>(0 - (value >> (data_bits<U>::value - 1)))
+  );
+}
+
+template <typename U>
+U unzigzag(U value) noexcept {
+  static_assert(std::is_unsigned<U>::value, "unsigned integral expected");
+  return static_cast<U>((value >> 1) ^ static_cast<U>(0 - (value & 1)));
+}
+
+// the amount of bits needed to represent `value`
+inline unsigned bit_width(std::uint64_t value) noexcept {
+  return value ? 64 - count_leading_zeros(value) : 0;
+}
+
+inline std::uint64_t mask(unsigned width) noexcept {
+  assert(width <= 64);
+  return width == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << width) - 1;
+}
+
+inline std::uint64_t load(unsigned char const *in) noexcept {
+  std::uint64_t value;
+  std::memcpy(std::addressof(value), in, sizeof(value));
+# if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  value = __builtin_bswap64(value);
+# endif
+  return value;
+}
+
+// writes the `n` values in `in` using `width` bits each, least significant
+// bits first, returning the pointer past the last byte written
+template <typename U>
+unsigned char *pack(
+  U const *in,
+  std::size_t n,
+  unsigned width,
+  unsigned char *out
+) noexcept {
+  assert(width <= 64);
+
+  if (!width) {
+    return out;
+  }
+
+  std::uint64_t buffer = 0;
+  unsigned filled = 0;
+
+  for (std::size_t i = 0; i < n; ++i) {
+    auto const value = static_cast<std::uint64_t>(in[i]);
+    assert(!(value & ~mask(width)));
+
+    buffer |= value << filled;
+    filled += width;
+
+    if (filled >= 64) {
+      for (unsigned j = 0; j < 8; ++j, buffer >>= 8) {
+        *out++ = static_cast<unsigned char>(buffer);
+      }
+
+      filled -= 64;
+      buffer = filled ? value >> (width - filled) : 0;
+    }
+
+    for (; filled >= 8; filled -= 8, buffer >>= 8) {
+      *out++ = static_cast<unsigned char>(buffer);
+    }
+  }
+
+  if (filled) {
+    *out++ = static_cast<unsigned char>(buffer);
+  }
+
+  return out;
+}
+
+// reads `n` values of `width` bits each written by `pack` from `in`, which
+// has `size` bytes readable, possibly past the end of the packed values
+template <typename U>
+void unpack(
+  unsigned char const *in,
+  std::size_t size,
+  unsigned width,
+  U *out,
+  std::size_t n
+) noexcept {
+  assert(width <= 64);
+
+  if (!width) {
+    std::fill(out, out + n, U(0));
+    return;
+  }
+
+  auto const m = mask(width);
+  std::size_t i = 0;
+  std::size_t bit = 0;
+
+  // a single word load per value while there are 9 bytes readable
+  for (; i < n && bit / 8 + 9 <= size; ++i, bit += width) {
+    auto const byte = bit / 8;
+    auto const shift = static_cast<unsigned>(bit % 8);
+    auto value = load(in + byte) >> shift;
+
+    if (shift + width > 64) {
+      value |= static_cast<std::uint64_t>(in[byte + 8]) << (64 - shift);
+    }
+
+    out[i] = static_cast<U>(value & m);
+  }
+
+  for (; i < n; ++i, bit += width) {
+    auto byte = bit / 8;
+    auto shift = static_cast<unsigned>(bit % 8);
+    std::uint64_t value = 0;
+
+    for (unsigned read = 0; read < width; shift = 0) {
+      value |= (static_cast<std::uint64_t>(in[byte++]) >> shift) << read;
+      read += 8 - shift;
+    }
+
+    out[i] = static_cast<U>(value & m);
+  }
+}
+
+inline std::size_t packed_size(std::size_t n, unsigned width) noexcept {
+  return (n * width + 7) / 8;
+}
+
+} // namespace block_codec_impl {
+} // namespace detail {
+
+/**
+ * Compresses integral sequences in blocks of up to 128 values by applying a
+ * `block_transform` and storing the residuals either bit-packed with the
+ * smallest width that fits them all, or as varints when that's smaller,
+ * e.g.: when a few outliers would widen the whole block.
+ *
+ * Each block is self-contained and starts with a header byte (the residual
+ * width and storage), followed by the amount of values minus one as a raw
+ * byte, the reference values as varints (the first value and, for
+ * delta-of-delta, the first delta, or the smallest value for
+ * frame-of-reference), the size in bytes of the varint residuals when they
+ * aren't bit-packed and finally the residuals themselves.
+ *
+ * Blocks can be decoded independently, so random access is achieved by
+ * keeping the offset of each block, which `encode_n` can report. Decoding
+ * can also be done one block at a time with `decode_block`, or resumed from
+ * the position returned by `decode_n`.
+ *
+ * Example:
+ *
+ *  std::vector<std::uint64_t> ids(1000);
+ *  std::iota(ids.begin(), ids.end(), 1000000);
+ *
+ *  using codec = block_codec<std::uint64_t, block_transform::delta>;
+ *
+ *  std::vector<char> buffer(codec::max_encoded_size(ids.size()));
+ *  std::vector<std::size_t> offsets(codec::blocks(ids.size()));
+ *  auto const end = codec::encode_n(
+ *    ids.data(), ids.size(), buffer.data(), offsets.begin()
+ *  );
+ *
+ *  // decodes the values in the range [256, 384)
+ *  std::uint64_t block[codec::block_size::value];
+ *  codec::decode_block(buffer.data() + offsets[2], end, block);
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+template <typename T, block_transform Transform>
+struct block_codec {
+  using type = T;
+
+  static_assert(std::is_integral<type>::value, "expected an integral");
+  static_assert(!std::is_same<type, bool>::value, "bool is not supported");
+
+  // maximum amount of values in a block
+  using block_size = detail::block_codec_impl::block_size;
+
+private:
+  using unsigned_type = typename std::make_unsigned<type>::type;
+  using value_codec = varint<type>;
+  using residual_codec = varint<unsigned_type>;
+
+  // amount of reference values stored in a block's header
+  using references = std::integral_constant<
+    std::size_t, Transform == block_transform::delta_of_delta ? 2 : 1
+  >;
+
+  // bound on the size of everything but the residuals of a block
+  using header_size = std::integral_constant<
+    std::size_t,
+    2 + references::value * value_codec::template max_size<char>::value
+      + varint<std::uint32_t>::template max_size<char>::value
+  >;
+
+public:
+  // amount of blocks needed to encode `n` values
+  static constexpr std::size_t blocks(std::size_t n) noexcept {
+    return (n + block_size::value - 1) / block_size::value;
+  }
+
+  // largest amount of bytes written when encoding `n` values
+  static constexpr std::size_t max_encoded_size(std::size_t n) noexcept {
+    return blocks(n) * header_size::value + n * sizeof(unsigned_type);
+  }
+
+  // encodes the `n` values in `values` as a single block, where `n` must be
+  // between one and `block_size`, returning the pointer past the last element
+  // written
+  // buffer must be able to fit at least `max_encoded_size(n)` elements
+  template <typename TData>
+  static TData *encode_block(
+    type const *values,
+    std::size_t n,
+    TData *out
+  ) noexcept {
+    static_assert(sizeof(TData) == 1, "byte-sized data unit expected");
+    assert(n > 0);
+    assert(n <= block_size::value);
+
+    namespace impl = detail::block_codec_impl;
+
+    unsigned_type residuals[block_size::value];
+    auto const count = transform(values, n, residuals);
+
+    std::uint64_t any = 0;
+
+    for (std::size_t i = 0; i < count; ++i) {
+      any |= residuals[i];
+    }
+
+    auto const width = impl::bit_width(any);
+
+    // varints take at least a byte per residual, so they can only be smaller
+    // when the bit-packing is wider than that
+    std::size_t varint_size = 0;
+
+    if (width > 8) {
+      for (std::size_t i = 0; i < count; ++i) {
+        varint_size += std::max<std::size_t>(
+          1, (impl::bit_width(residuals[i]) + 6) / 7
+        );
+      }
+    }
+
+    auto const use_varint = width > 8
+      && varint_size < impl::packed_size(count, width);
+
+    auto p = reinterpret_cast<unsigned char *>(out);
+    *p++ = static_cast<unsigned char>(
+      use_varint ? impl::varint_flag::value : width
+    );
+    *p++ = static_cast<unsigned char>(n - 1);
+
+    switch (Transform) {
+      case block_transform::delta:
+        p = value_codec::encode(values[0], p);
+        break;
+
+      case block_transform::delta_of_delta:
+        p = value_codec::encode(values[0], p);
+        p = residual_codec::encode(
+          n > 1
+            ? impl::zigzag(
+              static_cast<unsigned_type>(
+                static_cast<unsigned_type>(values[1])
+                  - static_cast<unsigned_type>(values[0])
+              )
+            )
+            : unsigned_type(0),
+          p
+        );
+        break;
+
+      case block_transform::frame_of_reference:
+        p = value_codec::encode(*std::min_element(values, values + n), p);
+        break;
+    }
+
+    if (use_varint) {
+      p = varint<std::uint32_t>::encode(
+        static_cast<std::uint32_t>(varint_size), p
+      );
+
+      // `encode_n` assumes room for `max_size` bytes per value, which the
+      // bound given by `max_encoded_size` doesn't account for
+      for (std::size_t i = 0; i < count; ++i) {
+        p = residual_codec::encode(residuals[i], p);
+      }
+    } else {
+      p = impl::pack(residuals, count, width, p);
+    }
+
+    return out + (p - reinterpret_cast<unsigned char *>(out));
+  }
+
+  // encodes the `n` values in `values` as consecutive blocks, all of them
+  // full but the last one, returning the pointer past the last element
+  // written
+  // buffer must be able to fit at least `max_encoded_size(n)` elements
+  template <typename TData>
+  static TData *encode_n(
+    type const *values,
+    std::size_t n,
+    TData *out
+  ) noexcept {
+    for (; n; ) {
+      auto const size = std::min(n, block_size::value);
+      out = encode_block(values, size, out);
+      values += size;
+      n -= size;
+    }
+
+    return out;
+  }
+
+  // same as above but also writes the offset of each block, relative to
+  // `out`, to `offsets`, which must be able to fit `blocks(n)` elements
+  template <typename TData, typename TOffsetIterator>
+  static TData *encode_n(
+    type const *values,
+    std::size_t n,
+    TData *out,
+    TOffsetIterator offsets
+  ) noexcept {
+    auto const begin = out;
+
+    for (; n; ++offsets) {
+      auto const size = std::min(n, block_size::value);
+      *offsets = static_cast<std::size_t>(out - begin);
+      out = encode_block(values, size, out);
+      values += size;
+      n -= size;
+    }
+
+    return out;
+  }
+
+  // decodes the block at `begin` into `out`, which must be able to fit
+  // `block_size` values
+  //
+  // returns the pointer past the block, along with the amount of values
+  // decoded, or `begin` and 0 when `[begin, end)` has an incomplete block
+  template <typename TData>
+  static std::pair<TData const *, std::size_t> decode_block(
+    TData const *begin,
+    TData const *end,
+    type *out
+  ) noexcept {
+    static_assert(sizeof(TData) == 1, "byte-sized data unit expected");
+    assert(begin <= end);
+
+    namespace impl = detail::block_codec_impl;
+
+    block_header header;
+    auto p = parse(
+      reinterpret_cast<unsigned char const *>(begin),
+      reinterpret_cast<unsigned char const *>(end),
+      header
+    );
+
+    if (!p) {
+      return std::make_pair(begin, std::size_t(0));
+    }
+
+    auto const last = reinterpret_cast<unsigned char const *>(end);
+    unsigned_type residuals[block_size::value];
+
+    if (header.varint) {
+      auto const result = residual_codec::decode_n(
+        p, p + header.payload, residuals, header.residuals
+      );
+
+      if (result.second != header.residuals) {
+        return std::make_pair(begin, std::size_t(0));
+      }
+    } else {
+      impl::unpack(
+        p, static_cast<std::size_t>(last - p), header.width,
+        residuals, header.residuals
+      );
+    }
+
+    reconstruct(header, residuals, out);
+
+    return std::make_pair(
+      begin + (p + header.payload - reinterpret_cast<unsigned char const *>(
+        begin
+      )),
+      header.size
+    );
+  }
+
+  // returns the pointer past the block at `begin`, along with the amount of
+  // values in it, without decoding it, or `begin` and 0 when `[begin, end)`
+  // has an incomplete block
+  template <typename TData>
+  static std::pair<TData const *, std::size_t> skip_block(
+    TData const *begin,
+    TData const *end
+  ) noexcept {
+    static_assert(sizeof(TData) == 1, "byte-sized data unit expected");
+    assert(begin <= end);
+
+    block_header header;
+    auto const p = parse(
+      reinterpret_cast<unsigned char const *>(begin),
+      reinterpret_cast<unsigned char const *>(end),
+      header
+    );
+
+    if (!p) {
+      return std::make_pair(begin, std::size_t(0));
+    }
+
+    return std::make_pair(
+      begin + (p + header.payload - reinterpret_cast<unsigned char const *>(
+        begin
+      )),
+      header.size
+    );
+  }
+
+  // decodes the consecutive blocks in `[begin, end)` into `out`, stopping
+  // before a block that doesn't fit in the `n` values left in `out` or that
+  // is incomplete
+  //
+  // returns the pointer past the last block decoded, along with the amount of
+  // values decoded, so that decoding can be resumed from there
+  template <typename TData>
+  static std::pair<TData const *, std::size_t> decode_n(
+    TData const *begin,
+    TData const *end,
+    type *out,
+    std::size_t n
+  ) noexcept {
+    std::size_t decoded = 0;
+
+    while (begin != end) {
+      if (n - decoded < block_size::value) {
+        // the block may still fit if it's a partial one
+        auto const size = skip_block(begin, end).second;
+
+        if (!size || size > n - decoded) {
+          break;
+        }
+
+        type buffer[block_size::value];
+        auto const result = decode_block(begin, end, buffer);
+        assert(result.second == size);
+        std::copy(buffer, buffer + size, out + decoded);
+        begin = result.first;
+        decoded += size;
+        continue;
+      }
+
+      auto const result = decode_block(begin, end, out + decoded);
+
+      if (!result.second) {
+        break;
+      }
+
+      begin = result.first;
+      decoded += result.second;
+    }
+
+    return std::make_pair(begin, decoded);
+  }
+
+private:
+  struct block_header {
+    std::size_t size;
+    std::size_t residuals;
+    std::size_t payload;
+    unsigned width;
+    bool varint;
+    type reference;
+    unsigned_type delta;
+  };
+
+  // computes the residuals of the `n` values in `values`, returning how many
+  // of them there are
+  static std::size_t transform(
+    type const *values,
+    std::size_t n,
+    unsigned_type *out
+  ) noexcept {
+    namespace impl = detail::block_codec_impl;
+
+    switch (Transform) {
+      case block_transform::delta: {
+        for (std::size_t i = 1; i < n; ++i) {
+          out[i - 1] = impl::zigzag(
+            static_cast<unsigned_type>(
+              static_cast<unsigned_type>(values[i])
+                - static_cast<unsigned_type>(values[i - 1])
+            )
+          );
+        }
+
+        return n - 1;
+      }
+
+      case block_transform::delta_of_delta: {
+        for (std::size_t i = 2; i < n; ++i) {
+          auto const previous = static_cast<unsigned_type>(
+            static_cast<unsigned_type>(values[i - 1])
+              - static_cast<unsigned_type>(values[i - 2])
+          );
+          auto const current = static_cast<unsigned_type>(
+            static_cast<unsigned_type>(values[i])
+              - static_cast<unsigned_type>(values[i - 1])
+          );
+          out[i - 2] = impl::zigzag(
+            static_cast<unsigned_type>(current - previous)
+          );
+        }
+
+        return n > 2 ? n - 2 : 0;
+      }
+
+      case block_transform::frame_of_reference: {
+        auto const min = static_cast<unsigned_type>(
+          *std::min_element(values, values + n)
+        );
+
+        for (std::size_t i = 0; i < n; ++i) {
+          out[i] = static_cast<unsigned_type>(
+            static_cast<unsigned_type>(values[i]) - min
+          );
+        }
+
+        return n;
+      }
+    }
+
+    return 0;
+  }
+
+  // the inverse of `transform`
+  static void reconstruct(
+    block_header const &header,
+    unsigned_type const *residuals,
+    type *out
+  ) noexcept {
+    namespace impl = detail::block_codec_impl;
+
+    auto current = static_cast<unsigned_type>(header.reference);
+
+    switch (Transform) {
+      case block_transform::delta: {
+        out[0] = header.reference;
+
+        for (std::size_t i = 1; i < header.size; ++i) {
+          current = static_cast<unsigned_type>(
+            current + impl::unzigzag(residuals[i - 1])
+          );
+          out[i] = static_cast<type>(current);
+        }
+
+        break;
+      }
+
+      case block_transform::delta_of_delta: {
+        out[0] = header.reference;
+        auto delta = impl::unzigzag(header.delta);
+
+        for (std::size_t i = 1; i < header.size; ++i) {
+          if (i > 1) {
+            delta = static_cast<unsigned_type>(
+              delta + impl::unzigzag(residuals[i - 2])
+            );
+          }
+
+          current = static_cast<unsigned_type>(current + delta);
+          out[i] = static_cast<type>(current);
+        }
+
+        break;
+      }
+
+      case block_transform::frame_of_reference: {
+        for (std::size_t i = 0; i < header.size; ++i) {
+          out[i] = static_cast<type>(
+            static_cast<unsigned_type>(current + residuals[i])
+          );
+        }
+
+        break;
+      }
+    }
+  }
+
+  // parses the header of the block at `begin`, returning the pointer to its
+  // residuals, or `nullptr` if `[begin, end)` has an incomplete block
+  static unsigned char const *parse(
+    unsigned char const *begin,
+    unsigned char const *end,
+    block_header &header
+  ) noexcept {
+    namespace impl = detail::block_codec_impl;
+
+    if (end - begin < 2) {
+      return nullptr;
+    }
+
+    header.width = begin[0] & impl::width_mask::value;
+    header.varint = begin[0] & impl::varint_flag::value;
+    header.size = static_cast<std::size_t>(begin[1]) + 1;
+
+    if (
+      header.size > block_size::value
+        || header.width > data_bits<unsigned_type>::value
+    ) {
+      return nullptr;
+    }
+
+    begin += 2;
+
+    auto const reference = value_codec::tracking_decode(begin, end);
+
+    if (!reference.second) {
+      return nullptr;
+    }
+
+    header.reference = reference.first;
+
+    switch (Transform) {
+      case block_transform::delta:
+        header.residuals = header.size - 1;
+        break;
+
+      case block_transform::delta_of_delta: {
+        auto const delta = residual_codec::tracking_decode(begin, end);
+
+        if (!delta.second) {
+          return nullptr;
+        }
+
+        header.delta = delta.first;
+        header.residuals = header.size > 2 ? header.size - 2 : 0;
+        break;
+      }
+
+      case block_transform::frame_of_reference:
+        header.residuals = header.size;
+        break;
+    }
+
+    if (header.varint) {
+      auto const payload = varint<std::uint32_t>::tracking_decode(begin, end);
+
+      if (!payload.second) {
+        return nullptr;
+      }
+
+      header.payload = payload.first;
+    } else {
+      header.payload = impl::packed_size(header.residuals, header.width);
+    }
+
+    if (static_cast<std::size_t>(end - begin) < header.payload) {
+      return nullptr;
+    }
+
+    return begin;
+  }
+};
+
+template <typename T>
+using delta_codec = block_codec<T, block_transform::delta>;
+
+template <typename T>
+using delta_of_delta_codec = block_codec<T, block_transform::delta_of_delta>;
+
+template <typename T>
+using frame_of_reference_codec = block_codec<
+  T, block_transform::frame_of_reference
+>;
+
+} // namespace fatal {
+
+#endif // FATAL_INCLUDE_fatal_codec_block_codec_h
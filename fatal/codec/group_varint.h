@@ -0,0 +1,560 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef FATAL_INCLUDE_fatal_codec_group_varint_h
+#define FATAL_INCLUDE_fatal_codec_group_varint_h
+
+#include <fatal/codec/varint.h>
+#include <fatal/math/numerics.h>
+#include <fatal/portability.h>
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#if FATAL_HAS_SIMD_SSSE3
+# include <tmmintrin.h>
+#endif // FATAL_HAS_SIMD_SSSE3
+
+namespace fatal {
+namespace detail {
+namespace group_varint_impl {
+
+// values are grouped in fours, each group described by one tag byte holding
+// the 2 bit length codes (byte count minus one) of its values, the first
+// value in the least significant bits
+using group_size = std::integral_constant<std::size_t, 4>;
+using code_bits = std::integral_constant<std::size_t, 2>;
+using code_mask = std::integral_constant<
+  unsigned, (1u << code_bits::value) - 1
+>;
+
+// the largest encoding of a single value
+using word_size = std::integral_constant<std::size_t, 4>;
+
+template <typename T>
+struct value_traits {
+  static_assert(std::is_integral<T>::value, "expected an integral");
+  static_assert(!std::is_same<T, bool>::value, "bool is not supported");
+  static_assert(sizeof(T) <= word_size::value, "type too large");
+
+  using type = varint_impl::value_traits<std::is_signed<T>::value, T>;
+  using internal = typename type::internal;
+};
+
+template <typename TData>
+using is_byte = std::integral_constant<
+  bool, std::is_integral<TData>::value && sizeof(TData) == 1
+>;
+
+// amount of bytes taken by the given length code
+inline std::size_t length(unsigned code) noexcept {
+  assert(code <= code_mask::value);
+  return code + 1;
+}
+
+// amount of bytes taken by the first `size` values described by `tag`
+inline std::size_t length(unsigned tag, std::size_t size) noexcept {
+  assert(size <= group_size::value);
+  std::size_t result = 0;
+
+  for (std::size_t i = 0; i < size; ++i, tag >>= code_bits::value) {
+    result += length(tag & code_mask::value);
+  }
+
+  return result;
+}
+
+// the length code needed to represent `value`
+inline unsigned code(std::uint32_t value) noexcept {
+  return value
+    ? static_cast<unsigned>(
+      (data_bits<std::uint32_t>::value - 1 - count_leading_zeros(value)) / 8
+    )
+    : 0;
+}
+
+// writes all 4 bytes of `value` in little endian order, of which only the
+// first `length(code(value))` are meaningful
+inline void store(unsigned char *out, std::uint32_t value) noexcept {
+# if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  value = __builtin_bswap32(value);
+# endif
+  std::memcpy(out, std::addressof(value), sizeof(value));
+}
+
+// reads `size` bytes in little endian order, reading all 4 bytes at once
+// when `wide` is set
+inline std::uint32_t load(
+  unsigned char const *in,
+  std::size_t size,
+  bool wide
+) noexcept {
+  assert(size && size <= word_size::value);
+
+  if (wide) {
+    std::uint32_t value;
+    std::memcpy(std::addressof(value), in, sizeof(value));
+#   if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap32(value);
+#   endif
+    return value & (~std::uint32_t(0) >> ((word_size::value - size) * 8));
+  }
+
+  std::uint32_t value = 0;
+
+  for (std::size_t i = size; i--; ) {
+    value = (value << 8) | in[i];
+  }
+
+  return value;
+}
+
+// writes the bytes of `value` in little endian order, returning its length
+// code
+//
+// when `wide` is set all 4 bytes of `value` are stored at once, so up to 3
+// bytes past its encoding may be overwritten
+inline unsigned encode_value(
+  unsigned char *out,
+  std::uint32_t value,
+  bool wide
+) noexcept {
+  auto const c = code(value);
+
+  if (wide) {
+    store(out, value);
+  } else {
+    for (std::size_t i = 0; i < length(c); ++i) {
+      out[i] = static_cast<unsigned char>(value >> (i * 8));
+    }
+  }
+
+  return c;
+}
+
+// encodes the values in [begin, end), at most 4 of them, as one group,
+// returning the amount of bytes written
+template <typename T, typename TInputIterator>
+std::size_t encode_group(
+  TInputIterator begin,
+  TInputIterator end,
+  unsigned char *out,
+  bool wide
+) noexcept {
+  using traits = typename value_traits<T>::type;
+
+  unsigned tag = 0;
+  std::size_t offset = 1;
+
+  for (std::size_t i = 0; begin != end; ++begin, ++i) {
+    assert(i < group_size::value);
+    auto const c = encode_value(
+      out + offset, static_cast<std::uint32_t>(traits::pre(*begin)), wide
+    );
+    tag |= c << (i * code_bits::value);
+    offset += length(c);
+  }
+
+  out[0] = static_cast<unsigned char>(tag);
+  return offset;
+}
+
+#if FATAL_HAS_SIMD_SSSE3
+
+// for each tag, the shuffle mask that moves each value of a group with all
+// 4 values present into its own 32 bit lane, zero extending it
+struct shuffle_table {
+  shuffle_table() noexcept {
+    for (unsigned tag = 0; tag < 256; ++tag) {
+      auto &mask = masks[tag];
+      std::size_t source = 0;
+
+      for (std::size_t i = 0; i < group_size::value; ++i) {
+        auto const size = length(
+          (tag >> (i * code_bits::value)) & code_mask::value
+        );
+
+        for (std::size_t j = 0; j < word_size::value; ++j) {
+          mask[i * word_size::value + j] = j < size
+            ? static_cast<std::int8_t>(source + j)
+            : static_cast<std::int8_t>(-1);
+        }
+
+        source += size;
+      }
+    }
+  }
+
+  static shuffle_table const &get() noexcept {
+    static shuffle_table const instance;
+    return instance;
+  }
+
+  alignas(16) std::int8_t masks[256][16];
+};
+
+// decodes a full group of 4 values from `in`, which must have 16 bytes
+// readable, into `out`, returning the amount of bytes consumed
+inline std::size_t decode_group_simd(
+  unsigned tag,
+  unsigned char const *in,
+  std::uint32_t *out
+) noexcept {
+  auto const data = _mm_loadu_si128(reinterpret_cast<__m128i const *>(in));
+  auto const mask = _mm_load_si128(
+    reinterpret_cast<__m128i const *>(shuffle_table::get().masks[tag])
+  );
+  _mm_storeu_si128(
+    reinterpret_cast<__m128i *>(out), _mm_shuffle_epi8(data, mask)
+  );
+  return length(tag, group_size::value);
+}
+
+#endif // FATAL_HAS_SIMD_SSSE3
+
+// decodes the first `size` values of a group whose data starts at `in`,
+// returning the amount of bytes consumed
+//
+// when `wide` is set, 16 bytes must be readable from `in`
+template <typename T>
+std::size_t decode_group(
+  unsigned tag,
+  unsigned char const *in,
+  T *out,
+  std::size_t size,
+  bool wide
+) noexcept {
+  using traits = typename value_traits<T>::type;
+  using internal = typename value_traits<T>::internal;
+
+  assert(size <= group_size::value);
+
+# if FATAL_HAS_SIMD_SSSE3
+  if (wide && size == group_size::value) {
+    std::uint32_t values[group_size::value];
+    auto const consumed = decode_group_simd(tag, in, values);
+
+    for (std::size_t i = 0; i < group_size::value; ++i) {
+      out[i] = traits::post(static_cast<internal>(values[i]));
+    }
+
+    return consumed;
+  }
+# endif // FATAL_HAS_SIMD_SSSE3
+
+  std::size_t offset = 0;
+
+  for (std::size_t i = 0; i < size; ++i, tag >>= code_bits::value) {
+    auto const n = length(tag & code_mask::value);
+    out[i] = traits::post(static_cast<internal>(load(in + offset, n, wide)));
+    offset += n;
+  }
+
+  return offset;
+}
+
+} // namespace group_varint_impl {
+} // namespace detail {
+
+/**
+ * Group varint codec for integers up to 32 bits.
+ *
+ * Values are encoded in groups of four, each group starting with a tag byte
+ * made of 2 bit codes telling how many bytes (one to four) each value takes,
+ * the first value in the least significant bits. The value bytes follow the
+ * tag, in little endian order. The last group may have less than four values,
+ * in which case the amount of values must be known by the decoder.
+ *
+ * Signed integers are zigzag encoded, just like in `varint`.
+ *
+ * This format trades a bit of space, when compared to `varint`, for decoding
+ * speed, since the size of the whole group is known upfront and there's no
+ * continuation bit to check on every byte.
+ *
+ * Example:
+ *
+ *  std::uint32_t const values[] = {1, 1000, 100000, 10000000};
+ *
+ *  group_varint<std::uint32_t>::automatic_buffer<> buffer;
+ *  auto const end = group_varint<std::uint32_t>::encode(
+ *    std::begin(values), std::end(values), buffer.begin()
+ *  );
+ *
+ *  group_varint<std::uint32_t>::decoder decoder;
+ *  decoder(buffer.begin(), end);
+ *  assert(decoder.done());
+ *  assert(decoder.value(2) == 100000);
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+template <typename T>
+struct group_varint {
+  using type = T;
+
+private:
+  using value_traits = detail::group_varint_impl::value_traits<type>;
+  using internal = typename value_traits::internal;
+
+public:
+  // amount of values in a full group
+  using group_size = detail::group_varint_impl::group_size;
+
+  // largest amount of bytes written when encoding a group
+  using max_size = std::integral_constant<
+    std::size_t, 1 + group_size::value * sizeof(internal)
+  >;
+
+  // an automatically allocated buffer of `TData` able
+  // to hold any encoding of a group of values of type `type`
+  template <typename TData = char>
+  using automatic_buffer = std::array<TData, max_size::value>;
+
+  // largest amount of bytes written when encoding `n` values
+  static constexpr std::size_t max_encoded_size(std::size_t n) noexcept {
+    return (n + group_size::value - 1) / group_size::value
+      + n * sizeof(internal);
+  }
+
+  struct encoder {
+    // encodes the values in `[begin, end)`, of which there must be between
+    // one and four, as a single group
+    template <typename TInputIterator>
+    encoder(TInputIterator begin, TInputIterator end) noexcept:
+      size_(encode_group(begin, end))
+    {}
+
+    // writes as much of the encoded group as fits in [begin, end), returning
+    // the iterator past the last element written
+    template <typename TOutputIterator>
+    TOutputIterator operator ()(
+      TOutputIterator begin,
+      TOutputIterator const end
+    ) noexcept {
+      for (; offset_ < size_ && begin != end; ++offset_, ++begin) {
+        *begin = static_cast<
+          typename std::iterator_traits<TOutputIterator>::value_type
+        >(buffer_[offset_]);
+      }
+
+      return begin;
+    }
+
+    // returns true if the encoding is done, false if it needs more room
+    bool done() const noexcept { return offset_ == size_; }
+
+    // returns false if the encoding is done, true if it needs more room
+    bool operator !() const noexcept { return !done(); }
+
+    // returns true if the encoding is done, false if it needs more room
+    explicit operator bool() const noexcept { return done(); }
+
+  private:
+    template <typename TInputIterator>
+    std::size_t encode_group(
+      TInputIterator begin,
+      TInputIterator end
+    ) noexcept {
+      assert(begin != end);
+      return detail::group_varint_impl::encode_group<type>(
+        begin, end, buffer_.data(), false
+      );
+    }
+
+    std::array<unsigned char, max_size::value> buffer_;
+    std::size_t size_;
+    std::size_t offset_ = 0;
+  };
+
+  // encodes the values in `[begin, end)`, of which there must be between one
+  // and four, as a single group, returning the iterator past the last element
+  // written, which must be able to fit `max_size` elements
+  template <typename TInputIterator, typename TOutputIterator>
+  static TOutputIterator encode(
+    TInputIterator begin,
+    TInputIterator end,
+    TOutputIterator out
+  ) noexcept {
+    encoder e(begin, end);
+    out = e(out, std::next(out, max_size::value));
+    assert(e.done());
+    return out;
+  }
+
+  struct decoder {
+    // decodes a group of `size` values, between one and four
+    explicit decoder(std::size_t size = group_size::value) noexcept:
+      size_(size)
+    {
+      assert(size_ > 0);
+      assert(size_ <= group_size::value);
+    }
+
+    // returns the iterator `i` to the first unused element such
+    // that [begin, i) represents the data that have been decoded
+    template <typename TInputIterator>
+    TInputIterator operator ()(
+      TInputIterator begin,
+      TInputIterator const end
+    ) noexcept {
+      for (; !done() && begin != end; ++begin) {
+        buffer_[offset_++] = static_cast<unsigned char>(*begin);
+
+        if (offset_ == 1) {
+          needed_ = 1 + detail::group_varint_impl::length(buffer_[0], size_);
+        }
+      }
+
+      if (done()) {
+        detail::group_varint_impl::decode_group(
+          buffer_[0], buffer_.data() + 1, values_.data(), size_, false
+        );
+      }
+
+      return begin;
+    }
+
+    // resets the internal structure of this decoder as if
+    // no data had been fed to it
+    void reset() noexcept {
+      offset_ = 0;
+      needed_ = 1;
+    }
+
+    // the amount of values in the group
+    std::size_t size() const noexcept { return size_; }
+
+    // the `i-th` value of the group, only valid after decoding is done
+    type value(std::size_t i) const noexcept {
+      assert(done());
+      assert(i < size_);
+      return values_[i];
+    }
+
+    // returns true if the decoding is done, false if it needs more data
+    bool done() const noexcept { return offset_ == needed_; }
+
+    // returns false if the decoding is done, true if it needs more data
+    bool operator !() const noexcept { return !done(); }
+
+    // returns true if the decoding is done, false if it needs more data
+    explicit operator bool() const noexcept { return done(); }
+
+  private:
+    // room for the widest group a tag can describe, regardless of `type`
+    std::array<
+      unsigned char,
+      1 + group_size::value * detail::group_varint_impl::word_size::value
+    > buffer_;
+    std::array<type, group_size::value> values_;
+    std::size_t const size_;
+    std::size_t offset_ = 0;
+    std::size_t needed_ = 1;
+  };
+
+  // encodes the `n` values in `values` as consecutive groups, the last one
+  // possibly partial, returning the pointer past the last element written
+  // buffer must be able to fit at least `max_encoded_size(n)` elements
+  template <typename TData>
+  static TData *encode_n(
+    type const *values,
+    std::size_t n,
+    TData *out
+  ) noexcept {
+    static_assert(
+      detail::group_varint_impl::is_byte<TData>::value,
+      "byte-sized data unit expected"
+    );
+
+    // whole values can be stored at once since the buffer bound already
+    // accounts for 4 bytes per value
+    using wide = std::integral_constant<
+      bool, sizeof(internal) == detail::group_varint_impl::word_size::value
+    >;
+
+    auto p = reinterpret_cast<unsigned char *>(out);
+
+    while (n) {
+      auto const size = std::min(n, group_size::value);
+      p += detail::group_varint_impl::encode_group<type>(
+        values, values + size, p, wide::value
+      );
+
+      values += size;
+      n -= size;
+    }
+
+    return out + (p - reinterpret_cast<unsigned char *>(out));
+  }
+
+  // decodes up to `n` values encoded as consecutive groups by `encode_n` in
+  // `[begin, end)` into `out`, stopping early if the input ends
+  //
+  // returns the pointer past the last group decoded, along with the amount of
+  // values decoded, which is less than `n` when the input ends before that
+  template <typename TData>
+  static std::pair<TData const *, std::size_t> decode_n(
+    TData const *begin,
+    TData const *end,
+    type *out,
+    std::size_t n
+  ) noexcept {
+    static_assert(
+      detail::group_varint_impl::is_byte<TData>::value,
+      "byte-sized data unit expected"
+    );
+    assert(begin <= end);
+
+    // a tag plus 16 bytes, so that a group can be read with a single load
+    using lookahead = std::integral_constant<
+      std::size_t,
+      1 + group_size::value * detail::group_varint_impl::word_size::value
+    >;
+
+    auto p = reinterpret_cast<unsigned char const *>(begin);
+    auto const last = reinterpret_cast<unsigned char const *>(end);
+    std::size_t i = 0;
+
+    while (i < n && p != last) {
+      auto const size = std::min(n - i, group_size::value);
+      auto const left = static_cast<std::size_t>(last - p);
+      auto const tag = *p;
+
+      if (left >= lookahead::value) {
+        p += 1 + detail::group_varint_impl::decode_group(
+          tag, p + 1, out + i, size, true
+        );
+      } else {
+        if (left < 1 + detail::group_varint_impl::length(tag, size)) {
+          break;
+        }
+
+        p += 1 + detail::group_varint_impl::decode_group(
+          tag, p + 1, out + i, size, false
+        );
+      }
+
+      i += size;
+    }
+
+    return std::make_pair(
+      begin + (p - reinterpret_cast<unsigned char const *>(begin)), i
+    );
+  }
+};
+
+} // namespace fatal {
+
+#endif // FATAL_INCLUDE_fatal_codec_group_varint_h
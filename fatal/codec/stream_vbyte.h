@@ -0,0 +1,340 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef FATAL_INCLUDE_fatal_codec_stream_vbyte_h
+#define FATAL_INCLUDE_fatal_codec_stream_vbyte_h
+
+#include <fatal/codec/group_varint.h>
+
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <cassert>
+#include <cstdint>
+
+namespace fatal {
+
+/**
+ * Stream VByte codec for blocks of integers up to 32 bits.
+ *
+ * A block of `n` values is encoded as two consecutive streams: the control
+ * stream, with one byte for every four values holding their 2 bit length
+ * codes (byte count minus one), the first value in the least significant
+ * bits, followed by the data stream with the bytes of each value in little
+ * endian order. The amount of values in the block must be known by the
+ * decoder.
+ *
+ * Keeping the control bytes apart from the data means the decoder knows
+ * where every group of four values starts without touching the data, which
+ * makes this format decode faster than `group_varint` on wide pipelines.
+ *
+ * Signed integers are zigzag encoded, just like in `varint`.
+ *
+ * Example:
+ *
+ *  std::vector<std::uint32_t> values{1, 1000, 100000, 10000000, 7};
+ *
+ *  using codec = stream_vbyte<std::uint32_t>;
+ *  std::vector<char> buffer(codec::max_encoded_size(values.size()));
+ *  auto const end = codec::encode_n(
+ *    values.data(), values.size(), buffer.data()
+ *  );
+ *
+ *  std::vector<std::uint32_t> decoded(values.size());
+ *  codec::decoder decoder(decoded.data(), decoded.size());
+ *  decoder(buffer.data(), end);
+ *  assert(decoder.done());
+ *  assert(decoded == values);
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+template <typename T>
+struct stream_vbyte {
+  using type = T;
+
+private:
+  using value_traits = detail::group_varint_impl::value_traits<type>;
+  using traits = typename value_traits::type;
+  using internal = typename value_traits::internal;
+  using group_size = detail::group_varint_impl::group_size;
+  using code_bits = detail::group_varint_impl::code_bits;
+  using code_mask = detail::group_varint_impl::code_mask;
+
+public:
+  // amount of control bytes describing `n` values
+  static constexpr std::size_t control_size(std::size_t n) noexcept {
+    return (n + group_size::value - 1) / group_size::value;
+  }
+
+  // largest amount of bytes written when encoding `n` values
+  static constexpr std::size_t max_encoded_size(std::size_t n) noexcept {
+    return control_size(n) + n * sizeof(internal);
+  }
+
+  struct encoder {
+    // encodes the `size` values pointed to by `values`, which must outlive
+    // the encoder
+    encoder(type const *values, std::size_t size) noexcept:
+      values_(values),
+      size_(size)
+    {}
+
+    // writes as much of the encoded block as fits in [begin, end), returning
+    // the iterator past the last element written
+    template <typename TOutputIterator>
+    TOutputIterator operator ()(
+      TOutputIterator begin,
+      TOutputIterator const end
+    ) noexcept {
+      using data_type = typename std::iterator_traits<
+        TOutputIterator
+      >::value_type;
+
+      for (; control_ < control_size(size_) && begin != end; ++begin) {
+        auto const offset = control_ * group_size::value;
+        auto const last = std::min(size_, offset + group_size::value);
+        unsigned tag = 0;
+
+        for (auto i = offset; i < last; ++i) {
+          tag |= detail::group_varint_impl::code(word(i))
+            << ((i - offset) * code_bits::value);
+        }
+
+        *begin = static_cast<data_type>(tag);
+        ++control_;
+      }
+
+      for (; index_ < size_ && begin != end; ++begin) {
+        auto const value = word(index_);
+        *begin = static_cast<data_type>(value >> (byte_ * 8));
+
+        if (
+          ++byte_ == detail::group_varint_impl::length(
+            detail::group_varint_impl::code(value)
+          )
+        ) {
+          byte_ = 0;
+          ++index_;
+        }
+      }
+
+      return begin;
+    }
+
+    // returns true if the encoding is done, false if it needs more room
+    bool done() const noexcept {
+      return control_ == control_size(size_) && index_ == size_;
+    }
+
+    // returns false if the encoding is done, true if it needs more room
+    bool operator !() const noexcept { return !done(); }
+
+    // returns true if the encoding is done, false if it needs more room
+    explicit operator bool() const noexcept { return done(); }
+
+  private:
+    std::uint32_t word(std::size_t i) const noexcept {
+      assert(i < size_);
+      return static_cast<std::uint32_t>(traits::pre(values_[i]));
+    }
+
+    type const *values_;
+    std::size_t const size_;
+    std::size_t control_ = 0;
+    std::size_t index_ = 0;
+    std::size_t byte_ = 0;
+  };
+
+  struct decoder {
+    // decodes a block of `size` values into `out`, which must outlive the
+    // decoder
+    decoder(type *out, std::size_t size):
+      out_(out),
+      size_(size)
+    {
+      control_.reserve(control_size(size_));
+    }
+
+    // returns the iterator `i` to the first unused element such
+    // that [begin, i) represents the data that have been decoded
+    template <typename TInputIterator>
+    TInputIterator operator ()(
+      TInputIterator begin,
+      TInputIterator const end
+    ) {
+      for (; control_.size() < control_size(size_) && begin != end; ++begin) {
+        control_.push_back(static_cast<unsigned char>(*begin));
+      }
+
+      for (; index_ < size_ && begin != end; ++begin) {
+        value_ |= static_cast<std::uint32_t>(
+          static_cast<unsigned char>(*begin)
+        ) << (byte_ * 8);
+
+        if (++byte_ == detail::group_varint_impl::length(code(index_))) {
+          out_[index_++] = traits::post(static_cast<internal>(value_));
+          value_ = 0;
+          byte_ = 0;
+        }
+      }
+
+      return begin;
+    }
+
+    // resets the internal structure of this decoder as if
+    // no data had been fed to it
+    void reset() noexcept {
+      control_.clear();
+      index_ = 0;
+      byte_ = 0;
+      value_ = 0;
+    }
+
+    // the amount of values in the block
+    std::size_t size() const noexcept { return size_; }
+
+    // the amount of values already written to the output
+    std::size_t decoded() const noexcept { return index_; }
+
+    // returns true if the decoding is done, false if it needs more data
+    bool done() const noexcept {
+      return control_.size() == control_size(size_) && index_ == size_;
+    }
+
+    // returns false if the decoding is done, true if it needs more data
+    bool operator !() const noexcept { return !done(); }
+
+    // returns true if the decoding is done, false if it needs more data
+    explicit operator bool() const noexcept { return done(); }
+
+  private:
+    unsigned code(std::size_t i) const noexcept {
+      return (control_[i / group_size::value]
+        >> ((i % group_size::value) * code_bits::value)
+      ) & code_mask::value;
+    }
+
+    type *const out_;
+    std::size_t const size_;
+    std::vector<unsigned char> control_;
+    std::size_t index_ = 0;
+    std::size_t byte_ = 0;
+    std::uint32_t value_ = 0;
+  };
+
+  // encodes the `n` values in `values` as a single block, returning the
+  // pointer past the last element written
+  // buffer must be able to fit at least `max_encoded_size(n)` elements
+  template <typename TData>
+  static TData *encode_n(
+    type const *values,
+    std::size_t n,
+    TData *out
+  ) noexcept {
+    static_assert(
+      detail::group_varint_impl::is_byte<TData>::value,
+      "byte-sized data unit expected"
+    );
+
+    // whole values can be stored at once since the buffer bound already
+    // accounts for 4 bytes per value
+    using wide = std::integral_constant<
+      bool, sizeof(internal) == detail::group_varint_impl::word_size::value
+    >;
+
+    auto control = reinterpret_cast<unsigned char *>(out);
+    auto data = control + control_size(n);
+
+    for (std::size_t i = 0; i < n; i += group_size::value, ++control) {
+      auto const size = std::min(n - i, group_size::value);
+      unsigned tag = 0;
+
+      for (std::size_t j = 0; j < size; ++j) {
+        auto const c = detail::group_varint_impl::encode_value(
+          data, static_cast<std::uint32_t>(traits::pre(values[i + j])),
+          wide::value
+        );
+        tag |= c << (j * code_bits::value);
+        data += detail::group_varint_impl::length(c);
+      }
+
+      *control = static_cast<unsigned char>(tag);
+    }
+
+    return out + (data - reinterpret_cast<unsigned char *>(out));
+  }
+
+  // decodes a block of `n` values encoded by `encode_n` in `[begin, end)`
+  // into `out`, stopping early if the input ends
+  //
+  // returns the pointer past the last group decoded, along with the amount of
+  // values decoded, which is less than `n` when the input ends before that
+  template <typename TData>
+  static std::pair<TData const *, std::size_t> decode_n(
+    TData const *begin,
+    TData const *end,
+    type *out,
+    std::size_t n
+  ) noexcept {
+    static_assert(
+      detail::group_varint_impl::is_byte<TData>::value,
+      "byte-sized data unit expected"
+    );
+    assert(begin <= end);
+
+    // so that a group can be read with a single load
+    using lookahead = std::integral_constant<
+      std::size_t,
+      group_size::value * detail::group_varint_impl::word_size::value
+    >;
+
+    auto control = reinterpret_cast<unsigned char const *>(begin);
+    auto const last = reinterpret_cast<unsigned char const *>(end);
+
+    if (static_cast<std::size_t>(last - control) < control_size(n)) {
+      return std::make_pair(begin, std::size_t(0));
+    }
+
+    auto data = control + control_size(n);
+    std::size_t i = 0;
+
+    while (i < n) {
+      auto const size = std::min(n - i, group_size::value);
+      auto const left = static_cast<std::size_t>(last - data);
+
+      if (left >= lookahead::value) {
+        data += detail::group_varint_impl::decode_group(
+          *control, data, out + i, size, true
+        );
+      } else {
+        if (left < detail::group_varint_impl::length(*control, size)) {
+          break;
+        }
+
+        data += detail::group_varint_impl::decode_group(
+          *control, data, out + i, size, false
+        );
+      }
+
+      ++control;
+      i += size;
+    }
+
+    return std::make_pair(
+      begin + (data - reinterpret_cast<unsigned char const *>(begin)), i
+    );
+  }
+};
+
+} // namespace fatal {
+
+#endif // FATAL_INCLUDE_fatal_codec_stream_vbyte_h
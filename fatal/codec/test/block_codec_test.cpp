@@ -0,0 +1,315 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/codec/block_codec.h>
+
+#include <fatal/test/driver.h>
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <cstdint>
+
+namespace fatal {
+
+// sorted values with small gaps, like ids
+template <typename T>
+std::vector<T> sorted_values(std::size_t size) {
+  std::mt19937 rng(static_cast<std::mt19937::result_type>(size));
+  std::vector<T> result(size);
+  auto value = std::numeric_limits<T>::min();
+
+  for (auto &i: result) {
+    i = value;
+    value = static_cast<T>(value + static_cast<T>(rng() % 4));
+  }
+
+  return result;
+}
+
+// values with a roughly constant stride, like timestamps
+template <typename T>
+std::vector<T> strided_values(std::size_t size) {
+  std::mt19937 rng(static_cast<std::mt19937::result_type>(size));
+  std::vector<T> result(size);
+  auto value = static_cast<T>(rng());
+
+  for (auto &i: result) {
+    i = value;
+    value = static_cast<T>(value + static_cast<T>(10 + rng() % 3));
+  }
+
+  return result;
+}
+
+// values of any magnitude, including the limits
+template <typename T>
+std::vector<T> random_values(std::size_t size) {
+  using limit = std::numeric_limits<T>;
+
+  std::mt19937_64 rng(size);
+  std::vector<T> result(size);
+
+  for (auto &i: result) {
+    switch (rng() % 8) {
+      case 0: i = limit::max(); break;
+      case 1: i = limit::min(); break;
+      default: i = static_cast<T>(rng() >> (rng() % 64)); break;
+    }
+  }
+
+  return result;
+}
+
+template <typename Codec>
+void check_roundtrip(std::vector<typename Codec::type> const &values) {
+  using type = typename Codec::type;
+
+  auto const n = values.size();
+  std::vector<char> encoded(Codec::max_encoded_size(n));
+  std::vector<std::size_t> offsets(Codec::blocks(n));
+  auto const end = Codec::encode_n(
+    values.data(), n, encoded.data(), offsets.begin()
+  );
+  FATAL_ASSERT_LE(end - encoded.data(), encoded.size());
+  encoded.resize(static_cast<std::size_t>(end - encoded.data()));
+
+  // same encoding without the offsets
+  std::vector<char> plain(Codec::max_encoded_size(n));
+  plain.resize(static_cast<std::size_t>(
+    Codec::encode_n(values.data(), n, plain.data()) - plain.data()
+  ));
+  FATAL_ASSERT_EQ(encoded, plain);
+
+  char const *const begin = encoded.data();
+  std::vector<type> decoded(n);
+  auto const result = Codec::decode_n(
+    begin, begin + encoded.size(), decoded.data(), n
+  );
+  FATAL_EXPECT_EQ(encoded.size(), result.first - begin);
+  FATAL_ASSERT_EQ(n, result.second);
+  FATAL_ASSERT_EQ(values, decoded);
+
+  // random access by block
+  for (std::size_t i = 0; i < offsets.size(); ++i) {
+    type block[Codec::block_size::value];
+    auto const first = i * Codec::block_size::value;
+    auto const size = std::min(n - first, Codec::block_size::value);
+
+    auto const decoded_block = Codec::decode_block(
+      begin + offsets[i], begin + encoded.size(), block
+    );
+    FATAL_ASSERT_EQ(size, decoded_block.second);
+    FATAL_ASSERT_TRUE(
+      std::equal(block, block + size, values.begin() + first)
+    );
+
+    auto const skipped = Codec::skip_block(
+      begin + offsets[i], begin + encoded.size()
+    );
+    FATAL_ASSERT_EQ(size, skipped.second);
+    FATAL_ASSERT_TRUE(decoded_block.first == skipped.first);
+    FATAL_ASSERT_EQ(
+      i + 1 < offsets.size() ? offsets[i + 1] : encoded.size(),
+      skipped.first - begin
+    );
+  }
+
+  if (!n) {
+    return;
+  }
+
+  // streaming decode, resumed where the previous call stopped
+  std::vector<type> streamed(n);
+  auto const half = Codec::decode_n(
+    begin, begin + encoded.size(), streamed.data(), n / 2
+  );
+  FATAL_ASSERT_EQ(
+    n / 2 / Codec::block_size::value * Codec::block_size::value,
+    half.second
+  );
+  auto const rest = Codec::decode_n(
+    half.first, begin + encoded.size(),
+    streamed.data() + half.second, n - half.second
+  );
+  FATAL_ASSERT_EQ(n, half.second + rest.second);
+  FATAL_ASSERT_EQ(values, streamed);
+
+  // stops before an incomplete block
+  auto const truncated = Codec::decode_n(
+    begin, begin + encoded.size() - 1, streamed.data(), n
+  );
+  FATAL_EXPECT_EQ(offsets.back(), truncated.first - begin);
+  FATAL_EXPECT_EQ(
+    (offsets.size() - 1) * Codec::block_size::value,
+    truncated.second
+  );
+}
+
+template <typename T, block_transform Transform>
+void check_codec() {
+  using codec = block_codec<T, Transform>;
+
+  for (std::size_t n: {0, 1, 2, 3, 127, 128, 129, 256, 1000}) {
+    check_roundtrip<codec>(sorted_values<T>(n));
+    check_roundtrip<codec>(strided_values<T>(n));
+    check_roundtrip<codec>(random_values<T>(n));
+  }
+}
+
+FATAL_TEST(delta, i8) { check_codec<std::int8_t, block_transform::delta>(); }
+FATAL_TEST(delta, i16) { check_codec<std::int16_t, block_transform::delta>(); }
+FATAL_TEST(delta, i32) { check_codec<std::int32_t, block_transform::delta>(); }
+FATAL_TEST(delta, i64) { check_codec<std::int64_t, block_transform::delta>(); }
+FATAL_TEST(delta, u8) { check_codec<std::uint8_t, block_transform::delta>(); }
+FATAL_TEST(delta, u16) { check_codec<std::uint16_t, block_transform::delta>(); }
+FATAL_TEST(delta, u32) { check_codec<std::uint32_t, block_transform::delta>(); }
+FATAL_TEST(delta, u64) { check_codec<std::uint64_t, block_transform::delta>(); }
+
+FATAL_TEST(delta_of_delta, i8) {
+  check_codec<std::int8_t, block_transform::delta_of_delta>();
+}
+FATAL_TEST(delta_of_delta, i16) {
+  check_codec<std::int16_t, block_transform::delta_of_delta>();
+}
+FATAL_TEST(delta_of_delta, i32) {
+  check_codec<std::int32_t, block_transform::delta_of_delta>();
+}
+FATAL_TEST(delta_of_delta, i64) {
+  check_codec<std::int64_t, block_transform::delta_of_delta>();
+}
+FATAL_TEST(delta_of_delta, u8) {
+  check_codec<std::uint8_t, block_transform::delta_of_delta>();
+}
+FATAL_TEST(delta_of_delta, u16) {
+  check_codec<std::uint16_t, block_transform::delta_of_delta>();
+}
+FATAL_TEST(delta_of_delta, u32) {
+  check_codec<std::uint32_t, block_transform::delta_of_delta>();
+}
+FATAL_TEST(delta_of_delta, u64) {
+  check_codec<std::uint64_t, block_transform::delta_of_delta>();
+}
+
+FATAL_TEST(frame_of_reference, i8) {
+  check_codec<std::int8_t, block_transform::frame_of_reference>();
+}
+FATAL_TEST(frame_of_reference, i16) {
+  check_codec<std::int16_t, block_transform::frame_of_reference>();
+}
+FATAL_TEST(frame_of_reference, i32) {
+  check_codec<std::int32_t, block_transform::frame_of_reference>();
+}
+FATAL_TEST(frame_of_reference, i64) {
+  check_codec<std::int64_t, block_transform::frame_of_reference>();
+}
+FATAL_TEST(frame_of_reference, u8) {
+  check_codec<std::uint8_t, block_transform::frame_of_reference>();
+}
+FATAL_TEST(frame_of_reference, u16) {
+  check_codec<std::uint16_t, block_transform::frame_of_reference>();
+}
+FATAL_TEST(frame_of_reference, u32) {
+  check_codec<std::uint32_t, block_transform::frame_of_reference>();
+}
+FATAL_TEST(frame_of_reference, u64) {
+  check_codec<std::uint64_t, block_transform::frame_of_reference>();
+}
+
+template <typename Codec>
+std::size_t encoded_size(std::vector<typename Codec::type> const &values) {
+  std::vector<char> buffer(Codec::max_encoded_size(values.size()));
+  return static_cast<std::size_t>(
+    Codec::encode_n(values.data(), values.size(), buffer.data())
+      - buffer.data()
+  );
+}
+
+template <typename T>
+std::size_t varint_size(std::vector<T> const &values) {
+  std::vector<char> buffer(
+    values.size() * varint<T>::template max_size<char>::value
+  );
+  return static_cast<std::size_t>(
+    varint<T>::encode_n(values.data(), values.size(), buffer.data())
+      - buffer.data()
+  );
+}
+
+FATAL_TEST(block_codec, compression) {
+  std::vector<std::uint64_t> ids(1000);
+  std::vector<std::uint64_t> timestamps(1000);
+
+  for (std::size_t i = 0; i < ids.size(); ++i) {
+    ids[i] = UINT64_C(1) << 40 | (i * 3);
+    timestamps[i] = UINT64_C(1500000000000) + i * 1000 + i % 2;
+  }
+
+  using delta = delta_codec<std::uint64_t>;
+  using delta_of_delta = delta_of_delta_codec<std::uint64_t>;
+  using frame_of_reference = frame_of_reference_codec<std::uint64_t>;
+
+  // a few bits per id, plus block headers
+  FATAL_EXPECT_LT(encoded_size<delta>(ids), 500);
+  FATAL_EXPECT_LT(encoded_size<delta>(ids) * 10, varint_size(ids));
+
+  // a few bits per timestamp, plus block headers
+  FATAL_EXPECT_LT(encoded_size<delta_of_delta>(timestamps), 500);
+  FATAL_EXPECT_LT(
+    encoded_size<delta_of_delta>(timestamps),
+    encoded_size<delta>(timestamps)
+  );
+
+  // a narrow range of unsorted values
+  std::vector<std::uint64_t> narrow(ids.rbegin(), ids.rend());
+  FATAL_EXPECT_LT(
+    encoded_size<frame_of_reference>(narrow) * 3, varint_size(narrow)
+  );
+}
+
+FATAL_TEST(block_codec, outliers) {
+  using codec = delta_codec<std::uint64_t>;
+
+  // a single outlier would widen the bit-packing of the whole block
+  std::vector<std::uint64_t> values(128);
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    values[i] = i;
+  }
+  values[64] = UINT64_C(1) << 60;
+
+  auto const size = encoded_size<codec>(values);
+  FATAL_EXPECT_LT(size, 160);
+  check_roundtrip<codec>(values);
+}
+
+FATAL_TEST(block_codec, corrupt) {
+  using codec = delta_codec<std::uint32_t>;
+
+  std::uint32_t out[codec::block_size::value];
+
+  // more values than fit in a block
+  char const too_long[] = {0, static_cast<char>(200), 1};
+  FATAL_EXPECT_EQ(
+    0, codec::decode_block(too_long, too_long + sizeof(too_long), out).second
+  );
+
+  // wider than the type
+  char const too_wide[] = {40, 1, 1, 0, 0, 0, 0, 0};
+  FATAL_EXPECT_EQ(
+    0, codec::decode_block(too_wide, too_wide + sizeof(too_wide), out).second
+  );
+
+  // the empty input
+  FATAL_EXPECT_EQ(0, codec::decode_block(too_wide, too_wide, out).second);
+  FATAL_EXPECT_EQ(0, codec::skip_block(too_wide, too_wide).second);
+}
+
+} // namespace fatal {
@@ -0,0 +1,202 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/codec/group_varint.h>
+
+#include <fatal/test/driver.h>
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include <cstdint>
+
+namespace fatal {
+
+// values with encodings of all possible sizes, including the limits
+template <typename T>
+std::vector<T> group_values(std::size_t size) {
+  using limit = std::numeric_limits<T>;
+  using unsigned_type = typename std::make_unsigned<T>::type;
+
+  std::mt19937 rng(static_cast<std::mt19937::result_type>(size));
+  std::vector<T> result;
+  result.reserve(size);
+
+  while (result.size() < size) {
+    switch (rng() % 8) {
+      case 0: result.push_back(limit::max()); break;
+      case 1: result.push_back(limit::min()); break;
+      default: {
+        auto const bits = rng() % data_bits<unsigned_type>::value + 1;
+        result.push_back(static_cast<T>(static_cast<unsigned_type>(
+          rng() & (~std::uint32_t(0) >> (32 - bits))
+        )));
+      }
+    }
+  }
+
+  return result;
+}
+
+FATAL_TEST(group_varint, layout) {
+  using codec = group_varint<std::uint32_t>;
+  std::uint32_t const values[] = {1, 0x1234, 0x123456, 0x12345678};
+
+  codec::automatic_buffer<unsigned char> buffer;
+  auto const end = codec::encode(
+    std::begin(values), std::end(values), buffer.begin()
+  );
+
+  std::vector<unsigned char> const expected{
+    0xe4,
+    0x01,
+    0x34, 0x12,
+    0x56, 0x34, 0x12,
+    0x78, 0x56, 0x34, 0x12
+  };
+  FATAL_EXPECT_EQ(
+    expected,
+    std::vector<unsigned char>(buffer.begin(), end)
+  );
+
+  // zero takes a single byte
+  std::uint32_t const zero[] = {0, 0};
+  auto const zero_end = codec::encode(
+    std::begin(zero), std::end(zero), buffer.begin()
+  );
+  FATAL_EXPECT_EQ(3, std::distance(buffer.begin(), zero_end));
+  FATAL_EXPECT_EQ(0, buffer[0]);
+}
+
+template <typename T>
+void check_group() {
+  using codec = group_varint<T>;
+  auto const values = group_values<T>(1000);
+
+  for (auto i = values.begin(); i != values.end(); ) {
+    auto const size = static_cast<std::size_t>(std::min<std::ptrdiff_t>(
+      std::distance(i, values.end()), 1 + std::distance(values.begin(), i) % 4
+    ));
+    auto const end = std::next(i, static_cast<std::ptrdiff_t>(size));
+
+    typename codec::template automatic_buffer<char> expected;
+    auto const expected_end = codec::encode(i, end, expected.begin());
+
+    // the encoder resumes when it runs out of room
+    typename codec::template automatic_buffer<char> buffer;
+    typename codec::encoder encoder(i, end);
+    auto out = buffer.begin();
+    while (!encoder) {
+      out = encoder(out, std::next(out));
+    }
+    FATAL_EXPECT_TRUE(encoder.done());
+    FATAL_ASSERT_EQ(
+      std::distance(expected.begin(), expected_end),
+      std::distance(buffer.begin(), out)
+    );
+    FATAL_ASSERT_TRUE(std::equal(buffer.begin(), out, expected.begin()));
+
+    // the decoder resumes when it runs out of data
+    typename codec::decoder decoder(size);
+    for (auto in = buffer.begin(); in != out; ++in) {
+      FATAL_ASSERT_FALSE(decoder.done());
+      FATAL_ASSERT_TRUE(std::next(in) == decoder(in, std::next(in)));
+    }
+    FATAL_ASSERT_TRUE(decoder.done());
+    FATAL_ASSERT_EQ(size, decoder.size());
+
+    for (std::size_t j = 0; j < size; ++j) {
+      FATAL_ASSERT_EQ(i[static_cast<std::ptrdiff_t>(j)], decoder.value(j));
+    }
+
+    // the decoder doesn't consume past the group
+    decoder.reset();
+    FATAL_EXPECT_FALSE(decoder.done());
+    FATAL_EXPECT_TRUE(out == decoder(buffer.begin(), buffer.end()));
+    FATAL_EXPECT_TRUE(decoder.done());
+
+    i = end;
+  }
+}
+
+FATAL_TEST(group_varint, i8) { check_group<std::int8_t>(); }
+FATAL_TEST(group_varint, i16) { check_group<std::int16_t>(); }
+FATAL_TEST(group_varint, i32) { check_group<std::int32_t>(); }
+FATAL_TEST(group_varint, u8) { check_group<std::uint8_t>(); }
+FATAL_TEST(group_varint, u16) { check_group<std::uint16_t>(); }
+FATAL_TEST(group_varint, u32) { check_group<std::uint32_t>(); }
+
+template <typename T, typename TData>
+void check_group_bulk() {
+  using codec = group_varint<T>;
+
+  for (std::size_t n: {0, 1, 3, 4, 5, 8, 17, 100, 1000, 10001}) {
+    auto const values = group_values<T>(n);
+
+    // the bulk encoding is the same as encoding each group separately
+    std::vector<TData> expected(codec::max_encoded_size(n));
+    auto e = expected.data();
+    for (auto i = values.begin(); i != values.end(); ) {
+      auto const end = std::next(i, std::min<std::ptrdiff_t>(
+        std::distance(i, values.end()), codec::group_size::value
+      ));
+      e = codec::encode(i, end, e);
+      i = end;
+    }
+    expected.resize(static_cast<std::size_t>(e - expected.data()));
+
+    std::vector<TData> encoded(codec::max_encoded_size(n));
+    auto const end = codec::encode_n(values.data(), n, encoded.data());
+    encoded.resize(static_cast<std::size_t>(end - encoded.data()));
+    FATAL_ASSERT_EQ(expected, encoded);
+
+    std::vector<T> decoded(n);
+    TData const *const begin = encoded.data();
+    auto const result = codec::decode_n(
+      begin, begin + encoded.size(), decoded.data(), n
+    );
+    FATAL_EXPECT_EQ(encoded.size(), std::distance(begin, result.first));
+    FATAL_ASSERT_EQ(n, result.second);
+    FATAL_ASSERT_EQ(values, decoded);
+
+    // stops before an incomplete group at the end of the input
+    if (n) {
+      std::vector<T> partial(n);
+      auto const truncated = codec::decode_n(
+        begin, begin + encoded.size() - 1, partial.data(), n
+      );
+      auto const groups = (n - 1) / codec::group_size::value;
+      FATAL_EXPECT_EQ(groups * codec::group_size::value, truncated.second);
+      FATAL_EXPECT_TRUE(
+        std::equal(
+          partial.begin(),
+          std::next(partial.begin(), truncated.second),
+          values.begin()
+        )
+      );
+    }
+  }
+}
+
+FATAL_TEST(group_varint, bulk_i8) { check_group_bulk<std::int8_t, char>(); }
+FATAL_TEST(group_varint, bulk_i16) { check_group_bulk<std::int16_t, char>(); }
+FATAL_TEST(group_varint, bulk_i32) { check_group_bulk<std::int32_t, char>(); }
+FATAL_TEST(group_varint, bulk_u8) { check_group_bulk<std::uint8_t, char>(); }
+FATAL_TEST(group_varint, bulk_u16) { check_group_bulk<std::uint16_t, char>(); }
+FATAL_TEST(group_varint, bulk_u32) { check_group_bulk<std::uint32_t, char>(); }
+
+FATAL_TEST(group_varint, bulk_u32_unsigned_char) {
+  check_group_bulk<std::uint32_t, unsigned char>();
+}
+
+} // namespace fatal {
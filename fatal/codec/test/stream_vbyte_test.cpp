@@ -0,0 +1,176 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/codec/stream_vbyte.h>
+
+#include <fatal/test/driver.h>
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include <cstdint>
+
+namespace fatal {
+
+// values with encodings of all possible sizes, including the limits
+template <typename T>
+std::vector<T> block_values(std::size_t size) {
+  using limit = std::numeric_limits<T>;
+  using unsigned_type = typename std::make_unsigned<T>::type;
+
+  std::mt19937 rng(static_cast<std::mt19937::result_type>(size));
+  std::vector<T> result;
+  result.reserve(size);
+
+  while (result.size() < size) {
+    switch (rng() % 8) {
+      case 0: result.push_back(limit::max()); break;
+      case 1: result.push_back(limit::min()); break;
+      default: {
+        auto const bits = rng() % data_bits<unsigned_type>::value + 1;
+        result.push_back(static_cast<T>(static_cast<unsigned_type>(
+          rng() & (~std::uint32_t(0) >> (32 - bits))
+        )));
+      }
+    }
+  }
+
+  return result;
+}
+
+FATAL_TEST(stream_vbyte, layout) {
+  using codec = stream_vbyte<std::uint32_t>;
+  std::vector<std::uint32_t> const values{
+    1, 0x1234, 0x123456, 0x12345678, 0xab
+  };
+
+  std::vector<unsigned char> buffer(codec::max_encoded_size(values.size()));
+  auto const end = codec::encode_n(
+    values.data(), values.size(), buffer.data()
+  );
+
+  std::vector<unsigned char> const expected{
+    0xe4, 0x00,
+    0x01,
+    0x34, 0x12,
+    0x56, 0x34, 0x12,
+    0x78, 0x56, 0x34, 0x12,
+    0xab
+  };
+  FATAL_EXPECT_EQ(
+    expected,
+    std::vector<unsigned char>(buffer.data(), end)
+  );
+
+  // an empty block takes no space
+  FATAL_EXPECT_EQ(0, codec::max_encoded_size(0));
+  FATAL_EXPECT_TRUE(buffer.data() == codec::encode_n(
+    values.data(), 0, buffer.data()
+  ));
+}
+
+template <typename T, typename TData>
+void check_block() {
+  using codec = stream_vbyte<T>;
+
+  for (std::size_t n: {0, 1, 3, 4, 5, 8, 17, 100, 1000, 10001}) {
+    auto const values = block_values<T>(n);
+
+    std::vector<TData> encoded(codec::max_encoded_size(n));
+    auto const end = codec::encode_n(values.data(), n, encoded.data());
+    encoded.resize(static_cast<std::size_t>(end - encoded.data()));
+
+    std::vector<T> decoded(n);
+    TData const *const begin = encoded.data();
+    auto const result = codec::decode_n(
+      begin, begin + encoded.size(), decoded.data(), n
+    );
+    FATAL_EXPECT_EQ(encoded.size(), std::distance(begin, result.first));
+    FATAL_ASSERT_EQ(n, result.second);
+    FATAL_ASSERT_EQ(values, decoded);
+
+    // stops before an incomplete group at the end of the input
+    if (n) {
+      std::vector<T> partial(n);
+      auto const truncated = codec::decode_n(
+        begin, begin + encoded.size() - 1, partial.data(), n
+      );
+      auto const groups = (n - 1) / 4;
+      FATAL_EXPECT_EQ(groups * 4, truncated.second);
+      FATAL_EXPECT_TRUE(
+        std::equal(
+          partial.begin(),
+          std::next(partial.begin(), truncated.second),
+          values.begin()
+        )
+      );
+
+      // nothing is decoded without the whole control stream
+      auto const control = codec::decode_n(
+        begin, begin + codec::control_size(n) - 1, partial.data(), n
+      );
+      FATAL_EXPECT_TRUE(begin == control.first);
+      FATAL_EXPECT_EQ(0, control.second);
+    }
+
+    if (n > 1000) {
+      continue;
+    }
+
+    // the encoder resumes when it runs out of room
+    std::vector<TData> buffer(encoded.size());
+    typename codec::encoder encoder(values.data(), n);
+    auto out = buffer.data();
+    while (!encoder) {
+      out = encoder(out, std::next(out));
+    }
+    FATAL_EXPECT_TRUE(encoder.done());
+    FATAL_ASSERT_EQ(encoded.size(), std::distance(buffer.data(), out));
+    FATAL_ASSERT_EQ(encoded, buffer);
+
+    // the decoder resumes when it runs out of data
+    std::vector<T> streamed(n);
+    typename codec::decoder decoder(streamed.data(), n);
+    FATAL_EXPECT_EQ(n, decoder.size());
+    for (auto in = buffer.begin(); in != buffer.end(); ++in) {
+      FATAL_ASSERT_FALSE(decoder.done());
+      FATAL_ASSERT_TRUE(std::next(in) == decoder(in, std::next(in)));
+    }
+    FATAL_ASSERT_TRUE(decoder.done());
+    FATAL_ASSERT_EQ(n, decoder.decoded());
+    FATAL_ASSERT_EQ(values, streamed);
+
+    // the decoder doesn't consume past the block
+    encoded.push_back(0);
+    decoder.reset();
+    FATAL_EXPECT_EQ(0, decoder.decoded());
+    FATAL_EXPECT_TRUE(
+      std::prev(encoded.end()) == decoder(encoded.begin(), encoded.end())
+    );
+    FATAL_EXPECT_TRUE(decoder.done());
+    FATAL_ASSERT_EQ(values, streamed);
+  }
+}
+
+FATAL_TEST(stream_vbyte, i8) { check_block<std::int8_t, char>(); }
+FATAL_TEST(stream_vbyte, i16) { check_block<std::int16_t, char>(); }
+FATAL_TEST(stream_vbyte, i32) { check_block<std::int32_t, char>(); }
+FATAL_TEST(stream_vbyte, u8) { check_block<std::uint8_t, char>(); }
+FATAL_TEST(stream_vbyte, u16) { check_block<std::uint16_t, char>(); }
+FATAL_TEST(stream_vbyte, u32) { check_block<std::uint32_t, char>(); }
+
+FATAL_TEST(stream_vbyte, u32_unsigned_char) {
+  check_block<std::uint32_t, unsigned char>();
+}
+
+} // namespace fatal {
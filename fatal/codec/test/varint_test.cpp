@@ -13,8 +13,11 @@
 
 #include <algorithm>
 #include <iterator>
+#include <limits>
+#include <random>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include <cassert>
 #include <cstdint>
@@ -292,4 +295,199 @@ FATAL_TEST(encoder, decoder_u16) { chk<use::encr, use::decr, std::uint16_t>(); }
 FATAL_TEST(encoder, decoder_u32) { chk<use::encr, use::decr, std::uint32_t>(); }
 FATAL_TEST(encoder, decoder_u64) { chk<use::encr, use::decr, std::uint64_t>(); }
 
+//////////
+// bulk //
+//////////
+
+// values whose encodings have all possible sizes, with long runs of single
+// byte encodings interleaved with runs of mixed sizes
+template <typename T>
+std::vector<T> bulk_values(std::size_t size) {
+  using limit = std::numeric_limits<T>;
+  using unsigned_type = typename std::make_unsigned<T>::type;
+
+  std::mt19937_64 rng(size);
+  std::vector<T> result;
+  result.reserve(size);
+
+  while (result.size() < size) {
+    auto const run = rng() % 40;
+    auto const bits = rng() % 2 ? 6 : rng() % data_bits<unsigned_type>::value;
+
+    for (std::size_t i = 0; i < run && result.size() < size; ++i) {
+      auto const value = static_cast<unsigned_type>(
+        rng() & ((std::uint64_t(1) << bits) - 1)
+      );
+      result.push_back(static_cast<T>(value));
+    }
+
+    result.push_back(rng() % 2 ? limit::max() : limit::min());
+  }
+
+  result.resize(size);
+  return result;
+}
+
+template <typename T, typename TData>
+void check_bulk() {
+  using codec = varint<T>;
+  using size = typename codec::template max_size<TData>;
+
+  for (std::size_t n: {0, 1, 7, 8, 15, 16, 17, 31, 100, 1000, 10000}) {
+    auto const values = bulk_values<T>(n);
+
+    // the bulk encoding is the same as encoding each value separately
+    std::vector<TData> expected(n * size::value);
+    auto e = expected.data();
+    for (auto value: values) {
+      e = codec::encode(value, e);
+    }
+    expected.resize(static_cast<std::size_t>(e - expected.data()));
+
+    std::vector<TData> encoded(n * size::value);
+    auto const end = codec::encode_n(values.data(), n, encoded.data());
+    encoded.resize(static_cast<std::size_t>(end - encoded.data()));
+    FATAL_ASSERT_EQ(expected, encoded);
+
+    std::vector<T> decoded(n + 1);
+    TData const *const begin = encoded.data();
+    auto const result = codec::decode_n(
+      begin, begin + encoded.size(), decoded.data(), n + 1
+    );
+    FATAL_EXPECT_EQ(encoded.size(), std::distance(begin, result.first));
+    FATAL_ASSERT_EQ(n, result.second);
+    decoded.resize(n);
+    FATAL_ASSERT_EQ(values, decoded);
+
+    // stops at the requested amount of values
+    if (n > 1) {
+      auto const half = codec::decode_n(
+        begin, begin + encoded.size(), decoded.data(), n / 2
+      );
+      FATAL_EXPECT_EQ(n / 2, half.second);
+      auto const rest = codec::decode_n(
+        half.first, begin + encoded.size(), decoded.data() + n / 2, n
+      );
+      FATAL_EXPECT_EQ(n - n / 2, rest.second);
+      FATAL_ASSERT_EQ(values, decoded);
+    }
+
+    // stops before an incomplete value at the end of the input
+    if (n && encoded.size() > 1) {
+      std::vector<T> partial(n);
+      auto const truncated = codec::decode_n(
+        begin, begin + encoded.size() - 1, partial.data(), n
+      );
+      FATAL_EXPECT_EQ(n - 1, truncated.second);
+
+      auto last = begin;
+      for (std::size_t i = 0; i < n - 1; ++i) {
+        codec::tracking_decode(last, begin + encoded.size());
+      }
+      FATAL_EXPECT_EQ(
+        std::distance(begin, last),
+        std::distance(begin, truncated.first)
+      );
+      FATAL_EXPECT_TRUE(
+        std::equal(partial.begin(), partial.end() - 1, values.begin())
+      );
+    }
+  }
+}
+
+template <typename T>
+void check_contiguous() {
+  using codec = varint<T>;
+
+  auto const values = bulk_values<T>(10000);
+  std::vector<char> encoded(
+    values.size() * codec::template max_size<char>::value
+  );
+  encoded.resize(static_cast<std::size_t>(
+    codec::encode_n(values.data(), values.size(), encoded.data())
+      - encoded.data()
+  ));
+
+  // pointers take the word at a time path, except for the last few values,
+  // while `std::vector` iterators always take the byte at a time one
+  char const *p = encoded.data();
+  char const *const end = p + encoded.size();
+  auto i = encoded.cbegin();
+
+  for (auto value: values) {
+    typename codec::decoder fast;
+    typename codec::decoder generic;
+
+    auto const next = fast(p, end);
+    i = generic(i, encoded.cend());
+
+    FATAL_ASSERT_TRUE(fast.done());
+    FATAL_ASSERT_TRUE(generic.done());
+    FATAL_ASSERT_EQ(value, fast.value());
+    FATAL_ASSERT_EQ(generic.value(), fast.value());
+    FATAL_ASSERT_EQ(std::distance(encoded.cbegin(), i), next - encoded.data());
+
+    p = next;
+  }
+
+  FATAL_EXPECT_TRUE(p == end);
+
+  // resuming a partially fed decoder
+  p = encoded.data();
+
+  for (auto value: values) {
+    typename codec::decoder decoder;
+    p = decoder(p, p + 1);
+
+    if (!decoder) {
+      p = decoder(p, end);
+    }
+
+    FATAL_ASSERT_TRUE(decoder.done());
+    FATAL_ASSERT_EQ(value, decoder.value());
+  }
+
+  FATAL_EXPECT_TRUE(p == end);
+}
+
+FATAL_TEST(contiguous, i8) { check_contiguous<std::int8_t>(); }
+FATAL_TEST(contiguous, i16) { check_contiguous<std::int16_t>(); }
+FATAL_TEST(contiguous, i32) { check_contiguous<std::int32_t>(); }
+FATAL_TEST(contiguous, i64) { check_contiguous<std::int64_t>(); }
+FATAL_TEST(contiguous, u8) { check_contiguous<std::uint8_t>(); }
+FATAL_TEST(contiguous, u16) { check_contiguous<std::uint16_t>(); }
+FATAL_TEST(contiguous, u32) { check_contiguous<std::uint32_t>(); }
+FATAL_TEST(contiguous, u64) { check_contiguous<std::uint64_t>(); }
+
+FATAL_TEST(contiguous, unterminated) {
+  using codec = varint<std::uint64_t>;
+
+  // longer than the longest encoding, with and without enough room for it
+  std::vector<char> const data(12, static_cast<char>(0x81));
+
+  for (std::size_t size = 1; size <= data.size(); ++size) {
+    codec::decoder decoder;
+    auto const end = data.data() + size;
+    FATAL_EXPECT_TRUE(end == decoder(data.data(), end));
+    FATAL_EXPECT_FALSE(decoder.done());
+  }
+}
+
+FATAL_TEST(bulk, i8) { check_bulk<std::int8_t, char>(); }
+FATAL_TEST(bulk, i16) { check_bulk<std::int16_t, char>(); }
+FATAL_TEST(bulk, i32) { check_bulk<std::int32_t, char>(); }
+FATAL_TEST(bulk, i64) { check_bulk<std::int64_t, char>(); }
+FATAL_TEST(bulk, u8) { check_bulk<std::uint8_t, char>(); }
+FATAL_TEST(bulk, u16) { check_bulk<std::uint16_t, char>(); }
+FATAL_TEST(bulk, u32) { check_bulk<std::uint32_t, char>(); }
+FATAL_TEST(bulk, u64) { check_bulk<std::uint64_t, char>(); }
+
+FATAL_TEST(bulk, u32_unsigned_char) {
+  check_bulk<std::uint32_t, unsigned char>();
+}
+
+FATAL_TEST(bulk, i64_unsigned_short) {
+  check_bulk<std::int64_t, unsigned short>();
+}
+
 } // namespace fatal {
@@ -11,12 +11,24 @@
 #define FATAL_INCLUDE_fatal_codec_varint_h
 
 #include <fatal/math/numerics.h>
+#include <fatal/portability.h>
 
 #include <array>
 #include <iterator>
 #include <type_traits>
+#include <utility>
 
 #include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#if FATAL_HAS_SIMD_SSE2
+# include <emmintrin.h>
+#endif // FATAL_HAS_SIMD_SSE2
+
+#if FATAL_HAS_SIMD_BMI2
+# include <immintrin.h>
+#endif // FATAL_HAS_SIMD_BMI2
 
 namespace fatal {
 namespace detail {
@@ -228,6 +240,169 @@ struct value_traits<true, T> {
   }
 };
 
+// kernels used by the bulk codec on contiguous buffers of byte-sized units
+struct bulk {
+  // amount of bytes classified at once
+  using block_size = std::integral_constant<std::size_t, 16>;
+
+  // bytes that must be readable from the beginning of a block so that every
+  // value ending inside of it can be read with a single 8 byte load
+  using lookahead = std::integral_constant<std::size_t, block_size::value + 8>;
+
+  // largest encoding handled by `compact()`
+  using word_size = std::integral_constant<std::size_t, 8>;
+
+  // largest encoding of a 64 bit value
+  using max_size = std::integral_constant<std::size_t, 10>;
+
+  // little endian load of 8 bytes
+  static std::uint64_t load(unsigned char const *p) noexcept {
+    std::uint64_t word;
+    std::memcpy(std::addressof(word), p, sizeof(word));
+#   if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64(word);
+#   endif
+    return word;
+  }
+
+  // little endian store of 8 bytes
+  static void store(unsigned char *p, std::uint64_t word) noexcept {
+#   if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64(word);
+#   endif
+    std::memcpy(p, std::addressof(word), sizeof(word));
+  }
+
+  // bit `i` is set iff byte `i` of the block starting at `p` has its
+  // continuation bit set
+  static std::uint32_t continuation_mask(unsigned char const *p) noexcept {
+#   if FATAL_HAS_SIMD_SSE2
+    return static_cast<std::uint32_t>(
+      _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const *>(p)))
+    );
+#   else // FATAL_HAS_SIMD_SSE2
+    return gather_high_bits(load(p)) | (gather_high_bits(load(p + 8)) << 8);
+#   endif // FATAL_HAS_SIMD_SSE2
+  }
+
+  // concatenates the 7 bit payloads of the first `size` bytes of `word`,
+  // for `size` in [1, 8]
+  static std::uint64_t compact(std::uint64_t word, std::size_t size) noexcept {
+    assert(size > 0);
+    assert(size <= word_size::value);
+
+    auto const payload = UINT64_C(0x7f7f7f7f7f7f7f7f) & (
+      size < word_size::value
+        ? (std::uint64_t(1) << (size * 8)) - 1
+        : ~std::uint64_t(0)
+    );
+
+#   if FATAL_HAS_SIMD_BMI2
+    return _pext_u64(word, payload);
+#   else // FATAL_HAS_SIMD_BMI2
+    auto x = word & payload;
+    x = ((x & UINT64_C(0x7f007f007f007f00)) >> 1)
+      | (x & UINT64_C(0x007f007f007f007f));
+    x = ((x & UINT64_C(0x3fff00003fff0000)) >> 2)
+      | (x & UINT64_C(0x00003fff00003fff));
+    x = ((x & UINT64_C(0x0fffffff00000000)) >> 4)
+      | (x & UINT64_C(0x000000000fffffff));
+    return x;
+#   endif // FATAL_HAS_SIMD_BMI2
+  }
+
+  // the inverse of `compact()`: spreads the lowest 56 bits of `value` into
+  // 7 bit payloads, one per byte
+  static std::uint64_t expand(std::uint64_t value) noexcept {
+    assert(!(value >> (word_size::value * 7)));
+
+#   if FATAL_HAS_SIMD_BMI2
+    return _pdep_u64(value, UINT64_C(0x7f7f7f7f7f7f7f7f));
+#   else // FATAL_HAS_SIMD_BMI2
+    auto x = value;
+    x = ((x & UINT64_C(0x00fffffff0000000)) << 4)
+      | (x & UINT64_C(0x000000000fffffff));
+    x = ((x & UINT64_C(0x0fffc0000fffc000)) << 2)
+      | (x & UINT64_C(0x00003fff00003fff));
+    x = ((x & UINT64_C(0x3f803f803f803f80)) << 1)
+      | (x & UINT64_C(0x007f007f007f007f));
+    return x;
+#   endif // FATAL_HAS_SIMD_BMI2
+  }
+
+  // encodes `value` with a single 8 byte store, returning the amount of
+  // bytes taken by the encoding, as long as `value` fits in 56 bits
+  static std::size_t encode(unsigned char *p, std::uint64_t value) noexcept {
+    auto const bits = data_bits<std::uint64_t>::value
+      - count_leading_zeros(value | 1);
+    auto const size = (bits + 6) / 7;
+    assert(size <= word_size::value);
+
+    store(
+      p,
+      expand(value) | (
+        UINT64_C(0x8080808080808080)
+          & ((std::uint64_t(1) << ((size - 1) * 8)) - 1)
+      )
+    );
+
+    return size;
+  }
+
+  // decodes the value starting at `p`, which must have `available` bytes
+  // readable, at least `word_size` of them, using a single 8 byte load for
+  // encodings up to 8 bytes long
+  //
+  // returns the amount of bytes taken by the encoding or 0 if it's longer
+  // than `max_size`, or than `word_size` when less than `max_size` bytes are
+  // available
+  static std::size_t decode(
+    unsigned char const *p,
+    std::size_t available,
+    std::uint64_t &value
+  ) noexcept {
+    assert(available >= word_size::value);
+
+    // single byte encodings are common enough to skip the word load
+    if (!(p[0] & 0x80)) {
+      value = p[0];
+      return 1;
+    }
+
+    auto const word = load(p);
+    auto const terminators = ~word & UINT64_C(0x8080808080808080);
+
+    if (terminators) {
+      auto const size = count_trailing_zeros(terminators) / 8 + 1;
+      value = compact(word, size);
+      return size;
+    }
+
+    if (available < max_size::value) {
+      return 0;
+    }
+
+    value = compact(word, word_size::value)
+      | (static_cast<std::uint64_t>(p[8] & 0x7f) << 56);
+
+    if (!(p[8] & 0x80)) {
+      return 9;
+    }
+
+    value |= static_cast<std::uint64_t>(p[9]) << 63;
+    return p[9] & 0x80 ? 0 : max_size::value;
+  }
+
+private:
+  // moves the most significant bit of each byte into the lowest 8 bits
+  static std::uint32_t gather_high_bits(std::uint64_t word) noexcept {
+    return static_cast<std::uint32_t>(
+      (((word & UINT64_C(0x8080808080808080)) >> 7)
+        * UINT64_C(0x0102040810204080)) >> 56
+    );
+  }
+};
+
 } // namespace varint_impl {
 } // namespace detail {
 
@@ -318,23 +493,53 @@ public:
     type value,
     TOutputIterator out
   ) noexcept {
-    using traits = detail::varint_impl::data_traits<
-      typename std::iterator_traits<TOutputIterator>::value_type
-    >;
+    return encode_internal(value_traits::pre(value), out);
+  }
+
+  // encodes the `n` values in `values` back to back, in the same format as
+  // `encode`, returning the pointer past the last element written
+  // buffer must be able to fit at least `n * max_size<TData>` elements
+  template <typename TData>
+  static TData *encode_n(
+    type const *values,
+    std::size_t n,
+    TData *out
+  ) noexcept {
+    using traits = detail::varint_impl::data_traits<TData>;
     using unsigned_unit = typename traits::unsigned_unit;
+    using batch = std::integral_constant<std::size_t, 8>;
+    using bytes = std::integral_constant<
+      bool, std::is_integral<TData>::value && sizeof(TData) == 1
+    >;
 
-    for (internal x = value_traits::pre(value); ; std::advance(out, 1)) {
-      unsigned_unit data = x & traits::filter_mask::value;
+    // batches of values that fit in a single data unit are stored directly
+    for (; n >= batch::value; n -= batch::value, values += batch::value) {
+      internal x[batch::value];
+      std::uintmax_t any = 0;
 
-      x >>= traits::payload_size::value;
+      for (std::size_t i = 0; i < batch::value; ++i) {
+        x[i] = value_traits::pre(values[i]);
+        any |= x[i];
+      }
 
-      if (x) {
-        *out = traits::to(data | traits::continuation_bit::value);
+      if (any >> traits::payload_size::value) {
+        for (std::size_t i = 0; i < batch::value; ++i) {
+          out = encode_one(x[i], out, n - i, bytes());
+        }
       } else {
-        *out = traits::to(data);
-        return std::next(out);
+        for (std::size_t i = 0; i < batch::value; ++i) {
+          out[i] = traits::to(static_cast<unsigned_unit>(x[i]));
+        }
+
+        out += batch::value;
       }
     }
+
+    for (; n; --n, ++values) {
+      out = encode_one(value_traits::pre(*values), out, n, bytes());
+    }
+
+    return out;
   }
 
   struct decoder {
@@ -345,22 +550,21 @@ public:
       TInputIterator begin,
       TInputIterator const end
     ) noexcept {
-      using traits = detail::varint_impl::data_traits<
-        typename std::iterator_traits<TInputIterator>::value_type
-      >;
-
-      for (; continuation_ && begin != end; std::advance(begin, 1)) {
-        assert(continuation_);
-
-        value_ |= static_cast<internal>(
-          traits::from(*begin) & traits::filter_mask::value
-        ) << shift_;
-        shift_ += traits::payload_size::value;
+      return feed(begin, end);
+    }
 
-        continuation_ = traits::from(*begin) & traits::continuation_bit::value;
-      }
+    // same as above, but when a buffer of byte-sized units has at least 8
+    // bytes left and no data has been fed to this decoder yet, the whole
+    // value is decoded with a single word load instead of byte by byte
+    template <typename TData>
+    TData *operator ()(TData *begin, TData *const end) noexcept {
+      using fast = std::integral_constant<
+        bool,
+        std::is_integral<TData>::value && sizeof(TData) == 1
+          && !std::is_same<type, bool>::value
+      >;
 
-      return begin;
+      return feed(begin, end, fast());
     }
 
     // resets the internal structure of this decoder as if
@@ -384,6 +588,60 @@ public:
     explicit operator bool() const noexcept { return !continuation_; }
 
   private:
+    template <typename TInputIterator>
+    TInputIterator feed(
+      TInputIterator begin,
+      TInputIterator const end
+    ) noexcept {
+      using traits = detail::varint_impl::data_traits<
+        typename std::iterator_traits<TInputIterator>::value_type
+      >;
+
+      for (; continuation_ && begin != end; std::advance(begin, 1)) {
+        assert(continuation_);
+
+        // payload past the width of `type` is discarded from malformed input
+        if (shift_ < data_bits<internal>::value) {
+          value_ |= static_cast<internal>(
+            traits::from(*begin) & traits::filter_mask::value
+          ) << shift_;
+          shift_ += traits::payload_size::value;
+        }
+
+        continuation_ = traits::from(*begin) & traits::continuation_bit::value;
+      }
+
+      return begin;
+    }
+
+    template <typename TData>
+    TData *feed(TData *begin, TData *const end, std::false_type) noexcept {
+      return feed(begin, end);
+    }
+
+    template <typename TData>
+    TData *feed(TData *begin, TData *const end, std::true_type) noexcept {
+      using bulk = detail::varint_impl::bulk;
+
+      assert(begin <= end);
+      auto const available = static_cast<std::size_t>(end - begin);
+
+      if (continuation_ && !shift_ && available >= bulk::word_size::value) {
+        std::uint64_t value;
+        auto const size = bulk::decode(
+          reinterpret_cast<unsigned char const *>(begin), available, value
+        );
+
+        if (size) {
+          value_ = static_cast<internal>(value);
+          continuation_ = false;
+          return begin + size;
+        }
+      }
+
+      return feed(begin, end);
+    }
+
     internal value_ = 0;
     shift_counter shift_ = 0;
     bool continuation_ = true;
@@ -409,6 +667,188 @@ public:
     begin = decode(begin, end);
     return std::make_pair(decode.value(), decode.done());
   }
+
+  // decodes up to `n` values encoded back to back in `[begin, end)` into
+  // `out`, stopping early if the input ends
+  //
+  // returns the pointer past the last value decoded, along with the amount of
+  // values decoded, which is less than `n` when the input ends before that or
+  // with an incomplete value
+  //
+  // for byte-sized data units, input is classified 16 bytes at a time using
+  // SIMD when available, so that runs of single byte values are copied in
+  // bulk and the remaining values are decoded with a single word load each
+  template <typename TData>
+  static std::pair<TData const *, std::size_t> decode_n(
+    TData const *begin,
+    TData const *end,
+    type *out,
+    std::size_t n
+  ) noexcept {
+    assert(begin <= end);
+
+    using bytes = std::integral_constant<
+      bool, std::is_integral<TData>::value && sizeof(TData) == 1
+    >;
+
+    auto const result = decode_n(begin, end, out, n, bytes());
+    assert(result.first <= end);
+    assert(result.second <= n);
+    return result;
+  }
+
+private:
+  template <typename TOutputIterator>
+  static TOutputIterator encode_internal(
+    internal x,
+    TOutputIterator out
+  ) noexcept {
+    using traits = detail::varint_impl::data_traits<
+      typename std::iterator_traits<TOutputIterator>::value_type
+    >;
+    using unsigned_unit = typename traits::unsigned_unit;
+
+    for (; ; std::advance(out, 1)) {
+      unsigned_unit data = x & traits::filter_mask::value;
+
+      x >>= traits::payload_size::value;
+
+      if (x) {
+        *out = traits::to(data | traits::continuation_bit::value);
+      } else {
+        *out = traits::to(data);
+        return std::next(out);
+      }
+    }
+  }
+
+  template <typename TData>
+  static TData *encode_one(
+    internal x,
+    TData *out,
+    std::size_t,
+    std::false_type
+  ) noexcept {
+    return encode_internal(x, out);
+  }
+
+  // `left` is the amount of values still to be encoded, including `x`, which
+  // tells how much room is guaranteed to be left in the output buffer
+  template <typename TData>
+  static TData *encode_one(
+    internal x,
+    TData *out,
+    std::size_t left,
+    std::true_type
+  ) noexcept {
+    using bulk = detail::varint_impl::bulk;
+
+    auto const value = static_cast<std::uint64_t>(x);
+
+    if (left * max_size<TData>::value < bulk::word_size::value
+      || (value >> (bulk::word_size::value * 7))
+    ) {
+      return encode_internal(x, out);
+    }
+
+    return out + bulk::encode(reinterpret_cast<unsigned char *>(out), value);
+  }
+
+  template <typename TData>
+  static std::pair<TData const *, std::size_t> decode_n(
+    TData const *begin,
+    TData const *end,
+    type *out,
+    std::size_t n,
+    std::false_type
+  ) noexcept {
+    std::size_t i = 0;
+
+    for (; i < n && begin != end; ++i) {
+      decoder decode;
+      auto const next = decode(begin, end);
+
+      if (!decode.done()) {
+        break;
+      }
+
+      out[i] = decode.value();
+      begin = next;
+    }
+
+    return std::make_pair(begin, i);
+  }
+
+  template <typename TData>
+  static std::pair<TData const *, std::size_t> decode_n(
+    TData const *begin,
+    TData const *end,
+    type *out,
+    std::size_t n,
+    std::true_type
+  ) noexcept {
+    using bulk = detail::varint_impl::bulk;
+
+    auto p = reinterpret_cast<unsigned char const *>(begin);
+    auto const last = reinterpret_cast<unsigned char const *>(end);
+    std::size_t i = 0;
+
+    while (i < n
+      && static_cast<std::size_t>(last - p) >= bulk::lookahead::value
+    ) {
+      auto const mask = bulk::continuation_mask(p);
+
+      if (!mask && n - i >= bulk::block_size::value) {
+        for (std::size_t j = 0; j < bulk::block_size::value; ++j) {
+          out[i + j] = value_traits::post(static_cast<internal>(p[j]));
+        }
+
+        i += bulk::block_size::value;
+        p += bulk::block_size::value;
+        continue;
+      }
+
+      std::uint32_t terminators = ~mask & ((1u << bulk::block_size::value) - 1);
+
+      // no value ends in this block, let the scalar path deal with it
+      if (!terminators) {
+        break;
+      }
+
+      std::size_t offset = 0;
+
+      do {
+        auto const terminator = count_trailing_zeros(terminators);
+        auto const size = terminator + 1 - offset;
+
+        if (size <= bulk::word_size::value) {
+          out[i] = value_traits::post(
+            static_cast<internal>(bulk::compact(bulk::load(p + offset), size))
+          );
+        } else {
+          decoder decode;
+          decode(p + offset, p + terminator + 1);
+          assert(decode.done());
+          out[i] = decode.value();
+        }
+
+        ++i;
+        offset = terminator + 1;
+        terminators &= terminators - 1;
+      } while (terminators && i < n);
+
+      p += offset;
+    }
+
+    auto const tail = decode_n(p, last, out + i, n - i, std::false_type());
+
+    return std::make_pair(
+      std::next(begin, std::distance(
+        reinterpret_cast<unsigned char const *>(begin), tail.first
+      )),
+      i + tail.second
+    );
+  }
 };
 
 } // namespace fatal {
@@ -0,0 +1,303 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef FATAL_INCLUDE_fatal_container_arena_h
+#define FATAL_INCLUDE_fatal_container_arena_h
+
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace fatal {
+
+/////////////////////
+// monotonic_arena //
+/////////////////////
+
+/**
+ * A memory arena that hands out memory by bumping a pointer into a block, and
+ * only releases memory all at once, either when `release()` is called or when
+ * the arena is destroyed.
+ *
+ * Blocks are allocated on demand, each one twice as big as the previous one.
+ * Allocations bigger than a block get a block of their own.
+ *
+ * Optionally, a caller-provided buffer (i.e.: on the stack) can be used as the
+ * first block. Such buffer is never freed by the arena.
+ *
+ * Not thread-safe.
+ *
+ * Example:
+ *
+ *  char buffer[1024];
+ *  monotonic_arena arena(buffer, sizeof(buffer));
+ *
+ *  // served from `buffer` while there's room left in it
+ *  auto p = arena.allocate(100, alignof(double));
+ *
+ *  // frees every block allocated by the arena at once
+ *  arena.release();
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+struct monotonic_arena {
+  using size_type = std::size_t;
+
+  using default_block_size = std::integral_constant<size_type, 4096>;
+
+  /**
+   * Constructs an arena that allocates blocks starting with `block_size` bytes.
+   *
+   * No memory is allocated until the first call to `allocate()`.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  explicit monotonic_arena(size_type block_size = default_block_size::value):
+    next_block_size_(block_size ? block_size : default_block_size::value),
+    initial_block_size_(next_block_size_)
+  {}
+
+  /**
+   * Constructs an arena that serves allocations from the given `buffer` until
+   * it runs out of space, then allocates blocks starting with `block_size`.
+   *
+   * The buffer is owned by the caller and must outlive this arena.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  monotonic_arena(
+    void *buffer,
+    size_type size,
+    size_type block_size = default_block_size::value
+  ):
+    initial_(static_cast<char *>(buffer)),
+    initial_size_(size),
+    current_(initial_),
+    end_(initial_ + size),
+    next_block_size_(block_size ? block_size : default_block_size::value),
+    initial_block_size_(next_block_size_)
+  {}
+
+  monotonic_arena(monotonic_arena const &) = delete;
+  monotonic_arena &operator =(monotonic_arena const &) = delete;
+
+  ~monotonic_arena() { free_blocks(); }
+
+  /**
+   * Allocates `size` bytes aligned to `alignment`, which must be a power of
+   * two.
+   *
+   * Throws `std::bad_alloc` if memory can't be allocated.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  void *allocate(
+    size_type size,
+    size_type alignment = alignof(std::max_align_t)
+  ) {
+    assert(alignment && !(alignment & (alignment - 1)));
+
+    if (auto p = bump(size, alignment)) {
+      return p;
+    }
+
+    add_block(size, alignment);
+
+    auto const p = bump(size, alignment);
+    assert(p);
+    return p;
+  }
+
+  /**
+   * Frees all the blocks allocated by this arena at once, invalidating all
+   * memory handed out so far.
+   *
+   * The caller-provided buffer, if any, is reused for subsequent allocations.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  void release() {
+    free_blocks();
+
+    current_ = initial_;
+    end_ = initial_ + initial_size_;
+    next_block_size_ = initial_block_size_;
+    allocated_ = 0;
+  }
+
+  /**
+   * Returns the number of bytes handed out by `allocate()` since this arena
+   * was constructed or last released, not including alignment padding.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  size_type allocated() const { return allocated_; }
+
+  /**
+   * Returns the number of blocks allocated from the heap by this arena,
+   * not including the caller-provided buffer.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  size_type blocks() const { return blocks_; }
+
+private:
+  struct block {
+    block *next;
+  };
+
+  using header_size = std::integral_constant<
+    size_type, (sizeof(block) + alignof(std::max_align_t) - 1)
+      & ~(alignof(std::max_align_t) - 1)
+  >;
+
+  void *bump(size_type size, size_type alignment) {
+    auto const address = reinterpret_cast<std::uintptr_t>(current_);
+    auto const padding = (alignment - (address & (alignment - 1)))
+      & (alignment - 1);
+
+    if (!current_ || static_cast<size_type>(end_ - current_) < padding
+      || static_cast<size_type>(end_ - current_) - padding < size
+    ) {
+      return nullptr;
+    }
+
+    auto const result = current_ + padding;
+    current_ = result + size;
+    allocated_ += size;
+    return result;
+  }
+
+  void add_block(size_type size, size_type alignment) {
+    auto const limit = std::numeric_limits<size_type>::max()
+      - header_size::value - alignment;
+
+    if (size > limit) {
+      throw std::bad_alloc();
+    }
+
+    auto capacity = next_block_size_;
+
+    if (capacity < size + alignment) {
+      capacity = size + alignment;
+    }
+
+    auto const memory = static_cast<char *>(
+      ::operator new(header_size::value + capacity)
+    );
+
+    auto const b = reinterpret_cast<block *>(memory);
+    b->next = blocks_head_;
+    blocks_head_ = b;
+    ++blocks_;
+
+    current_ = memory + header_size::value;
+    end_ = current_ + capacity;
+
+    if (next_block_size_ <= std::numeric_limits<size_type>::max() / 2) {
+      next_block_size_ *= 2;
+    }
+  }
+
+  void free_blocks() {
+    while (blocks_head_) {
+      auto const next = blocks_head_->next;
+      ::operator delete(blocks_head_);
+      blocks_head_ = next;
+    }
+
+    blocks_ = 0;
+  }
+
+  char *const initial_ = nullptr;
+  size_type const initial_size_ = 0;
+  char *current_ = nullptr;
+  char *end_ = nullptr;
+  block *blocks_head_ = nullptr;
+  size_type blocks_ = 0;
+  size_type allocated_ = 0;
+  size_type next_block_size_;
+  size_type const initial_block_size_;
+};
+
+/////////////////////
+// arena_allocator //
+/////////////////////
+
+/**
+ * An STL-style allocator that allocates memory from a `monotonic_arena`.
+ *
+ * Deallocation is a no-op: memory is only reclaimed when the arena is
+ * released or destroyed, which must only happen after every object using
+ * this allocator is gone.
+ *
+ * Example:
+ *
+ *  monotonic_arena arena;
+ *  arena_allocator<int> allocator(arena);
+ *
+ *  std::vector<int, arena_allocator<int>> v(allocator);
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+template <typename T>
+struct arena_allocator {
+  using value_type = T;
+
+  explicit arena_allocator(monotonic_arena &arena) noexcept:
+    arena_(std::addressof(arena))
+  {}
+
+  template <typename U>
+  arena_allocator(arena_allocator<U> const &rhs) noexcept:
+    arena_(std::addressof(rhs.arena()))
+  {}
+
+  value_type *allocate(std::size_t n) {
+    if (n > std::numeric_limits<std::size_t>::max() / sizeof(value_type)) {
+      throw std::bad_alloc();
+    }
+
+    return static_cast<value_type *>(
+      arena_->allocate(n * sizeof(value_type), alignof(value_type))
+    );
+  }
+
+  void deallocate(value_type *, std::size_t) noexcept {}
+
+  monotonic_arena &arena() const noexcept { return *arena_; }
+
+private:
+  monotonic_arena *arena_;
+};
+
+template <typename T, typename U>
+bool operator ==(
+  arena_allocator<T> const &lhs,
+  arena_allocator<U> const &rhs
+) noexcept {
+  return std::addressof(lhs.arena()) == std::addressof(rhs.arena());
+}
+
+template <typename T, typename U>
+bool operator !=(
+  arena_allocator<T> const &lhs,
+  arena_allocator<U> const &rhs
+) noexcept {
+  return !(lhs == rhs);
+}
+
+} // namespace fatal {
+
+#endif // FATAL_INCLUDE_fatal_container_arena_h
@@ -0,0 +1,94 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/container/circular_queue.h>
+
+#include <fatal/benchmark/driver.h>
+
+#include <vector>
+
+#include <cstdint>
+
+namespace fatal {
+
+using window = std::integral_constant<std::size_t, 1000>;
+using burst = std::integral_constant<std::size_t, 64>;
+
+// keeps a window of in-flight sequence numbers, looking them up by index
+// like a packet reordering buffer would
+template <typename TPolicy>
+std::uint64_t reorder(std::size_t n) {
+  circular_queue<std::uint64_t, TPolicy> q(window::value);
+  std::uint64_t sum = 0;
+
+  for (std::size_t i = 0; i < window::value; ++i) {
+    q.push_back(i);
+  }
+
+  for (std::size_t i = 0; i < n; ++i) {
+    sum += q[(i * 7) % q.size()];
+    q.pop_front();
+    q.push_back(i);
+  }
+
+  return sum;
+}
+
+FATAL_BENCHMARK(reorder, default_capacity, n) {
+  prevent_optimization(reorder<default_capacity_policy>(n));
+}
+
+FATAL_BENCHMARK(reorder, power_of_two_capacity, n) {
+  prevent_optimization(reorder<power_of_two_capacity_policy>(n));
+}
+
+std::vector<std::uint64_t> const burst_values(burst::value, 42);
+
+// moves bursts of elements in and out of the queue
+template <typename TPolicy, bool Bulk>
+std::size_t bursts(std::size_t n) {
+  circular_queue<std::uint64_t, TPolicy> q(window::value);
+  auto const begin = burst_values.data();
+  auto const end = begin + burst_values.size();
+
+  for (std::size_t i = 0; i < n; ++i) {
+    if (Bulk) {
+      q.append(begin, end);
+      q.erase_front(burst::value);
+    } else {
+      for (auto j = begin; j != end; ++j) {
+        q.push_back(*j);
+      }
+
+      for (auto j = burst::value; j--; ) {
+        q.pop_front();
+      }
+    }
+  }
+
+  return q.size();
+}
+
+FATAL_BENCHMARK(bursts, default_capacity, n) {
+  prevent_optimization(bursts<default_capacity_policy, false>(n));
+}
+
+FATAL_BENCHMARK(bursts, power_of_two_capacity, n) {
+  prevent_optimization(bursts<power_of_two_capacity_policy, false>(n));
+}
+
+FATAL_BENCHMARK(bursts, default_capacity_bulk, n) {
+  prevent_optimization(bursts<default_capacity_policy, true>(n));
+}
+
+FATAL_BENCHMARK(bursts, power_of_two_capacity_bulk, n) {
+  prevent_optimization(bursts<power_of_two_capacity_policy, true>(n));
+}
+
+} // namespace fatal {
@@ -0,0 +1,180 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/container/circular_queue.h>
+#include <fatal/container/concurrent_circular_queue.h>
+
+#include <fatal/benchmark/driver.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <cstdint>
+
+namespace fatal {
+
+using capacity = std::integral_constant<std::size_t, 1024>;
+using batch_size = std::integral_constant<std::size_t, 32>;
+
+// the baseline: a `circular_queue` protected by a mutex
+template <typename T>
+class locked_queue {
+  using lock_guard = std::lock_guard<std::mutex>;
+
+public:
+  explicit locked_queue(std::size_t capacity): capacity_(capacity) {}
+
+  bool try_push(T const &value) {
+    lock_guard lock(mutex_);
+
+    if (queue_.size() == capacity_) {
+      return false;
+    }
+
+    queue_.push_back(value);
+    return true;
+  }
+
+  bool try_pop(T &out) {
+    lock_guard lock(mutex_);
+
+    if (queue_.empty()) {
+      return false;
+    }
+
+    out = std::move(queue_.front());
+    queue_.pop_front();
+    return true;
+  }
+
+  std::size_t push_n(T const *begin, std::size_t n) {
+    lock_guard lock(mutex_);
+    auto const count = std::min(n, capacity_ - queue_.size());
+
+    for (std::size_t i = 0; i < count; ++i) {
+      queue_.push_back(begin[i]);
+    }
+
+    return count;
+  }
+
+  std::size_t pop_n(T *out, std::size_t n) {
+    lock_guard lock(mutex_);
+    auto const count = std::min(n, queue_.size());
+
+    for (std::size_t i = 0; i < count; ++i) {
+      out[i] = std::move(queue_.front());
+      queue_.pop_front();
+    }
+
+    return count;
+  }
+
+private:
+  std::size_t const capacity_;
+  std::mutex mutex_;
+  circular_queue<T> queue_;
+};
+
+// moves `n` elements through the queue, from `threads` producers into as many
+// consumers, returning the sum of all elements received
+template <typename Queue, bool Batch>
+std::uint64_t transfer(std::size_t threads, std::size_t n) {
+  Queue q(capacity::value);
+  std::atomic<std::uint64_t> sum(0);
+  std::vector<std::thread> workers;
+
+  for (std::size_t t = 0; t < threads; ++t) {
+    auto const count = n / threads + (t < n % threads);
+
+    workers.emplace_back([&q, count] {
+      std::uint64_t batch[batch_size::value];
+
+      for (std::size_t i = 0; i < count; ) {
+        std::size_t pushed;
+
+        if (Batch) {
+          auto const size = std::min(batch_size::value, count - i);
+
+          for (std::size_t j = 0; j < size; ++j) {
+            batch[j] = i + j;
+          }
+
+          pushed = q.push_n(batch, size);
+        } else {
+          pushed = q.try_push(i);
+        }
+
+        if (pushed) {
+          i += pushed;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+
+    workers.emplace_back([&q, &sum, count] {
+      std::uint64_t batch[batch_size::value];
+      std::uint64_t local = 0;
+
+      for (std::size_t i = 0; i < count; ) {
+        auto const popped = Batch
+          ? q.pop_n(batch, std::min(batch_size::value, count - i))
+          : q.try_pop(batch[0]);
+
+        if (!popped) {
+          std::this_thread::yield();
+          continue;
+        }
+
+        for (std::size_t j = 0; j < popped; ++j) {
+          local += batch[j];
+        }
+
+        i += popped;
+      }
+
+      sum += local;
+    });
+  }
+
+  for (auto &i: workers) {
+    i.join();
+  }
+
+  return sum.load();
+}
+
+#define BENCHMARK_QUEUE(Name, Queue, Threads) \
+  FATAL_BENCHMARK(Name, threads_##Threads, n) { \
+    prevent_optimization(transfer<Queue, false>(Threads, n)); \
+  } \
+  \
+  FATAL_BENCHMARK(Name##_batch, threads_##Threads, n) { \
+    prevent_optimization(transfer<Queue, true>(Threads, n)); \
+  }
+
+using mutex_queue = locked_queue<std::uint64_t>;
+
+BENCHMARK_QUEUE(mutex, mutex_queue, 1)
+BENCHMARK_QUEUE(mutex, mutex_queue, 2)
+BENCHMARK_QUEUE(mutex, mutex_queue, 4)
+
+BENCHMARK_QUEUE(spsc, spsc_circular_queue<std::uint64_t>, 1)
+
+BENCHMARK_QUEUE(mpmc, mpmc_circular_queue<std::uint64_t>, 1)
+BENCHMARK_QUEUE(mpmc, mpmc_circular_queue<std::uint64_t>, 2)
+BENCHMARK_QUEUE(mpmc, mpmc_circular_queue<std::uint64_t>, 4)
+
+#undef BENCHMARK_QUEUE
+
+} // namespace fatal {
@@ -0,0 +1,213 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/container/dynamic_bitset.h>
+
+#include <fatal/benchmark/driver.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <cstddef>
+
+namespace fatal {
+
+using bits = std::integral_constant<std::size_t, 1 << 22>;
+using queries = std::integral_constant<std::size_t, 1024>;
+
+// roughly a quarter of the bits are set
+struct data {
+  data(): bitset(bits::value), other(bits::value), plain(bits::value) {
+    std::mt19937_64 rng(0);
+
+    for (std::size_t i = 0; i < bits::value; ++i) {
+      auto const value = rng() % 4 == 0;
+      bitset.assign(i, value);
+      plain[i] = value;
+      other.assign(i, rng() % 2);
+    }
+
+    bitset.build_index();
+
+    auto const count = bitset.count();
+
+    for (std::size_t i = 0; i < queries::value; ++i) {
+      positions.push_back(rng() % bits::value);
+      ranks.push_back(rng() % count);
+    }
+  }
+
+  dynamic_bitset bitset;
+  dynamic_bitset other;
+  std::vector<bool> plain;
+  std::vector<std::size_t> positions;
+  std::vector<std::size_t> ranks;
+};
+
+// built before the benchmarks run, so that it's not accounted for
+data const benchmark_data;
+
+// read through a volatile pointer so that queries aren't hoisted out of the
+// benchmark loops
+data const *volatile source = &benchmark_data;
+
+// keeps the results of the queries alive
+std::size_t volatile sink;
+
+FATAL_BENCHMARK(count, vector_bool, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    auto const &plain = source->plain;
+    result += static_cast<std::size_t>(
+      std::count(plain.begin(), plain.end(), true)
+    );
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(count, dynamic_bitset, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += source->bitset.count();
+  }
+
+  sink = result;
+}
+
+// the number of bits set before each position, without an index
+FATAL_BENCHMARK(rank, scan, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    auto const &bitset = source->bitset;
+
+    for (std::size_t i = 0; i < 16; ++i) {
+      auto const position = source->positions[i];
+      auto const words = position / 64;
+
+      for (std::size_t w = 0; w < words; ++w) {
+        result += population_count(bitset.data()[w]);
+      }
+
+      if (position % 64) {
+        result += population_count(
+          bitset.data()[words] & ((std::uint64_t(1) << (position % 64)) - 1)
+        );
+      }
+    }
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(rank, dynamic_bitset, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    auto const &bitset = source->bitset;
+
+    for (std::size_t i = 0; i < 16; ++i) {
+      result += bitset.rank(source->positions[i]);
+    }
+  }
+
+  sink = result;
+}
+
+// the position of each set bit with a given rank, without an index
+FATAL_BENCHMARK(select, scan, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    auto const &bitset = source->bitset;
+
+    for (std::size_t i = 0; i < 16; ++i) {
+      auto rank = source->ranks[i];
+      std::size_t w = 0;
+
+      for (;; ++w) {
+        auto const count = population_count(bitset.data()[w]);
+
+        if (rank < count) {
+          break;
+        }
+
+        rank -= count;
+      }
+
+      auto word = bitset.data()[w];
+
+      for (; rank; --rank) {
+        word &= word - 1;
+      }
+
+      result += w * 64 + count_trailing_zeros(word);
+    }
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(select, dynamic_bitset, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    auto const &bitset = source->bitset;
+
+    for (std::size_t i = 0; i < 16; ++i) {
+      result += bitset.select(source->ranks[i]);
+    }
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(build_index, dynamic_bitset, n) {
+  auto bitset = benchmark_data.bitset;
+
+  while (n--) {
+    bitset.build_index();
+  }
+
+  sink = bitset.rank(bitset.size());
+}
+
+FATAL_BENCHMARK(and_not, vector_bool, n) {
+  auto lhs = benchmark_data.plain;
+  std::vector<bool> rhs(bits::value);
+
+  for (std::size_t i = 0; i < bits::value; ++i) {
+    rhs[i] = benchmark_data.other[i];
+  }
+
+  while (n--) {
+    for (std::size_t i = 0; i < bits::value; ++i) {
+      lhs[i] = lhs[i] && !rhs[i];
+    }
+  }
+
+  sink = lhs.size();
+}
+
+FATAL_BENCHMARK(and_not, dynamic_bitset, n) {
+  auto lhs = benchmark_data.bitset;
+  auto const &rhs = benchmark_data.other;
+
+  while (n--) {
+    lhs.and_not(rhs);
+  }
+
+  sink = lhs.count();
+}
+
+} // namespace fatal {
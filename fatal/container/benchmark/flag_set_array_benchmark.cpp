@@ -0,0 +1,212 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/container/flag_set_array.h>
+
+#include <fatal/benchmark/driver.h>
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include <cstddef>
+
+namespace fatal {
+
+struct f0 {};
+struct f1 {};
+struct f2 {};
+struct f3 {};
+struct f4 {};
+struct f5 {};
+
+using row_flags = flag_set<f0, f1, f2, f3, f4, f5>;
+using row_flags_array = flag_set_array<f0, f1, f2, f3, f4, f5>;
+
+using rows = std::integral_constant<std::size_t, 1 << 16>;
+
+// each flag is set for roughly half of the rows
+struct data {
+  data(): array(rows::value) {
+    std::mt19937 rng(0);
+    plain.reserve(rows::value);
+
+    for (std::size_t i = 0; i < rows::value; ++i) {
+      auto const bits = rng();
+      row_flags value;
+      value.set_if<f0>(bits & 1);
+      value.set_if<f1>(bits & 2);
+      value.set_if<f2>(bits & 4);
+      value.set_if<f3>(bits & 8);
+      value.set_if<f4>(bits & 16);
+      value.set_if<f5>(bits & 32);
+
+      plain.push_back(value);
+      array.assign(i, value);
+    }
+  }
+
+  std::vector<row_flags> plain;
+  row_flags_array array;
+};
+
+// built before the benchmarks run, so that it's not accounted for
+data const benchmark_data;
+
+// read through a volatile pointer so that queries aren't hoisted out of the
+// benchmark loops
+data const *volatile source = &benchmark_data;
+
+// keeps the results of the queries alive
+std::size_t volatile sink;
+
+template <typename... UFlags>
+std::size_t plain_count_if(std::vector<row_flags> const &plain) {
+  std::size_t result = 0;
+
+  for (auto const &i: plain) {
+    result += i.test<UFlags...>();
+  }
+
+  return result;
+}
+
+template <typename... UFlags>
+void plain_select(
+  std::vector<row_flags> const &plain,
+  std::vector<std::size_t> &out
+) {
+  out.clear();
+
+  for (std::size_t i = 0; i < plain.size(); ++i) {
+    if (plain[i].test<UFlags...>()) {
+      out.push_back(i);
+    }
+  }
+}
+
+FATAL_BENCHMARK(count_if_1, flag_set_test, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += plain_count_if<f2>(source->plain);
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(count_if_1, flag_set_array, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += source->array.count_if<f2>();
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(count_if_3, flag_set_test, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += plain_count_if<f0, f3, f5>(source->plain);
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(count_if_3, flag_set_array, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += source->array.count_if<f0, f3, f5>();
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(select_indexes, flag_set_test, n) {
+  std::vector<std::size_t> out;
+  out.reserve(rows::value);
+
+  while (n--) {
+    plain_select<f0, f3, f5>(source->plain, out);
+  }
+
+  prevent_optimization(out.size());
+}
+
+FATAL_BENCHMARK(select_indexes, flag_set_array, n) {
+  std::vector<std::size_t> out;
+  out.reserve(rows::value);
+
+  while (n--) {
+    out.clear();
+    source->array.select_indexes<f0, f3, f5>(std::back_inserter(out));
+  }
+
+  prevent_optimization(out.size());
+}
+
+FATAL_BENCHMARK(select_bitmap, flag_set_test, n) {
+  std::vector<row_flags_array::word_type> out(rows::value / 64);
+
+  while (n--) {
+    auto const &plain = source->plain;
+    std::fill(out.begin(), out.end(), 0);
+
+    for (std::size_t i = 0; i < plain.size(); ++i) {
+      out[i / 64] |= row_flags_array::word_type(
+        plain[i].test<f0, f3, f5>()
+      ) << (i % 64);
+    }
+  }
+
+  prevent_optimization(out.back());
+}
+
+FATAL_BENCHMARK(select_bitmap, flag_set_array, n) {
+  std::vector<row_flags_array::word_type> out;
+
+  while (n--) {
+    source->array.select<f0, f3, f5>(out);
+  }
+
+  prevent_optimization(out.back());
+}
+
+FATAL_BENCHMARK(set_range, flag_set_test, n) {
+  auto plain = benchmark_data.plain;
+
+  while (n--) {
+    for (std::size_t i = 100; i < plain.size() - 100; ++i) {
+      plain[i].set<f1, f4>();
+    }
+
+    for (std::size_t i = 100; i < plain.size() - 100; ++i) {
+      plain[i].reset<f1, f4>();
+    }
+  }
+
+  prevent_optimization(plain.back().get());
+}
+
+FATAL_BENCHMARK(set_range, flag_set_array, n) {
+  auto array = benchmark_data.array;
+
+  while (n--) {
+    array.set<f1, f4>(100, array.size() - 100);
+    array.reset<f1, f4>(100, array.size() - 100);
+  }
+
+  prevent_optimization(array[array.size() - 1].get());
+}
+
+} // namespace fatal {
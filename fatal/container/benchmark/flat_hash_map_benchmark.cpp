@@ -0,0 +1,244 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/container/flat_hash_map.h>
+
+#include <fatal/benchmark/driver.h>
+
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <cstddef>
+
+namespace fatal {
+
+using keys = std::integral_constant<std::size_t, 1 << 14>;
+
+// keys of 8 to 40 characters, and as many keys known not to be in the maps
+struct data {
+  data() {
+    std::mt19937_64 rng(0);
+
+    auto const make = [&rng]() {
+      std::string key(8 + rng() % 33, '\0');
+
+      for (auto &c: key) {
+        c = static_cast<char>('a' + rng() % 26);
+      }
+
+      return key;
+    };
+
+    for (std::size_t i = 0; i < keys::value; ++i) {
+      hits.push_back(make());
+      // upper case letters never show up in `hits`
+      misses.push_back(make());
+      misses.back().front() = 'A';
+    }
+
+    for (std::size_t i = 0; i < keys::value; ++i) {
+      flat[hits[i]] = i;
+      unordered[hits[i]] = i;
+    }
+  }
+
+  std::vector<std::string> hits;
+  std::vector<std::string> misses;
+  flat_hash_map<std::string, std::size_t> flat;
+  std::unordered_map<std::string, std::size_t> unordered;
+};
+
+// built before the benchmarks run, so that it's not accounted for
+data const benchmark_data;
+
+// read through a volatile pointer so that lookups aren't hoisted out of the
+// benchmark loops
+data const *volatile source = &benchmark_data;
+
+// keeps the results of the lookups alive
+std::size_t volatile sink;
+
+////////////
+// insert //
+////////////
+
+FATAL_BENCHMARK(insert, std_unordered_map, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    std::unordered_map<std::string, std::size_t> map;
+
+    for (auto const &key: source->hits) {
+      map[key] = result;
+    }
+
+    result += map.size();
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(insert, flat_hash_map, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    flat_hash_map<std::string, std::size_t> map;
+
+    for (auto const &key: source->hits) {
+      map[key] = result;
+    }
+
+    result += map.size();
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(insert, flat_hash_map_arena, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    monotonic_arena arena;
+    flat_hash_map<string_view, std::size_t> map(arena);
+
+    for (auto const &key: source->hits) {
+      map[key] = result;
+    }
+
+    result += map.size();
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(insert, flat_hash_map_reserved, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    flat_hash_map<std::string, std::size_t> map(keys::value);
+
+    for (auto const &key: source->hits) {
+      map[key] = result;
+    }
+
+    result += map.size();
+  }
+
+  sink = result;
+}
+
+////////////////
+// lookup_hit //
+////////////////
+
+FATAL_BENCHMARK(lookup_hit, std_unordered_map, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    auto const &map = source->unordered;
+
+    for (auto const &key: source->hits) {
+      result += map.find(key)->second;
+    }
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(lookup_hit, flat_hash_map, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    auto const &map = source->flat;
+
+    for (auto const &key: source->hits) {
+      result += map.find(key)->second;
+    }
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(lookup_hit, flat_hash_map_string_view, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    auto const &map = source->flat;
+
+    for (auto const &key: source->hits) {
+      result += map.find(string_view(key))->second;
+    }
+  }
+
+  sink = result;
+}
+
+/////////////////
+// lookup_miss //
+/////////////////
+
+FATAL_BENCHMARK(lookup_miss, std_unordered_map, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    auto const &map = source->unordered;
+
+    for (auto const &key: source->misses) {
+      result += map.count(key);
+    }
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(lookup_miss, flat_hash_map, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    auto const &map = source->flat;
+
+    for (auto const &key: source->misses) {
+      result += map.count(key);
+    }
+  }
+
+  sink = result;
+}
+
+/////////////
+// iterate //
+/////////////
+
+FATAL_BENCHMARK(iterate, std_unordered_map, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    for (auto const &i: source->unordered) {
+      result += i.second;
+    }
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(iterate, flat_hash_map, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    for (auto const &i: source->flat) {
+      result += i.second;
+    }
+  }
+
+  sink = result;
+}
+
+} // namespace fatal {
@@ -0,0 +1,113 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/container/mirrored_ring_buffer.h>
+#include <fatal/string/tokenizer.h>
+#include <fatal/type/sequence.h>
+
+#include <fatal/benchmark/driver.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+
+#include <cstring>
+
+namespace fatal {
+
+using read_size = std::integral_constant<std::size_t, 4096>;
+
+// lines of random length, as if read from a socket
+std::string make_input() {
+  std::mt19937 rng(read_size::value);
+  std::string result;
+
+  while (result.size() < (1 << 20)) {
+    result.append(20 + rng() % 200, 'x');
+    result.push_back('\n');
+  }
+
+  return result;
+}
+
+std::string const input(make_input());
+
+// simulates `read()` by copying the next chunk of the input to `out`
+std::size_t read_chunk(std::size_t &offset, char *out, std::size_t size) {
+  size = std::min(std::min(size, read_size::value), input.size() - offset);
+  std::memcpy(out, input.data() + offset, size);
+  offset += size;
+  return size;
+}
+
+// the lines are tokenized straight out of the ring buffer
+FATAL_BENCHMARK(read_lines, mirrored_ring_buffer, n) {
+  mirrored_ring_buffer buffer(read_size::value * 4);
+  std::size_t total = 0;
+
+  while (n--) {
+    for (std::size_t offset = 0; offset < input.size(); ) {
+      buffer.commit(read_chunk(offset, buffer.writable(), buffer.available()));
+      buffer.consume_tokens<line_tokenizer>(
+        [&](string_view line) { total += line.size(); }
+      );
+    }
+  }
+
+  prevent_optimization(total);
+}
+
+// the trailing partial line is moved to the front of the buffer after each
+// read
+FATAL_BENCHMARK(read_lines, compacting_buffer, n) {
+  std::string buffer(read_size::value * 4, '\0');
+  std::size_t total = 0;
+
+  while (n--) {
+    std::size_t size = 0;
+
+    for (std::size_t offset = 0; offset < input.size(); ) {
+      size += read_chunk(offset, &buffer[size], buffer.size() - size);
+
+      string_view data(buffer.data(), size);
+      for (auto i = data.find('\n'); i != data.end(); i = data.find('\n')) {
+        total += static_cast<std::size_t>(i - data.begin());
+        data.reset(std::next(i));
+      }
+
+      size = data.size();
+      std::memmove(&buffer[0], data.data(), size);
+    }
+  }
+
+  prevent_optimization(total);
+}
+
+// lines split across reads are stitched together by the tokenizer
+FATAL_BENCHMARK(read_lines, stream_tokenizer, n) {
+  std::string buffer(read_size::value * 4, '\0');
+  stream_tokenizer<sequence<char, '\n'>> tokenizer;
+  std::size_t total = 0;
+
+  while (n--) {
+    for (std::size_t offset = 0; offset < input.size(); ) {
+      auto const size = read_chunk(offset, &buffer[0], buffer.size());
+      tokenizer(
+        string_view(buffer.data(), size),
+        [&](string_view line) { total += line.size(); }
+      );
+    }
+
+    tokenizer.finish([&](string_view line) { total += line.size(); });
+  }
+
+  prevent_optimization(total);
+}
+
+} // namespace fatal {
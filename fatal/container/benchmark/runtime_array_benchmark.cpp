@@ -0,0 +1,94 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/container/arena.h>
+#include <fatal/container/runtime_array.h>
+
+#include <fatal/benchmark/driver.h>
+
+#include <vector>
+
+#include <cstdint>
+
+namespace fatal {
+
+// per-request scratch arrays of varying sizes
+using sizes = std::integral_constant<std::size_t, 64>;
+
+std::size_t scratch_size(std::size_t i) { return 8 + (i * 37) % 200; }
+
+template <typename Array>
+std::uint64_t use(Array &scratch) {
+  auto const data = scratch.data();
+  auto const size = scratch.size();
+
+  for (std::size_t i = 0; i < size; ++i) {
+    data[i] = static_cast<std::uint64_t>(i);
+  }
+
+  return data[size / 2];
+}
+
+FATAL_BENCHMARK(scratch, std_vector, n) {
+  std::uint64_t sum = 0;
+
+  while (n--) {
+    std::vector<std::uint64_t> scratch(scratch_size(n % sizes::value));
+    sum += use(scratch);
+  }
+
+  prevent_optimization(sum);
+}
+
+FATAL_BENCHMARK(scratch, runtime_array, n) {
+  std::uint64_t sum = 0;
+
+  while (n--) {
+    runtime_array<std::uint64_t, 32> scratch(scratch_size(n % sizes::value));
+    sum += use(scratch);
+  }
+
+  prevent_optimization(sum);
+}
+
+FATAL_BENCHMARK(scratch, runtime_array_arena, n) {
+  using allocator = arena_allocator<std::uint64_t>;
+
+  char buffer[64 * 1024];
+  monotonic_arena arena(buffer, sizeof(buffer));
+  std::uint64_t sum = 0;
+
+  while (n--) {
+    {
+      runtime_array<std::uint64_t, 32, allocator> scratch(
+        scratch_size(n % sizes::value), allocator(arena)
+      );
+      sum += use(scratch);
+    }
+
+    // a request is done
+    arena.release();
+  }
+
+  prevent_optimization(sum);
+}
+
+FATAL_BENCHMARK(scratch, runtime_array_reused, n) {
+  runtime_array<std::uint64_t, 32> scratch(0);
+  std::uint64_t sum = 0;
+
+  while (n--) {
+    scratch.resize(scratch_size(n % sizes::value));
+    sum += use(scratch);
+  }
+
+  prevent_optimization(sum);
+}
+
+} // namespace fatal {
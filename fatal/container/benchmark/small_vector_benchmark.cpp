@@ -0,0 +1,169 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/container/small_vector.h>
+
+#include <fatal/benchmark/driver.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+
+namespace fatal {
+
+// keeps the results alive
+std::size_t volatile sink;
+
+// a value that the compiler can't assume to be constant
+std::size_t volatile seed = 1;
+
+template <typename Vector>
+std::size_t push_back(std::size_t count) {
+  Vector v;
+  auto const value = seed;
+
+  for (std::size_t i = 0; i < count; ++i) {
+    v.push_back(value + i);
+  }
+
+  std::size_t result = 0;
+
+  for (auto i: v) {
+    result += i;
+  }
+
+  return result;
+}
+
+FATAL_BENCHMARK(push_back_8, std_vector, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += push_back<std::vector<std::size_t>>(8);
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(push_back_8, small_vector, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += push_back<small_vector<std::size_t, 8>>(8);
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(push_back_100, std_vector, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += push_back<std::vector<std::size_t>>(100);
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(push_back_100, small_vector, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += push_back<small_vector<std::size_t, 8>>(100);
+  }
+
+  sink = result;
+}
+
+// heap allocated elements which aren't trivially copyable, but are trivially
+// relocatable
+using pointer = std::unique_ptr<std::size_t>;
+
+template <>
+struct is_trivially_relocatable<pointer>: std::true_type {};
+
+template <typename Vector>
+std::size_t insert_front(std::size_t count) {
+  Vector v;
+
+  for (std::size_t i = 0; i < count; ++i) {
+    v.insert(v.begin(), pointer(new std::size_t(seed + i)));
+  }
+
+  std::size_t result = 0;
+
+  for (auto const &i: v) {
+    result += *i;
+  }
+
+  return result;
+}
+
+FATAL_BENCHMARK(insert_front_64, std_vector, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += insert_front<std::vector<pointer>>(64);
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(insert_front_64, small_vector, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += insert_front<small_vector<pointer, 8>>(64);
+  }
+
+  sink = result;
+}
+
+template <typename Vector>
+std::size_t erase_front(std::size_t count) {
+  Vector v;
+  v.reserve(count);
+
+  for (std::size_t i = 0; i < count; ++i) {
+    v.emplace_back(std::to_string(seed + i));
+  }
+
+  std::size_t result = 0;
+
+  while (!v.empty()) {
+    result += v.front().size();
+    v.erase(v.begin());
+  }
+
+  return result;
+}
+
+FATAL_BENCHMARK(erase_front_64_strings, std_vector, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += erase_front<std::vector<std::string>>(64);
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(erase_front_64_strings, small_vector, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += erase_front<small_vector<std::string, 8>>(64);
+  }
+
+  sink = result;
+}
+
+} // namespace fatal {
@@ -0,0 +1,279 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/container/variant.h>
+
+#include <fatal/container/arena.h>
+
+#include <fatal/benchmark/driver.h>
+
+#include <memory>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include <cstddef>
+
+namespace fatal {
+
+using values = std::integral_constant<std::size_t, 1 << 12>;
+
+template <std::size_t>
+struct alternative {
+  std::size_t value;
+};
+
+template <typename> struct indexed_variant;
+
+template <std::size_t... Indexes>
+struct indexed_variant<index_sequence<Indexes...>> {
+  using type = auto_variant<alternative<Indexes>...>;
+};
+
+// the unions used by a variant of `Size` alternatives, each storing a value
+// of a type picked at random
+template <std::size_t Size>
+struct data {
+  using traits = typename indexed_variant<
+    make_index_sequence<Size>
+  >::type::traits;
+  using size_type = typename traits::size_type;
+  using union_type = typename traits::union_type;
+
+  data(): unions(new union_type[values::value]) {
+    std::mt19937_64 rng(Size);
+
+    for (std::size_t i = 0; i < values::value; ++i) {
+      tags.push_back(static_cast<size_type>(rng() % Size));
+      construct<0>(tags.back(), unions[i], i);
+    }
+  }
+
+  std::vector<size_type> tags;
+  std::unique_ptr<union_type[]> unions;
+
+private:
+  template <std::size_t Index>
+  static typename std::enable_if<(Index < Size)>::type construct(
+    size_type tag, union_type &u, std::size_t value
+  ) {
+    using type = alternative<Index>;
+
+    if (tag == Index) {
+      traits::template construct<type>(nullptr, tag, u, type{value});
+    } else {
+      construct<Index + 1>(tag, u, value);
+    }
+  }
+
+  template <std::size_t Index>
+  static typename std::enable_if<(Index == Size)>::type construct(
+    size_type, union_type &, std::size_t
+  ) {}
+};
+
+struct all_data {
+  data<2> small;
+  data<8> medium;
+  data<32> large;
+  data<64> huge;
+};
+
+// built before the benchmarks run, so that it's not accounted for
+all_data const benchmark_data;
+
+// read through a volatile pointer so that visits aren't hoisted out of the
+// benchmark loops
+all_data const *volatile source = &benchmark_data;
+
+// keeps the results of the visits alive
+std::size_t volatile sink;
+
+// does something different for each alternative, so that the compiler can't
+// merge the visits into a single branchless expression
+struct hash_visitor {
+  template <std::size_t Index>
+  void operator ()(alternative<Index> const &value, std::size_t &out) const {
+    out = out * (Index + 3) + value.value;
+  }
+};
+
+// the original dispatch, comparing the tag against each alternative in turn
+template <typename Data>
+std::size_t recursive(Data const &d) {
+  std::size_t result = 0;
+
+  for (std::size_t i = 0; i < values::value; ++i) {
+    Data::traits::visit(d.tags[i], d.unions[i], hash_visitor(), result);
+  }
+
+  return result;
+}
+
+template <typename Data>
+std::size_t dispatch(Data const &d) {
+  std::size_t result = 0;
+
+  for (std::size_t i = 0; i < values::value; ++i) {
+    Data::traits::dispatch(d.tags[i], d.unions[i], hash_visitor(), result);
+  }
+
+  return result;
+}
+
+/////////////
+// visit_2 //
+/////////////
+
+// `dispatch` falls back to `visit` for unions of up to `dispatch_threshold`
+// types (8), so only `visit` is measured here and in `visit_8`
+
+FATAL_BENCHMARK(visit_2, recursive, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += recursive(source->small);
+  }
+
+  sink = result;
+}
+
+/////////////
+// visit_8 //
+/////////////
+
+FATAL_BENCHMARK(visit_8, recursive, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += recursive(source->medium);
+  }
+
+  sink = result;
+}
+
+//////////////
+// visit_32 //
+//////////////
+
+FATAL_BENCHMARK(visit_32, recursive, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += recursive(source->large);
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(visit_32, dispatch, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += dispatch(source->large);
+  }
+
+  sink = result;
+}
+
+//////////////
+// visit_64 //
+//////////////
+
+FATAL_BENCHMARK(visit_64, recursive, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += recursive(source->huge);
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(visit_64, dispatch, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += dispatch(source->huge);
+  }
+
+  sink = result;
+}
+
+////////////
+// assign //
+////////////
+
+// assigns values of alternating types to a variant whose types are all
+// dynamically allocated - the variants start with a value, so that only the
+// steady state is measured
+template <typename Variant>
+std::size_t assign(Variant &v) {
+  std::size_t result = 0;
+
+  for (std::size_t i = 0; i < values::value; i += 4) {
+    result += v.template emplace<alternative<0>>(alternative<0>{i}).value;
+    result += v.template emplace<alternative<1>>(alternative<1>{i}).value;
+    result += v.template emplace<alternative<2>>(alternative<2>{i}).value;
+    result += v.template emplace<alternative<3>>(alternative<3>{i}).value;
+  }
+
+  return result;
+}
+
+template <typename StoragePolicy>
+using assign_variant = variant<
+  StoragePolicy,
+  alternative<0>, alternative<1>, alternative<2>, alternative<3>
+>;
+
+FATAL_BENCHMARK(assign, legacy_storage_policy, n) {
+  std::allocator<void> allocator;
+  assign_variant<
+    legacy_storage_policy<std::allocator<void>, dynamic_allocation_policy>
+  > v(allocator, alternative<3>{0});
+  std::size_t result = 0;
+
+  while (n--) {
+    result += assign(v);
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(assign, block_reuse_storage_policy, n) {
+  std::allocator<void> allocator;
+  assign_variant<
+    block_reuse_storage_policy<std::allocator<void>, dynamic_allocation_policy>
+  > v(allocator, alternative<3>{0});
+  std::size_t result = 0;
+
+  while (n--) {
+    result += assign(v);
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(assign, block_reuse_storage_policy_arena, n) {
+  monotonic_arena arena;
+  arena_allocator<void> allocator(arena);
+  assign_variant<
+    block_reuse_storage_policy<arena_allocator<void>, dynamic_allocation_policy>
+  > v(allocator, alternative<3>{0});
+  std::size_t result = 0;
+
+  while (n--) {
+    result += assign(v);
+  }
+
+  sink = result;
+}
+
+} // namespace fatal {
@@ -25,24 +25,98 @@
 #include <vector>
 
 #include <cassert>
+#include <cstring>
 
 FATAL_DIAGNOSTIC_PUSH
 FATAL_GCC_DIAGNOSTIC_IGNORED_SHADOW_IF_BROKEN
 
 namespace fatal {
+namespace detail {
+namespace circular_queue_impl {
 
-// TODO: shrink_to_fit, pop_back, prevent growth (T4534263)
+// an uninitialized slot for an element, whose lifetime is managed by the
+// queue holding it
 template <typename T>
+union item {
+  item() noexcept {}
+  item(item const &) noexcept {}
+  item(item &&) noexcept {}
+  ~item() noexcept {}
+  T value;
+};
+
+} // namespace circular_queue_impl {
+} // namespace detail {
+
+/**
+ * Capacity policies for `circular_queue`, deciding how many slots to allocate
+ * and how an index wraps around them.
+ *
+ * `default_capacity_policy` allocates exactly the capacity requested and
+ * doubles it whenever the queue is full. Wrapping an index takes a comparison
+ * and a subtraction.
+ *
+ * `power_of_two_capacity_policy` rounds the capacity up to a power of two,
+ * which doubling preserves, so that wrapping an index takes a single mask.
+ *
+ * Example:
+ *
+ *  // yields `8`
+ *  power_of_two_capacity_policy::capacity(5);
+ *
+ *  // yields `3`
+ *  power_of_two_capacity_policy::wrap(11, 8);
+ *
+ *  circular_queue<int, power_of_two_capacity_policy> q(5);
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+struct default_capacity_policy {
+  template <typename TSize>
+  static TSize capacity(TSize requested) noexcept { return requested; }
+
+  template <typename TSize>
+  static TSize grow(TSize capacity) noexcept {
+    return capacity ? capacity * 2 : 1;
+  }
+
+  // `index` must be less than twice the `capacity`
+  template <typename TSize>
+  static TSize wrap(TSize index, TSize capacity) noexcept {
+    return index < capacity ? index : index - capacity;
+  }
+};
+
+struct power_of_two_capacity_policy {
+  template <typename TSize>
+  static TSize capacity(TSize requested) noexcept {
+    TSize result = 1;
+
+    while (result < requested) {
+      result <<= 1;
+    }
+
+    return requested ? result : 0;
+  }
+
+  template <typename TSize>
+  static TSize grow(TSize capacity) noexcept {
+    return capacity ? capacity * 2 : 1;
+  }
+
+  template <typename TSize>
+  static TSize wrap(TSize index, TSize capacity) noexcept {
+    assert(!(capacity & (capacity - 1)));
+    return index & (capacity - 1);
+  }
+};
+
+// TODO: shrink_to_fit, pop_back, prevent growth (T4534263)
+template <typename T, typename TCapacityPolicy = default_capacity_policy>
 class circular_queue {
   static_assert(!std::is_reference<T>::value, "can't store references");
 
-  union item_t {
-    item_t() noexcept {}
-    item_t(item_t const &) noexcept {}
-    item_t(item_t &&) noexcept {}
-    ~item_t() noexcept {}
-    T value;
-  };
+  using item_t = detail::circular_queue_impl::item<T>;
 
   // TODO: make it a customizable container
   using queue_type = std::vector<item_t>;
@@ -58,14 +132,18 @@ public:
     typename std::add_const<T>::type
   >::type;
   using pointer = typename std::add_pointer<T>::type;
+  using capacity_policy = TCapacityPolicy;
 
 private:
+  // `index` must be less than twice the capacity
+  size_type wrap(size_type index) const {
+    return capacity_policy::wrap(index, queue_.size());
+  }
+
   size_type loose_real_index(fatal::fast_pass<size_type> i) const {
     FATAL_ASSUME_LE(i, size_);
-    auto const index = offset_ + i;
-    auto const size = queue_.size();
-    auto result = index < size ? index : index - size;
-    FATAL_ASSUME_LT(result, size);
+    auto result = wrap(offset_ + i);
+    FATAL_ASSUME_LT(result, queue_.size());
     return result;
   }
 
@@ -75,13 +153,12 @@ private:
   }
 
   size_type append_index() const {
-    auto const index = offset_ + size_;
-    auto const size = queue_.size();
-    auto result = index < size ? index : index - size;
-    FATAL_ASSUME_ONE(
-      FATAL_LT(result, size),
-      FATAL_EQ(size, static_cast<size_type>(0))
-    );
+    if (queue_.empty()) {
+      return 0;
+    }
+
+    auto result = wrap(offset_ + size_);
+    FATAL_ASSUME_LT(result, queue_.size());
     return result;
   }
 
@@ -90,12 +167,11 @@ private:
       return 0;
     }
 
-    auto const result = offset_ ? offset_ - 1 : queue_.size() - 1;
+    auto const result = wrap(offset_ + queue_.size() - 1);
     FATAL_ASSUME_LT(result, queue_.size());
     return result;
   }
 
-  using growth_rate = std::integral_constant<std::size_t, 2>;
   using chunk_range = std::pair<size_type, size_type>;
   using chunk_pair = std::array<chunk_range, 2>;
 
@@ -123,43 +199,166 @@ private:
     return chunk;
   }
 
-  void grow() {
-    FATAL_ASSUME_EQ(size_, queue_.size());
-    queue_type grown;
-    grown.resize(queue_.empty() ? 1 : queue_.size() * growth_rate::value);
-    FATAL_ASSUME_LT(size_, grown.size());
+  // the empty slots, from the back of the queue onwards
+  chunk_pair free_chunks() const {
+    FATAL_ASSUME_LE(size_, queue_.size());
+    auto const available = queue_.size() - size_;
+    auto const begin = append_index();
+    auto const gap = queue_.size() - begin;
 
+    chunk_pair chunk;
 
-    auto destination = grown.begin();
+    chunk[0].first = begin;
+    chunk[1].first = 0;
 
-    for (auto chunk: chunks()) {
-      for(auto i = chunk.first; i < chunk.second; ++i, ++destination) {
-        new (std::addressof(destination->value)) value_type(
-          std::move(queue_[i].value)
-        );
+    if (gap < available) {
+      chunk[0].second = queue_.size();
+      chunk[1].second = available - gap;
+    } else {
+      chunk[0].second = begin + available;
+      chunk[1].second = 0;
+    }
 
-        queue_[i].value.~value_type();
-      }
+    return chunk;
+  }
+
+  using is_trivially_copyable = std::integral_constant<
+    bool, FATAL_IS_TRIVIALLY_COPYABLE(value_type)
+  >;
+
+  // moves the elements in the `[begin, end)` slots to the uninitialized
+  // slots starting at `to`
+  static void relocate(
+    item_t *to,
+    item_t *begin,
+    item_t *end,
+    std::true_type
+  ) noexcept {
+    if (begin != end) {
+      std::memcpy(
+        std::addressof(to->value),
+        std::addressof(begin->value),
+        static_cast<size_type>(end - begin) * sizeof(value_type)
+      );
+    }
+  }
+
+  static void relocate(
+    item_t *to,
+    item_t *begin,
+    item_t *end,
+    std::false_type
+  ) {
+    for (; begin != end; ++begin, ++to) {
+      new (std::addressof(to->value)) value_type(std::move(begin->value));
+      begin->value.~value_type();
+    }
+  }
+
+  // grows the capacity until it fits at least `required` elements
+  void grow(size_type required) {
+    FATAL_ASSUME_LT(queue_.size(), required);
+    auto capacity = queue_.size();
+
+    do {
+      capacity = capacity_policy::grow(capacity);
+    } while (capacity < required);
+
+    queue_type grown(capacity);
+    auto destination = grown.data();
+
+    for (auto chunk: chunks()) {
+      relocate(
+        destination,
+        queue_.data() + chunk.first,
+        queue_.data() + chunk.second,
+        is_trivially_copyable()
+      );
+      destination += chunk.second - chunk.first;
     }
 
-    FATAL_ASSUME_NOT_NEGATIVE(std::distance(grown.begin(), destination));
     FATAL_ASSUME_EQ(
       size_,
-      static_cast<size_type>(std::distance(grown.begin(), destination))
+      static_cast<size_type>(std::distance(grown.data(), destination))
     );
     queue_ = std::move(grown);
     offset_ = 0;
 
-    FATAL_ASSUME_LT(size_, queue_.size());
+    FATAL_ASSUME_LE(required, queue_.size());
+  }
+
+  template <typename TIterator>
+  void append(TIterator begin, TIterator end, std::input_iterator_tag) {
+    for (; begin != end; ++begin) {
+      emplace_back(*begin);
+    }
+  }
+
+  template <typename TIterator>
+  void append(TIterator begin, TIterator end, std::forward_iterator_tag) {
+    auto const count = static_cast<size_type>(std::distance(begin, end));
+
+    if (queue_.size() - size_ < count) {
+      grow(size_ + count);
+    }
+
+    append_n(
+      begin, count,
+      std::integral_constant<
+        bool,
+        is_trivially_copyable::value
+          && std::is_pointer<TIterator>::value
+          && std::is_same<
+            typename std::remove_cv<
+              typename std::remove_pointer<TIterator>::type
+            >::type,
+            value_type
+          >::value
+      >()
+    );
+  }
+
+  template <typename U>
+  void append_n(U *begin, size_type count, std::true_type) noexcept {
+    for (auto chunk: free_chunks()) {
+      auto const size = std::min(count, chunk.second - chunk.first);
+
+      if (size) {
+        std::memcpy(
+          std::addressof(queue_[chunk.first].value),
+          begin,
+          size * sizeof(value_type)
+        );
+      }
+
+      begin += size;
+      count -= size;
+      size_ += size;
+    }
+
+    FATAL_ASSUME_EQ(count, static_cast<size_type>(0));
+  }
+
+  template <typename TIterator>
+  void append_n(TIterator begin, size_type count, std::false_type) {
+    for (auto chunk: free_chunks()) {
+      for (auto i = chunk.first; count && i < chunk.second; ++i, ++begin) {
+        new (std::addressof(queue_[i].value)) value_type(*begin);
+        --count;
+        ++size_;
+      }
+    }
+
+    FATAL_ASSUME_EQ(count, static_cast<size_type>(0));
   }
 
 public:
   circular_queue() = default;
 
   // TODO: PROPERLY DECLARE noexcept
-  explicit circular_queue(size_type capacity) {
-    queue_.reserve(capacity);
-  }
+  explicit circular_queue(size_type capacity):
+    queue_(capacity_policy::capacity(capacity))
+  {}
 
   // TODO: PROPERLY DECLARE noexcept
   circular_queue(circular_queue const &other):
@@ -204,11 +403,11 @@ public:
   reference emplace_front(UArgs &&...args) {
     FATAL_ASSUME_LE(size_, queue_.size());
     if (size_ == queue_.size()) {
-      grow();
+      grow(size_ + 1);
     }
     FATAL_ASSUME_LT(size_, queue_.size());
 
-    auto offset = offset_ > 0 ? offset_ - 1 : offset_ = queue_.size() - 1;
+    auto const offset = prepend_index();
     FATAL_ASSUME_LT(offset, queue_.size());
 
     auto p = new (std::addressof(queue_[offset].value)) value_type(
@@ -222,11 +421,7 @@ public:
 
   void pop_front() {
     queue_[offset_].value.~value_type();
-
-    if (++offset_ == queue_.size()) {
-      offset_ = 0;
-    }
-
+    offset_ = wrap(offset_ + 1);
     --size_;
   }
 
@@ -234,7 +429,7 @@ public:
   reference emplace_back(UArgs &&...args) {
     FATAL_ASSUME_LE(size_, queue_.size());
     if (size_ == queue_.size()) {
-      grow();
+      grow(size_ + 1);
     }
     FATAL_ASSUME_LT(size_, queue_.size());
 
@@ -246,27 +441,47 @@ public:
     return *p;
   }
 
-  void pop_front(size_type count) {
+  void pop_front(size_type count) { erase_front(count); }
+
+  // appends the elements in `[begin, end)` to the back of the queue, growing
+  // it at most once when `TIterator` is a forward iterator
+  //
+  // the elements are copied with `std::memcpy` when `TIterator` is a pointer
+  // to a trivially copyable `value_type`
+  template <typename TIterator>
+  void append(TIterator begin, TIterator end) {
+    append(
+      begin, end,
+      typename std::iterator_traits<TIterator>::iterator_category()
+    );
+  }
+
+  template <typename TRange>
+  void append(TRange const &range) {
+    using std::begin;
+    using std::end;
+    append(begin(range), end(range));
+  }
+
+  // removes the first `count` elements, which is a constant time operation
+  // for trivially destructible types
+  void erase_front(size_type count) noexcept {
     FATAL_ASSUME_LE(count, size_);
 
-    auto chunk = std::min(count, queue_.size() - offset_);
-    for (auto const end = offset_ + chunk; offset_ < end; ++offset_) {
-      queue_[offset_].value.~value_type();
-    }
+    if (!std::is_trivially_destructible<value_type>::value) {
+      auto const chunk = std::min(count, queue_.size() - offset_);
 
-    FATAL_ASSUME_LE(offset_, queue_.size());
-    if (offset_ == queue_.size()) {
-      offset_ = 0;
-    }
-    FATAL_ASSUME_LT(offset_, queue_.size());
+      for (auto i = offset_, end = offset_ + chunk; i < end; ++i) {
+        queue_[i].value.~value_type();
+      }
 
-    FATAL_ASSUME_LE(chunk, count);
-    FATAL_ASSUME_EQ(offset_ == 0, count == chunk);
-    for (auto const end = count - chunk; offset_ < end; ++offset_) {
-      queue_[offset_].~value_type();
+      for (size_type i = 0, end = count - chunk; i < end; ++i) {
+        queue_[i].value.~value_type();
+      }
     }
 
     size_ -= count;
+    offset_ = size_ ? wrap(offset_ + count) : 0;
   }
 
   // shifts one element from the back to the front of the queue
@@ -282,11 +497,7 @@ public:
     auto const original = real_index(size_ - 1);
     FATAL_ASSUME_LT(original, queue_.size());
 
-    if (offset_) {
-      --offset_;
-    } else {
-      offset_ = queue_.size() - 1;
-    }
+    offset_ = prepend_index();
     FATAL_ASSUME_LT(offset_, queue_.size());
 
     FATAL_ASSUME_LE(size_, queue_.size());
@@ -319,21 +530,13 @@ public:
     FATAL_ASSUME_LE(size_, queue_.size());
     if (size_ == queue_.size()) {
       // no empty slots, just need to adjust the offset
-      if (offset_ < count) {
-        FATAL_ASSUME_LT(count, queue_.size());
-        offset_ += queue_.size() - count;
-      } else {
-        offset_ -= count;
-      }
+      FATAL_ASSUME_LT(count, queue_.size());
+      offset_ = wrap(offset_ + queue_.size() - count);
       FATAL_ASSUME_LT(offset_, queue_.size());
     } else {
       // empty slots, move front chunk to back
       while (count--) {
-        if (offset_) {
-          --offset_;
-        } else {
-          offset_ = queue_.size() - 1;
-        }
+        offset_ = prepend_index();
         FATAL_ASSUME_LT(offset_, queue_.size());
 
         auto &from = queue_[loose_real_index(size_)].value;
@@ -361,9 +564,7 @@ public:
     auto const destination = loose_real_index(size_);
 
     FATAL_ASSUME_LT(offset_, queue_.size());
-    if (++offset_ == queue_.size()) {
-      offset_ = 0;
-    }
+    offset_ = wrap(offset_ + 1);
     FATAL_ASSUME_LT(offset_, queue_.size());
 
     FATAL_ASSUME_LE(size_, queue_.size());
@@ -397,14 +598,7 @@ public:
     if (size_ == queue_.size()) {
       // no empty slots, just need to adjust the offset
       FATAL_ASSUME_LT(offset_, queue_.size());
-      auto const gap = queue_.size() - offset_;
-
-      if (count < gap) {
-        offset_ += count;
-      } else {
-        offset_ = count - gap;
-      }
-
+      offset_ = wrap(offset_ + count);
       FATAL_ASSUME_LT(offset_, queue_.size());
     } else {
       // empty slots, move back chunk to front
@@ -419,9 +613,7 @@ public:
         );
         from.~value_type();
 
-        if (++offset_ == queue_.size()) {
-          offset_ = 0;
-        }
+        offset_ = wrap(offset_ + 1);
         FATAL_ASSUME_LT(offset_, queue_.size());
       }
     }
@@ -477,12 +669,10 @@ public:
 
   fatal::fast_pass<size_type> size() const noexcept { return size_; }
 
+  size_type capacity() const noexcept { return queue_.size(); }
+
   bool empty() const noexcept {
-    static_assert(
-      noexcept(queue_.empty()),
-      "underlying container must provide a noexcept empty()"
-    );
-    return queue_.empty();
+    return !size_;
   }
 
   using const_iterator = random_access_iterator<circular_queue, true>;
@@ -0,0 +1,580 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef FATAL_INCLUDE_fatal_container_concurrent_circular_queue_h
+#define FATAL_INCLUDE_fatal_container_concurrent_circular_queue_h
+
+#include <fatal/container/circular_queue.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include <cassert>
+#include <cstddef>
+
+namespace fatal {
+namespace detail {
+namespace concurrent_circular_queue_impl {
+
+// indices written by different threads are kept this far apart so that they
+// never share a cache line
+using cache_line_size = std::integral_constant<std::size_t, 64>;
+
+struct padding {
+  char bytes[cache_line_size::value];
+};
+
+inline std::size_t round_capacity(std::size_t capacity) noexcept {
+  assert(capacity > 0);
+  std::size_t result = 1;
+
+  while (result < capacity) {
+    result <<= 1;
+  }
+
+  return result;
+}
+
+} // namespace concurrent_circular_queue_impl {
+} // namespace detail {
+
+/**
+ * A bounded, lock-free, single-producer / single-consumer queue.
+ *
+ * Elements live in uninitialized slots with the same layout as the ones used
+ * by `circular_queue`, in a buffer whose capacity is rounded up to a power of
+ * two and never grows. Pushing to a full queue or popping from an empty one
+ * fails instead of blocking.
+ *
+ * At most one thread may push and at most one thread may pop at any given
+ * time. The head and tail indices live in separate cache lines, and each side
+ * keeps a cached copy of the other side's index so that it only has to touch
+ * the shared cache line when the queue looks full (or empty).
+ *
+ * `push_n` and `pop_n` transfer as many elements as possible with a single
+ * index update, amortizing the synchronization among the whole batch.
+ *
+ * Example:
+ *
+ *  spsc_circular_queue<int> q(1024);
+ *
+ *  std::thread producer([&] {
+ *    for (int i = 0; i < 100; ++i) {
+ *      while (!q.try_push(i)) {
+ *        std::this_thread::yield();
+ *      }
+ *    }
+ *  });
+ *
+ *  for (int i = 0, value; i < 100; ) {
+ *    if (q.try_pop(value)) {
+ *      assert(value == i++);
+ *    }
+ *  }
+ *
+ *  producer.join();
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+template <typename T>
+class spsc_circular_queue {
+  static_assert(!std::is_reference<T>::value, "can't store references");
+
+  using item_t = detail::circular_queue_impl::item<T>;
+  using padding = detail::concurrent_circular_queue_impl::padding;
+
+public:
+  using size_type = std::size_t;
+  using value_type = T;
+
+  // the actual capacity is `capacity` rounded up to a power of two
+  explicit spsc_circular_queue(size_type capacity):
+    mask_(detail::concurrent_circular_queue_impl::round_capacity(capacity) - 1),
+    items_(new item_t[mask_ + 1])
+  {}
+
+  spsc_circular_queue(spsc_circular_queue const &) = delete;
+  spsc_circular_queue(spsc_circular_queue &&) = delete;
+
+  ~spsc_circular_queue() noexcept {
+    static_assert(
+      std::is_nothrow_destructible<value_type>::value,
+      "value_type must provide a noexcept destructor"
+    );
+
+    auto const tail = tail_.load(std::memory_order_acquire);
+
+    for (auto i = head_.load(std::memory_order_relaxed); i != tail; ++i) {
+      items_[i & mask_].value.~value_type();
+    }
+  }
+
+  bool try_push(value_type const &value) { return try_emplace(value); }
+  bool try_push(value_type &&value) { return try_emplace(std::move(value)); }
+
+  // producer side: constructs an element at the back of the queue, returning
+  // false without constructing it if the queue is full
+  template <typename... UArgs>
+  bool try_emplace(UArgs &&...args) {
+    auto const tail = tail_.load(std::memory_order_relaxed);
+
+    if (tail - head_cache_ > mask_) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+
+      if (tail - head_cache_ > mask_) {
+        return false;
+      }
+    }
+
+    new (std::addressof(items_[tail & mask_].value)) value_type(
+      std::forward<UArgs>(args)...
+    );
+
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // producer side: pushes up to `n` elements from `begin`, publishing them
+  // all at once, and returns how many were pushed, which is less than `n`
+  // when the queue fills up
+  template <typename TInputIterator>
+  size_type push_n(TInputIterator begin, size_type n) {
+    auto const tail = tail_.load(std::memory_order_relaxed);
+
+    if (capacity() - (tail - head_cache_) < n) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+    }
+
+    auto const count = std::min(n, capacity() - (tail - head_cache_));
+    size_type i = 0;
+
+    try {
+      for (; i < count; ++i, ++begin) {
+        new (std::addressof(items_[(tail + i) & mask_].value)) value_type(
+          *begin
+        );
+      }
+    } catch (...) {
+      tail_.store(tail + i, std::memory_order_release);
+      throw;
+    }
+
+    tail_.store(tail + count, std::memory_order_release);
+    return count;
+  }
+
+  // consumer side: moves the front element into `out` and removes it,
+  // returning false if the queue is empty
+  //
+  // if moving the element throws, it is discarded and the exception is
+  // propagated
+  bool try_pop(value_type &out) {
+    auto const head = head_.load(std::memory_order_relaxed);
+
+    if (head == tail_cache_) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+
+      if (head == tail_cache_) {
+        return false;
+      }
+    }
+
+    auto &value = items_[head & mask_].value;
+
+    try {
+      out = std::move(value);
+    } catch (...) {
+      value.~value_type();
+      head_.store(head + 1, std::memory_order_release);
+      throw;
+    }
+
+    value.~value_type();
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // consumer side: moves up to `n` elements into `out`, releasing their
+  // slots all at once, and returns how many were popped, which is less than
+  // `n` when the queue empties
+  template <typename TOutputIterator>
+  size_type pop_n(TOutputIterator out, size_type n) {
+    auto const head = head_.load(std::memory_order_relaxed);
+
+    if (tail_cache_ - head < n) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+    }
+
+    auto const count = std::min(n, tail_cache_ - head);
+    size_type i = 0;
+
+    try {
+      for (; i < count; ++i, ++out) {
+        auto &value = items_[(head + i) & mask_].value;
+        *out = std::move(value);
+        value.~value_type();
+      }
+    } catch (...) {
+      items_[(head + i) & mask_].value.~value_type();
+      head_.store(head + i + 1, std::memory_order_release);
+      throw;
+    }
+
+    head_.store(head + count, std::memory_order_release);
+    return count;
+  }
+
+  size_type capacity() const noexcept { return mask_ + 1; }
+
+  // only exact when neither side is running concurrently
+  size_type size() const noexcept {
+    auto const head = head_.load(std::memory_order_acquire);
+    return tail_.load(std::memory_order_acquire) - head;
+  }
+
+  // only exact when neither side is running concurrently
+  bool empty() const noexcept { return !size(); }
+
+private:
+  size_type const mask_;
+  std::unique_ptr<item_t[]> const items_;
+
+  padding pad0_;
+
+  // written by the consumer
+  std::atomic<size_type> head_{0};
+  size_type tail_cache_ = 0;
+
+  padding pad1_;
+
+  // written by the producer
+  std::atomic<size_type> tail_{0};
+  size_type head_cache_ = 0;
+
+  padding pad2_;
+};
+
+/**
+ * A bounded, lock-free, multi-producer / multi-consumer queue.
+ *
+ * Each slot pairs a `circular_queue`-style uninitialized element with a
+ * sequence number telling which ticket the slot is waiting for, so that
+ * producers and consumers only contend on the head and tail tickets, each in
+ * its own cache line, and never on the slots themselves (D. Vyukov's bounded
+ * queue). The capacity is rounded up to a power of two and never grows.
+ * Pushing to a full queue or popping from an empty one fails instead of
+ * blocking.
+ *
+ * `push_n` and `pop_n` claim as many consecutive slots as possible with a
+ * single compare-and-swap, amortizing the contention among the whole batch.
+ *
+ * Elements are constructed before a slot is claimed and then moved into it,
+ * so `value_type` must have a noexcept move constructor.
+ *
+ * Example:
+ *
+ *  mpmc_circular_queue<int> q(1024);
+ *
+ *  // from any amount of threads
+ *  q.try_push(10);
+ *
+ *  // from any amount of threads
+ *  int value;
+ *  if (q.try_pop(value)) {
+ *    // ...
+ *  }
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+template <typename T>
+class mpmc_circular_queue {
+  static_assert(!std::is_reference<T>::value, "can't store references");
+  static_assert(
+    std::is_nothrow_move_constructible<T>::value,
+    "value_type must provide a noexcept move constructor"
+  );
+
+  using item_t = detail::circular_queue_impl::item<T>;
+  using padding = detail::concurrent_circular_queue_impl::padding;
+
+public:
+  using size_type = std::size_t;
+  using value_type = T;
+
+private:
+  using difference_type = std::make_signed<size_type>::type;
+
+  struct cell {
+    std::atomic<size_type> sequence;
+    item_t item;
+  };
+
+public:
+  // the actual capacity is `capacity` rounded up to a power of two
+  explicit mpmc_circular_queue(size_type capacity):
+    mask_(detail::concurrent_circular_queue_impl::round_capacity(capacity) - 1),
+    cells_(new cell[mask_ + 1])
+  {
+    for (size_type i = 0; i <= mask_; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  mpmc_circular_queue(mpmc_circular_queue const &) = delete;
+  mpmc_circular_queue(mpmc_circular_queue &&) = delete;
+
+  ~mpmc_circular_queue() noexcept {
+    static_assert(
+      std::is_nothrow_destructible<value_type>::value,
+      "value_type must provide a noexcept destructor"
+    );
+
+    auto const tail = tail_.load(std::memory_order_acquire);
+
+    for (auto i = head_.load(std::memory_order_relaxed); i != tail; ++i) {
+      cells_[i & mask_].item.value.~value_type();
+    }
+  }
+
+  bool try_push(value_type const &value) { return try_emplace(value); }
+
+  bool try_push(value_type &&value) noexcept {
+    size_type ticket;
+
+    if (!claim(tail_, 0, ticket)) {
+      return false;
+    }
+
+    publish(ticket, std::move(value));
+    return true;
+  }
+
+  // constructs an element and pushes it to the back of the queue, returning
+  // false if the queue is full
+  template <typename... UArgs>
+  bool try_emplace(UArgs &&...args) {
+    return try_push(value_type(std::forward<UArgs>(args)...));
+  }
+
+  // pushes up to `n` elements from `begin`, claiming their slots all at
+  // once, and returns how many were pushed, which is less than `n` when the
+  // queue fills up
+  //
+  // the elements are copied out of `begin` before their slots are claimed,
+  // so an exception leaves the queue untouched
+  template <typename TInputIterator>
+  size_type push_n(TInputIterator begin, size_type n) {
+    size_type total = 0;
+
+    while (total < n) {
+      // stage a small batch so that its construction can't throw after the
+      // slots have been claimed
+      using batch_size = std::integral_constant<size_type, 32>;
+      item_t batch[batch_size::value];
+      auto const size = std::min(n - total, batch_size::value);
+      size_type staged = 0;
+
+      try {
+        for (; staged < size; ++staged, ++begin) {
+          new (std::addressof(batch[staged].value)) value_type(*begin);
+        }
+      } catch (...) {
+        destroy(batch, 0, staged);
+        throw;
+      }
+
+      size_type ticket;
+      auto const claimed = claim_n(tail_, 0, size, ticket);
+
+      for (size_type i = 0; i < claimed; ++i) {
+        publish(ticket + i, std::move(batch[i].value));
+      }
+
+      destroy(batch, 0, size);
+      total += claimed;
+
+      if (claimed < size) {
+        break;
+      }
+    }
+
+    return total;
+  }
+
+  // moves the front element into `out` and removes it, returning false if
+  // the queue is empty
+  //
+  // if moving the element throws, it is discarded and the exception is
+  // propagated
+  bool try_pop(value_type &out) {
+    size_type ticket;
+
+    if (!claim(head_, 1, ticket)) {
+      return false;
+    }
+
+    consume(ticket, out);
+    return true;
+  }
+
+  // moves up to `n` elements into `out`, claiming their slots all at once,
+  // and returns how many were popped, which is less than `n` when the queue
+  // empties
+  template <typename TOutputIterator>
+  size_type pop_n(TOutputIterator out, size_type n) {
+    size_type ticket;
+    auto const claimed = claim_n(head_, 1, n, ticket);
+    size_type i = 0;
+
+    try {
+      for (; i < claimed; ++i, ++out) {
+        consume(ticket + i, *out);
+      }
+    } catch (...) {
+      // the remaining claimed elements are discarded
+      for (++i; i < claimed; ++i) {
+        release(ticket + i);
+      }
+
+      throw;
+    }
+
+    return claimed;
+  }
+
+  size_type capacity() const noexcept { return mask_ + 1; }
+
+  // only exact when no other thread is accessing the queue
+  size_type size() const noexcept {
+    auto const head = head_.load(std::memory_order_acquire);
+    return tail_.load(std::memory_order_acquire) - head;
+  }
+
+  // only exact when no other thread is accessing the queue
+  bool empty() const noexcept { return !size(); }
+
+private:
+  // the distance between a slot's sequence number and the ticket being
+  // claimed, `offset` being 0 for producers and 1 for consumers
+  difference_type lag(size_type ticket, size_type offset) const noexcept {
+    return static_cast<difference_type>(
+      cells_[ticket & mask_].sequence.load(std::memory_order_acquire)
+        - (ticket + offset)
+    );
+  }
+
+  // claims a single ticket from `index`
+  bool claim(
+    std::atomic<size_type> &index,
+    size_type offset,
+    size_type &ticket
+  ) noexcept {
+    return claim_n(index, offset, 1, ticket) != 0;
+  }
+
+  // claims up to `n` consecutive tickets from `index` whose slots are ready,
+  // returning how many were claimed and setting `ticket` to the first one
+  size_type claim_n(
+    std::atomic<size_type> &index,
+    size_type offset,
+    size_type n,
+    size_type &ticket
+  ) noexcept {
+    if (!n) {
+      return 0;
+    }
+
+    ticket = index.load(std::memory_order_relaxed);
+
+    for (;;) {
+      auto const distance = lag(ticket, offset);
+
+      if (distance < 0) {
+        // full for producers, empty for consumers
+        return 0;
+      }
+
+      if (distance > 0) {
+        // some other thread claimed this ticket already
+        ticket = index.load(std::memory_order_relaxed);
+        continue;
+      }
+
+      size_type ready = 1;
+
+      while (ready < n && !lag(ticket + ready, offset)) {
+        ++ready;
+      }
+
+      if (
+        index.compare_exchange_weak(
+          ticket, ticket + ready, std::memory_order_relaxed
+        )
+      ) {
+        return ready;
+      }
+    }
+  }
+
+  void publish(size_type ticket, value_type &&value) noexcept {
+    auto &slot = cells_[ticket & mask_];
+    new (std::addressof(slot.item.value)) value_type(std::move(value));
+    slot.sequence.store(ticket + 1, std::memory_order_release);
+  }
+
+  // `out` is either a `value_type` or what dereferencing an output iterator
+  // yields, like the `back_insert_iterator` itself for `std::back_inserter`
+  template <typename Destination>
+  void consume(size_type ticket, Destination &&out) {
+    auto &value = cells_[ticket & mask_].item.value;
+
+    try {
+      out = std::move(value);
+    } catch (...) {
+      release(ticket);
+      throw;
+    }
+
+    release(ticket);
+  }
+
+  void release(size_type ticket) noexcept {
+    auto &slot = cells_[ticket & mask_];
+    slot.item.value.~value_type();
+    slot.sequence.store(ticket + mask_ + 1, std::memory_order_release);
+  }
+
+  static void destroy(item_t *items, size_type begin, size_type end) noexcept {
+    for (; begin != end; ++begin) {
+      items[begin].value.~value_type();
+    }
+  }
+
+  size_type const mask_;
+  std::unique_ptr<cell[]> const cells_;
+
+  padding pad0_;
+
+  // claimed by consumers
+  std::atomic<size_type> head_{0};
+
+  padding pad1_;
+
+  // claimed by producers
+  std::atomic<size_type> tail_{0};
+
+  padding pad2_;
+};
+
+} // namespace fatal {
+
+#endif // FATAL_INCLUDE_fatal_container_concurrent_circular_queue_h
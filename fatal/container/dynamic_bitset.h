@@ -0,0 +1,553 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef FATAL_INCLUDE_fatal_container_dynamic_bitset_h
+#define FATAL_INCLUDE_fatal_container_dynamic_bitset_h
+
+#include <fatal/math/numerics.h>
+#include <fatal/portability.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#if FATAL_HAS_SIMD_BMI2
+# include <immintrin.h>
+#endif // FATAL_HAS_SIMD_BMI2
+
+namespace fatal {
+namespace detail {
+namespace dynamic_bitset_impl {
+
+using word = std::uint64_t;
+using word_bits = data_bits<word>;
+
+// the rank directory has one entry per block of 8 words (512 bits), made of
+// the number of bits set before the block, followed by the number of bits set
+// in the block before each of its words 1 to 7, packed 9 bits each
+using block_words = std::integral_constant<std::size_t, 8>;
+using relative_bits = std::integral_constant<unsigned, 9>;
+using relative_mask = mersenne_number<relative_bits::value>;
+
+// the select directory has the block containing every `select_sample`-th set
+// bit
+using select_sample = std::integral_constant<std::size_t, 4096>;
+
+inline std::size_t words_for(std::size_t bits) noexcept {
+  return (bits + word_bits::value - 1) / word_bits::value;
+}
+
+// the mask of the bits of the last word that are in use
+inline word tail_mask(std::size_t bits) noexcept {
+  auto const used = bits % word_bits::value;
+  return used ? (word(1) << used) - 1 : ~word(0);
+}
+
+inline unsigned relative_rank(word packed, std::size_t i) noexcept {
+  assert(i < block_words::value);
+  return i ? static_cast<unsigned>(
+    (packed >> ((i - 1) * relative_bits::value)) & relative_mask::value
+  ) : 0;
+}
+
+// the position of the bit set in `value` that has `rank` bits set below it
+inline unsigned select_in_word(word value, unsigned rank) noexcept {
+  assert(rank < population_count(value));
+
+# if FATAL_HAS_SIMD_BMI2
+  return count_trailing_zeros(_pdep_u64(word(1) << rank, value));
+# else // FATAL_HAS_SIMD_BMI2
+  unsigned offset = 0;
+
+  for (;;) {
+    auto const bits = population_count(value & 0xff);
+
+    if (rank < bits) {
+      break;
+    }
+
+    rank -= bits;
+    value >>= 8;
+    offset += 8;
+  }
+
+  for (; rank; --rank) {
+    value &= value - 1;
+  }
+
+  return offset + count_trailing_zeros(value);
+# endif // FATAL_HAS_SIMD_BMI2
+}
+
+} // namespace dynamic_bitset_impl {
+} // namespace detail {
+
+/**
+ * A runtime-sized sequence of bits, with support for succinct `rank()` and
+ * `select()` queries.
+ *
+ * Bits are stored 64 to a word, and operations on ranges of bits or on whole
+ * bitsets (`count()`, `&=`, `|=`, `and_not()`, ...) work a word at a time.
+ *
+ * `rank()` and `select()` rely on a directory built by `build_index()`, which
+ * must be called again after the bitset is modified. The directory takes 25%
+ * of the space taken by the bits. `rank()` takes constant time, with a single
+ * population count. `select()` binary searches the blocks of 512 bits between
+ * two samples of its directory, then finds the bit in the block in constant
+ * time. When set bits are spread roughly evenly, that's a handful of blocks.
+ *
+ * Example:
+ *
+ *  // tracks which of a million rows have been deleted
+ *  dynamic_bitset tombstones(1000000);
+ *  tombstones.set(10);
+ *  tombstones.set(20);
+ *  tombstones.set(500000, 600000);
+ *  tombstones.build_index();
+ *
+ *  // yields `2`: the number of deleted rows before row 100
+ *  tombstones.rank(100);
+ *
+ *  // yields `500001`: the third deleted row
+ *  tombstones.select(3);
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+class dynamic_bitset {
+  using word = detail::dynamic_bitset_impl::word;
+  using word_bits = detail::dynamic_bitset_impl::word_bits;
+
+public:
+  using size_type = std::size_t;
+  using word_type = word;
+
+  dynamic_bitset() = default;
+
+  /**
+   * Creates a bitset with `size` bits, all set to `value`.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  explicit dynamic_bitset(size_type size, bool value = false) {
+    resize(size, value);
+  }
+
+  bool test(size_type i) const {
+    assert(i < size_);
+    return (words_[i / word_bits::value] >> (i % word_bits::value)) & 1;
+  }
+
+  bool operator [](size_type i) const { return test(i); }
+
+  dynamic_bitset &set(size_type i) {
+    assert(i < size_);
+    words_[i / word_bits::value] |= bit(i);
+    indexed_ = false;
+    return *this;
+  }
+
+  dynamic_bitset &reset(size_type i) {
+    assert(i < size_);
+    words_[i / word_bits::value] &= ~bit(i);
+    indexed_ = false;
+    return *this;
+  }
+
+  dynamic_bitset &flip(size_type i) {
+    assert(i < size_);
+    words_[i / word_bits::value] ^= bit(i);
+    indexed_ = false;
+    return *this;
+  }
+
+  dynamic_bitset &assign(size_type i, bool value) {
+    return value ? set(i) : reset(i);
+  }
+
+  /**
+   * Sets the bits in the range [begin, end).
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  dynamic_bitset &set(size_type begin, size_type end) {
+    fill(begin, end, true);
+    return *this;
+  }
+
+  /**
+   * Resets the bits in the range [begin, end).
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  dynamic_bitset &reset(size_type begin, size_type end) {
+    fill(begin, end, false);
+    return *this;
+  }
+
+  dynamic_bitset &set() { return set(0, size_); }
+  dynamic_bitset &reset() { return reset(0, size_); }
+
+  void push_back(bool value) {
+    resize(size_ + 1);
+
+    if (value) {
+      set(size_ - 1);
+    }
+  }
+
+  /**
+   * Resizes the bitset to `size` bits. New bits are set to `value`.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  void resize(size_type size, bool value = false) {
+    namespace impl = detail::dynamic_bitset_impl;
+
+    auto const old = size_;
+
+    if (size < old && size % word_bits::value) {
+      // the bits past the end are kept unset
+      words_[size / word_bits::value] &= impl::tail_mask(size);
+    }
+
+    words_.resize(impl::words_for(size));
+    size_ = size;
+    indexed_ = false;
+
+    if (value && size > old) {
+      fill(old, size, true);
+    }
+  }
+
+  void reserve(size_type size) {
+    words_.reserve(detail::dynamic_bitset_impl::words_for(size));
+  }
+
+  void clear() noexcept {
+    words_.clear();
+    size_ = 0;
+    indexed_ = false;
+  }
+
+  size_type size() const noexcept { return size_; }
+  bool empty() const noexcept { return !size_; }
+
+  /**
+   * The words holding the bits. Bit `i` is bit `i % 64` of word `i / 64`.
+   * The bits of the last word past `size()` are always unset.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  word_type const *data() const noexcept { return words_.data(); }
+  size_type words() const noexcept { return words_.size(); }
+
+  /**
+   * The number of bits set.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  size_type count() const noexcept {
+    size_type result = 0;
+
+    for (auto i: words_) {
+      result += population_count(i);
+    }
+
+    return result;
+  }
+
+  bool any() const noexcept {
+    return std::any_of(
+      words_.begin(), words_.end(), [](word i) { return i != 0; }
+    );
+  }
+
+  bool none() const noexcept { return !any(); }
+
+  //////////////////////
+  // bulk bitwise ops //
+  //////////////////////
+
+  /**
+   * Keeps only the bits that are also set in `rhs`, which must have the same
+   * size.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  dynamic_bitset &operator &=(dynamic_bitset const &rhs) {
+    return apply(rhs, [](word lhs, word rhs) { return lhs & rhs; });
+  }
+
+  /**
+   * Sets the bits that are set in `rhs`, which must have the same size.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  dynamic_bitset &operator |=(dynamic_bitset const &rhs) {
+    return apply(rhs, [](word lhs, word rhs) { return lhs | rhs; });
+  }
+
+  /**
+   * Flips the bits that are set in `rhs`, which must have the same size.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  dynamic_bitset &operator ^=(dynamic_bitset const &rhs) {
+    return apply(rhs, [](word lhs, word rhs) { return lhs ^ rhs; });
+  }
+
+  /**
+   * Resets the bits that are set in `rhs`, which must have the same size.
+   *
+   * Example:
+   *
+   *  // drops the rows that have been deleted
+   *  live.and_not(tombstones);
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  dynamic_bitset &and_not(dynamic_bitset const &rhs) {
+    return apply(rhs, [](word lhs, word rhs) { return lhs & ~rhs; });
+  }
+
+  /////////////////
+  // rank/select //
+  /////////////////
+
+  /**
+   * Builds the directory used by `rank()` and `select()`.
+   *
+   * Must be called after the bitset is modified, before querying it.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  void build_index() {
+    namespace impl = detail::dynamic_bitset_impl;
+
+    auto const blocks = (words_.size() + impl::block_words::value - 1)
+      / impl::block_words::value;
+
+    ranks_.resize(blocks * 2 + 1);
+    samples_.clear();
+
+    word total = 0;
+    auto next_sample = total;
+
+    for (size_type block = 0; block < blocks; ++block) {
+      auto const first = block * impl::block_words::value;
+      auto const last = std::min(
+        first + impl::block_words::value, words_.size()
+      );
+
+      word relative = 0;
+      word packed = 0;
+
+      // words past the end get the count of the whole block
+      for (auto i = first; i < first + impl::block_words::value; ++i) {
+        if (auto const j = i - first) {
+          packed |= relative << ((j - 1) * impl::relative_bits::value);
+        }
+
+        if (i < last) {
+          relative += population_count(words_[i]);
+        }
+      }
+
+      ranks_[block * 2] = total;
+      ranks_[block * 2 + 1] = packed;
+      total += relative;
+
+      for (; next_sample < total; next_sample += impl::select_sample::value) {
+        samples_.push_back(block);
+      }
+    }
+
+    ranks_.back() = total;
+    indexed_ = true;
+  }
+
+  /**
+   * The number of bits set before position `i`, for `i` in [0, size()].
+   *
+   * Requires an up to date index (see `build_index()`).
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  size_type rank(size_type i) const {
+    namespace impl = detail::dynamic_bitset_impl;
+
+    assert(indexed_);
+    assert(i <= size_);
+
+    auto const w = i / word_bits::value;
+    auto const block = w / impl::block_words::value;
+    auto const offset = i % word_bits::value;
+
+    auto result = ranks_[block * 2];
+
+    if (block * 2 + 1 < ranks_.size()) {
+      result += impl::relative_rank(
+        ranks_[block * 2 + 1], w % impl::block_words::value
+      );
+    }
+
+    if (offset) {
+      result += population_count(words_[w] & ((word(1) << offset) - 1));
+    }
+
+    return static_cast<size_type>(result);
+  }
+
+  /**
+   * The position of the set bit that has `k` set bits before it, that is, the
+   * position `i` for which `test(i) && rank(i) == k`.
+   *
+   * Returns `size()` when fewer than `k + 1` bits are set.
+   *
+   * Requires an up to date index (see `build_index()`).
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  size_type select(size_type k) const {
+    namespace impl = detail::dynamic_bitset_impl;
+
+    assert(indexed_);
+
+    if (k >= ranks_.back()) {
+      return size_;
+    }
+
+    // the block is the last one with fewer than `k + 1` bits set before it,
+    // which lies between two consecutive samples
+    auto const sample = k / impl::select_sample::value;
+    auto lo = samples_[sample];
+    auto hi = sample + 1 < samples_.size()
+      ? samples_[sample + 1] + 1
+      : (ranks_.size() - 1) / 2;
+
+    while (hi - lo > 1) {
+      auto const middle = lo + (hi - lo) / 2;
+
+      if (ranks_[middle * 2] <= k) {
+        lo = middle;
+      } else {
+        hi = middle;
+      }
+    }
+
+    auto rank = k - static_cast<size_type>(ranks_[lo * 2]);
+    auto const packed = ranks_[lo * 2 + 1];
+    size_type i = 1;
+
+    while (
+      i < impl::block_words::value && impl::relative_rank(packed, i) <= rank
+    ) {
+      ++i;
+    }
+
+    auto const w = lo * impl::block_words::value + i - 1;
+    rank -= impl::relative_rank(packed, i - 1);
+
+    return w * word_bits::value + impl::select_in_word(
+      words_[w], static_cast<unsigned>(rank)
+    );
+  }
+
+  void swap(dynamic_bitset &other) noexcept {
+    using std::swap;
+    swap(words_, other.words_);
+    swap(size_, other.size_);
+    swap(ranks_, other.ranks_);
+    swap(samples_, other.samples_);
+    swap(indexed_, other.indexed_);
+  }
+
+  bool operator ==(dynamic_bitset const &rhs) const {
+    return size_ == rhs.size_ && words_ == rhs.words_;
+  }
+
+  bool operator !=(dynamic_bitset const &rhs) const {
+    return !(*this == rhs);
+  }
+
+private:
+  static word bit(size_type i) noexcept {
+    return word(1) << (i % word_bits::value);
+  }
+
+  template <typename Operation>
+  dynamic_bitset &apply(dynamic_bitset const &rhs, Operation &&operation) {
+    assert(size_ == rhs.size_);
+
+    auto const size = words_.size();
+    auto *const lhs = words_.data();
+    auto const *const other = rhs.words_.data();
+
+    for (size_type i = 0; i < size; ++i) {
+      lhs[i] = operation(lhs[i], other[i]);
+    }
+
+    indexed_ = false;
+    return *this;
+  }
+
+  void fill(size_type begin, size_type end, bool value) {
+    namespace impl = detail::dynamic_bitset_impl;
+
+    assert(begin <= end);
+    assert(end <= size_);
+
+    indexed_ = false;
+
+    if (begin == end) {
+      return;
+    }
+
+    auto const first = begin / word_bits::value;
+    auto const last = (end - 1) / word_bits::value;
+    auto const head = ~word(0) << (begin % word_bits::value);
+    auto const tail = impl::tail_mask(end);
+    auto const update = [value](word &out, word mask) {
+      out = value ? out | mask : out & ~mask;
+    };
+
+    if (first == last) {
+      update(words_[first], head & tail);
+      return;
+    }
+
+    update(words_[first], head);
+    std::fill(
+      words_.begin() + static_cast<std::ptrdiff_t>(first + 1),
+      words_.begin() + static_cast<std::ptrdiff_t>(last),
+      value ? ~word(0) : word(0)
+    );
+    update(words_[last], tail);
+  }
+
+  std::vector<word> words_;
+  size_type size_ = 0;
+
+  // refer to `detail::dynamic_bitset_impl` for the layout of the directory
+  std::vector<word> ranks_{0};
+  std::vector<size_type> samples_;
+  bool indexed_ = true;
+};
+
+inline void swap(dynamic_bitset &lhs, dynamic_bitset &rhs) noexcept {
+  lhs.swap(rhs);
+}
+
+} // namespace fatal {
+
+#endif // FATAL_INCLUDE_fatal_container_dynamic_bitset_h
@@ -0,0 +1,647 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef FATAL_INCLUDE_fatal_container_flag_set_array_h
+#define FATAL_INCLUDE_fatal_container_flag_set_array_h
+
+#include <fatal/container/flag_set.h>
+#include <fatal/math/numerics.h>
+#include <fatal/portability.h>
+#include <fatal/type/foreach.h>
+#include <fatal/type/list.h>
+#include <fatal/type/slice.h>
+#include <fatal/type/tag.h>
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#if FATAL_HAS_SIMD_AVX2
+# include <immintrin.h>
+#elif FATAL_HAS_SIMD_SSSE3
+# include <tmmintrin.h>
+#endif // FATAL_HAS_SIMD_AVX2
+
+namespace fatal {
+namespace detail {
+namespace flag_set_array_impl {
+
+using word = std::uint64_t;
+using word_bits = data_bits<word>;
+
+inline std::size_t words_for(std::size_t bits) noexcept {
+  return (bits + word_bits::value - 1) / word_bits::value;
+}
+
+// the mask of the bits of the last word that are in use
+inline word tail_mask(std::size_t bits) noexcept {
+  auto const used = bits % word_bits::value;
+  return used ? (word(1) << used) - 1 : ~word(0);
+}
+
+template <std::size_t Columns>
+using columns = std::array<word const *, Columns>;
+
+// the rows whose bits are set in all of the given columns, as a bitmap
+template <std::size_t Columns>
+inline word conjunction(columns<Columns> const &in, std::size_t i) noexcept {
+  auto result = ~word(0);
+
+  for (auto column: in) {
+    result &= column[i];
+  }
+
+  return result;
+}
+
+#if FATAL_HAS_SIMD_SSSE3
+// counts the bits set in each byte with a nibble lookup table, then adds
+// them up into each 64-bit lane
+# if FATAL_HAS_SIMD_AVX2
+using vector = __m256i;
+
+inline vector load(word const *data) {
+  return _mm256_loadu_si256(reinterpret_cast<__m256i const *>(data));
+}
+
+inline vector zero() { return _mm256_setzero_si256(); }
+
+inline vector accumulate(vector sum, vector value) {
+  auto const lookup = _mm256_setr_epi8(
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+  );
+  auto const nibble = _mm256_set1_epi8(0x0f);
+  auto const bytes = _mm256_add_epi8(
+    _mm256_shuffle_epi8(lookup, _mm256_and_si256(value, nibble)),
+    _mm256_shuffle_epi8(
+      lookup,
+      _mm256_and_si256(_mm256_srli_epi16(value, 4), nibble)
+    )
+  );
+
+  return _mm256_add_epi64(sum, _mm256_sad_epu8(bytes, zero()));
+}
+
+inline vector conjunction(vector lhs, vector rhs) {
+  return _mm256_and_si256(lhs, rhs);
+}
+
+inline std::size_t total(vector sum) {
+  alignas(vector) word lanes[4];
+  _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), sum);
+  return static_cast<std::size_t>(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+}
+# else // FATAL_HAS_SIMD_AVX2
+using vector = __m128i;
+
+inline vector load(word const *data) {
+  return _mm_loadu_si128(reinterpret_cast<__m128i const *>(data));
+}
+
+inline vector zero() { return _mm_setzero_si128(); }
+
+inline vector accumulate(vector sum, vector value) {
+  auto const lookup = _mm_setr_epi8(
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+  );
+  auto const nibble = _mm_set1_epi8(0x0f);
+  auto const bytes = _mm_add_epi8(
+    _mm_shuffle_epi8(lookup, _mm_and_si128(value, nibble)),
+    _mm_shuffle_epi8(lookup, _mm_and_si128(_mm_srli_epi16(value, 4), nibble))
+  );
+
+  return _mm_add_epi64(sum, _mm_sad_epu8(bytes, zero()));
+}
+
+inline vector conjunction(vector lhs, vector rhs) {
+  return _mm_and_si128(lhs, rhs);
+}
+
+inline std::size_t total(vector sum) {
+  alignas(vector) word lanes[2];
+  _mm_store_si128(reinterpret_cast<__m128i *>(lanes), sum);
+  return static_cast<std::size_t>(lanes[0] + lanes[1]);
+}
+# endif // FATAL_HAS_SIMD_AVX2
+#endif // FATAL_HAS_SIMD_SSSE3
+
+// counts the bits set in all of the given columns, for the first `words`
+// words of each, which must all be in use
+template <std::size_t Columns>
+std::size_t count(columns<Columns> const &in, std::size_t words) noexcept {
+  std::size_t result = 0;
+  std::size_t i = 0;
+
+# if FATAL_HAS_SIMD_SSSE3
+  using lanes = std::integral_constant<
+    std::size_t, sizeof(vector) / sizeof(word)
+  >;
+
+  if (Columns && words >= lanes::value) {
+    auto sum = zero();
+
+    for (; i + lanes::value <= words; i += lanes::value) {
+      auto value = load(in[0] + i);
+
+      for (std::size_t column = 1; column < Columns; ++column) {
+        value = conjunction(value, load(in[column] + i));
+      }
+
+      sum = accumulate(sum, value);
+    }
+
+    result = total(sum);
+  }
+# endif // FATAL_HAS_SIMD_SSSE3
+
+  for (; i < words; ++i) {
+    result += population_count(conjunction(in, i));
+  }
+
+  return result;
+}
+
+// sets or resets the bits in the range [begin, end)
+inline void fill(
+  word *column,
+  std::size_t begin,
+  std::size_t end,
+  bool value
+) {
+  if (begin >= end) {
+    return;
+  }
+
+  auto const first = begin / word_bits::value;
+  auto const last = (end - 1) / word_bits::value;
+  auto const head = ~word(0) << (begin % word_bits::value);
+  auto const tail = tail_mask(end);
+
+  if (first == last) {
+    auto const mask = head & tail;
+    column[first] = value ? column[first] | mask : column[first] & ~mask;
+    return;
+  }
+
+  column[first] = value ? column[first] | head : column[first] & ~head;
+  std::fill(column + first + 1, column + last, value ? ~word(0) : word(0));
+  column[last] = value ? column[last] | tail : column[last] & ~tail;
+}
+
+} // namespace flag_set_array_impl {
+} // namespace detail {
+
+/**
+ * A columnar array of `flag_set<Flags...>`, meant for large collections of
+ * flag sets (say, one per row of a table) that are filtered as a whole.
+ *
+ * Rather than storing one integral per set, each flag is stored in its own
+ * bitmap, with one bit per element. This means that queries like counting or
+ * selecting the elements with a given set of flags operate on 64 elements per
+ * word, and on 128 or 256 elements per instruction when SSSE3 or AVX2 are
+ * available (refer to `FATAL_HAS_SIMD_*`). The same goes for setting and
+ * resetting flags for a range of elements.
+ *
+ * Accessing a single element is slower than with a plain array of `flag_set`,
+ * since its flags must be gathered from each bitmap.
+ *
+ * Assume, in the examples below, that these types are available:
+ *
+ *  struct deleted {};
+ *  struct dirty {};
+ *  struct pinned {};
+ *
+ * Example:
+ *
+ *  flag_set_array<deleted, dirty, pinned> rows(1000);
+ *
+ *  rows.set<dirty>(100, 200);
+ *  rows.set<pinned>(150, 300);
+ *
+ *  // yields `50`
+ *  rows.count_if<dirty, pinned>();
+ *
+ *  std::vector<std::size_t> indexes;
+ *
+ *  // appends `150`, `151`, ..., `199` to `indexes`
+ *  rows.select_indexes<dirty, pinned>(std::back_inserter(indexes));
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+template <typename... Flags>
+class flag_set_array {
+  using word = detail::flag_set_array_impl::word;
+  using word_bits = detail::flag_set_array_impl::word_bits;
+
+  template <typename... UFlags>
+  using columns = detail::flag_set_array_impl::columns<sizeof...(UFlags)>;
+
+public:
+  using value_type = flag_set<Flags...>;
+  using tag_list = typename value_type::tag_list;
+  using size_type = std::size_t;
+
+  /**
+   * The type of the words of the bitmaps returned by `select()`.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  using word_type = word;
+
+  flag_set_array() = default;
+
+  /**
+   * Creates an array of `size` elements, with all flags unset.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  explicit flag_set_array(size_type size) { resize(size); }
+
+  /**
+   * Gathers the flags of the element at position `i` into a `flag_set`.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  value_type operator [](size_type i) const {
+    assert(i < size_);
+    value_type result;
+    foreach<tag_list>(gather(), *this, i, result);
+    return result;
+  }
+
+  /**
+   * Sets the flags of the element at position `i` to exactly the ones set in
+   * `value`.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  void assign(size_type i, value_type const &value) {
+    assert(i < size_);
+    foreach<tag_list>(scatter(), *this, i, value);
+  }
+
+  /**
+   * Appends an element with the flags set in `value`.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  void push_back(value_type const &value) {
+    resize(size_ + 1);
+    assign(size_ - 1, value);
+  }
+
+  /**
+   * Tells whether all the given flags are set for the element at position
+   * `i`.
+   *
+   * Example:
+   *
+   *  flag_set_array<deleted, dirty, pinned> rows(10);
+   *  rows.set<dirty>(3);
+   *
+   *  // yields `true`
+   *  rows.test<dirty>(3);
+   *
+   *  // yields `false`
+   *  rows.test<dirty, pinned>(3);
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  template <typename... UFlags>
+  bool test(size_type i) const {
+    assert(i < size_);
+    auto const bit = word(1) << (i % word_bits::value);
+    return (detail::flag_set_array_impl::conjunction(
+      columns_for<UFlags...>(), i / word_bits::value
+    ) & bit) != 0;
+  }
+
+  /**
+   * Sets the given flags for the element at position `i`.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  template <typename... UFlags>
+  void set(size_type i) { set<UFlags...>(i, i + 1); }
+
+  /**
+   * Sets the given flags for the elements in the range [begin, end).
+   *
+   * Example:
+   *
+   *  flag_set_array<deleted, dirty, pinned> rows(1000);
+   *
+   *  // marks elements 100 to 199 as both `dirty` and `pinned`
+   *  rows.set<dirty, pinned>(100, 200);
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  template <typename... UFlags>
+  void set(size_type begin, size_type end) {
+    fill<UFlags...>(begin, end, true);
+  }
+
+  /**
+   * Resets the given flags for the element at position `i`.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  template <typename... UFlags>
+  void reset(size_type i) { reset<UFlags...>(i, i + 1); }
+
+  /**
+   * Resets the given flags for the elements in the range [begin, end).
+   *
+   * Example:
+   *
+   *  flag_set_array<deleted, dirty, pinned> rows(1000);
+   *  rows.set<dirty>(0, 1000);
+   *
+   *  // leaves only elements 0 to 99 marked as `dirty`
+   *  rows.reset<dirty>(100, 1000);
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  template <typename... UFlags>
+  void reset(size_type begin, size_type end) {
+    fill<UFlags...>(begin, end, false);
+  }
+
+  /**
+   * Counts the elements that have all the given flags set.
+   *
+   * This is equivalent to counting the elements for which
+   * `flag_set::test<UFlags...>()` yields `true`, only faster.
+   *
+   * Example:
+   *
+   *  flag_set_array<deleted, dirty, pinned> rows(1000);
+   *  rows.set<dirty>(0, 500);
+   *  rows.set<pinned>(250, 1000);
+   *
+   *  // yields `500`
+   *  rows.count_if<dirty>();
+   *
+   *  // yields `250`
+   *  rows.count_if<dirty, pinned>();
+   *
+   *  // yields `1000`
+   *  rows.count_if<>();
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  template <typename... UFlags>
+  size_type count_if() const {
+    namespace impl = detail::flag_set_array_impl;
+
+    if (!size_) {
+      return 0;
+    }
+
+    auto const in = columns_for<UFlags...>();
+    auto const last = words() - 1;
+
+    return impl::count(in, last) + population_count(
+      impl::conjunction(in, last) & impl::tail_mask(size_)
+    );
+  }
+
+  /**
+   * Selects the elements that have all the given flags set, as a bitmap.
+   *
+   * The bitmap is stored in `out`, which is resized to `words()` words. The
+   * element at position `i` is selected when the bit `i % 64` of
+   * `out[i / 64]` is set.
+   *
+   * Example:
+   *
+   *  flag_set_array<deleted, dirty, pinned> rows(100);
+   *  rows.set<dirty>(1, 3);
+   *
+   *  std::vector<flag_set_array<deleted, dirty, pinned>::word_type> bitmap;
+   *  rows.select<dirty>(bitmap);
+   *
+   *  // yields `0b110`
+   *  bitmap[0];
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  template <typename... UFlags>
+  void select(std::vector<word_type> &out) const {
+    namespace impl = detail::flag_set_array_impl;
+
+    auto const in = columns_for<UFlags...>();
+    auto const count = words();
+    out.resize(count);
+
+    for (size_type i = 0; i < count; ++i) {
+      out[i] = impl::conjunction(in, i);
+    }
+
+    if (count) {
+      out.back() &= impl::tail_mask(size_);
+    }
+  }
+
+  /**
+   * Writes to `out` the position of each element that has all the given
+   * flags set, in increasing order.
+   *
+   * Returns the output iterator past the last position written.
+   *
+   * Example:
+   *
+   *  flag_set_array<deleted, dirty, pinned> rows(100);
+   *  rows.set<dirty>(10, 13);
+   *
+   *  std::vector<std::size_t> indexes;
+   *
+   *  // appends `10`, `11` and `12` to `indexes`
+   *  rows.select_indexes<dirty>(std::back_inserter(indexes));
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  template <typename... UFlags, typename OutputIterator>
+  OutputIterator select_indexes(OutputIterator out) const {
+    namespace impl = detail::flag_set_array_impl;
+
+    auto const in = columns_for<UFlags...>();
+    auto const count = words();
+
+    for (size_type i = 0; i < count; ++i) {
+      auto bits = impl::conjunction(in, i);
+
+      if (i + 1 == count) {
+        bits &= impl::tail_mask(size_);
+      }
+
+      for (auto const base = i * word_bits::value; bits; bits &= bits - 1) {
+        *out = base + count_trailing_zeros(bits);
+        ++out;
+      }
+    }
+
+    return out;
+  }
+
+  /**
+   * Resizes the array to `size` elements. New elements have all flags unset.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  void resize(size_type size) {
+    namespace impl = detail::flag_set_array_impl;
+
+    auto const required = impl::words_for(size);
+
+    if (required > stride_) {
+      relayout(std::max(required, stride_ * 2));
+    }
+
+    // the bits past the end are kept unset so that growing needs no clearing
+    if (size < size_) {
+      for (size_type column = 0; column < flags::value; ++column) {
+        impl::fill(data_.data() + column * stride_, size, size_, false);
+      }
+    }
+
+    size_ = size;
+  }
+
+  /**
+   * Reserves memory for at least `size` elements.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  void reserve(size_type size) {
+    auto const required = detail::flag_set_array_impl::words_for(size);
+
+    if (required > stride_) {
+      relayout(required);
+    }
+  }
+
+  void clear() noexcept {
+    std::fill(data_.begin(), data_.end(), word(0));
+    size_ = 0;
+  }
+
+  size_type size() const noexcept { return size_; }
+  bool empty() const noexcept { return !size_; }
+
+  /**
+   * The number of words in a bitmap holding one bit per element.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  size_type words() const noexcept {
+    return detail::flag_set_array_impl::words_for(size_);
+  }
+
+  void swap(flag_set_array &other) noexcept {
+    using std::swap;
+    swap(data_, other.data_);
+    swap(stride_, other.stride_);
+    swap(size_, other.size_);
+  }
+
+private:
+  using flags = fatal::size<tag_list>;
+
+  template <typename Flag>
+  word const *column() const {
+    return data_.data() + index_of<tag_list, Flag>::value * stride_;
+  }
+
+  template <typename Flag>
+  word *column() {
+    return data_.data() + index_of<tag_list, Flag>::value * stride_;
+  }
+
+  template <typename... UFlags>
+  columns<UFlags...> columns_for() const {
+    return columns<UFlags...>{{column<UFlags>()...}};
+  }
+
+  template <typename... UFlags>
+  void fill(size_type begin, size_type end, bool value) {
+    assert(begin <= end);
+    assert(end <= size_);
+
+    word *const out[] = {column<UFlags>()..., nullptr};
+
+    for (auto i = out; *i; ++i) {
+      detail::flag_set_array_impl::fill(*i, begin, end, value);
+    }
+  }
+
+  // moves the bitmaps apart so that each can hold `stride` words
+  void relayout(size_type stride) {
+    std::vector<word> data(flags::value * stride);
+    auto const count = words();
+
+    for (size_type column = 0; column < flags::value; ++column) {
+      std::copy(
+        data_.begin() + static_cast<std::ptrdiff_t>(column * stride_),
+        data_.begin() + static_cast<std::ptrdiff_t>(column * stride_ + count),
+        data.begin() + static_cast<std::ptrdiff_t>(column * stride)
+      );
+    }
+
+    data_.swap(data);
+    stride_ = stride;
+  }
+
+  struct gather {
+    template <typename Flag, std::size_t Index>
+    void operator ()(
+      indexed<Flag, Index>,
+      flag_set_array const &array,
+      size_type i,
+      value_type &out
+    ) const {
+      out.template set_if<Flag>(array.template test<Flag>(i));
+    }
+  };
+
+  struct scatter {
+    template <typename Flag, std::size_t Index>
+    void operator ()(
+      indexed<Flag, Index>,
+      flag_set_array &array,
+      size_type i,
+      value_type const &value
+    ) const {
+      if (value.template test<Flag>()) {
+        array.template set<Flag>(i);
+      } else {
+        array.template reset<Flag>(i);
+      }
+    }
+  };
+
+  // one bitmap per flag, `stride_` words apart
+  std::vector<word> data_;
+  size_type stride_ = 0;
+  size_type size_ = 0;
+};
+
+template <typename... Flags>
+void swap(flag_set_array<Flags...> &lhs, flag_set_array<Flags...> &rhs) {
+  lhs.swap(rhs);
+}
+
+} // namespace fatal {
+
+#endif // FATAL_INCLUDE_fatal_container_flag_set_array_h
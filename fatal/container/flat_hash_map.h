@@ -0,0 +1,1166 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef FATAL_INCLUDE_fatal_container_flat_hash_map_h
+#define FATAL_INCLUDE_fatal_container_flat_hash_map_h
+
+#include <fatal/container/arena.h>
+#include <fatal/math/hash.h>
+#include <fatal/math/numerics.h>
+#include <fatal/portability.h>
+#include <fatal/string/rope.h>
+#include <fatal/string/string_view.h>
+#include <fatal/type/conditional.h>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if FATAL_HAS_SIMD_SSE2
+# include <emmintrin.h>
+#endif // FATAL_HAS_SIMD_SSE2
+
+namespace fatal {
+namespace detail {
+namespace flat_hash_map_impl {
+
+// normalizes string-like keys so that they can be hashed and compared
+// regardless of their representation
+inline string_view as_view(string_view s) { return s; }
+inline string_view as_view(std::string const &s) { return string_view(s); }
+inline string_view as_view(char const *s) { return string_view(s); }
+
+template <std::size_t SmallBufferSize, typename Allocator>
+rope<SmallBufferSize, Allocator> const &as_view(
+  rope<SmallBufferSize, Allocator> const &r
+) {
+  return r;
+}
+
+inline bool equals(string_view lhs, string_view rhs) {
+  return lhs.size() == rhs.size()
+    && (lhs.empty() || !std::memcmp(lhs.data(), rhs.data(), lhs.size()));
+}
+
+template <std::size_t SmallBufferSize, typename Allocator>
+bool equals(string_view lhs, rope<SmallBufferSize, Allocator> const &rhs) {
+  return lhs.size() == rhs.size() && rhs.for_each_piece(
+    [&lhs](string_view piece) {
+      if (std::memcmp(lhs.data(), piece.data(), piece.size())) {
+        return false;
+      }
+
+      lhs += piece.size();
+      return true;
+    }
+  );
+}
+
+template <std::size_t SmallBufferSize, typename Allocator>
+bool equals(rope<SmallBufferSize, Allocator> const &lhs, string_view rhs) {
+  return equals(rhs, lhs);
+}
+
+template <typename>
+struct is_rope: std::false_type {};
+
+template <std::size_t SmallBufferSize, typename Allocator>
+struct is_rope<rope<SmallBufferSize, Allocator>>: std::true_type {};
+
+} // namespace flat_hash_map_impl {
+} // namespace detail {
+
+/**
+ * A hasher for `std::string`, `string_view` and `rope`, which hashes the
+ * bytes of the string using `bytes_hasher`, regardless of how it's
+ * represented. This means that a `rope` hashes to the same value as a
+ * `std::string` with the same contents.
+ *
+ * Transparent, meaning it can be used for heterogeneous lookups on
+ * `flat_hash_map`.
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+struct string_hasher {
+  using is_transparent = void;
+
+  template <typename T>
+  std::size_t operator ()(T const &key) const {
+    return hash(detail::flat_hash_map_impl::as_view(key));
+  }
+
+private:
+  static std::size_t hash(string_view s) {
+    return *bytes_hasher<std::size_t>()(s.data(), s.size());
+  }
+
+  template <std::size_t SmallBufferSize, typename Allocator>
+  static std::size_t hash(rope<SmallBufferSize, Allocator> const &r) {
+    bytes_hasher<std::size_t> hasher;
+
+    r.for_each_piece([&hasher](string_view piece) {
+      hasher(piece.data(), piece.size());
+      return true;
+    });
+
+    return *hasher;
+  }
+};
+
+/**
+ * Compares `std::string`, `string_view` and `rope` for equality, regardless
+ * of how the strings are represented.
+ *
+ * Transparent, meaning it can be used for heterogeneous lookups on
+ * `flat_hash_map`.
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+struct string_equal {
+  using is_transparent = void;
+
+  template <typename T, typename U>
+  bool operator ()(T const &lhs, U const &rhs) const {
+    namespace impl = detail::flat_hash_map_impl;
+    return impl::equals(impl::as_view(lhs), impl::as_view(rhs));
+  }
+};
+
+namespace detail {
+namespace flat_hash_map_impl {
+
+template <typename Key>
+using is_string = std::integral_constant<
+  bool,
+  std::is_same<Key, std::string>::value || std::is_same<Key, string_view>::value
+>;
+
+template <typename Key>
+using default_hasher = conditional<
+  is_string<Key>::value, string_hasher, std::hash<Key>
+>;
+
+template <typename Key>
+using default_key_equal = conditional<
+  is_string<Key>::value, string_equal, std::equal_to<Key>
+>;
+
+// converts the key given to an insertion into the type of the stored key
+template <typename Key>
+struct key_factory {
+  template <typename K>
+  static Key make(K &&key, monotonic_arena *, std::false_type) {
+    return construct(
+      std::forward<K>(key),
+      std::is_same<typename std::decay<K>::type, string_view>()
+    );
+  }
+
+  template <typename K>
+  static Key make(K const &key, monotonic_arena *, std::true_type) {
+    return key.to_string();
+  }
+
+private:
+  template <typename K>
+  static Key construct(K &&key, std::false_type) {
+    return Key(std::forward<K>(key));
+  }
+
+  static Key construct(string_view key, std::true_type) {
+    return Key(key.data(), key.size());
+  }
+};
+
+// when keys are stored in an arena, the bytes of the keys given to an
+// insertion are copied into it, so that they outlive the caller's strings
+template <>
+struct key_factory<string_view> {
+  template <typename K>
+  static string_view make(
+    K const &key,
+    monotonic_arena *arena,
+    std::false_type
+  ) {
+    string_view const view(as_view(key));
+    return arena ? intern(view.data(), view.size(), *arena) : view;
+  }
+
+  template <typename K>
+  static string_view make(
+    K const &key,
+    monotonic_arena *arena,
+    std::true_type
+  ) {
+    if (!arena) {
+      throw std::invalid_argument(
+        "rope keys need an arena to be stored as string_view"
+      );
+    }
+
+    auto const data = static_cast<char *>(arena->allocate(key.size(), 1));
+    key.copy(data, data + key.size());
+    return string_view(data, key.size());
+  }
+
+private:
+  static string_view intern(
+    char const *data,
+    std::size_t size,
+    monotonic_arena &arena
+  ) {
+    auto const copy = static_cast<char *>(arena.allocate(size, 1));
+
+    if (size) {
+      std::memcpy(copy, data, size);
+    }
+
+    return string_view(copy, size);
+  }
+};
+
+// control bytes tell whether a slot is empty, deleted or full. Full slots
+// keep 7 bits of the hash of their key, so that most mismatches are ruled out
+// without comparing keys
+using control = signed char;
+using empty = std::integral_constant<control, -128>;
+using deleted = std::integral_constant<control, -2>;
+
+// slots are probed a group at a time
+using group_size = std::integral_constant<std::size_t, 16>;
+
+// one bit per slot in a group
+using mask = std::uint32_t;
+
+// a group with no slots, so that lookups on an empty map need no special case
+inline control *empty_group() {
+  alignas(group_size::value) static control group[group_size::value] = {
+    empty::value, empty::value, empty::value, empty::value,
+    empty::value, empty::value, empty::value, empty::value,
+    empty::value, empty::value, empty::value, empty::value,
+    empty::value, empty::value, empty::value, empty::value
+  };
+
+  return group;
+}
+
+struct group {
+# if FATAL_HAS_SIMD_SSE2
+  explicit group(control const *controls):
+    controls_(_mm_loadu_si128(reinterpret_cast<__m128i const *>(controls)))
+  {}
+
+  mask match(control h2) const {
+    return movemask(_mm_cmpeq_epi8(controls_, _mm_set1_epi8(h2)));
+  }
+
+  mask match_empty() const {
+    return movemask(_mm_cmpeq_epi8(controls_, _mm_set1_epi8(empty::value)));
+  }
+
+  // empty and deleted are the only control bytes with the sign bit set
+  mask match_free() const { return movemask(controls_); }
+
+private:
+  static mask movemask(__m128i value) {
+    return static_cast<mask>(_mm_movemask_epi8(value));
+  }
+
+  __m128i controls_;
+# else // FATAL_HAS_SIMD_SSE2
+  explicit group(control const *controls): controls_(controls) {}
+
+  mask match(control h2) const {
+    mask result = 0;
+
+    for (std::size_t i = 0; i < group_size::value; ++i) {
+      result |= mask(controls_[i] == h2) << i;
+    }
+
+    return result;
+  }
+
+  mask match_empty() const { return match(empty::value); }
+
+  mask match_free() const {
+    mask result = 0;
+
+    for (std::size_t i = 0; i < group_size::value; ++i) {
+      result |= mask(controls_[i] < 0) << i;
+    }
+
+    return result;
+  }
+
+private:
+  control const *controls_;
+# endif // FATAL_HAS_SIMD_SSE2
+};
+
+// spreads the entropy of weak hashes, like the identity `std::hash` of
+// integers, over all bits, since both the high and the low bits are used
+inline std::uint64_t mix(std::uint64_t hash) {
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdull;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ull;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+// picks the first group to probe
+inline std::size_t h1(std::uint64_t hash) {
+  return static_cast<std::size_t>(hash >> 7);
+}
+
+// kept in the control byte
+inline control h2(std::uint64_t hash) {
+  return static_cast<control>(hash & 0x7f);
+}
+
+// at most 7/8 of the slots are used before the table grows
+inline std::size_t max_load(std::size_t capacity) {
+  return capacity - capacity / 8;
+}
+
+// the storage of an element, in the style of abseil's map slots
+//
+// elements are exposed as `value`, but constructed as `mutable_value` when
+// both pairs are standard layout, so that keys can be moved while the table
+// grows. `value` is then read through the common initial sequence of both
+// members. Otherwise `value` is constructed and keys are copied instead
+template <typename Key, typename T>
+union slot {
+  using mutable_keys = std::integral_constant<
+    bool,
+    std::is_standard_layout<std::pair<Key, T>>::value
+      && std::is_standard_layout<std::pair<Key const, T>>::value
+  >;
+
+  // the member holding the element
+  using element = typename std::conditional<
+    mutable_keys::value, std::pair<Key, T>, std::pair<Key const, T>
+  >::type;
+
+  slot() {}
+  ~slot() {}
+
+  element &get() noexcept { return get(mutable_keys()); }
+  element const &get() const noexcept {
+    return const_cast<slot &>(*this).get();
+  }
+
+  std::pair<Key const, T> value;
+  std::pair<Key, T> mutable_value;
+
+private:
+  std::pair<Key, T> &get(std::true_type) noexcept { return mutable_value; }
+  std::pair<Key const, T> &get(std::false_type) noexcept { return value; }
+};
+
+} // namespace flat_hash_map_impl {
+} // namespace detail {
+
+/**
+ * An open addressing hash map that stores its elements in a flat array,
+ * in the style of Swiss tables.
+ *
+ * Each slot has a control byte, holding 7 bits of the hash of its key, and
+ * lookups probe a group of 16 control bytes at a time - with a single SSE2
+ * comparison when available (refer to `FATAL_HAS_SIMD_SSE2`). Keys are only
+ * compared for the slots whose control byte matches, which is almost always
+ * the one holding the key looked up, if any.
+ *
+ * Compared to node based maps like `std::unordered_map`, this means one
+ * allocation for the whole table rather than one per element, and lookups
+ * that touch one or two cache lines. On the other hand, references and
+ * iterators are invalidated when the table grows (`reserve()` avoids that)
+ * and elements may be copied, rather than moved, while growing if moving
+ * them might throw. Keys are only moved when `std::pair<Key, T>` is standard
+ * layout, and copied otherwise. Move-only keys and values are supported.
+ *
+ * Lookups are heterogeneous: when both `Hash` and `KeyEqual` are transparent
+ * the key looked up may have any type they accept. That's the default for
+ * `std::string` and `string_view` keys, which use `string_hasher` and
+ * `string_equal`, so that any of `std::string`, `string_view`, `rope` and
+ * `char const *` can be looked up.
+ *
+ * Maps keyed by `string_view` can be given a `monotonic_arena`, in which case
+ * the contents of keys are copied into the arena when inserted. This avoids
+ * one allocation per key, as with `std::string` keys, while not requiring the
+ * caller to keep the strings alive. The memory of erased keys is only
+ * reclaimed with the arena.
+ *
+ * Example:
+ *
+ *  monotonic_arena arena;
+ *  flat_hash_map<string_view, int> map(arena);
+ *
+ *  {
+ *    std::string key("hello");
+ *
+ *    // "hello" is copied into `arena`
+ *    map["hello"] = 10;
+ *  }
+ *
+ *  // yields `10`, looking up a `rope` without flattening it
+ *  map.at(rope<>("hel", "lo"));
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+template <
+  typename Key,
+  typename T,
+  typename Hash = detail::flat_hash_map_impl::default_hasher<Key>,
+  typename KeyEqual = detail::flat_hash_map_impl::default_key_equal<Key>,
+  typename Allocator = std::allocator<std::pair<Key const, T>>
+>
+class flat_hash_map {
+  using control = detail::flat_hash_map_impl::control;
+  using group_size = detail::flat_hash_map_impl::group_size;
+
+public:
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<Key const, T>;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using allocator_type = Allocator;
+  using reference = value_type &;
+  using const_reference = value_type const &;
+
+private:
+  using slot_type = detail::flat_hash_map_impl::slot<Key, T>;
+
+  static_assert(
+    slot_type::mutable_keys::value || std::is_copy_constructible<Key>::value,
+    "move-only keys require std::pair<Key, T> to be standard layout"
+  );
+
+  using allocator_traits = std::allocator_traits<Allocator>;
+  using slot_allocator = typename allocator_traits
+    ::template rebind_alloc<slot_type>;
+  using slot_traits = std::allocator_traits<slot_allocator>;
+  using control_allocator = typename allocator_traits
+    ::template rebind_alloc<control>;
+  using control_traits = std::allocator_traits<control_allocator>;
+
+  template <bool IsConst>
+  class iterator_impl {
+    friend class flat_hash_map;
+    template <bool> friend class iterator_impl;
+
+    using slot = typename std::conditional<
+      IsConst, slot_type const, slot_type
+    >::type;
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::pair<Key const, T>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = typename std::conditional<
+      IsConst, value_type const, value_type
+    >::type *;
+    using reference = decltype(*pointer());
+
+    iterator_impl() = default;
+
+    template <
+      bool OtherIsConst,
+      typename = typename std::enable_if<IsConst && !OtherIsConst>::type
+    >
+    /* implicit */ iterator_impl(iterator_impl<OtherIsConst> const &rhs):
+      control_(rhs.control_),
+      slot_(rhs.slot_),
+      end_(rhs.end_)
+    {}
+
+    reference operator *() const { return slot_->value; }
+    pointer operator ->() const { return std::addressof(slot_->value); }
+
+    iterator_impl &operator ++() {
+      ++control_;
+      ++slot_;
+      skip();
+      return *this;
+    }
+
+    iterator_impl operator ++(int) {
+      auto copy(*this);
+      ++*this;
+      return copy;
+    }
+
+    template <bool OtherIsConst>
+    bool operator ==(iterator_impl<OtherIsConst> const &rhs) const {
+      return control_ == rhs.control_;
+    }
+
+    template <bool OtherIsConst>
+    bool operator !=(iterator_impl<OtherIsConst> const &rhs) const {
+      return control_ != rhs.control_;
+    }
+
+  private:
+    iterator_impl(control const *controls, slot *slots, control const *end):
+      control_(controls),
+      slot_(slots),
+      end_(end)
+    {
+      skip();
+    }
+
+    void skip() {
+      while (control_ != end_ && *control_ < 0) {
+        ++control_;
+        ++slot_;
+      }
+    }
+
+    control const *control_ = nullptr;
+    slot *slot_ = nullptr;
+    control const *end_ = nullptr;
+  };
+
+public:
+  using iterator = iterator_impl<false>;
+  using const_iterator = iterator_impl<true>;
+
+  /**
+   * Creates an empty map with room for at least `capacity` elements before
+   * the table needs to grow.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  explicit flat_hash_map(
+    size_type capacity = 0,
+    hasher const &hash = hasher(),
+    key_equal const &equal = key_equal(),
+    allocator_type const &allocator = allocator_type()
+  ):
+    hash_(hash),
+    equal_(equal),
+    slot_allocator_(allocator),
+    control_allocator_(allocator)
+  {
+    reserve(capacity);
+  }
+
+  /**
+   * Creates an empty map keyed by `string_view` that copies the contents of
+   * the keys inserted into `keys`. The arena must outlive this map.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  explicit flat_hash_map(
+    monotonic_arena &keys,
+    size_type capacity = 0,
+    hasher const &hash = hasher(),
+    key_equal const &equal = key_equal(),
+    allocator_type const &allocator = allocator_type()
+  ):
+    flat_hash_map(capacity, hash, equal, allocator)
+  {
+    static_assert(
+      std::is_same<Key, string_view>::value,
+      "only maps keyed by string_view can store keys in an arena"
+    );
+
+    keys_ = std::addressof(keys);
+  }
+
+  flat_hash_map(flat_hash_map const &rhs):
+    hash_(rhs.hash_),
+    equal_(rhs.equal_),
+    slot_allocator_(
+      slot_traits::select_on_container_copy_construction(rhs.slot_allocator_)
+    ),
+    control_allocator_(slot_allocator_),
+    keys_(rhs.keys_)
+  {
+    reserve(rhs.size_);
+
+    for (auto const &i: rhs) {
+      insert_unique(i);
+    }
+  }
+
+  flat_hash_map(flat_hash_map &&rhs) noexcept:
+    hash_(std::move(rhs.hash_)),
+    equal_(std::move(rhs.equal_)),
+    slot_allocator_(std::move(rhs.slot_allocator_)),
+    control_allocator_(std::move(rhs.control_allocator_))
+  {
+    steal(rhs);
+  }
+
+  flat_hash_map &operator =(flat_hash_map const &rhs) {
+    if (this != std::addressof(rhs)) {
+      flat_hash_map copy(rhs);
+      swap(copy);
+    }
+
+    return *this;
+  }
+
+  flat_hash_map &operator =(flat_hash_map &&rhs)
+    noexcept(slot_traits::propagate_on_container_move_assignment::value)
+  {
+    if (this != std::addressof(rhs)) {
+      hash_ = std::move(rhs.hash_);
+      equal_ = std::move(rhs.equal_);
+      move_assign(
+        rhs,
+        typename slot_traits::propagate_on_container_move_assignment()
+      );
+    }
+
+    return *this;
+  }
+
+  ~flat_hash_map() { release(); }
+
+  ////////////
+  // lookup //
+  ////////////
+
+  template <typename K>
+  iterator find(K const &key) {
+    return iterator_at(find_index(key, hash_of(key)));
+  }
+
+  template <typename K>
+  const_iterator find(K const &key) const {
+    return iterator_at(find_index(key, hash_of(key)));
+  }
+
+  template <typename K>
+  size_type count(K const &key) const {
+    return find_index(key, hash_of(key)) != capacity_;
+  }
+
+  /**
+   * Returns the value mapped to `key`.
+   *
+   * Throws `std::out_of_range` when `key` is not in the map.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  template <typename K>
+  mapped_type &at(K const &key) {
+    auto const i = find_index(key, hash_of(key));
+
+    if (i == capacity_) {
+      throw std::out_of_range("key not found in flat_hash_map");
+    }
+
+    return slots_[i].get().second;
+  }
+
+  template <typename K>
+  mapped_type const &at(K const &key) const {
+    return const_cast<flat_hash_map &>(*this).at(key);
+  }
+
+  ///////////////
+  // insertion //
+  ///////////////
+
+  /**
+   * Inserts an element mapping `key` to a value constructed from `args`,
+   * unless `key` is already in the map, in which case `args` are left
+   * untouched.
+   *
+   * The key stored is constructed from `key`. For maps with an arena, the
+   * contents of `key` are copied into it.
+   *
+   * Returns an iterator to the element with the given key, and whether it was
+   * inserted.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> try_emplace(K &&key, Args &&...args) {
+    auto const hash = hash_of(key);
+    auto const found = find_index(key, hash);
+
+    if (found != capacity_) {
+      return std::make_pair(iterator_at(found), false);
+    }
+
+    return std::make_pair(
+      iterator_at(
+        insert_at(
+          hash,
+          make_key(std::forward<K>(key)),
+          std::forward<Args>(args)...
+        )
+      ),
+      true
+    );
+  }
+
+  std::pair<iterator, bool> insert(value_type const &value) {
+    return try_emplace(value.first, value.second);
+  }
+
+  std::pair<iterator, bool> insert(value_type &&value) {
+    return try_emplace(value.first, std::move(value.second));
+  }
+
+  /**
+   * Returns the value mapped to `key`, default constructing one if `key` is
+   * not in the map.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  template <typename K>
+  mapped_type &operator [](K &&key) {
+    return try_emplace(std::forward<K>(key)).first->second;
+  }
+
+  /////////////
+  // erasure //
+  /////////////
+
+  iterator erase(iterator i) { return erase(const_iterator(i)); }
+
+  iterator erase(const_iterator i) {
+    assert(i.control_ != controls_ + capacity_);
+    auto const index = static_cast<size_type>(i.control_ - controls_);
+    erase_at(index);
+    return iterator_at(index);
+  }
+
+  template <typename K>
+  size_type erase(K const &key) {
+    auto const i = find_index(key, hash_of(key));
+
+    if (i == capacity_) {
+      return 0;
+    }
+
+    erase_at(i);
+    return 1;
+  }
+
+  void clear() noexcept {
+    destroy_all();
+
+    if (capacity_) {
+      std::fill(
+        controls_, controls_ + capacity_,
+        detail::flat_hash_map_impl::empty::value
+      );
+    }
+
+    size_ = 0;
+    growth_left_ = detail::flat_hash_map_impl::max_load(capacity_);
+  }
+
+  //////////////
+  // capacity //
+  //////////////
+
+  /**
+   * Makes room for at least `size` elements, so that no further allocation
+   * happens until the map has more than `size` elements.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  void reserve(size_type size) {
+    if (size <= size_ + growth_left_) {
+      return;
+    }
+
+    auto capacity = std::max(capacity_, group_size::value);
+
+    while (detail::flat_hash_map_impl::max_load(capacity) < size) {
+      capacity *= 2;
+    }
+
+    rehash(capacity);
+  }
+
+  size_type size() const noexcept { return size_; }
+  bool empty() const noexcept { return !size_; }
+
+  /**
+   * The number of slots in the table, of which at most 7/8 are used.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  size_type capacity() const noexcept { return capacity_; }
+
+  ///////////////
+  // iteration //
+  ///////////////
+
+  iterator begin() { return iterator_at(0); }
+  const_iterator begin() const { return iterator_at(0); }
+  const_iterator cbegin() const { return begin(); }
+
+  iterator end() { return iterator_at(capacity_); }
+  const_iterator end() const { return iterator_at(capacity_); }
+  const_iterator cend() const { return end(); }
+
+  hasher hash_function() const { return hash_; }
+  key_equal key_eq() const { return equal_; }
+  allocator_type get_allocator() const { return slot_allocator_; }
+
+  void swap(flat_hash_map &other) noexcept {
+    using std::swap;
+    swap(hash_, other.hash_);
+    swap(equal_, other.equal_);
+    swap(slot_allocator_, other.slot_allocator_);
+    swap(control_allocator_, other.control_allocator_);
+    swap(controls_, other.controls_);
+    swap(slots_, other.slots_);
+    swap(capacity_, other.capacity_);
+    swap(size_, other.size_);
+    swap(growth_left_, other.growth_left_);
+    swap(keys_, other.keys_);
+  }
+
+private:
+  template <typename K>
+  std::uint64_t hash_of(K const &key) const {
+    return detail::flat_hash_map_impl::mix(
+      static_cast<std::uint64_t>(hash_(key))
+    );
+  }
+
+  template <typename K>
+  key_type make_key(K &&key) {
+    using impl = detail::flat_hash_map_impl::key_factory<key_type>;
+
+    return impl::make(
+      std::forward<K>(key),
+      keys_,
+      detail::flat_hash_map_impl::is_rope<typename std::decay<K>::type>()
+    );
+  }
+
+  size_type groups() const noexcept {
+    return capacity_ ? capacity_ / group_size::value : 1;
+  }
+
+  // the index of the slot holding `key`, or `capacity_` if there's none
+  template <typename K>
+  size_type find_index(K const &key, std::uint64_t hash) const {
+    namespace impl = detail::flat_hash_map_impl;
+
+    auto const h2 = impl::h2(hash);
+    auto const last = groups() - 1;
+
+    // triangular probing visits every group since their count is a power
+    // of two
+    for (size_type i = impl::h1(hash) & last, step = 0; ; ) {
+      auto const first = i * group_size::value;
+      impl::group const group(controls_ + first);
+
+      for (auto match = group.match(h2); match; match &= match - 1) {
+        auto const slot = first + count_trailing_zeros(match);
+
+        if (equal_(slots_[slot].get().first, key)) {
+          return slot;
+        }
+      }
+
+      if (group.match_empty()) {
+        return capacity_;
+      }
+
+      i = (i + ++step) & last;
+    }
+  }
+
+  // the index of the first empty or deleted slot on the probe sequence
+  static size_type find_free(
+    control const *controls,
+    size_type groups,
+    std::uint64_t hash
+  ) {
+    namespace impl = detail::flat_hash_map_impl;
+
+    auto const last = groups - 1;
+
+    for (size_type i = impl::h1(hash) & last, step = 0; ; ) {
+      if (auto const free = impl::group(
+        controls + i * group_size::value
+      ).match_free()) {
+        return i * group_size::value + count_trailing_zeros(free);
+      }
+
+      i = (i + ++step) & last;
+    }
+  }
+
+  template <typename... Args>
+  size_type insert_at(std::uint64_t hash, key_type &&key, Args &&...args) {
+    namespace impl = detail::flat_hash_map_impl;
+
+    auto i = find_free(controls_, groups(), hash);
+
+    // reusing a deleted slot doesn't take up more room
+    if (!growth_left_ && controls_[i] != impl::deleted::value) {
+      // too many deleted slots are dropped rather than growing the table
+      rehash(
+        capacity_ && size_ < impl::max_load(capacity_) / 2
+          ? capacity_
+          : std::max(capacity_ * 2, group_size::value)
+      );
+
+      i = find_free(controls_, groups(), hash);
+    }
+
+    construct(
+      slots_ + i,
+      std::piecewise_construct,
+      std::forward_as_tuple(std::move(key)),
+      std::forward_as_tuple(std::forward<Args>(args)...)
+    );
+
+    growth_left_ -= controls_[i] == impl::empty::value;
+    controls_[i] = impl::h2(hash);
+    ++size_;
+
+    return i;
+  }
+
+  // inserts an element known not to be in the map
+  void insert_unique(value_type const &value) {
+    insert_at(hash_of(value.first), key_type(value.first), value.second);
+  }
+
+  // keys are only moved when they're mutable
+  void insert_unique(slot_type &slot) {
+    auto &element = slot.get();
+    auto const hash = hash_of(element.first);
+    insert_at(
+      hash, key_type(std::move(element.first)), std::move(element.second)
+    );
+  }
+
+  void move_assign(flat_hash_map &rhs, std::true_type) noexcept {
+    release();
+    slot_allocator_ = std::move(rhs.slot_allocator_);
+    control_allocator_ = std::move(rhs.control_allocator_);
+    steal(rhs);
+  }
+
+  // the memory of `rhs` can only be taken over when it was allocated by an
+  // equal allocator, otherwise its elements are moved one by one
+  void move_assign(flat_hash_map &rhs, std::false_type) {
+    if (slot_allocator_ == rhs.slot_allocator_) {
+      release();
+      steal(rhs);
+      return;
+    }
+
+    clear();
+    reserve(rhs.size_);
+    keys_ = rhs.keys_;
+
+    for (size_type i = 0; i < rhs.capacity_; ++i) {
+      if (rhs.controls_[i] >= 0) {
+        insert_unique(rhs.slots_[i]);
+      }
+    }
+
+    rhs.clear();
+  }
+
+  // begins the lifetime of `slot` and constructs its element from `args`
+  template <typename... Args>
+  void construct(slot_type *slot, Args &&...args) {
+    ::new (static_cast<void *>(slot)) slot_type;
+    slot_traits::construct(
+      slot_allocator_, std::addressof(slot->get()), std::forward<Args>(args)...
+    );
+  }
+
+  void destroy(slot_type *slot) noexcept {
+    slot_traits::destroy(slot_allocator_, std::addressof(slot->get()));
+    slot->~slot_type();
+  }
+
+  void erase_at(size_type i) {
+    namespace impl = detail::flat_hash_map_impl;
+
+    assert(i < capacity_);
+    assert(controls_[i] >= 0);
+
+    destroy(slots_ + i);
+    --size_;
+
+    // a group with an empty slot has never been full, so no probe sequence
+    // goes past it and the slot can be reused as empty
+    auto const first = i / group_size::value * group_size::value;
+
+    if (impl::group(controls_ + first).match_empty()) {
+      controls_[i] = impl::empty::value;
+      ++growth_left_;
+    } else {
+      controls_[i] = impl::deleted::value;
+    }
+  }
+
+  // moves all elements to a new table with `capacity` slots, which must be a
+  // power of two multiple of the group size. The current table is left
+  // untouched if an element throws while being moved, unless it can't be
+  // copied
+  void rehash(size_type capacity) {
+    namespace impl = detail::flat_hash_map_impl;
+
+    assert(capacity >= group_size::value);
+    assert(!(capacity & (capacity - 1)));
+    assert(impl::max_load(capacity) >= size_);
+
+    auto const controls = control_traits::allocate(
+      control_allocator_, capacity
+    );
+    std::fill(controls, controls + capacity, impl::empty::value);
+
+    slot_type *slots;
+
+    try {
+      slots = slot_traits::allocate(slot_allocator_, capacity);
+    } catch (...) {
+      control_traits::deallocate(control_allocator_, controls, capacity);
+      throw;
+    }
+
+    auto const groups = capacity / group_size::value;
+    size_type i = 0;
+
+    try {
+      for (; i < capacity_; ++i) {
+        if (controls_[i] < 0) {
+          continue;
+        }
+
+        auto const j = find_free(
+          controls, groups, hash_of(slots_[i].get().first)
+        );
+
+        construct(slots + j, std::move_if_noexcept(slots_[i].get()));
+        controls[j] = controls_[i];
+      }
+    } catch (...) {
+      for (size_type j = 0; j < capacity; ++j) {
+        if (controls[j] >= 0) {
+          destroy(slots + j);
+        }
+      }
+
+      slot_traits::deallocate(slot_allocator_, slots, capacity);
+      control_traits::deallocate(control_allocator_, controls, capacity);
+      throw;
+    }
+
+    auto const size = size_;
+    release();
+
+    controls_ = controls;
+    slots_ = slots;
+    capacity_ = capacity;
+    size_ = size;
+    growth_left_ = impl::max_load(capacity) - size;
+  }
+
+  void destroy_all() noexcept {
+    if (std::is_trivially_destructible<typename slot_type::element>::value) {
+      return;
+    }
+
+    for (size_type i = 0; i < capacity_; ++i) {
+      if (controls_[i] >= 0) {
+        destroy(slots_ + i);
+      }
+    }
+  }
+
+  // destroys all elements and frees the table, leaving the map empty
+  void release() noexcept {
+    destroy_all();
+
+    if (capacity_) {
+      slot_traits::deallocate(slot_allocator_, slots_, capacity_);
+      control_traits::deallocate(control_allocator_, controls_, capacity_);
+    }
+
+    controls_ = detail::flat_hash_map_impl::empty_group();
+    slots_ = nullptr;
+    capacity_ = 0;
+    size_ = 0;
+    growth_left_ = 0;
+  }
+
+  void steal(flat_hash_map &rhs) noexcept {
+    controls_ = rhs.controls_;
+    slots_ = rhs.slots_;
+    capacity_ = rhs.capacity_;
+    size_ = rhs.size_;
+    growth_left_ = rhs.growth_left_;
+    keys_ = rhs.keys_;
+
+    rhs.controls_ = detail::flat_hash_map_impl::empty_group();
+    rhs.slots_ = nullptr;
+    rhs.capacity_ = 0;
+    rhs.size_ = 0;
+    rhs.growth_left_ = 0;
+  }
+
+  iterator iterator_at(size_type i) {
+    return iterator(controls_ + i, slots_ + i, controls_ + capacity_);
+  }
+
+  const_iterator iterator_at(size_type i) const {
+    return const_iterator(controls_ + i, slots_ + i, controls_ + capacity_);
+  }
+
+  hasher hash_;
+  key_equal equal_;
+  slot_allocator slot_allocator_;
+  control_allocator control_allocator_;
+  control *controls_ = detail::flat_hash_map_impl::empty_group();
+  slot_type *slots_ = nullptr;
+  size_type capacity_ = 0;
+  size_type size_ = 0;
+  size_type growth_left_ = 0;
+  monotonic_arena *keys_ = nullptr;
+};
+
+template <
+  typename Key, typename T, typename Hash, typename KeyEqual, typename Allocator
+>
+void swap(
+  flat_hash_map<Key, T, Hash, KeyEqual, Allocator> &lhs,
+  flat_hash_map<Key, T, Hash, KeyEqual, Allocator> &rhs
+) noexcept {
+  lhs.swap(rhs);
+}
+
+} // namespace fatal {
+
+#endif // FATAL_INCLUDE_fatal_container_flat_hash_map_h
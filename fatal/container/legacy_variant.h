@@ -10,6 +10,7 @@
 #ifndef FATAL_INCLUDE_fatal_container_legacy_variant_h
 #define FATAL_INCLUDE_fatal_container_legacy_variant_h
 
+#include <fatal/container/arena.h>
 #include <fatal/container/optional.h>
 #include <fatal/container/unitary_union.h>
 #include <fatal/functional/functional.h>
@@ -17,13 +18,17 @@
 #include <fatal/portability.h>
 #include <fatal/type/conditional.h>
 #include <fatal/type/deprecated/type_list.h>
+#include <fatal/type/sequence.h>
 #include <fatal/type/traits.h>
+#include <fatal/type/void.h>
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <utility>
 
 #include <cassert>
+#include <cstddef>
 
 FATAL_DIAGNOSTIC_PUSH
 FATAL_GCC_DIAGNOSTIC_IGNORED_SHADOW_IF_BROKEN
@@ -128,6 +133,29 @@ public:
 using dynamic_allocation_policy = fixed_allocation_policy<true>;
 using automatic_allocation_policy = fixed_allocation_policy<false>;
 
+/**
+ * An allocation policy that stores types inline when they're scalars or when
+ * their size in bytes is at most `InlineSize`. Otherwise, they're dynamically
+ * allocated.
+ *
+ * Useful to tune the size of a variant against how often its values end up
+ * in the heap.
+ *
+ * Example:
+ *
+ *  // `std::string` is stored inline, `std::array<char, 64>` is not
+ *  using policy = default_storage_policy<
+ *    std::allocator<void>,
+ *    inline_size_allocation_policy<sizeof(std::string)>
+ *  >;
+ *
+ *  variant<policy, std::string, std::array<char, 64>> v;
+ *
+ * @author: Marcelo Juchem <marcelo@fb.com>
+ */
+template <std::size_t InlineSize>
+using inline_size_allocation_policy = default_allocation_policy<0, InlineSize>;
+
 /**
  * ####################
  * # 'STORAGE POLICY' #
@@ -161,6 +189,20 @@ using automatic_allocation_policy = fixed_allocation_policy<false>;
  *  static T const &get(typename storage_type<T>::type const &);
  *  static T &get(typename storage_type<T>::type &);
  *
+ * - optionally, can_reuse() and reuse() allow the variant to hand the heap
+ *   block of a destroyed value over to a value of a different type, rather
+ *   than deallocating it and allocating a new one (see
+ *   block_reuse_storage_policy):
+ *
+ *  template <typename From, typename To>
+ *  static constexpr bool can_reuse();
+ *
+ *  template <typename From, typename To>
+ *  static void reuse(
+ *    typename storage_type<From>::type &from,
+ *    typename storage_type<To>::type &to
+ *  );
+ *
  * TAllocator is any STL-style allocator which will be rebound to whatever
  * type the storage policy must handle. It will only be used for dynamically
  * allocated types.
@@ -265,8 +307,10 @@ struct legacy_storage_policy {
     >::type &storage,
     Args &&...args
   ) {
-    using rebound_alloc = typename allocator_traits::template rebind_alloc<T>;
-    rebound_alloc(*allocator).construct(storage, std::forward<Args>(args)...);
+    using rebound_traits = typename allocator_traits
+      ::template rebind_traits<T>;
+    typename rebound_traits::allocator_type rebound(*allocator);
+    rebound_traits::construct(rebound, storage, std::forward<Args>(args)...);
     return *storage;
   }
 
@@ -277,8 +321,10 @@ struct legacy_storage_policy {
       storage_type<T>::dynamic::value, typename storage_type<T>::type
     >::type &storage
   ) {
-    using rebound_alloc = typename allocator_traits::template rebind_alloc<T>;
-    rebound_alloc(*allocator).destroy(storage);
+    using rebound_traits = typename allocator_traits
+      ::template rebind_traits<T>;
+    typename rebound_traits::allocator_type rebound(*allocator);
+    rebound_traits::destroy(rebound, storage);
   }
 
   template <typename T>
@@ -393,6 +439,222 @@ using default_storage_policy = legacy_storage_policy<
   Allocator, AllocationPolicy, IsCopyable
 >;
 
+/**
+ * Allocation counters that do nothing. Used by default by
+ * `block_reuse_storage_policy`.
+ *
+ * @author: Marcelo Juchem <marcelo@fb.com>
+ */
+struct no_allocation_counters {
+  static void on_allocate() {}
+  static void on_deallocate() {}
+  static void on_reuse() {}
+};
+
+/**
+ * Allocation counters for `block_reuse_storage_policy`. They count how many
+ * heap blocks were allocated, deallocated and reused, across every variant
+ * using a storage policy with these counters.
+ *
+ * The counters are atomic, so they can be shared by variants on different
+ * threads. Different `Tag`s get different counters.
+ *
+ * Example:
+ *
+ *  struct message_tag {};
+ *  using counters = allocation_counters<message_tag>;
+ *  using policy = block_reuse_storage_policy<
+ *    std::allocator<void>, dynamic_allocation_policy, true, counters
+ *  >;
+ *
+ *  variant<policy, std::string, std::vector<int>> v;
+ *
+ *  v = std::string("hello");
+ *  v = std::vector<int>{1, 2, 3};
+ *
+ *  // how many of the assignments above needed a new heap block
+ *  auto allocations = counters::allocations();
+ *
+ *  // how many of them reused the previous one
+ *  auto reuses = counters::reuses();
+ *
+ * @author: Marcelo Juchem <marcelo@fb.com>
+ */
+template <typename Tag = void>
+struct allocation_counters {
+  static void on_allocate() { increment(allocations_); }
+  static void on_deallocate() { increment(deallocations_); }
+  static void on_reuse() { increment(reuses_); }
+
+  static std::size_t allocations() { return allocations_.load(); }
+  static std::size_t deallocations() { return deallocations_.load(); }
+  static std::size_t reuses() { return reuses_.load(); }
+
+  static void reset() {
+    allocations_.store(0);
+    deallocations_.store(0);
+    reuses_.store(0);
+  }
+
+private:
+  static void increment(std::atomic<std::size_t> &counter) {
+    counter.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  static std::atomic<std::size_t> allocations_;
+  static std::atomic<std::size_t> deallocations_;
+  static std::atomic<std::size_t> reuses_;
+};
+
+template <typename Tag>
+std::atomic<std::size_t> allocation_counters<Tag>::allocations_(0);
+
+template <typename Tag>
+std::atomic<std::size_t> allocation_counters<Tag>::deallocations_(0);
+
+template <typename Tag>
+std::atomic<std::size_t> allocation_counters<Tag>::reuses_(0);
+
+/**
+ * A storage policy that behaves like `legacy_storage_policy`, except that a
+ * variant assigned a value of a different type can reuse the heap block of
+ * the value it held, rather than deallocating it and allocating a new one.
+ *
+ * To make this possible, heap blocks come in a few sizes only: a power of two
+ * multiple of `alignof(std::max_align_t)`. Any two dynamically allocated types
+ * whose block sizes match can take over each other's block.
+ *
+ * Allocations go through `TAllocator`, which can be an `arena_allocator` - see
+ * `arena_variant`. `TCounters` is notified of every allocation, deallocation
+ * and reuse of a block - see `allocation_counters`.
+ *
+ * Example:
+ *
+ *  using policy = block_reuse_storage_policy<
+ *    std::allocator<void>, dynamic_allocation_policy
+ *  >;
+ *
+ *  variant<policy, std::string, std::vector<int>> v;
+ *
+ *  // allocates a block for `std::string`
+ *  v = std::string("hello");
+ *
+ *  // destroys the string and stores the vector in the same block
+ *  v = std::vector<int>{1, 2, 3};
+ *
+ * @author: Marcelo Juchem <marcelo@fb.com>
+ */
+template <
+  typename TAllocator = std::allocator<void>,
+  typename TAllocationPolicy = default_allocation_policy<>,
+  bool IsCopyable = true,
+  typename TCounters = no_allocation_counters
+>
+struct block_reuse_storage_policy:
+  public legacy_storage_policy<TAllocator, TAllocationPolicy, IsCopyable>
+{
+private:
+  using base = legacy_storage_policy<TAllocator, TAllocationPolicy, IsCopyable>;
+
+public:
+  using allocator_type = typename base::allocator_type;
+  using allocator_traits = typename base::allocator_traits;
+  using counters = TCounters;
+
+  template <typename T>
+  using storage_type = typename base::template storage_type<T>;
+
+  // the unit heap blocks are made of
+  using block = typename std::aligned_storage<
+    alignof(std::max_align_t), alignof(std::max_align_t)
+  >::type;
+
+  // how many units make the heap block used to store `T`, or 0 when `T` is
+  // stored inline
+  template <typename T>
+  constexpr static std::size_t block_size() {
+    return storage_type<T>::dynamic::value
+      ? std::size_t(1) << most_significant_bit<
+          (sizeof(T) + sizeof(block) - 1) / sizeof(block) - 1
+        >::value
+      : 0;
+  }
+
+  // whether the heap block of a `From` can be reused to store a `To`
+  template <typename From, typename To>
+  constexpr static bool can_reuse() {
+    return block_size<From>() && block_size<From>() == block_size<To>();
+  }
+
+  // Methods for when T is stored using DYNAMIC ALLOCATION.
+
+  template <typename T>
+  static void allocate(
+    allocator_type *allocator,
+    typename std::enable_if<
+      storage_type<T>::dynamic::value, typename storage_type<T>::type
+    >::type &storage
+  ) {
+    static_assert(
+      alignof(T) <= alignof(block),
+      "block_reuse_storage_policy: unsupported alignment"
+    );
+
+    auto const p = block_allocator(*allocator).allocate(block_size<T>());
+    storage = static_cast<T *>(static_cast<void *>(p));
+    counters::on_allocate();
+  }
+
+  template <typename T>
+  static void deallocate(
+    allocator_type *allocator,
+    typename std::enable_if<
+      storage_type<T>::dynamic::value, typename storage_type<T>::type
+    >::type &storage
+  ) {
+    block_allocator(*allocator).deallocate(
+      static_cast<block *>(static_cast<void *>(storage)), block_size<T>()
+    );
+    storage = nullptr;
+    counters::on_deallocate();
+  }
+
+  // hands the block of a destroyed `From` over to the storage of a `To`
+  template <typename From, typename To>
+  static void reuse(
+    typename std::enable_if<
+      can_reuse<From, To>(), typename storage_type<From>::type
+    >::type &from,
+    typename storage_type<To>::type &to
+  ) {
+    to = static_cast<To *>(static_cast<void *>(from));
+    counters::on_reuse();
+  }
+
+  // Methods for when T is stored using AUTOMATIC ALLOCATION.
+
+  template <typename T>
+  static void allocate(
+    allocator_type *,
+    typename std::enable_if<
+      !storage_type<T>::dynamic::value, typename storage_type<T>::type
+    >::type &
+  ) {}
+
+  template <typename T>
+  static void deallocate(
+    allocator_type *,
+    typename std::enable_if<
+      !storage_type<T>::dynamic::value, typename storage_type<T>::type
+    >::type &
+  ) {}
+
+private:
+  using block_allocator = typename allocator_traits::template rebind_alloc<
+    block
+  >;
+};
+
 namespace detail {
 namespace variant_impl {
 
@@ -519,6 +781,17 @@ struct variadic_union_traits<TStoragePolicy, TSize, Depth, T> {
     );
   }
 
+  // same as `visit` - see the general case for details
+  template <typename TUnion, typename TVisitor, typename... UArgs>
+  static void dispatch(
+    size_type const depth, TUnion &u, TVisitor &&visitor, UArgs &&...args
+  ) {
+    assert(depth == Depth), (void) depth;
+    visit_at<Depth>(
+      u, std::forward<TVisitor>(visitor), std::forward<UArgs>(args)...
+    );
+  }
+
   static void allocate(
     allocator_type *allocator, size_type const depth, union_type &u
   ) {
@@ -590,6 +863,32 @@ struct variadic_union_traits<TStoragePolicy, TSize, Depth, T> {
     return std::is_same<U, value_type>::value ? Depth : end_depth();
   }
 
+  // the traits for the level at the given depth
+  template <size_type>
+  using at = variadic_union_traits;
+
+  template <size_type Index>
+  static storage_type const &storage(union_type const &u) {
+    static_assert(Index == Depth, "depth out of bounds");
+    return u.storage;
+  }
+
+  template <size_type Index>
+  static storage_type &storage(union_type &u) {
+    static_assert(Index == Depth, "depth out of bounds");
+    return u.storage;
+  }
+
+  template <
+    size_type Index, typename TUnion, typename TVisitor, typename... UArgs
+  >
+  static void visit_at(TUnion &u, TVisitor &&visitor, UArgs &&...args) {
+    visitor(
+      storage_policy::template get<value_type>(storage<Index>(u)),
+      std::forward<UArgs>(args)...
+    );
+  }
+
   template <typename U>
   static storage_type const &get(
     typename std::enable_if<
@@ -707,6 +1006,39 @@ struct variadic_union_traits<TStoragePolicy, TSize, Depth, T, Head, Tail...> {
     }
   }
 
+  /**
+   * Same as `visit`, but rather than comparing `depth` against each level of
+   * the recursion, it looks up the function that visits the given depth in a
+   * table built at compile time, and calls it. Dispatching costs a single
+   * indirect call regardless of the number of types in the union.
+   *
+   * Unions of up to `dispatch_threshold` types are still visited with `visit`,
+   * whose chain of comparisons is short enough to be inlined and turned into
+   * a switch by the compiler, which beats an indirect call.
+   *
+   * `u` can be either a `union_type` or a `union_type const`.
+   *
+   * Example:
+   *
+   *  traits::dispatch(tag, u, visitor, additional_arg);
+   *
+   *  // equivalent to
+   *  traits::visit(tag, u, visitor, additional_arg);
+   *
+   * @author: Marcelo Juchem <marcelo@fb.com>
+   */
+  template <typename TUnion, typename TVisitor, typename... UArgs>
+  static void dispatch(
+    size_type const depth, TUnion &u, TVisitor &&visitor, UArgs &&...args
+  ) {
+    assert(depth >= Depth && depth < end_depth());
+    dispatch(
+      bool_constant<(end_depth() - Depth > dispatch_threshold::value)>(),
+      make_index_sequence<end_depth() - Depth>(), depth, u,
+      std::forward<TVisitor>(visitor), std::forward<UArgs>(args)...
+    );
+  }
+
   static void allocate(
     allocator_type *allocator, size_type const depth, union_type &u
   ) {
@@ -784,6 +1116,90 @@ struct variadic_union_traits<TStoragePolicy, TSize, Depth, T, Head, Tail...> {
       : tail_type::template get_depth<U>();
   }
 
+  // the traits for the level at the given depth
+  template <size_type Index>
+  using at = typename std::conditional<
+    Index == Depth,
+    head_type,
+    typename tail_type::template at<Index>
+  >::type;
+
+  template <size_type Index>
+  static typename at<Index>::storage_type const &storage(
+    typename std::enable_if<Index == Depth, union_type>::type const &u
+  ) {
+    return head_type::template storage<Index>(u.head);
+  }
+
+  template <size_type Index>
+  static typename at<Index>::storage_type &storage(
+    typename std::enable_if<Index == Depth, union_type>::type &u
+  ) {
+    return head_type::template storage<Index>(u.head);
+  }
+
+  template <size_type Index>
+  static typename at<Index>::storage_type const &storage(
+    typename std::enable_if<Index != Depth, union_type>::type const &u
+  ) {
+    return tail_type::template storage<Index>(u.tail);
+  }
+
+  template <size_type Index>
+  static typename at<Index>::storage_type &storage(
+    typename std::enable_if<Index != Depth, union_type>::type &u
+  ) {
+    return tail_type::template storage<Index>(u.tail);
+  }
+
+  // visits the member at the given depth, regardless of the type it holds
+  template <
+    size_type Index, typename TUnion, typename TVisitor, typename... UArgs
+  >
+  static void visit_at(TUnion &u, TVisitor &&visitor, UArgs &&...args) {
+    visitor(
+      storage_policy::template get<typename at<Index>::value_type>(
+        storage<Index>(u)
+      ),
+      std::forward<UArgs>(args)...
+    );
+  }
+
+  // the largest number of types for which `dispatch` falls back to `visit`
+  using dispatch_threshold = size_constant<8>;
+
+private:
+  template <typename TIndexes, typename TUnion, typename... UArgs>
+  static void dispatch(
+    std::false_type, TIndexes, size_type const depth, TUnion &u,
+    UArgs &&...args
+  ) {
+    visit(depth, u, std::forward<UArgs>(args)...);
+  }
+
+  template <
+    std::size_t... Indexes,
+    typename TUnion, typename TVisitor, typename... UArgs
+  >
+  static void dispatch(
+    std::true_type, index_sequence<Indexes...>,
+    size_type const depth, TUnion &u, TVisitor &&visitor, UArgs &&...args
+  ) {
+    using thunk = void (*)(TUnion &, TVisitor &&, UArgs &&...);
+
+    static constexpr thunk table[sizeof...(Indexes)] = {
+      &visit_at<
+        static_cast<size_type>(Depth + Indexes), TUnion, TVisitor, UArgs...
+      >...
+    };
+
+    table[depth - Depth](
+      u, std::forward<TVisitor>(visitor), std::forward<UArgs>(args)...
+    );
+  }
+
+public:
+
   template <typename U>
   static storage_type const &get(
     typename std::enable_if<
@@ -930,6 +1346,19 @@ struct nothrow_mv_assign<T, true> {
   using type = std::true_type;
 };
 
+// tells whether the storage policy can hand the heap block of a `From` over
+// to a `To` - only policies providing `can_reuse()` and `reuse()` can
+template <typename TStoragePolicy, typename From, typename To, typename = void>
+struct can_reuse_block: std::false_type {};
+
+template <typename TStoragePolicy, typename From, typename To>
+struct can_reuse_block<
+  TStoragePolicy, From, To,
+  void_t<decltype(TStoragePolicy::template can_reuse<From, To>())>
+>:
+  bool_constant<TStoragePolicy::template can_reuse<From, To>()>
+{};
+
 } // namespace variant_impl {
 } // namespace detail {
 
@@ -1249,7 +1678,7 @@ public:
       return false;
     }
 
-    traits::template visit(
+    traits::dispatch(
       storedType, union_, std::forward<TVisitor>(visitor),
       std::forward<UArgs>(args)...
     );
@@ -1264,7 +1693,7 @@ public:
       return false;
     }
 
-    traits::template visit(
+    traits::dispatch(
       storedType, union_, std::forward<TVisitor>(visitor),
       std::forward<UArgs>(args)...
     );
@@ -1608,9 +2037,11 @@ private:
       }
     }
 
-    unset_impl(allocator);
+    if (!reuse_block<U>(reuses_block<U>())) {
+      unset_impl(allocator);
+      traits::allocate(allocator, tag<U>(), union_);
+    }
 
-    traits::allocate(allocator, tag<U>(), union_);
     try {
       auto &result = traits::template construct<U>(
         allocator, tag<U>(), union_, std::forward<UArgs>(args)...
@@ -1623,6 +2054,66 @@ private:
     }
   }
 
+  // whether the heap block of some other type can be reused to store a `U`
+  template <typename U>
+  using reuses_block = bool_constant<
+    logical_or<
+      detail::variant_impl::can_reuse_block<
+        storage_policy, typename std::decay<Args>::type, U
+      >...
+    >::value
+  >;
+
+  template <typename U>
+  bool reuse_block(std::false_type) { return false; }
+
+  // destroys the value currently stored, and hands its heap block over to a
+  // `U`, when the storage policy allows it - returns true if it did so
+  template <typename U>
+  bool reuse_block(std::true_type) {
+    auto const storedType = control_.storedType();
+
+    if (storedType == no_tag()) {
+      return false;
+    }
+
+    bool reused = false;
+    traits::dispatch(
+      storedType, union_, block_reuse_visitor<U>(), *this, reused
+    );
+
+    if (reused) {
+      control_.setStoredType(no_tag());
+    }
+
+    return reused;
+  }
+
+  template <typename To>
+  struct block_reuse_visitor {
+    template <typename From>
+    void operator ()(From &, legacy_variant &v, bool &reused) const {
+      reuse<From>(
+        detail::variant_impl::can_reuse_block<storage_policy, From, To>(),
+        v, reused
+      );
+    }
+
+  private:
+    template <typename From>
+    static void reuse(std::false_type, legacy_variant &, bool &) {}
+
+    template <typename From>
+    static void reuse(std::true_type, legacy_variant &v, bool &reused) {
+      auto &from = traits::template get<From>(v.union_);
+      storage_policy::template destroy<From>(v.control_.allocator(), from);
+      storage_policy::template reuse<From, To>(
+        from, traits::template get<To>(v.union_)
+      );
+      reused = true;
+    }
+  };
+
   void unset_impl(allocator_type *allocator) {
     auto const storedType = control_.storedType();
 
@@ -1740,6 +2231,30 @@ using dynamic_variant = variant<
 template <typename... Args>
 using default_dynamic_variant = dynamic_variant<std::allocator<void>, Args...>;
 
+/**
+ * A variant whose dynamically allocated values live in a `monotonic_arena`.
+ *
+ * Since an arena never frees memory on its own, heap blocks are reused across
+ * assignments whenever possible - see `block_reuse_storage_policy`.
+ *
+ * The allocator given to the variant must outlive it.
+ *
+ * Example:
+ *
+ *  monotonic_arena arena;
+ *  arena_allocator<void> allocator(arena);
+ *
+ *  arena_variant<int, std::string> v(allocator);
+ *  v = std::string("allocated from the arena");
+ *
+ * @author: Marcelo Juchem <marcelo@fb.com>
+ */
+template <typename... Args>
+using arena_variant = variant<
+  block_reuse_storage_policy<arena_allocator<void>>,
+  Args...
+>;
+
 /**
  * Wraps non-derived visitors that return a value on operator()
  *
@@ -2120,6 +2635,103 @@ result_type legacy_visit_def(
     : defaultValue;
 }
 
+namespace detail {
+namespace variant_impl {
+
+// visits the next pending variant with the remaining ones, followed by the
+// values visited so far, as additional arguments, then appends the newly
+// visited value to the end of the latter
+template <std::size_t Pending, typename TVisitor>
+struct multi_visitor {
+  template <typename U, typename TVariant, typename... UArgs>
+  void operator ()(U &&value, TVariant &&variant, UArgs &&...args) const {
+    std::forward<TVariant>(variant).visit(
+      multi_visitor<Pending - 1, TVisitor>{visitor},
+      std::forward<UArgs>(args)...,
+      std::forward<U>(value)
+    );
+  }
+
+  TVisitor &visitor;
+};
+
+template <typename TVisitor>
+struct multi_visitor<0, TVisitor> {
+  template <typename U, typename... UArgs>
+  void operator ()(U &&value, UArgs &&...visited) const {
+    visitor(std::forward<UArgs>(visited)..., std::forward<U>(value));
+  }
+
+  TVisitor &visitor;
+};
+
+template <typename TVisitor, typename TVariant, typename... Variants>
+void multi_visit(
+  TVisitor &visitor, TVariant &&variant, Variants &&...variants
+) {
+  std::forward<TVariant>(variant).visit(
+    multi_visitor<sizeof...(Variants), TVisitor>{visitor},
+    std::forward<Variants>(variants)...
+  );
+}
+
+} // namespace variant_impl {
+} // namespace detail {
+
+/**
+ * Visits the values stored in all the given variants at once, calling
+ * `visitor(value_1, value_2, ..., value_n)`, where each `value_i` has the
+ * actual type stored in the i-th variant.
+ *
+ * Each variant is dispatched through a jump table, so the overhead is one
+ * indirect call per variant, rather than a search over the cartesian product
+ * of the types.
+ *
+ * If any of the variants is empty, the visitor is not called.
+ *
+ * Returns true if the visitor has been called, false otherwise.
+ *
+ * Example:
+ *
+ *  struct visitor {
+ *    void operator ()(int lhs, int rhs) const { std::cout << lhs + rhs; }
+ *
+ *    template <typename T, typename U>
+ *    void operator ()(T const &, U const &) const { std::cout << "mixed"; }
+ *  };
+ *
+ *  default_variant<int, std::string> a(10);
+ *  default_variant<int, double> b(20);
+ *
+ *  // prints `30`
+ *  multi_visit(visitor(), a, b);
+ *
+ *  b = 5.6;
+ *
+ *  // prints `mixed`
+ *  multi_visit(visitor(), a, b);
+ *
+ * @author: Marcelo Juchem <marcelo@fb.com>
+ */
+template <typename TVisitor, typename... Variants>
+bool multi_visit(TVisitor &&visitor, Variants &&...variants) {
+  static_assert(sizeof...(Variants) > 0, "no variants to visit");
+
+  bool const empty[] = { variants.empty()... };
+
+  for (auto const i: empty) {
+    if (i) {
+      return false;
+    }
+  }
+
+  detail::variant_impl::multi_visit(
+    visitor, std::forward<Variants>(variants)...
+  );
+
+  return true;
+}
+
 } // namespace fatal {
 
 namespace std {
@@ -0,0 +1,331 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef FATAL_INCLUDE_fatal_container_mirrored_ring_buffer_h
+#define FATAL_INCLUDE_fatal_container_mirrored_ring_buffer_h
+
+#include <fatal/string/string_view.h>
+
+#include <algorithm>
+#include <system_error>
+#include <utility>
+
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace fatal {
+namespace detail {
+namespace mirrored_ring_buffer_impl {
+
+[[noreturn]] inline void fail(char const *what) {
+  throw std::system_error(errno, std::system_category(), what);
+}
+
+// an anonymous file backing the buffer, closed on destruction since the
+// mappings keep the memory alive
+struct backing_file {
+  backing_file() {
+#   ifdef __linux__
+    fd = ::memfd_create("fatal::mirrored_ring_buffer", MFD_CLOEXEC);
+
+    if (fd < 0) {
+      fail("memfd_create");
+    }
+#   else // __linux__
+    char name[] = "/fatal_mirrored_ring_buffer_XXXXXX";
+    std::size_t const suffix = sizeof(name) - 7;
+
+    for (auto attempt = 0; fd < 0; ++attempt) {
+      auto seed = reinterpret_cast<std::uintptr_t>(this)
+        ^ static_cast<std::uintptr_t>(::getpid())
+        ^ static_cast<std::uintptr_t>(attempt) * 2654435761u;
+
+      for (auto i = suffix; i < sizeof(name) - 1; ++i, seed /= 36) {
+        name[i] = "0123456789abcdefghijklmnopqrstuvwxyz"[seed % 36];
+      }
+
+      fd = ::shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+
+      if (fd < 0 && (errno != EEXIST || attempt == 100)) {
+        fail("shm_open");
+      }
+    }
+
+    ::shm_unlink(name);
+#   endif // __linux__
+  }
+
+  backing_file(backing_file const &) = delete;
+  backing_file(backing_file &&) = delete;
+
+  ~backing_file() { ::close(fd); }
+
+  int fd = -1;
+};
+
+inline std::size_t page_size() {
+  auto const result = ::sysconf(_SC_PAGESIZE);
+
+  if (result <= 0) {
+    fail("sysconf");
+  }
+
+  return static_cast<std::size_t>(result);
+}
+
+} // namespace mirrored_ring_buffer_impl {
+} // namespace detail {
+
+/**
+ * A byte ring buffer whose memory is mapped twice, back to back, so that
+ * both the readable and the writable regions are always contiguous, even
+ * when they wrap around the end of the buffer.
+ *
+ * This means parsers can work directly on `readable()` without handling data
+ * split in two chunks, like the ones returned by `circular_queue`, and without
+ * copying it out first. Likewise, `writable()` can be handed as is to a
+ * single `read()` call.
+ *
+ * The capacity is rounded up to a multiple of the page size. The buffer
+ * never grows.
+ *
+ * Throws `std::system_error` when the underlying memory can't be mapped.
+ *
+ * Example:
+ *
+ *  mirrored_ring_buffer buffer(64 * 1024);
+ *
+ *  for (;;) {
+ *    auto const bytes = ::read(socket, buffer.writable(), buffer.available());
+ *
+ *    if (bytes <= 0) {
+ *      break;
+ *    }
+ *
+ *    buffer.commit(static_cast<std::size_t>(bytes));
+ *
+ *    // calls `handle` for every complete line, leaving any trailing partial
+ *    // line in the buffer, to be completed by the next `read()`
+ *    buffer.consume_tokens<line_tokenizer>(handle);
+ *  }
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+class mirrored_ring_buffer {
+public:
+  using size_type = std::size_t;
+
+  explicit mirrored_ring_buffer(size_type capacity) {
+    namespace impl = detail::mirrored_ring_buffer_impl;
+
+    auto const page = impl::page_size();
+    capacity_ = std::max(
+      static_cast<size_type>(1),
+      (capacity + page - 1) / page
+    ) * page;
+
+    impl::backing_file file;
+
+    if (::ftruncate(file.fd, static_cast<off_t>(capacity_))) {
+      impl::fail("ftruncate");
+    }
+
+    // reserves the address space for both mappings
+    auto const reserved = ::mmap(
+      nullptr, capacity_ * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0
+    );
+
+    if (reserved == MAP_FAILED) {
+      impl::fail("mmap");
+    }
+
+    data_ = static_cast<char *>(reserved);
+
+    for (auto i = 0; i < 2; ++i) {
+      auto const address = data_ + capacity_ * static_cast<size_type>(i);
+      auto const mapped = ::mmap(
+        address, capacity_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+        file.fd, 0
+      );
+
+      if (mapped != address) {
+        auto const error = errno;
+        ::munmap(data_, capacity_ * 2);
+        errno = error;
+        impl::fail("mmap");
+      }
+    }
+  }
+
+  mirrored_ring_buffer(mirrored_ring_buffer const &) = delete;
+
+  mirrored_ring_buffer(mirrored_ring_buffer &&rhs) noexcept:
+    data_(rhs.data_),
+    capacity_(rhs.capacity_),
+    head_(rhs.head_),
+    size_(rhs.size_)
+  {
+    rhs.data_ = nullptr;
+    rhs.capacity_ = 0;
+    rhs.head_ = 0;
+    rhs.size_ = 0;
+  }
+
+  mirrored_ring_buffer &operator =(mirrored_ring_buffer const &) = delete;
+
+  mirrored_ring_buffer &operator =(mirrored_ring_buffer &&rhs) noexcept {
+    swap(rhs);
+    return *this;
+  }
+
+  ~mirrored_ring_buffer() noexcept {
+    if (data_) {
+      ::munmap(data_, capacity_ * 2);
+    }
+  }
+
+  /**
+   * The bytes written but not yet consumed, as a single contiguous view.
+   *
+   * The view remains valid until those bytes are consumed.
+   */
+  string_view readable() const {
+    return string_view(data_ + head_, size_);
+  }
+
+  /**
+   * Where to write up to `available()` bytes, which become readable once
+   * `commit()`ed.
+   */
+  char *writable() noexcept {
+    auto const tail = head_ + size_;
+    return data_ + (tail < capacity_ ? tail : tail - capacity_);
+  }
+
+  /**
+   * Makes the first `size` bytes written to `writable()` readable.
+   */
+  void commit(size_type size) noexcept {
+    assert(size <= available());
+    size_ += size;
+  }
+
+  /**
+   * Discards the first `size` readable bytes.
+   */
+  void consume(size_type size) noexcept {
+    assert(size <= size_);
+    size_ -= size;
+    auto const head = head_ + size;
+    head_ = !size_ ? 0 : head < capacity_ ? head : head - capacity_;
+  }
+
+  /**
+   * Copies as much of `data` as fits, returning how many bytes were written.
+   */
+  size_type write(string_view data) noexcept {
+    auto const size = std::min(data.size(), available());
+
+    if (size) {
+      std::memcpy(writable(), data.data(), size);
+      commit(size);
+    }
+
+    return size;
+  }
+
+  /**
+   * Calls `visitor(token, args...)` for every readable token terminated by
+   * the delimiter of `Tokenizer` (e.g.: `line_tokenizer`), then consumes
+   * them, along with their delimiters.
+   *
+   * Tokens are built from views into the buffer, so that no bytes are
+   * copied. Any bytes following the last delimiter are kept, since they may
+   * be completed by a subsequent write.
+   *
+   * Returns the number of tokens visited.
+   *
+   * Example:
+   *
+   *  mirrored_ring_buffer buffer(4096);
+   *  buffer.write("a,b\nc,d\ne,");
+   *
+   *  // calls `visitor` with a `comma_tokenizer` for "a,b" and one for "c,d"
+   *  buffer.consume_tokens<csv_tokenizer>(visitor);
+   *
+   *  // yields "e,"
+   *  buffer.readable();
+   */
+  template <typename Tokenizer, typename Visitor, typename... Args>
+  size_type consume_tokens(Visitor &&visitor, Args &&...args) {
+    using token = typename Tokenizer::token;
+
+    auto const data = readable();
+    auto remaining = data;
+    size_type count = 0;
+
+    for (;;) {
+      auto const i = remaining.find(Tokenizer::delimiter::value);
+
+      if (i == remaining.end()) {
+        break;
+      }
+
+      visitor(token(string_view(remaining.begin(), i)), args...);
+      remaining.reset(std::next(i));
+      ++count;
+    }
+
+    consume(data.size() - remaining.size());
+    return count;
+  }
+
+  void clear() noexcept {
+    head_ = 0;
+    size_ = 0;
+  }
+
+  size_type capacity() const noexcept { return capacity_; }
+  size_type size() const noexcept { return size_; }
+  size_type available() const noexcept { return capacity_ - size_; }
+  bool empty() const noexcept { return !size_; }
+  bool full() const noexcept { return size_ == capacity_; }
+
+  void swap(mirrored_ring_buffer &other) noexcept {
+    using std::swap;
+    swap(data_, other.data_);
+    swap(capacity_, other.capacity_);
+    swap(head_, other.head_);
+    swap(size_, other.size_);
+  }
+
+private:
+  char *data_ = nullptr;
+  size_type capacity_ = 0;
+  size_type head_ = 0;
+  size_type size_ = 0;
+};
+
+inline void swap(
+  mirrored_ring_buffer &lhs,
+  mirrored_ring_buffer &rhs
+) noexcept {
+  lhs.swap(rhs);
+}
+
+} // namespace fatal {
+
+#endif // FATAL_INCLUDE_fatal_container_mirrored_ring_buffer_h
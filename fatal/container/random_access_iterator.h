@@ -17,6 +17,8 @@
 #include <memory>
 #include <type_traits>
 
+#include <cassert>
+
 namespace fatal {
 namespace detail {
 
@@ -10,19 +10,22 @@
 #ifndef FATAL_INCLUDE_fatal_container_runtime_array_h
 #define FATAL_INCLUDE_fatal_container_runtime_array_h
 
-#include <fatal/container/variadic_union.h>
-
 #include <fatal/portability.h>
 
-#include <array>
+#include <algorithm>
 #include <iterator>
 #include <limits>
 #include <memory>
+#include <new>
 #include <stdexcept>
 #include <type_traits>
 #include <utility>
 
 #include <cassert>
+#include <cstring>
+
+FATAL_DIAGNOSTIC_PUSH
+FATAL_GCC_DIAGNOSTIC_IGNORED_SHADOW_IF_BROKEN
 
 namespace fatal {
 namespace detail {
@@ -35,15 +38,67 @@ using size = std::integral_constant<
   std::size_t, Bytes / sizeof(T) ? Bytes / sizeof(T) : 1
 >;
 
+// the allocator is a base so that stateless allocators take no space
+template <typename Allocator>
+struct storage: Allocator {
+  using pointer = typename std::allocator_traits<Allocator>::value_type *;
+
+  explicit storage(Allocator const &allocator): Allocator(allocator) {}
+  explicit storage(Allocator &&allocator): Allocator(std::move(allocator)) {}
+
+  Allocator &allocator() noexcept { return *this; }
+  Allocator const &allocator() const noexcept { return *this; }
+
+  pointer data;
+  std::size_t capacity;
+};
+
 } // namespace runtime_array_impl {
 } // namespace detail {
 
+/**
+ * An array whose size is only known at runtime, which keeps up to
+ * `SmallBufferSize` elements inline, only allocating memory from `Allocator`
+ * for bigger arrays.
+ *
+ * Elements are default-initialized, like the ones of a plain array: elements
+ * of trivially constructible types are left uninitialized, so that no time is
+ * spent zeroing scratch memory. Use the constructor or the `resize` overload
+ * taking a value to initialize them.
+ *
+ * `resize`, `assign` and the assignment operators reuse the current storage
+ * whenever it's big enough. Trivially copyable elements are copied with
+ * `std::memcpy` and trivially destructible ones are never visited on
+ * destruction.
+ *
+ * Any STL-style allocator can be used, like `arena_allocator`, which can
+ * serve allocations from a buffer on the stack.
+ *
+ * Example:
+ *
+ *  // up to 32 elements kept inline, no allocations
+ *  runtime_array<int, 32> small(n);
+ *
+ *  // allocations served from `buffer` while there's room in it
+ *  char buffer[4096];
+ *  monotonic_arena arena(buffer, sizeof(buffer));
+ *  runtime_array<int, 0, arena_allocator<int>> scratch(
+ *    n, arena_allocator<int>(arena)
+ *  );
+ *
+ *  // no allocation as long as `m <= scratch.capacity()`
+ *  scratch.resize(m);
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
 template <
   typename T,
-  std::size_t SmallBufferSize = detail::runtime_array_impl::size<T>::value
+  std::size_t SmallBufferSize = detail::runtime_array_impl::size<T>::value,
+  typename Allocator = std::allocator<T>
 >
 struct runtime_array {
   using value_type = T;
+  using allocator_type = Allocator;
 
   using const_pointer = value_type const *;
   using pointer = value_type *;
@@ -61,74 +116,232 @@ struct runtime_array {
     "small buffer size is too big"
   );
 
+  static_assert(
+    std::is_same<typename allocator_type::value_type, value_type>::value,
+    "allocator must allocate elements of the array's value_type"
+  );
+
 private:
   using small_size = std::integral_constant<size_type, SmallBufferSize>;
-  using static_type = std::array<value_type, small_size::value>;
-  using dynamic_type = std::unique_ptr<value_type[]>;
-  using container_type = variadic_union<static_type, dynamic_type>;
+  using allocator_traits = std::allocator_traits<allocator_type>;
+  using storage_type = detail::runtime_array_impl::storage<allocator_type>;
+  using buffer_type = typename std::aligned_storage<
+    sizeof(value_type) * (small_size::value ? small_size::value : 1),
+    alignof(value_type)
+  >::type;
+
+  using trivial_default = std::integral_constant<
+    bool, FATAL_IS_TRIVIALLY_DEFAULT_CONSTRUCTIBLE(value_type)
+  >;
+  using trivial_copy = std::integral_constant<
+    bool, FATAL_IS_TRIVIALLY_COPYABLE(value_type)
+  >;
+  using trivial_destructor = std::is_trivially_destructible<value_type>;
 
 public:
+  explicit runtime_array(
+    size_type size,
+    allocator_type const &allocator = allocator_type()
+  ):
+    storage_(allocator)
+  {
+    acquire(size);
+    construct(data(), size);
+    size_ = size;
+  }
 
-FATAL_DIAGNOSTIC_PUSH
-FATAL_GCC_DIAGNOSTIC_IGNORED_SHADOW_IF_BROKEN
-
-  explicit runtime_array(size_type size):
-    size_(size)
+  runtime_array(
+    size_type size,
+    const_reference value,
+    allocator_type const &allocator = allocator_type()
+  ):
+    storage_(allocator)
   {
-    if (is_small()) {
-      data_ = container_.template construct<static_type>().data();
-    } else {
-      data_ = container_.template construct<dynamic_type>(
-        new value_type[size_]
-      ).get();
-    }
+    acquire(size);
+    construct(data(), size, value);
+    size_ = size;
   }
 
   runtime_array(runtime_array const &rhs):
-    size_(rhs.size_)
+    storage_(
+      allocator_traits::select_on_container_copy_construction(
+        rhs.get_allocator()
+      )
+    )
+  {
+    acquire(rhs.size_);
+    copy(data(), rhs.data(), rhs.size_);
+    size_ = rhs.size_;
+  }
+
+  runtime_array(runtime_array &&rhs)
+    noexcept(std::is_nothrow_move_constructible<value_type>::value)
+  :
+    storage_(std::move(rhs.storage_.allocator()))
   {
     if (rhs.is_small()) {
-      data_ = container_.template construct<static_type>(
-        rhs.container_.template ref<static_type>()
-      ).data();
-    } else {
-      data_ = container_.template construct<dynamic_type>(
-        new value_type[size_]
-      ).get();
+      acquire(rhs.size_);
+      relocate(data(), rhs.data(), rhs.size_);
+      size_ = rhs.size_;
+      return;
+    }
+
+    storage_.data = rhs.storage_.data;
+    storage_.capacity = rhs.storage_.capacity;
+    size_ = rhs.size_;
+
+    rhs.storage_.data = rhs.small_data();
+    rhs.storage_.capacity = small_size::value;
+    rhs.size_ = 0;
+  }
 
-      auto input = rhs.container_.template ref<dynamic_type>().get();
-      auto end = std::copy(input, std::next(input, size_), data_);
-      assert(std::next(data_, size_) == end);
+  ~runtime_array() {
+    destroy(data(), size_);
+    release();
+  }
+
+  runtime_array &operator =(runtime_array const &rhs) {
+    if (this != std::addressof(rhs)) {
+      assign(rhs.begin(), rhs.end());
     }
+
+    return *this;
   }
 
-FATAL_DIAGNOSTIC_POP
+  runtime_array &operator =(runtime_array &&rhs) {
+    if (this == std::addressof(rhs)) {
+      return *this;
+    }
 
-  runtime_array(runtime_array &&rhs):
-    size_(rhs.size_)
-  {
-    if (rhs.is_small()) {
-      data_ = container_.template construct<static_type>(
-        std::move(rhs.container_.template ref<static_type>())
-      ).data();
-    } else {
-      data_ = container_.template construct<dynamic_type>(
-        std::move(rhs.container_.template ref<dynamic_type>())
-      ).get();
+    if (rhs.is_small() || get_allocator() != rhs.get_allocator()) {
+      assign(
+        std::make_move_iterator(rhs.begin()),
+        std::make_move_iterator(rhs.end())
+      );
+      return *this;
+    }
+
+    destroy(data(), size_);
+    release();
+
+    storage_.data = rhs.storage_.data;
+    storage_.capacity = rhs.storage_.capacity;
+    size_ = rhs.size_;
+
+    rhs.storage_.data = rhs.small_data();
+    rhs.storage_.capacity = small_size::value;
+    rhs.size_ = 0;
+
+    return *this;
+  }
+
+  /**
+   * Changes the number of elements to `size`, default-initializing the new
+   * ones.
+   *
+   * Only reallocates when `size` exceeds the capacity.
+   */
+  void resize(size_type size) {
+    reserve(size);
+    resize_in_place(size, [](pointer to, size_type count) {
+      construct(to, count);
+    });
+  }
+
+  /**
+   * Changes the number of elements to `size`, initializing the new ones as
+   * copies of `value`.
+   *
+   * Only reallocates when `size` exceeds the capacity.
+   */
+  void resize(size_type size, const_reference value) {
+    if (size > capacity()) {
+      value_type copy(value);
+      reserve(size);
+      resize_in_place(size, [&copy](pointer to, size_type count) {
+        construct(to, count, copy);
+      });
+      return;
     }
+
+    resize_in_place(size, [&value](pointer to, size_type count) {
+      construct(to, count, value);
+    });
   }
 
-  ~runtime_array() {
-    if (is_small()) {
-      container_.template destroy<static_type>();
-    } else {
-      container_.template destroy<dynamic_type>();
+  /**
+   * Replaces the contents with `size` copies of `value`.
+   *
+   * Only reallocates when `size` exceeds the capacity.
+   */
+  void assign(size_type size, const_reference value) {
+    if (size > capacity()) {
+      value_type copy(value);
+      clear();
+      reserve(size);
+      construct(data(), size, copy);
+      size_ = size;
+      return;
+    }
+
+    auto const common = std::min(size, size_);
+    std::fill(data(), data() + common, value);
+    resize_in_place(size, [&value](pointer to, size_type count) {
+      construct(to, count, value);
+    });
+  }
+
+  /**
+   * Replaces the contents with the elements in `[first, last)`, which must
+   * not point into this array.
+   *
+   * Only reallocates when there are more elements than the capacity.
+   */
+  template <
+    typename TIterator,
+    typename = typename std::enable_if<
+      !std::is_integral<TIterator>::value
+    >::type
+  >
+  void assign(TIterator first, TIterator last) {
+    auto const size = static_cast<size_type>(std::distance(first, last));
+
+    if (size > capacity()) {
+      clear();
+      reserve(size);
+      copy(data(), first, size);
+      size_ = size;
+      return;
     }
+
+    auto const common = std::min(size, size_);
+    first = copy_assign(data(), first, common);
+    resize_in_place(size, [&first](pointer to, size_type count) {
+      copy(to, first, count);
+    });
+  }
+
+  /**
+   * Makes sure there's room for at least `size` elements without further
+   * reallocations.
+   */
+  void reserve(size_type size) {
+    if (size > capacity()) {
+      reallocate(size);
+    }
+  }
+
+  /**
+   * Destroys all elements, keeping the storage for future use.
+   */
+  void clear() noexcept {
+    destroy(data(), size_);
+    size_ = 0;
   }
 
   const_reference at(size_type i) const {
     if (i < size_) {
-      return data_[i];
+      return data()[i];
     }
 
     throw std::out_of_range("index out of bounds");
@@ -136,7 +349,7 @@ FATAL_DIAGNOSTIC_POP
 
   reference at(size_type i) {
     if (i < size_) {
-      return data_[i];
+      return data()[i];
     }
 
     throw std::out_of_range("index out of bounds");
@@ -144,36 +357,240 @@ FATAL_DIAGNOSTIC_POP
 
   const_reference operator [](size_type i) const {
     assert(i < size_);
-    return data_[i];
+    return data()[i];
   }
 
   reference operator [](size_type i) {
     assert(i < size_);
-    return data_[i];
+    return data()[i];
   }
 
-  pointer data() const { return data_; }
-  pointer data() { return data_; }
+  pointer data() const { return storage_.data; }
+  pointer data() { return storage_.data; }
 
-  const_iterator cbegin() const { return data_; }
-  const_iterator begin() const { return data_; }
-  iterator begin() { return data_; }
+  const_iterator cbegin() const { return data(); }
+  const_iterator begin() const { return data(); }
+  iterator begin() { return data(); }
 
-  const_iterator cend() const { return std::next(data_, size_); }
-  const_iterator end() const { return std::next(data_, size_); }
-  iterator end() { return std::next(data_, size_); }
+  const_iterator cend() const { return std::next(data(), size_); }
+  const_iterator end() const { return std::next(data(), size_); }
+  iterator end() { return std::next(data(), size_); }
 
   size_type size() const { return size_; }
+  size_type capacity() const { return storage_.capacity; }
   bool empty() const { return !size_; }
 
+  allocator_type get_allocator() const { return storage_.allocator(); }
+
 private:
-  bool is_small() const { return size_ <= small_size::value; }
+  pointer small_data() noexcept {
+    return reinterpret_cast<pointer>(std::addressof(buffer_));
+  }
+
+  bool is_small() const noexcept {
+    return storage_.data == reinterpret_cast<const_pointer>(
+      std::addressof(buffer_)
+    );
+  }
+
+  // points the storage to the small buffer or to newly allocated memory,
+  // depending on `size`
+  void acquire(size_type size) {
+    if (size <= small_size::value) {
+      storage_.data = small_data();
+      storage_.capacity = small_size::value;
+    } else {
+      storage_.data = allocator_traits::allocate(storage_.allocator(), size);
+      storage_.capacity = size;
+    }
+  }
+
+  void release() noexcept {
+    if (!is_small()) {
+      allocator_traits::deallocate(
+        storage_.allocator(), storage_.data, storage_.capacity
+      );
+    }
+  }
+
+  // moves the elements to newly allocated memory for `size` elements
+  void reallocate(size_type size) {
+    assert(size > small_size::value);
+    auto const to = allocator_traits::allocate(storage_.allocator(), size);
+
+    try {
+      relocate(to, data(), size_);
+    } catch (...) {
+      allocator_traits::deallocate(storage_.allocator(), to, size);
+      throw;
+    }
+
+    destroy(data(), size_);
+    release();
+
+    storage_.data = to;
+    storage_.capacity = size;
+  }
+
+  // grows or shrinks the array within its current capacity, constructing new
+  // elements with `fill(begin, count)`
+  template <typename Fill>
+  void resize_in_place(size_type size, Fill &&fill) {
+    assert(size <= capacity());
+
+    if (size < size_) {
+      destroy(data() + size, size_ - size);
+    } else {
+      fill(data() + size_, size - size_);
+    }
 
-  size_type const size_;
-  pointer data_;
-  container_type container_;
+    size_ = size;
+  }
+
+  // constructs `count` default-initialized elements, which are left
+  // uninitialized for trivially constructible types
+  static void construct(pointer to, size_type count) {
+    construct(to, count, trivial_default());
+  }
+
+  static void construct(pointer, size_type, std::true_type) noexcept {}
+
+  static void construct(pointer to, size_type count, std::false_type) {
+    size_type i = 0;
+
+    try {
+      for (; i < count; ++i) {
+        new (static_cast<void *>(to + i)) value_type;
+      }
+    } catch (...) {
+      destroy(to, i);
+      throw;
+    }
+  }
+
+  static void construct(pointer to, size_type count, const_reference value) {
+    size_type i = 0;
+
+    try {
+      for (; i < count; ++i) {
+        new (static_cast<void *>(to + i)) value_type(value);
+      }
+    } catch (...) {
+      destroy(to, i);
+      throw;
+    }
+  }
+
+  // copy constructs `count` elements from `from`, returning the iterator
+  // past the last element copied
+  template <typename TIterator>
+  static TIterator copy(pointer to, TIterator from, size_type count) {
+    return copy(
+      to, from, count,
+      std::integral_constant<
+        bool,
+        trivial_copy::value
+          && std::is_pointer<TIterator>::value
+          && std::is_same<
+            typename std::remove_cv<
+              typename std::remove_pointer<TIterator>::type
+            >::type,
+            value_type
+          >::value
+      >()
+    );
+  }
+
+  template <typename TIterator>
+  static TIterator copy(
+    pointer to,
+    TIterator from,
+    size_type count,
+    std::true_type
+  ) noexcept {
+    if (count) {
+      std::memcpy(to, from, count * sizeof(value_type));
+    }
+
+    return from + count;
+  }
+
+  template <typename TIterator>
+  static TIterator copy(
+    pointer to,
+    TIterator from,
+    size_type count,
+    std::false_type
+  ) {
+    size_type i = 0;
+
+    try {
+      for (; i < count; ++i, ++from) {
+        new (static_cast<void *>(to + i)) value_type(*from);
+      }
+    } catch (...) {
+      destroy(to, i);
+      throw;
+    }
+
+    return from;
+  }
+
+  // copy assigns `count` elements from `from`, returning the iterator past
+  // the last element copied
+  template <typename TIterator>
+  static TIterator copy_assign(pointer to, TIterator from, size_type count) {
+    for (auto const end = to + count; to != end; ++to, ++from) {
+      *to = *from;
+    }
+
+    return from;
+  }
+
+  // moves `count` elements to uninitialized memory, leaving the source
+  // elements alive
+  static void relocate(pointer to, pointer from, size_type count) {
+    relocate(to, from, count, trivial_copy());
+  }
+
+  static void relocate(
+    pointer to,
+    pointer from,
+    size_type count,
+    std::true_type
+  ) noexcept {
+    copy(to, from, count, std::true_type());
+  }
+
+  static void relocate(
+    pointer to,
+    pointer from,
+    size_type count,
+    std::false_type
+  ) {
+    copy(to, std::make_move_iterator(from), count, std::false_type());
+  }
+
+  static void destroy(pointer begin, size_type count) noexcept {
+    static_assert(
+      std::is_nothrow_destructible<value_type>::value,
+      "value_type must provide a noexcept destructor"
+    );
+
+    if (!trivial_destructor::value) {
+      for (auto const end = begin + count; begin != end; ++begin) {
+        begin->~value_type();
+      }
+    }
+  }
+
+  storage_type storage_;
+  size_type size_ = 0;
+  buffer_type buffer_;
 };
 
 } // namespace fatal {
 
+FATAL_DIAGNOSTIC_POP
+
 #endif // FATAL_INCLUDE_fatal_container_runtime_array_h
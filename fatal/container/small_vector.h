@@ -0,0 +1,1101 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef FATAL_INCLUDE_fatal_container_small_vector_h
+#define FATAL_INCLUDE_fatal_container_small_vector_h
+
+#include <fatal/portability.h>
+
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <cassert>
+#include <cstring>
+
+FATAL_DIAGNOSTIC_PUSH
+FATAL_GCC_DIAGNOSTIC_IGNORED_SHADOW_IF_BROKEN
+
+namespace fatal {
+
+/**
+ * Tells whether objects of type `T` can be moved to another address with
+ * `std::memcpy`, without calling their move constructor and destructor.
+ *
+ * This holds for trivially copyable types, and for most types that don't
+ * keep pointers into themselves. Specialize it as `std::true_type` for such
+ * types in order to let containers like `small_vector` grow, insert and
+ * erase using `std::memcpy` and `std::memmove`.
+ *
+ * Example:
+ *
+ *  struct handle {
+ *    handle(handle &&rhs): p_(rhs.p_) { rhs.p_ = nullptr; }
+ *    ~handle() { delete p_; }
+ *
+ *  private:
+ *    int *p_;
+ *  };
+ *
+ *  namespace fatal {
+ *    template <>
+ *    struct is_trivially_relocatable<handle>: std::true_type {};
+ *  }
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+template <typename T>
+struct is_trivially_relocatable:
+  std::integral_constant<bool, FATAL_IS_TRIVIALLY_COPYABLE(T)>
+{};
+
+namespace detail {
+namespace small_vector_impl {
+
+// the allocator is a base so that stateless allocators take no space
+template <typename Allocator>
+struct storage: Allocator {
+  using pointer = typename std::allocator_traits<Allocator>::value_type *;
+
+  explicit storage(Allocator const &allocator): Allocator(allocator) {}
+  explicit storage(Allocator &&allocator): Allocator(std::move(allocator)) {}
+
+  Allocator &allocator() noexcept { return *this; }
+  Allocator const &allocator() const noexcept { return *this; }
+
+  pointer data;
+  std::size_t capacity;
+};
+
+} // namespace small_vector_impl {
+} // namespace detail {
+
+/**
+ * A vector that keeps up to `SmallBufferSize` elements inline, only
+ * allocating memory from `Allocator` once it grows bigger than that.
+ *
+ * Storage is always contiguous: when the inline buffer runs out of room,
+ * all elements are moved to the heap. `shrink_to_fit()` moves them back
+ * whenever they fit in the inline buffer again.
+ *
+ * Elements are moved around with `std::memcpy` and `std::memmove` when
+ * growing, inserting and erasing, as long as they are trivially relocatable
+ * (refer to `is_trivially_relocatable`). Otherwise, they are moved with their
+ * move constructor when it doesn't throw, or copied otherwise, so that
+ * growing gives the strong exception guarantee.
+ *
+ * Moving a `small_vector` whose elements are inline moves the elements,
+ * therefore iterators are invalidated, unlike with `std::vector`.
+ *
+ * Example:
+ *
+ *  // no allocations for up to 4 elements
+ *  small_vector<int, 4> v{1, 2, 3};
+ *
+ *  v.push_back(4);
+ *  assert(v.is_inline());
+ *
+ *  // all elements are moved to the heap
+ *  v.insert(v.begin(), 0);
+ *  assert(!v.is_inline());
+ *
+ *  // elements are moved back inline
+ *  v.erase(v.begin(), v.begin() + 2);
+ *  v.shrink_to_fit();
+ *  assert(v.is_inline());
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+template <
+  typename T,
+  std::size_t SmallBufferSize = 8,
+  typename Allocator = std::allocator<T>
+>
+struct small_vector {
+  using value_type = T;
+  using allocator_type = Allocator;
+
+  using const_pointer = value_type const *;
+  using pointer = value_type *;
+
+  using const_reference = value_type const &;
+  using reference = value_type &;
+
+  using const_iterator = const_pointer;
+  using iterator = pointer;
+
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+
+  /**
+   * The number of elements kept inline.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  using small_buffer_size = std::integral_constant<size_type, SmallBufferSize>;
+
+  static_assert(
+    std::is_same<typename allocator_type::value_type, value_type>::value,
+    "allocator must allocate elements of the vector's value_type"
+  );
+
+private:
+  using allocator_traits = std::allocator_traits<allocator_type>;
+  using storage_type = detail::small_vector_impl::storage<allocator_type>;
+  using buffer_type = typename std::aligned_storage<
+    sizeof(value_type)
+      * (small_buffer_size::value ? small_buffer_size::value : 1),
+    alignof(value_type)
+  >::type;
+
+  using relocatable = is_trivially_relocatable<value_type>;
+  using trivial_destructor = std::is_trivially_destructible<value_type>;
+
+public:
+  small_vector(): small_vector(allocator_type()) {}
+
+  explicit small_vector(allocator_type const &allocator):
+    storage_(allocator)
+  {
+    storage_.data = small_data();
+    storage_.capacity = small_buffer_size::value;
+  }
+
+  /**
+   * Constructs a vector with `size` value-initialized elements.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  explicit small_vector(
+    size_type size,
+    allocator_type const &allocator = allocator_type()
+  ):
+    small_vector(allocator)
+  {
+    resize(size);
+  }
+
+  small_vector(
+    size_type size,
+    const_reference value,
+    allocator_type const &allocator = allocator_type()
+  ):
+    small_vector(allocator)
+  {
+    insert(end(), size, value);
+  }
+
+  template <
+    typename TIterator,
+    typename = typename std::enable_if<
+      !std::is_integral<TIterator>::value
+    >::type
+  >
+  small_vector(
+    TIterator first,
+    TIterator last,
+    allocator_type const &allocator = allocator_type()
+  ):
+    small_vector(allocator)
+  {
+    insert(end(), first, last);
+  }
+
+  small_vector(
+    std::initializer_list<value_type> values,
+    allocator_type const &allocator = allocator_type()
+  ):
+    small_vector(values.begin(), values.end(), allocator)
+  {}
+
+  small_vector(small_vector const &rhs):
+    small_vector(
+      rhs.begin(), rhs.end(),
+      allocator_traits::select_on_container_copy_construction(
+        rhs.get_allocator()
+      )
+    )
+  {}
+
+  small_vector(small_vector &&rhs)
+    noexcept(
+      relocatable::value
+        || std::is_nothrow_move_constructible<value_type>::value
+    )
+  :
+    storage_(std::move(rhs.storage_.allocator()))
+  {
+    storage_.data = small_data();
+    storage_.capacity = small_buffer_size::value;
+    steal(rhs);
+  }
+
+  ~small_vector() {
+    destroy(data(), size_);
+    release();
+  }
+
+  small_vector &operator =(small_vector const &rhs) {
+    if (this != std::addressof(rhs)) {
+      assign(rhs.begin(), rhs.end());
+    }
+
+    return *this;
+  }
+
+  small_vector &operator =(small_vector &&rhs) {
+    if (this == std::addressof(rhs)) {
+      return *this;
+    }
+
+    if (rhs.is_inline() || get_allocator() != rhs.get_allocator()) {
+      assign(
+        std::make_move_iterator(rhs.begin()),
+        std::make_move_iterator(rhs.end())
+      );
+      rhs.clear();
+      return *this;
+    }
+
+    destroy(data(), size_);
+    release();
+    storage_.data = small_data();
+    storage_.capacity = small_buffer_size::value;
+    size_ = 0;
+    steal(rhs);
+
+    return *this;
+  }
+
+  small_vector &operator =(std::initializer_list<value_type> values) {
+    assign(values.begin(), values.end());
+    return *this;
+  }
+
+  ////////////
+  // assign //
+  ////////////
+
+  /**
+   * Replaces the contents with `size` copies of `value`.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  void assign(size_type size, const_reference value) {
+    if (size > capacity()) {
+      value_type copy(value);
+      clear();
+      insert(end(), size, copy);
+      return;
+    }
+
+    auto const common = std::min(size, size_);
+    std::fill(data(), data() + common, value);
+
+    if (size < size_) {
+      destroy(data() + size, size_ - size);
+      size_ = size;
+    } else {
+      insert(end(), size - size_, value);
+    }
+  }
+
+  /**
+   * Replaces the contents with the elements in `[first, last)`, which must
+   * not point into this vector.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  template <
+    typename TIterator,
+    typename = typename std::enable_if<
+      !std::is_integral<TIterator>::value
+    >::type
+  >
+  void assign(TIterator first, TIterator last) {
+    auto i = begin();
+
+    for (auto const end = this->end(); i != end && first != last; ++i) {
+      *i = *first;
+      ++first;
+    }
+
+    erase(i, end());
+    insert(end(), first, last);
+  }
+
+  void assign(std::initializer_list<value_type> values) {
+    assign(values.begin(), values.end());
+  }
+
+  ////////////
+  // access //
+  ////////////
+
+  const_reference at(size_type i) const {
+    if (i < size_) {
+      return data()[i];
+    }
+
+    throw std::out_of_range("index out of bounds");
+  }
+
+  reference at(size_type i) {
+    if (i < size_) {
+      return data()[i];
+    }
+
+    throw std::out_of_range("index out of bounds");
+  }
+
+  const_reference operator [](size_type i) const {
+    assert(i < size_);
+    return data()[i];
+  }
+
+  reference operator [](size_type i) {
+    assert(i < size_);
+    return data()[i];
+  }
+
+  const_reference front() const {
+    assert(size_);
+    return *data();
+  }
+
+  reference front() {
+    assert(size_);
+    return *data();
+  }
+
+  const_reference back() const {
+    assert(size_);
+    return data()[size_ - 1];
+  }
+
+  reference back() {
+    assert(size_);
+    return data()[size_ - 1];
+  }
+
+  const_pointer data() const { return storage_.data; }
+  pointer data() { return storage_.data; }
+
+  ///////////////
+  // iterators //
+  ///////////////
+
+  const_iterator cbegin() const { return data(); }
+  const_iterator begin() const { return data(); }
+  iterator begin() { return data(); }
+
+  const_iterator cend() const { return data() + size_; }
+  const_iterator end() const { return data() + size_; }
+  iterator end() { return data() + size_; }
+
+  const_reverse_iterator crbegin() const { return rbegin(); }
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+
+  const_reverse_iterator crend() const { return rend(); }
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+
+  //////////////
+  // capacity //
+  //////////////
+
+  size_type size() const { return size_; }
+  bool empty() const { return !size_; }
+  size_type capacity() const { return storage_.capacity; }
+
+  size_type max_size() const {
+    return allocator_traits::max_size(storage_.allocator());
+  }
+
+  /**
+   * Tells whether the elements are kept in the inline buffer, as opposed to
+   * memory allocated from `Allocator`.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  bool is_inline() const noexcept {
+    return storage_.data == reinterpret_cast<const_pointer>(
+      std::addressof(buffer_)
+    );
+  }
+
+  /**
+   * Makes sure there's room for at least `size` elements without further
+   * reallocations.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  void reserve(size_type size) {
+    if (size > capacity()) {
+      reallocate(size, size_, 0, [](pointer) {});
+    }
+  }
+
+  /**
+   * Releases the memory not used by the elements, moving them back into the
+   * inline buffer when they fit.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  void shrink_to_fit() {
+    if (is_inline() || size_ == capacity()) {
+      return;
+    }
+
+    if (size_ > small_buffer_size::value) {
+      reallocate(size_, size_, 0, [](pointer) {});
+      return;
+    }
+
+    auto const from = data();
+    auto const capacity = storage_.capacity;
+
+    relocate(small_data(), from, size_);
+    allocator_traits::deallocate(storage_.allocator(), from, capacity);
+
+    storage_.data = small_data();
+    storage_.capacity = small_buffer_size::value;
+  }
+
+  ///////////////
+  // modifiers //
+  ///////////////
+
+  /**
+   * Destroys all elements, keeping the storage for future use.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  void clear() noexcept {
+    destroy(data(), size_);
+    size_ = 0;
+  }
+
+  void push_back(const_reference value) { emplace_back(value); }
+  void push_back(value_type &&value) { emplace_back(std::move(value)); }
+
+  template <typename... Args>
+  reference emplace_back(Args &&...args) {
+    if (size_ == capacity()) {
+      // `args` may refer to an element, so the new element is constructed
+      // before the old ones are moved
+      reallocate(grown(1), size_, 1, [&](pointer to) {
+        new (static_cast<void *>(to)) value_type(std::forward<Args>(args)...);
+      });
+    } else {
+      new (static_cast<void *>(end())) value_type(std::forward<Args>(args)...);
+      ++size_;
+    }
+
+    return back();
+  }
+
+  void pop_back() {
+    assert(size_);
+    --size_;
+    destroy(end(), 1);
+  }
+
+  /**
+   * Changes the number of elements to `size`, value-initializing the new
+   * ones.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  void resize(size_type size) {
+    if (size <= size_) {
+      destroy(data() + size, size_ - size);
+      size_ = size;
+      return;
+    }
+
+    reserve(size);
+
+    while (size_ < size) {
+      new (static_cast<void *>(end())) value_type();
+      ++size_;
+    }
+  }
+
+  void resize(size_type size, const_reference value) {
+    if (size <= size_) {
+      destroy(data() + size, size_ - size);
+      size_ = size;
+      return;
+    }
+
+    insert(end(), size - size_, value);
+  }
+
+  /**
+   * Inserts an element constructed from `args` before `position`, returning
+   * an iterator to it.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  template <typename... Args>
+  iterator emplace(const_iterator position, Args &&...args) {
+    auto const index = index_of(position);
+
+    if (index == size_) {
+      emplace_back(std::forward<Args>(args)...);
+      return data() + index;
+    }
+
+    return emplace_at(index, relocatable(), std::forward<Args>(args)...);
+  }
+
+  iterator insert(const_iterator position, const_reference value) {
+    return emplace(position, value);
+  }
+
+  iterator insert(const_iterator position, value_type &&value) {
+    return emplace(position, std::move(value));
+  }
+
+  /**
+   * Inserts `count` copies of `value` before `position`, returning an
+   * iterator to the first element inserted.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  iterator insert(
+    const_iterator position,
+    size_type count,
+    const_reference value
+  ) {
+    auto const index = index_of(position);
+
+    if (!count) {
+      return data() + index;
+    }
+
+    auto const fill = [&](pointer to) {
+      size_type i = 0;
+
+      try {
+        for (; i < count; ++i) {
+          new (static_cast<void *>(to + i)) value_type(value);
+        }
+      } catch (...) {
+        destroy(to, i);
+        throw;
+      }
+    };
+
+    if (count > capacity() - size_) {
+      reallocate(grown(count), index, count, fill);
+      return data() + index;
+    }
+
+    if (relocatable::value || index == size_) {
+      // `value` may refer to an element that is about to move
+      value_type copy(value);
+      return insert_in_place(index, count, [&](pointer to) {
+        size_type i = 0;
+
+        try {
+          for (; i < count; ++i) {
+            new (static_cast<void *>(to + i)) value_type(copy);
+          }
+        } catch (...) {
+          destroy(to, i);
+          throw;
+        }
+      });
+    }
+
+    return append_and_rotate(index, [&]() {
+      for (auto i = count; i--; ) {
+        new (static_cast<void *>(end())) value_type(value);
+        ++size_;
+      }
+    });
+  }
+
+  /**
+   * Inserts the elements in `[first, last)`, which must not point into this
+   * vector, before `position`. Returns an iterator to the first element
+   * inserted.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  template <
+    typename TIterator,
+    typename = typename std::enable_if<
+      !std::is_integral<TIterator>::value
+    >::type
+  >
+  iterator insert(const_iterator position, TIterator first, TIterator last) {
+    return insert_range(
+      index_of(position), first, last,
+      typename std::iterator_traits<TIterator>::iterator_category()
+    );
+  }
+
+  iterator insert(
+    const_iterator position,
+    std::initializer_list<value_type> values
+  ) {
+    return insert(position, values.begin(), values.end());
+  }
+
+  iterator erase(const_iterator position) {
+    assert(position != end());
+    return erase(position, std::next(position));
+  }
+
+  /**
+   * Erases the elements in `[first, last)`, returning an iterator to the
+   * element that followed them.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  iterator erase(const_iterator first, const_iterator last) {
+    auto const index = index_of(first);
+    auto const count = static_cast<size_type>(std::distance(first, last));
+    assert(index + count <= size_);
+
+    auto const begin = data() + index;
+
+    if (!count) {
+      return begin;
+    }
+
+    if (relocatable::value) {
+      destroy(begin, count);
+
+      if (auto const tail = size_ - index - count) {
+        std::memmove(
+          static_cast<void *>(begin), begin + count, tail * sizeof(value_type)
+        );
+      }
+    } else {
+      std::move(begin + count, end(), begin);
+      destroy(end() - count, count);
+    }
+
+    size_ -= count;
+    return begin;
+  }
+
+  void swap(small_vector &other) {
+    if (this == std::addressof(other)) {
+      return;
+    }
+
+    if (!is_inline() && !other.is_inline()) {
+      using std::swap;
+
+      if (allocator_traits::propagate_on_container_swap::value) {
+        swap(storage_.allocator(), other.storage_.allocator());
+      }
+
+      swap(storage_.data, other.storage_.data);
+      swap(storage_.capacity, other.storage_.capacity);
+      swap(size_, other.size_);
+      return;
+    }
+
+    small_vector copy(std::move(other));
+    other = std::move(*this);
+    *this = std::move(copy);
+  }
+
+  allocator_type get_allocator() const { return storage_.allocator(); }
+
+private:
+  pointer small_data() noexcept {
+    return reinterpret_cast<pointer>(std::addressof(buffer_));
+  }
+
+  size_type index_of(const_iterator position) const {
+    assert(position >= begin());
+    assert(position <= end());
+    return static_cast<size_type>(position - begin());
+  }
+
+  // the capacity to grow to in order to fit `count` more elements
+  size_type grown(size_type count) const {
+    if (count > max_size() - size_) {
+      throw std::length_error("small_vector is too big");
+    }
+
+    return std::max(size_ + count, capacity() * 2);
+  }
+
+  // takes the elements of `rhs`, which is left empty. The storage of this
+  // vector must be the inline buffer
+  void steal(small_vector &rhs) {
+    assert(is_inline());
+
+    if (rhs.is_inline()) {
+      relocate(data(), rhs.data(), rhs.size_);
+    } else {
+      storage_.data = rhs.storage_.data;
+      storage_.capacity = rhs.storage_.capacity;
+
+      rhs.storage_.data = rhs.small_data();
+      rhs.storage_.capacity = small_buffer_size::value;
+    }
+
+    size_ = rhs.size_;
+    rhs.size_ = 0;
+  }
+
+  void release() noexcept {
+    if (!is_inline()) {
+      allocator_traits::deallocate(
+        storage_.allocator(), storage_.data, storage_.capacity
+      );
+    }
+  }
+
+  // moves the elements to newly allocated memory for `capacity` elements,
+  // leaving a gap of `count` elements at `index` which is filled by
+  // `fill(gap)` before the elements are moved. `fill` must destroy whatever
+  // it constructed if it throws
+  //
+  // this vector is left untouched if an exception is thrown
+  template <typename Fill>
+  void reallocate(
+    size_type capacity,
+    size_type index,
+    size_type count,
+    Fill &&fill
+  ) {
+    assert(index <= size_);
+    assert(size_ + count <= capacity);
+
+    auto &allocator = storage_.allocator();
+    auto const to = allocator_traits::allocate(allocator, capacity);
+
+    try {
+      fill(to + index);
+    } catch (...) {
+      allocator_traits::deallocate(allocator, to, capacity);
+      throw;
+    }
+
+    auto const from = data();
+
+    if (relocatable::value) {
+      copy_bytes(to, from, index);
+      copy_bytes(to + index + count, from + index, size_ - index);
+    } else {
+      try {
+        move_construct(to, from, index);
+
+        try {
+          move_construct(to + index + count, from + index, size_ - index);
+        } catch (...) {
+          destroy(to, index);
+          throw;
+        }
+      } catch (...) {
+        destroy(to + index, count);
+        allocator_traits::deallocate(allocator, to, capacity);
+        throw;
+      }
+
+      destroy(from, size_);
+    }
+
+    release();
+
+    storage_.data = to;
+    storage_.capacity = capacity;
+    size_ += count;
+  }
+
+  // constructs an element out of `args` at `index`, which must not be the
+  // end of the vector
+  template <typename... Args>
+  iterator emplace_at(size_type index, std::true_type, Args &&...args) {
+    // `args` may refer to an element that is about to move, so the element is
+    // constructed aside and then relocated into place
+    typename std::aligned_storage<
+      sizeof(value_type), alignof(value_type)
+    >::type buffer;
+    auto const value = reinterpret_cast<pointer>(std::addressof(buffer));
+    new (static_cast<void *>(value)) value_type(std::forward<Args>(args)...);
+
+    return insert_in_place(index, 1, [value](pointer to) {
+      copy_bytes(to, value, 1);
+    }, [value]() {
+      destroy(value, 1);
+    });
+  }
+
+  template <typename... Args>
+  iterator emplace_at(size_type index, std::false_type, Args &&...args) {
+    if (size_ == capacity()) {
+      reallocate(grown(1), index, 1, [&](pointer to) {
+        new (static_cast<void *>(to)) value_type(std::forward<Args>(args)...);
+      });
+
+      return data() + index;
+    }
+
+    // `args` may refer to an element that is about to move
+    value_type value(std::forward<Args>(args)...);
+
+    return append_and_rotate(index, [&]() {
+      new (static_cast<void *>(end())) value_type(std::move(value));
+      ++size_;
+    });
+  }
+
+  template <typename TIterator>
+  iterator insert_range(
+    size_type index,
+    TIterator first,
+    TIterator last,
+    std::input_iterator_tag
+  ) {
+    return append_and_rotate(index, [&]() {
+      for (; first != last; ++first) {
+        emplace_back(*first);
+      }
+    });
+  }
+
+  template <typename TIterator>
+  iterator insert_range(
+    size_type index,
+    TIterator first,
+    TIterator last,
+    std::forward_iterator_tag
+  ) {
+    auto const count = static_cast<size_type>(std::distance(first, last));
+
+    if (!count) {
+      return data() + index;
+    }
+
+    auto const fill = [&](pointer to) {
+      size_type i = 0;
+
+      try {
+        for (auto j = first; i < count; ++i, ++j) {
+          new (static_cast<void *>(to + i)) value_type(*j);
+        }
+      } catch (...) {
+        destroy(to, i);
+        throw;
+      }
+    };
+
+    if (count > capacity() - size_) {
+      reallocate(grown(count), index, count, fill);
+      return data() + index;
+    }
+
+    if (relocatable::value || index == size_) {
+      return insert_in_place(index, count, fill);
+    }
+
+    return append_and_rotate(index, [&]() {
+      for (; first != last; ++first) {
+        new (static_cast<void *>(end())) value_type(*first);
+        ++size_;
+      }
+    });
+  }
+
+  // opens a gap of `count` elements at `index` by shifting the elements after
+  // it with `std::memmove`, then fills it with `fill(gap)`. The elements are
+  // shifted back if `fill` throws
+  //
+  // only valid for trivially relocatable elements, or when inserting at the
+  // end
+  template <typename Fill, typename Cleanup>
+  iterator insert_in_place(
+    size_type index,
+    size_type count,
+    Fill &&fill,
+    Cleanup &&cleanup
+  ) {
+    try {
+      if (count > capacity() - size_) {
+        reserve(grown(count));
+      }
+    } catch (...) {
+      cleanup();
+      throw;
+    }
+
+    auto const gap = data() + index;
+    auto const tail = size_ - index;
+
+    if (tail) {
+      std::memmove(
+        static_cast<void *>(gap + count), gap, tail * sizeof(value_type)
+      );
+    }
+
+    try {
+      fill(gap);
+    } catch (...) {
+      if (tail) {
+        std::memmove(
+          static_cast<void *>(gap), gap + count, tail * sizeof(value_type)
+        );
+      }
+
+      cleanup();
+      throw;
+    }
+
+    size_ += count;
+    return gap;
+  }
+
+  template <typename Fill>
+  iterator insert_in_place(size_type index, size_type count, Fill &&fill) {
+    return insert_in_place(index, count, std::forward<Fill>(fill), []() {});
+  }
+
+  // appends new elements with `append()`, then rotates them into place at
+  // `index`. The elements appended are destroyed if `append` throws
+  template <typename Append>
+  iterator append_and_rotate(size_type index, Append &&append) {
+    auto const size = size_;
+
+    try {
+      append();
+    } catch (...) {
+      erase(begin() + size, end());
+      throw;
+    }
+
+    std::rotate(begin() + index, begin() + size, end());
+    return data() + index;
+  }
+
+  static void copy_bytes(pointer to, const_pointer from, size_type count) {
+    if (count) {
+      std::memcpy(static_cast<void *>(to), from, count * sizeof(value_type));
+    }
+  }
+
+  // move constructs `count` elements from `from`, or copy constructs them if
+  // moving may throw, leaving the source elements alive
+  static void move_construct(pointer to, pointer from, size_type count) {
+    size_type i = 0;
+
+    try {
+      for (; i < count; ++i) {
+        new (static_cast<void *>(to + i)) value_type(
+          std::move_if_noexcept(from[i])
+        );
+      }
+    } catch (...) {
+      destroy(to, i);
+      throw;
+    }
+  }
+
+  // moves `count` elements to uninitialized memory, ending the lifetime of
+  // the source elements
+  static void relocate(pointer to, pointer from, size_type count) {
+    if (relocatable::value) {
+      copy_bytes(to, from, count);
+    } else {
+      move_construct(to, from, count);
+      destroy(from, count);
+    }
+  }
+
+  static void destroy(pointer begin, size_type count) noexcept {
+    static_assert(
+      std::is_nothrow_destructible<value_type>::value,
+      "value_type must provide a noexcept destructor"
+    );
+
+    if (!trivial_destructor::value) {
+      for (auto const end = begin + count; begin != end; ++begin) {
+        begin->~value_type();
+      }
+    }
+  }
+
+  storage_type storage_;
+  size_type size_ = 0;
+  buffer_type buffer_;
+};
+
+template <
+  typename T, std::size_t LSize, typename LAllocator,
+  std::size_t RSize, typename RAllocator
+>
+bool operator ==(
+  small_vector<T, LSize, LAllocator> const &lhs,
+  small_vector<T, RSize, RAllocator> const &rhs
+) {
+  return lhs.size() == rhs.size()
+    && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <
+  typename T, std::size_t LSize, typename LAllocator,
+  std::size_t RSize, typename RAllocator
+>
+bool operator !=(
+  small_vector<T, LSize, LAllocator> const &lhs,
+  small_vector<T, RSize, RAllocator> const &rhs
+) {
+  return !(lhs == rhs);
+}
+
+template <
+  typename T, std::size_t LSize, typename LAllocator,
+  std::size_t RSize, typename RAllocator
+>
+bool operator <(
+  small_vector<T, LSize, LAllocator> const &lhs,
+  small_vector<T, RSize, RAllocator> const &rhs
+) {
+  return std::lexicographical_compare(
+    lhs.begin(), lhs.end(), rhs.begin(), rhs.end()
+  );
+}
+
+template <typename T, std::size_t SmallBufferSize, typename Allocator>
+void swap(
+  small_vector<T, SmallBufferSize, Allocator> &lhs,
+  small_vector<T, SmallBufferSize, Allocator> &rhs
+) {
+  lhs.swap(rhs);
+}
+
+} // namespace fatal {
+
+FATAL_DIAGNOSTIC_POP
+
+#endif // FATAL_INCLUDE_fatal_container_small_vector_h
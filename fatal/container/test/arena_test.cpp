@@ -0,0 +1,102 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/container/arena.h>
+
+#include <fatal/test/driver.h>
+
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+namespace fatal {
+
+template <typename T>
+bool is_aligned(T const *p, std::size_t alignment) {
+  return !(reinterpret_cast<std::uintptr_t>(p) & (alignment - 1));
+}
+
+FATAL_TEST(monotonic_arena, allocate) {
+  monotonic_arena arena(64);
+  FATAL_EXPECT_EQ(0, arena.blocks());
+  FATAL_EXPECT_EQ(0, arena.allocated());
+
+  auto const a = static_cast<char *>(arena.allocate(3, 1));
+  auto const b = static_cast<char *>(arena.allocate(8, 8));
+  FATAL_EXPECT_EQ(1, arena.blocks());
+  FATAL_EXPECT_EQ(11, arena.allocated());
+  FATAL_EXPECT_TRUE(is_aligned(b, 8));
+  FATAL_EXPECT_LE(3, b - a);
+
+  // doesn't fit in the first block
+  arena.allocate(60, 1);
+  FATAL_EXPECT_EQ(2, arena.blocks());
+
+  // bigger than a block
+  auto const big = arena.allocate(10000, 64);
+  FATAL_EXPECT_EQ(3, arena.blocks());
+  FATAL_EXPECT_TRUE(is_aligned(static_cast<char *>(big), 64));
+
+  arena.release();
+  FATAL_EXPECT_EQ(0, arena.blocks());
+  FATAL_EXPECT_EQ(0, arena.allocated());
+
+  arena.allocate(1, 1);
+  FATAL_EXPECT_EQ(1, arena.blocks());
+}
+
+FATAL_TEST(monotonic_arena, initial_buffer) {
+  alignas(16) char buffer[64];
+  monotonic_arena arena(buffer, sizeof(buffer));
+
+  auto const a = static_cast<char *>(arena.allocate(16, 16));
+  auto const b = static_cast<char *>(arena.allocate(48, 1));
+  FATAL_EXPECT_EQ(0, arena.blocks());
+  FATAL_EXPECT_EQ(0, a - buffer);
+  FATAL_EXPECT_EQ(16, b - buffer);
+
+  arena.allocate(1, 1);
+  FATAL_EXPECT_EQ(1, arena.blocks());
+
+  // the buffer is reused after a release
+  arena.release();
+  FATAL_EXPECT_EQ(0, static_cast<char *>(arena.allocate(8, 8)) - buffer);
+  FATAL_EXPECT_EQ(0, arena.blocks());
+}
+
+FATAL_TEST(arena_allocator, containers) {
+  monotonic_arena arena;
+  arena_allocator<int> allocator(arena);
+
+  std::vector<int, arena_allocator<int>> v(allocator);
+
+  for (int i = 0; i < 1000; ++i) {
+    v.push_back(i);
+  }
+
+  for (int i = 0; i < 1000; ++i) {
+    FATAL_EXPECT_EQ(i, v[i]);
+  }
+
+  using string = std::basic_string<
+    char, std::char_traits<char>, arena_allocator<char>
+  >;
+
+  string s(100, 'x', arena_allocator<char>(allocator));
+  FATAL_EXPECT_EQ(100, s.size());
+  FATAL_EXPECT_LE(1000 * sizeof(int) + 100, arena.allocated());
+
+  FATAL_EXPECT_TRUE(allocator == arena_allocator<char>(arena));
+
+  monotonic_arena other;
+  FATAL_EXPECT_TRUE(allocator != arena_allocator<int>(other));
+}
+
+} // namespace fatal {
@@ -11,6 +11,9 @@
 
 #include <fatal/test/driver.h>
 
+#include <list>
+#include <sstream>
+#include <string>
 #include <vector>
 #include <unordered_map>
 
@@ -306,6 +309,125 @@ FATAL_TEST(circular_queue, shift_to_back_by) {
   }
 }
 
+FATAL_TEST(circular_queue, power_of_two_capacity) {
+  using policy = power_of_two_capacity_policy;
+
+  FATAL_EXPECT_EQ(0, policy::capacity(0u));
+  FATAL_EXPECT_EQ(1, policy::capacity(1u));
+  FATAL_EXPECT_EQ(4, policy::capacity(3u));
+  FATAL_EXPECT_EQ(16, policy::capacity(16u));
+  FATAL_EXPECT_EQ(32, policy::capacity(17u));
+  FATAL_EXPECT_EQ(5, policy::wrap(13u, 8u));
+
+  circular_queue<int, policy> q(5);
+  FATAL_EXPECT_EQ(8, q.capacity());
+
+  // keeps wrapping around the buffer while growing
+  for (int i = 0; i < 100; ++i) {
+    q.push_back(i);
+
+    if (i % 3 == 0) {
+      q.push_front(-i);
+    }
+
+    if (i % 2 == 0) {
+      q.pop_front();
+    }
+
+    FATAL_EXPECT_FALSE(q.capacity() & (q.capacity() - 1));
+  }
+
+  std::vector<int> expected;
+  circular_queue<int> reference(5);
+
+  for (int i = 0; i < 100; ++i) {
+    reference.push_back(i);
+
+    if (i % 3 == 0) {
+      reference.push_front(-i);
+    }
+
+    if (i % 2 == 0) {
+      reference.pop_front();
+    }
+  }
+
+  FATAL_ASSERT_EQ(reference.size(), q.size());
+  FATAL_EXPECT_TRUE(std::equal(q.begin(), q.end(), reference.begin()));
+}
+
+template <typename TPolicy>
+void check_append() {
+  {
+    // trivially copyable elements, wrapping around the buffer
+    circular_queue<int, TPolicy> q(8);
+    for (int i = 0; i < 6; ++i) {
+      q.push_back(i);
+    }
+    q.erase_front(5);
+    FATAL_EXPECT_EQ(1, q.size());
+
+    int const values[] = {10, 11, 12, 13, 14, 15, 16};
+    q.append(values, values + 7);
+    FATAL_EXPECT_EQ(8, q.capacity());
+    CHECK_CONTENTS(5, 10, 11, 12, 13, 14, 15, 16);
+
+    // grows once
+    std::vector<int> const more{20, 21, 22};
+    q.append(more.data(), more.data() + more.size());
+    CHECK_CONTENTS(5, 10, 11, 12, 13, 14, 15, 16, 20, 21, 22);
+
+    q.erase_front(4);
+    CHECK_CONTENTS(13, 14, 15, 16, 20, 21, 22);
+
+    // ranges and iterators that can't be copied bitwise
+    q.append(std::list<int>{30, 31});
+    q.append(more.begin(), more.begin() + 1);
+    CHECK_CONTENTS(13, 14, 15, 16, 20, 21, 22, 30, 31, 20);
+
+    // input iterators
+    std::istringstream in("40 41");
+    q.append(std::istream_iterator<int>(in), std::istream_iterator<int>());
+    CHECK_CONTENTS(13, 14, 15, 16, 20, 21, 22, 30, 31, 20, 40, 41);
+
+    q.erase_front(q.size());
+    FATAL_EXPECT_TRUE(q.empty());
+    q.append(values, values);
+    FATAL_EXPECT_TRUE(q.empty());
+  }
+
+  {
+    circular_queue<std::string, TPolicy> q(4);
+    q.push_back("a");
+    q.push_back("b");
+    q.push_back("c");
+    q.erase_front(2);
+
+    std::vector<std::string> const values{"d", "e", "f", "g", "h"};
+    q.append(values);
+    q.append(values.data(), values.data() + 1);
+    FATAL_ASSERT_EQ(7, q.size());
+
+    std::vector<std::string> const expected{
+      "c", "d", "e", "f", "g", "h", "d"
+    };
+    FATAL_EXPECT_TRUE(std::equal(q.begin(), q.end(), expected.begin()));
+
+    q.erase_front(3);
+    FATAL_EXPECT_EQ("f", q.front());
+    FATAL_EXPECT_EQ("d", q.back());
+    FATAL_EXPECT_EQ(4, q.size());
+  }
+}
+
+FATAL_TEST(circular_queue, append_erase_front) {
+  check_append<default_capacity_policy>();
+}
+
+FATAL_TEST(circular_queue, append_erase_front_power_of_two) {
+  check_append<power_of_two_capacity_policy>();
+}
+
 # undef CHECK_CONTENTS
 
 template <typename Data, typename Factory>
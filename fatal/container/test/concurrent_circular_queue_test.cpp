@@ -0,0 +1,390 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/container/concurrent_circular_queue.h>
+
+#include <fatal/test/driver.h>
+#include <fatal/test/ref_counter.h>
+
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cstdint>
+
+namespace fatal {
+
+template <template <typename> class Queue>
+void check_capacity() {
+  FATAL_EXPECT_EQ(1, Queue<int>(1).capacity());
+  FATAL_EXPECT_EQ(2, Queue<int>(2).capacity());
+  FATAL_EXPECT_EQ(4, Queue<int>(3).capacity());
+  FATAL_EXPECT_EQ(64, Queue<int>(64).capacity());
+  FATAL_EXPECT_EQ(128, Queue<int>(65).capacity());
+}
+
+template <template <typename> class Queue>
+void check_push_pop() {
+  Queue<int> q(4);
+  int value = -1;
+
+  FATAL_EXPECT_TRUE(q.empty());
+  FATAL_EXPECT_FALSE(q.try_pop(value));
+  FATAL_EXPECT_EQ(-1, value);
+
+  // wraps around the buffer a few times
+  for (int round = 0; round < 5; ++round) {
+    for (int i = 0; i < 4; ++i) {
+      FATAL_ASSERT_TRUE(q.try_push(round * 10 + i));
+      FATAL_EXPECT_EQ(i + 1, q.size());
+    }
+
+    FATAL_EXPECT_FALSE(q.try_push(100));
+    FATAL_EXPECT_FALSE(q.try_emplace(100));
+
+    for (int i = 0; i < 4; ++i) {
+      FATAL_ASSERT_TRUE(q.try_pop(value));
+      FATAL_EXPECT_EQ(round * 10 + i, value);
+    }
+
+    FATAL_EXPECT_TRUE(q.empty());
+    FATAL_EXPECT_FALSE(q.try_pop(value));
+
+    // keeps head and tail out of sync with the buffer boundaries
+    FATAL_ASSERT_TRUE(q.try_emplace(round));
+    FATAL_ASSERT_TRUE(q.try_pop(value));
+    FATAL_EXPECT_EQ(round, value);
+  }
+}
+
+template <template <typename> class Queue>
+void check_push_n_pop_n() {
+  Queue<std::string> q(8);
+  std::vector<std::string> const input{
+    "a", "b", "c", "d", "e", "f", "g", "h", "i", "j"
+  };
+  std::vector<std::string> output(input.size());
+
+  FATAL_EXPECT_EQ(0, q.pop_n(output.begin(), output.size()));
+  FATAL_EXPECT_EQ(0, q.push_n(input.begin(), 0));
+
+  FATAL_EXPECT_EQ(3, q.push_n(input.begin(), 3));
+  FATAL_EXPECT_EQ(3, q.size());
+
+  // only as many as fit
+  FATAL_EXPECT_EQ(5, q.push_n(input.begin() + 3, 7));
+  FATAL_EXPECT_EQ(8, q.size());
+  FATAL_EXPECT_EQ(0, q.push_n(input.begin() + 8, 2));
+
+  FATAL_EXPECT_EQ(2, q.pop_n(output.begin(), 2));
+  FATAL_EXPECT_EQ("a", output[0]);
+  FATAL_EXPECT_EQ("b", output[1]);
+
+  // wraps around the buffer
+  FATAL_EXPECT_EQ(2, q.push_n(input.begin() + 8, 2));
+
+  // only as many as there are
+  FATAL_EXPECT_EQ(8, q.pop_n(output.begin() + 2, 10));
+  FATAL_EXPECT_EQ(input, output);
+  FATAL_EXPECT_TRUE(q.empty());
+
+  // output iterators that don't yield a reference to a `value_type`
+  std::vector<std::string> appended;
+  FATAL_EXPECT_EQ(3, q.push_n(input.begin(), 3));
+  FATAL_EXPECT_EQ(3, q.pop_n(std::back_inserter(appended), 10));
+  FATAL_EXPECT_EQ(
+    (std::vector<std::string>(input.begin(), input.begin() + 3)),
+    appended
+  );
+}
+
+template <template <typename> class Queue>
+void check_destruction() {
+  using refc = ref_counter<>;
+  refc::guard guard;
+
+  {
+    Queue<refc> q(8);
+    FATAL_EXPECT_EQ(0, refc::alive());
+
+    for (int i = 0; i < 6; ++i) {
+      FATAL_ASSERT_TRUE(q.try_emplace());
+    }
+    FATAL_EXPECT_EQ(6, refc::alive());
+
+    refc out;
+    FATAL_ASSERT_TRUE(q.try_pop(out));
+    FATAL_EXPECT_EQ(6, refc::alive());
+
+    std::vector<refc> batch(2);
+    FATAL_EXPECT_EQ(2, q.pop_n(batch.begin(), batch.size()));
+    FATAL_EXPECT_EQ(3 + 1 + 2, refc::alive());
+
+    FATAL_EXPECT_EQ(2, q.push_n(batch.begin(), batch.size()));
+    FATAL_EXPECT_EQ(5 + 1 + 2, refc::alive());
+  }
+
+  // the elements left in the queue are destroyed along with it
+  FATAL_EXPECT_EQ(0, refc::alive());
+  FATAL_EXPECT_EQ(0, refc::valid());
+}
+
+FATAL_TEST(spsc_circular_queue, capacity) {
+  check_capacity<spsc_circular_queue>();
+}
+
+FATAL_TEST(spsc_circular_queue, push_pop) {
+  check_push_pop<spsc_circular_queue>();
+}
+
+FATAL_TEST(spsc_circular_queue, push_n_pop_n) {
+  check_push_n_pop_n<spsc_circular_queue>();
+}
+
+FATAL_TEST(spsc_circular_queue, destruction) {
+  check_destruction<spsc_circular_queue>();
+}
+
+FATAL_TEST(mpmc_circular_queue, capacity) {
+  check_capacity<mpmc_circular_queue>();
+}
+
+FATAL_TEST(mpmc_circular_queue, push_pop) {
+  check_push_pop<mpmc_circular_queue>();
+}
+
+FATAL_TEST(mpmc_circular_queue, push_n_pop_n) {
+  check_push_n_pop_n<mpmc_circular_queue>();
+}
+
+FATAL_TEST(mpmc_circular_queue, destruction) {
+  check_destruction<mpmc_circular_queue>();
+}
+
+FATAL_TEST(spsc_circular_queue, push_n_throws) {
+  struct thrower {
+    explicit thrower(int value): value(value) {}
+
+    thrower(thrower const &rhs): value(rhs.value) {
+      if (value < 0) {
+        throw value;
+      }
+    }
+
+    thrower &operator =(thrower const &) = default;
+
+    int value;
+  };
+
+  spsc_circular_queue<thrower> q(8);
+  std::vector<thrower> input;
+  input.reserve(3);
+  input.emplace_back(1);
+  input.emplace_back(2);
+  input.emplace_back(-1);
+
+  FATAL_EXPECT_THROW(int) {
+    q.push_n(input.begin(), input.size());
+  };
+
+  // the elements constructed before the exception are kept
+  FATAL_ASSERT_EQ(2, q.size());
+
+  thrower out(0);
+  FATAL_ASSERT_TRUE(q.try_pop(out));
+  FATAL_EXPECT_EQ(1, out.value);
+  FATAL_ASSERT_TRUE(q.try_pop(out));
+  FATAL_EXPECT_EQ(2, out.value);
+}
+
+FATAL_TEST(mpmc_circular_queue, push_n_throws) {
+  struct thrower {
+    explicit thrower(int value): value(value) {}
+
+    thrower(thrower const &rhs): value(rhs.value) {
+      if (value < 0) {
+        throw value;
+      }
+    }
+
+    thrower(thrower &&rhs) noexcept: value(rhs.value) {}
+    thrower &operator =(thrower &&) = default;
+
+    int value;
+  };
+
+  mpmc_circular_queue<thrower> q(8);
+  std::vector<thrower> input;
+  input.emplace_back(1);
+  input.emplace_back(-1);
+
+  FATAL_EXPECT_THROW(int) {
+    q.push_n(input.begin(), input.size());
+  };
+
+  // the batch is staged before claiming any slot
+  FATAL_EXPECT_TRUE(q.empty());
+}
+
+using sequence_number = std::uint64_t;
+
+FATAL_TEST(spsc_circular_queue, threads) {
+  using limit = std::integral_constant<sequence_number, 200000>;
+
+  spsc_circular_queue<sequence_number> q(64);
+
+  std::thread producer([&] {
+    sequence_number batch[7];
+
+    for (sequence_number i = 0; i < limit::value; ) {
+      if (i % 3) {
+        if (q.try_push(i)) {
+          ++i;
+        } else {
+          std::this_thread::yield();
+        }
+      } else {
+        auto const size = std::min<sequence_number>(7, limit::value - i);
+
+        for (sequence_number j = 0; j < size; ++j) {
+          batch[j] = i + j;
+        }
+
+        auto const pushed = q.push_n(batch, size);
+        i += pushed;
+
+        if (!pushed) {
+          std::this_thread::yield();
+        }
+      }
+    }
+  });
+
+  sequence_number expected = 0;
+  sequence_number batch[5];
+
+  while (expected < limit::value) {
+    if (expected % 2) {
+      sequence_number value;
+
+      if (q.try_pop(value)) {
+        FATAL_ASSERT_EQ(expected, value);
+        ++expected;
+      } else {
+        std::this_thread::yield();
+      }
+    } else {
+      auto const popped = q.pop_n(batch, 5);
+
+      for (std::size_t i = 0; i < popped; ++i, ++expected) {
+        FATAL_ASSERT_EQ(expected, batch[i]);
+      }
+
+      if (!popped) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  producer.join();
+  FATAL_EXPECT_TRUE(q.empty());
+}
+
+FATAL_TEST(mpmc_circular_queue, threads) {
+  using producers = std::integral_constant<sequence_number, 3>;
+  using consumers = std::integral_constant<std::size_t, 3>;
+  using limit = std::integral_constant<sequence_number, 50000>;
+
+  // encodes the producer along with a sequence number
+  mpmc_circular_queue<sequence_number> q(32);
+  std::vector<std::thread> threads;
+
+  for (sequence_number p = 0; p < producers::value; ++p) {
+    threads.emplace_back([&q, p] {
+      sequence_number batch[4];
+
+      for (sequence_number i = 0; i < limit::value; ) {
+        if (i % 2) {
+          if (q.try_push(i * producers::value + p)) {
+            ++i;
+          } else {
+            std::this_thread::yield();
+          }
+        } else {
+          auto const size = std::min<sequence_number>(4, limit::value - i);
+
+          for (sequence_number j = 0; j < size; ++j) {
+            batch[j] = (i + j) * producers::value + p;
+          }
+
+          auto const pushed = q.push_n(batch, size);
+          i += pushed;
+
+          if (!pushed) {
+            std::this_thread::yield();
+          }
+        }
+      }
+    });
+  }
+
+  std::atomic<sequence_number> total(0);
+  std::vector<std::vector<sequence_number>> received(consumers::value);
+
+  for (std::size_t c = 0; c < consumers::value; ++c) {
+    threads.emplace_back([&, c] {
+      auto &out = received[c];
+      sequence_number batch[3];
+
+      while (total.load() < producers::value * limit::value) {
+        auto const popped = c % 2 ? q.pop_n(batch, 3) : q.try_pop(batch[0]);
+
+        if (!popped) {
+          std::this_thread::yield();
+          continue;
+        }
+
+        out.insert(out.end(), batch, batch + popped);
+        total += popped;
+      }
+    });
+  }
+
+  for (auto &i: threads) {
+    i.join();
+  }
+
+  FATAL_EXPECT_TRUE(q.empty());
+  FATAL_ASSERT_EQ(producers::value * limit::value, total.load());
+
+  // every element is received exactly once, and each consumer sees the
+  // elements of any given producer in order
+  std::vector<bool> seen(producers::value * limit::value);
+
+  for (auto const &out: received) {
+    std::vector<sequence_number> last(producers::value, 0);
+    std::vector<bool> first(producers::value, true);
+
+    for (auto i: out) {
+      FATAL_ASSERT_LT(i, seen.size());
+      FATAL_ASSERT_FALSE(seen[i]);
+      seen[i] = true;
+
+      auto const p = i % producers::value;
+      FATAL_ASSERT_TRUE(first[p] || last[p] < i);
+      first[p] = false;
+      last[p] = i;
+    }
+  }
+}
+
+} // namespace fatal {
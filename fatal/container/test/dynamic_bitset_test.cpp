@@ -0,0 +1,264 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/container/dynamic_bitset.h>
+
+#include <fatal/test/driver.h>
+
+#include <random>
+#include <vector>
+
+#include <cstddef>
+
+namespace fatal {
+
+void check_contents(
+  dynamic_bitset const &actual,
+  std::vector<bool> const &expected
+) {
+  FATAL_ASSERT_EQ(expected.size(), actual.size());
+
+  std::size_t count = 0;
+
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    FATAL_ASSERT_EQ(expected[i], actual.test(i));
+    count += expected[i];
+  }
+
+  FATAL_EXPECT_EQ(count, actual.count());
+  FATAL_EXPECT_EQ(count != 0, actual.any());
+  FATAL_EXPECT_EQ(count == 0, actual.none());
+
+  // the bits past the end are kept unset
+  if (auto const tail = actual.size() % 64) {
+    FATAL_EXPECT_EQ(0, actual.data()[actual.words() - 1] >> tail);
+  }
+}
+
+// checks `rank()` and `select()` against a linear scan
+void check_index(dynamic_bitset &actual) {
+  actual.build_index();
+
+  std::size_t rank = 0;
+
+  for (std::size_t i = 0; i < actual.size(); ++i) {
+    FATAL_ASSERT_EQ(rank, actual.rank(i));
+
+    if (actual.test(i)) {
+      FATAL_ASSERT_EQ(i, actual.select(rank));
+      ++rank;
+    }
+  }
+
+  FATAL_EXPECT_EQ(rank, actual.rank(actual.size()));
+  FATAL_EXPECT_EQ(actual.size(), actual.select(rank));
+  FATAL_EXPECT_EQ(actual.size(), actual.select(rank + 1000));
+}
+
+FATAL_TEST(dynamic_bitset, empty) {
+  dynamic_bitset b;
+
+  FATAL_EXPECT_TRUE(b.empty());
+  FATAL_EXPECT_EQ(0, b.size());
+  FATAL_EXPECT_EQ(0, b.words());
+  FATAL_EXPECT_EQ(0, b.count());
+  FATAL_EXPECT_TRUE(b.none());
+  FATAL_EXPECT_EQ(0, b.rank(0));
+  FATAL_EXPECT_EQ(0, b.select(0));
+
+  check_index(b);
+}
+
+FATAL_TEST(dynamic_bitset, single_bits) {
+  dynamic_bitset b(130);
+  std::vector<bool> expected(130);
+  check_contents(b, expected);
+
+  for (auto i: {0, 1, 63, 64, 65, 127, 128, 129}) {
+    b.set(static_cast<std::size_t>(i));
+    expected[static_cast<std::size_t>(i)] = true;
+  }
+  check_contents(b, expected);
+
+  b.reset(63).flip(64).flip(100);
+  expected[63] = false;
+  expected[64] = false;
+  expected[100] = true;
+  check_contents(b, expected);
+  FATAL_EXPECT_TRUE(b[100]);
+  FATAL_EXPECT_FALSE(b[101]);
+
+  b.assign(101, true).assign(0, false);
+  expected[101] = true;
+  expected[0] = false;
+  check_contents(b, expected);
+  check_index(b);
+}
+
+FATAL_TEST(dynamic_bitset, ranges) {
+  std::size_t const size = 1500;
+  dynamic_bitset b(size);
+  std::vector<bool> expected(size);
+
+  auto const fill = [&](std::size_t begin, std::size_t end, bool value) {
+    if (value) {
+      b.set(begin, end);
+    } else {
+      b.reset(begin, end);
+    }
+
+    for (auto i = begin; i < end; ++i) {
+      expected[i] = value;
+    }
+  };
+
+  // within a word, across words, and ending at word boundaries
+  fill(3, 9, true);
+  fill(60, 70, true);
+  fill(128, 256, true);
+  fill(300, 1499, true);
+  check_contents(b, expected);
+  check_index(b);
+
+  fill(5, 5, false);
+  fill(64, 65, false);
+  fill(200, 640, false);
+  fill(1490, 1500, false);
+  check_contents(b, expected);
+  check_index(b);
+
+  b.set();
+  check_contents(b, std::vector<bool>(size, true));
+  check_index(b);
+
+  b.reset();
+  check_contents(b, std::vector<bool>(size));
+  check_index(b);
+}
+
+FATAL_TEST(dynamic_bitset, resize) {
+  dynamic_bitset b(100, true);
+  check_contents(b, std::vector<bool>(100, true));
+
+  b.resize(70);
+  check_contents(b, std::vector<bool>(70, true));
+
+  // the bits removed don't come back
+  std::vector<bool> expected(70, true);
+  expected.resize(200);
+  b.resize(200);
+  check_contents(b, expected);
+
+  expected.resize(300, true);
+  b.resize(300, true);
+  check_contents(b, expected);
+  check_index(b);
+
+  b.push_back(false);
+  b.push_back(true);
+  expected.push_back(false);
+  expected.push_back(true);
+  check_contents(b, expected);
+  check_index(b);
+
+  b.clear();
+  FATAL_EXPECT_TRUE(b.empty());
+  b.resize(10);
+  check_contents(b, std::vector<bool>(10));
+}
+
+FATAL_TEST(dynamic_bitset, bitwise) {
+  std::mt19937 rng(7);
+  std::size_t const size = 1000;
+  dynamic_bitset lhs(size);
+  dynamic_bitset rhs(size);
+  std::vector<bool> l(size);
+  std::vector<bool> r(size);
+
+  for (std::size_t i = 0; i < size; ++i) {
+    l[i] = rng() % 2;
+    r[i] = rng() % 3 == 0;
+    lhs.assign(i, l[i]);
+    rhs.assign(i, r[i]);
+  }
+
+  auto const check = [&](
+    dynamic_bitset const &actual,
+    bool (*operation)(bool, bool)
+  ) {
+    std::vector<bool> expected(size);
+
+    for (std::size_t i = 0; i < size; ++i) {
+      expected[i] = operation(l[i], r[i]);
+    }
+
+    check_contents(actual, expected);
+  };
+
+  auto result = lhs;
+  result &= rhs;
+  check(result, [](bool a, bool b) { return a && b; });
+
+  result = lhs;
+  result |= rhs;
+  check(result, [](bool a, bool b) { return a || b; });
+
+  result = lhs;
+  result ^= rhs;
+  check(result, [](bool a, bool b) { return a != b; });
+
+  result = lhs;
+  result.and_not(rhs);
+  check(result, [](bool a, bool b) { return a && !b; });
+  check_index(result);
+
+  FATAL_EXPECT_TRUE(lhs == lhs);
+  FATAL_EXPECT_TRUE(lhs != rhs);
+  FATAL_EXPECT_TRUE(lhs != dynamic_bitset(size + 1));
+}
+
+FATAL_TEST(dynamic_bitset, rank_select) {
+  std::mt19937 rng(13);
+
+  // from sparse to dense, so that samples of the select directory are either
+  // many blocks apart or several per block
+  for (auto density: {1000u, 50u, 2u, 1u}) {
+    for (auto size: {1, 64, 511, 512, 513, 4096, 20000, 100000}) {
+      dynamic_bitset b(static_cast<std::size_t>(size));
+
+      for (std::size_t i = 0; i < b.size(); ++i) {
+        if (rng() % density == 0) {
+          b.set(i);
+        }
+      }
+
+      check_index(b);
+    }
+  }
+
+  // all bits set in a single word, past many empty blocks
+  dynamic_bitset b(1 << 16);
+  b.set(40000, 40064);
+  check_index(b);
+}
+
+FATAL_TEST(dynamic_bitset, swap) {
+  dynamic_bitset a(10, true);
+  dynamic_bitset b(3);
+  a.build_index();
+
+  swap(a, b);
+  FATAL_EXPECT_EQ(3, a.size());
+  FATAL_EXPECT_EQ(0, a.count());
+  FATAL_EXPECT_EQ(10, b.size());
+  FATAL_EXPECT_EQ(10, b.count());
+  FATAL_EXPECT_EQ(5, b.rank(5));
+}
+
+} // namespace fatal {
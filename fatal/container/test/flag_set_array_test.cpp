@@ -0,0 +1,231 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/container/flag_set_array.h>
+
+#include <fatal/test/driver.h>
+
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include <cstddef>
+
+namespace fatal {
+
+struct f0 {};
+struct f1 {};
+struct f2 {};
+struct f3 {};
+
+using fs = flag_set<f0, f1, f2, f3>;
+using fa = flag_set_array<f0, f1, f2, f3>;
+
+// checks every query against a plain array of `flag_set`
+template <typename... UFlags>
+void check_queries(fa const &actual, std::vector<fs> const &expected) {
+  std::size_t count = 0;
+  std::vector<std::size_t> indexes;
+  std::vector<fa::word_type> bitmap(actual.words());
+
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    auto const match = expected[i].template test<UFlags...>();
+    FATAL_ASSERT_EQ(match, actual.template test<UFlags...>(i));
+
+    if (match) {
+      ++count;
+      indexes.push_back(i);
+      bitmap[i / 64] |= fa::word_type(1) << (i % 64);
+    }
+  }
+
+  FATAL_EXPECT_EQ(count, actual.template count_if<UFlags...>());
+
+  std::vector<std::size_t> selected;
+  actual.template select_indexes<UFlags...>(std::back_inserter(selected));
+  FATAL_EXPECT_EQ(indexes, selected);
+
+  std::vector<fa::word_type> selected_bitmap(3, 0xff);
+  actual.template select<UFlags...>(selected_bitmap);
+  FATAL_EXPECT_EQ(bitmap, selected_bitmap);
+}
+
+void check_all_queries(fa const &actual, std::vector<fs> const &expected) {
+  FATAL_ASSERT_EQ(expected.size(), actual.size());
+
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    FATAL_ASSERT_EQ(expected[i].get(), actual[i].get());
+  }
+
+  check_queries<>(actual, expected);
+  check_queries<f0>(actual, expected);
+  check_queries<f3>(actual, expected);
+  check_queries<f1, f2>(actual, expected);
+  check_queries<f0, f1, f2>(actual, expected);
+  check_queries<f0, f1, f2, f3>(actual, expected);
+}
+
+FATAL_TEST(flag_set_array, empty) {
+  fa a;
+
+  FATAL_EXPECT_TRUE(a.empty());
+  FATAL_EXPECT_EQ(0, a.size());
+  FATAL_EXPECT_EQ(0, a.words());
+  FATAL_EXPECT_EQ(0, a.count_if<>());
+  FATAL_EXPECT_EQ(0, a.count_if<f0>());
+
+  std::vector<fa::word_type> bitmap(2);
+  a.select<f0>(bitmap);
+  FATAL_EXPECT_TRUE(bitmap.empty());
+
+  flag_set_array<> none(70);
+  FATAL_EXPECT_EQ(70, none.count_if<>());
+}
+
+FATAL_TEST(flag_set_array, element_access) {
+  fa a(3);
+
+  FATAL_EXPECT_EQ(3, a.size());
+  FATAL_EXPECT_EQ(1, a.words());
+  FATAL_EXPECT_EQ(0, a[1].get());
+
+  a.assign(1, fs(f0(), f2()));
+  FATAL_EXPECT_TRUE((a[1].test<f0, f2>()));
+  FATAL_EXPECT_FALSE(a[1].test<f1>());
+  FATAL_EXPECT_EQ(0, a[0].get());
+  FATAL_EXPECT_EQ(0, a[2].get());
+
+  a.assign(1, fs(f1()));
+  FATAL_EXPECT_TRUE(a[1].equals<f1>());
+
+  a.set<f3>(2);
+  FATAL_EXPECT_TRUE(a.test<f3>(2));
+  a.reset<f3>(2);
+  FATAL_EXPECT_FALSE(a.test<f3>(2));
+
+  a.push_back(fs(f0(), f3()));
+  FATAL_EXPECT_EQ(4, a.size());
+  FATAL_EXPECT_TRUE((a[3].equals<f0, f3>()));
+}
+
+FATAL_TEST(flag_set_array, ranges) {
+  std::size_t const size = 1000;
+  fa a(size);
+  std::vector<fs> expected(size);
+
+  auto const set = [&](std::size_t begin, std::size_t end) {
+    a.set<f1, f2>(begin, end);
+
+    for (auto i = begin; i < end; ++i) {
+      expected[i].set<f1, f2>();
+    }
+  };
+
+  auto const reset = [&](std::size_t begin, std::size_t end) {
+    a.reset<f2>(begin, end);
+
+    for (auto i = begin; i < end; ++i) {
+      expected[i].reset<f2>();
+    }
+  };
+
+  // within a word, across words, and ending at word boundaries
+  set(3, 9);
+  set(60, 70);
+  set(128, 256);
+  set(300, 999);
+  check_all_queries(a, expected);
+
+  reset(5, 5);
+  reset(64, 65);
+  reset(200, 640);
+  reset(990, 1000);
+  check_all_queries(a, expected);
+
+  set(0, size);
+  check_all_queries(a, expected);
+}
+
+FATAL_TEST(flag_set_array, resize) {
+  fa a;
+  std::vector<fs> expected;
+
+  for (std::size_t i = 0; i < 200; ++i) {
+    fs value;
+    value.set_if<f0>(i % 2);
+    value.set_if<f1>(i % 3 == 0);
+    value.set_if<f2>(i % 5 != 0);
+    value.set_if<f3>(i > 100);
+
+    a.push_back(value);
+    expected.push_back(value);
+  }
+
+  check_all_queries(a, expected);
+
+  a.set<f0, f1, f2, f3>(0, a.size());
+
+  // the elements removed don't come back
+  a.resize(67);
+  expected.assign(67, fs(f0(), f1(), f2(), f3()));
+  check_all_queries(a, expected);
+
+  a.resize(150);
+  expected.resize(150);
+  check_all_queries(a, expected);
+
+  a.reserve(1000);
+  check_all_queries(a, expected);
+
+  a.clear();
+  FATAL_EXPECT_TRUE(a.empty());
+  a.resize(10);
+  check_all_queries(a, std::vector<fs>(10));
+}
+
+FATAL_TEST(flag_set_array, random) {
+  std::mt19937 rng(42);
+  std::vector<fs> expected;
+  fa a;
+
+  for (auto size: {1, 63, 64, 65, 127, 128, 129, 255, 256, 257, 1031}) {
+    auto const n = static_cast<std::size_t>(size);
+    expected.assign(n, fs());
+    a.resize(0);
+    a.resize(n);
+
+    for (std::size_t i = 0; i < n; ++i) {
+      auto const bits = rng();
+      fs value;
+      value.set_if<f0>(bits & 1);
+      value.set_if<f1>(bits & 2);
+      value.set_if<f2>(bits & 4);
+      value.set_if<f3>(bits & 8);
+
+      expected[i] = value;
+      a.assign(i, value);
+    }
+
+    check_all_queries(a, expected);
+  }
+}
+
+FATAL_TEST(flag_set_array, swap) {
+  fa a(10);
+  a.set<f0>(0, 10);
+  fa b(3);
+
+  swap(a, b);
+  FATAL_EXPECT_EQ(3, a.size());
+  FATAL_EXPECT_EQ(0, a.count_if<f0>());
+  FATAL_EXPECT_EQ(10, b.size());
+  FATAL_EXPECT_EQ(10, b.count_if<f0>());
+}
+
+} // namespace fatal {
@@ -0,0 +1,433 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/container/flat_hash_map.h>
+
+#include <fatal/container/arena.h>
+
+#include <fatal/test/driver.h>
+#include <fatal/test/ref_counter.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace fatal {
+
+template <typename Map>
+std::vector<std::pair<typename Map::key_type, typename Map::mapped_type>>
+sorted(Map const &map) {
+  std::vector<
+    std::pair<typename Map::key_type, typename Map::mapped_type>
+  > result(map.begin(), map.end());
+
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+FATAL_TEST(flat_hash_map, empty) {
+  flat_hash_map<int, int> map;
+
+  FATAL_EXPECT_TRUE(map.empty());
+  FATAL_EXPECT_EQ(0, map.size());
+  FATAL_EXPECT_EQ(0, map.capacity());
+  FATAL_EXPECT_TRUE(map.begin() == map.end());
+  FATAL_EXPECT_TRUE(map.find(10) == map.end());
+  FATAL_EXPECT_EQ(0, map.count(10));
+  FATAL_EXPECT_EQ(0, map.erase(10));
+
+  FATAL_EXPECT_THROW(std::out_of_range) {
+    map.at(10);
+  };
+
+  map.clear();
+  FATAL_EXPECT_TRUE(map.empty());
+}
+
+FATAL_TEST(flat_hash_map, insert_find_erase) {
+  flat_hash_map<int, std::string> map;
+
+  auto const a = map.try_emplace(1, "one");
+  FATAL_EXPECT_TRUE(a.second);
+  FATAL_EXPECT_EQ(1, a.first->first);
+  FATAL_EXPECT_EQ("one", a.first->second);
+
+  // existing keys are left untouched
+  auto const b = map.try_emplace(1, "uno");
+  FATAL_EXPECT_FALSE(b.second);
+  FATAL_EXPECT_TRUE(a.first == b.first);
+  FATAL_EXPECT_EQ("one", map.at(1));
+
+  FATAL_EXPECT_TRUE(map.insert(std::make_pair(2, std::string("two"))).second);
+  map[3] = "three";
+  map[3] += "!";
+  FATAL_EXPECT_EQ(3, map.size());
+  FATAL_EXPECT_EQ("three!", map.at(3));
+  FATAL_EXPECT_EQ("two", map.find(2)->second);
+  FATAL_EXPECT_EQ(1, map.count(2));
+  FATAL_EXPECT_TRUE(map.find(4) == map.end());
+
+  FATAL_EXPECT_EQ(1, map.erase(2));
+  FATAL_EXPECT_EQ(0, map.erase(2));
+  FATAL_EXPECT_EQ(2, map.size());
+  FATAL_EXPECT_TRUE(map.find(2) == map.end());
+
+  map.erase(map.find(1));
+  FATAL_EXPECT_EQ(1, map.size());
+  FATAL_EXPECT_EQ(
+    (std::vector<std::pair<int, std::string>>{{3, "three!"}}),
+    sorted(map)
+  );
+
+  map.clear();
+  FATAL_EXPECT_TRUE(map.empty());
+  FATAL_EXPECT_TRUE(map.begin() == map.end());
+  FATAL_EXPECT_TRUE(map.find(3) == map.end());
+}
+
+FATAL_TEST(flat_hash_map, reserve) {
+  flat_hash_map<int, int> map(100);
+  auto const capacity = map.capacity();
+  FATAL_EXPECT_LE(100, capacity);
+  FATAL_EXPECT_EQ(0, capacity & (capacity - 1));
+
+  for (int i = 0; i < 100; ++i) {
+    map[i] = i;
+  }
+
+  // no growth
+  FATAL_EXPECT_EQ(capacity, map.capacity());
+
+  map.reserve(1000);
+  FATAL_EXPECT_LE(1000, map.capacity());
+
+  for (int i = 0; i < 100; ++i) {
+    FATAL_ASSERT_EQ(i, map.at(i));
+  }
+}
+
+// checks a map against `std::map` under a random mix of insertions and
+// erasures, so that deleted slots pile up and get reused or dropped
+FATAL_TEST(flat_hash_map, random) {
+  std::mt19937 rng(17);
+  flat_hash_map<unsigned, unsigned> map;
+  std::map<unsigned, unsigned> expected;
+
+  for (auto i = 0; i < 20000; ++i) {
+    auto const key = static_cast<unsigned>(rng() % 2000);
+
+    if (rng() % 3) {
+      auto const value = static_cast<unsigned>(rng());
+      map[key] = value;
+      expected[key] = value;
+    } else {
+      FATAL_ASSERT_EQ(expected.erase(key), map.erase(key));
+    }
+
+    FATAL_ASSERT_EQ(expected.size(), map.size());
+  }
+
+  for (unsigned key = 0; key < 2000; ++key) {
+    auto const i = expected.find(key);
+    auto const j = map.find(key);
+
+    if (i == expected.end()) {
+      FATAL_ASSERT_TRUE(j == map.end());
+    } else {
+      FATAL_ASSERT_TRUE(j != map.end());
+      FATAL_ASSERT_EQ(i->second, j->second);
+    }
+  }
+
+  FATAL_EXPECT_EQ(
+    (std::vector<std::pair<unsigned, unsigned>>(
+      expected.begin(), expected.end()
+    )),
+    sorted(map)
+  );
+
+  // erasing while iterating
+  for (auto i = map.begin(); i != map.end(); ) {
+    i = i->first % 2 ? map.erase(i) : std::next(i);
+  }
+
+  for (auto const &i: map) {
+    FATAL_ASSERT_EQ(0, i.first % 2);
+  }
+}
+
+FATAL_TEST(flat_hash_map, heterogeneous_lookup) {
+  flat_hash_map<std::string, int> map;
+  map["hello"] = 1;
+  map[std::string("world")] = 2;
+  map[string_view("hello, world")] = 3;
+  map[rope<>("ro", "pe")] = 4;
+
+  FATAL_EXPECT_EQ(4, map.size());
+
+  FATAL_EXPECT_EQ(1, map.at(std::string("hello")));
+  FATAL_EXPECT_EQ(1, map.at(string_view("hello")));
+  FATAL_EXPECT_EQ(2, map.at("world"));
+  FATAL_EXPECT_EQ(3, map.at(rope<>("hello", ", ", "world")));
+  FATAL_EXPECT_EQ(3, map.at(rope<>("hello, world")));
+  FATAL_EXPECT_EQ(4, map.at("rope"));
+
+  FATAL_EXPECT_TRUE(map.find(rope<>("hello", ", ")) == map.end());
+  FATAL_EXPECT_TRUE(map.find(string_view("hell")) == map.end());
+  FATAL_EXPECT_EQ(0, map.count(std::string("hello\0", 6)));
+
+  FATAL_EXPECT_EQ(1, map.erase(rope<>("wor", "ld")));
+  FATAL_EXPECT_EQ(3, map.size());
+}
+
+FATAL_TEST(flat_hash_map, arena_keys) {
+  monotonic_arena arena;
+  flat_hash_map<string_view, int> map(arena);
+
+  {
+    std::string key("temporary");
+    map[key] = 1;
+    map[string_view(key).slice(0, 4)] = 2;
+    map[rope<>("r", "op", "e")] = 3;
+    key.assign(key.size(), 'x');
+  }
+
+  // the keys outlive the strings they were inserted from
+  FATAL_EXPECT_EQ(3, map.size());
+  FATAL_EXPECT_EQ(1, map.at("temporary"));
+  FATAL_EXPECT_EQ(2, map.at(std::string("temp")));
+  FATAL_EXPECT_EQ(3, map.at(rope<>("rope")));
+  FATAL_EXPECT_LE(9 + 4 + 4, arena.allocated());
+
+  // without an arena, keys are views into the caller's strings
+  flat_hash_map<string_view, int> views;
+  std::string const key("key");
+  views[key] = 1;
+  FATAL_EXPECT_EQ(key.data(), views.begin()->first.data());
+
+  FATAL_EXPECT_THROW(std::invalid_argument) {
+    views[rope<>("r", "ope")] = 2;
+  };
+  FATAL_EXPECT_EQ(1, views.size());
+}
+
+FATAL_TEST(flat_hash_map, copy_move) {
+  flat_hash_map<std::string, int> map;
+
+  for (int i = 0; i < 50; ++i) {
+    map[std::to_string(i)] = i;
+  }
+
+  auto copy(map);
+  FATAL_EXPECT_EQ(sorted(map), sorted(copy));
+
+  copy.erase("10");
+  copy["x"] = 100;
+  FATAL_EXPECT_EQ(50, map.size());
+  FATAL_EXPECT_EQ(10, map.at("10"));
+
+  auto moved(std::move(copy));
+  FATAL_EXPECT_TRUE(copy.empty());
+  FATAL_EXPECT_EQ(100, moved.at("x"));
+
+  copy = map;
+  FATAL_EXPECT_EQ(sorted(map), sorted(copy));
+
+  moved = std::move(copy);
+  FATAL_EXPECT_EQ(sorted(map), sorted(moved));
+
+  swap(moved, copy);
+  FATAL_EXPECT_TRUE(moved.empty());
+  FATAL_EXPECT_EQ(sorted(map), sorted(copy));
+
+  // the moved from map is still usable
+  moved["a"] = 1;
+  FATAL_EXPECT_EQ(1, moved.at("a"));
+}
+
+// counts how many times keys are copied
+struct counted_key {
+  explicit counted_key(int key): value(key) {}
+
+  counted_key(counted_key const &rhs): value(rhs.value) { ++copies; }
+  counted_key(counted_key &&rhs) noexcept: value(rhs.value) {}
+
+  bool operator ==(counted_key const &rhs) const { return value == rhs.value; }
+
+  struct hash {
+    std::size_t operator ()(counted_key const &key) const {
+      return std::hash<int>()(key.value);
+    }
+  };
+
+  int value;
+  static std::size_t copies;
+};
+
+std::size_t counted_key::copies = 0;
+
+FATAL_TEST(flat_hash_map, move_only) {
+  // keys are moved, rather than copied, while the table grows
+  {
+    flat_hash_map<counted_key, int, counted_key::hash> map;
+    counted_key::copies = 0;
+
+    for (int i = 0; i < 1000; ++i) {
+      map.try_emplace(counted_key(i), i);
+    }
+
+    FATAL_EXPECT_EQ(1000, map.size());
+    FATAL_EXPECT_EQ(0, counted_key::copies);
+    FATAL_EXPECT_EQ(500, map.at(counted_key(500)));
+  }
+
+  flat_hash_map<std::unique_ptr<int>, std::unique_ptr<int>> map;
+
+  for (int i = 0; i < 100; ++i) {
+    map.try_emplace(
+      std::unique_ptr<int>(new int(i)),
+      std::unique_ptr<int>(new int(i))
+    );
+  }
+
+  FATAL_ASSERT_EQ(100, map.size());
+
+  for (auto const &i: map) {
+    FATAL_EXPECT_EQ(*i.first, *i.second);
+  }
+
+  auto moved(std::move(map));
+  FATAL_EXPECT_EQ(100, moved.size());
+  FATAL_EXPECT_TRUE(map.empty());
+}
+
+// members in both the base and the derived class aren't standard layout
+struct layout_key: counted_key {
+  explicit layout_key(int key): counted_key(key), tag(key) {}
+
+  int tag;
+};
+
+FATAL_TEST(flat_hash_map, non_standard_layout_keys) {
+  using map_type = flat_hash_map<layout_key, int, counted_key::hash>;
+
+  FATAL_EXPECT_SAME<
+    std::pair<layout_key const, int> &,
+    map_type::iterator::reference
+  >();
+  FATAL_EXPECT_SAME<
+    std::pair<layout_key const, int> const &,
+    map_type::const_iterator::reference
+  >();
+
+  FATAL_EXPECT_FALSE(
+    (std::is_standard_layout<std::pair<layout_key, int>>::value)
+  );
+
+  map_type map;
+  counted_key::copies = 0;
+
+  for (int i = 0; i < 1000; ++i) {
+    map.try_emplace(layout_key(i), i);
+  }
+
+  // keys can't be moved while the table grows, so they're copied
+  FATAL_EXPECT_EQ(1000, map.size());
+  FATAL_EXPECT_LT(0, counted_key::copies);
+
+  for (auto const &i: map) {
+    FATAL_EXPECT_EQ(i.first.value, i.second);
+    FATAL_EXPECT_EQ(i.first.tag, i.second);
+  }
+
+  map_type moved;
+  moved = std::move(map);
+  FATAL_EXPECT_EQ(1000, moved.size());
+  FATAL_EXPECT_EQ(500, moved.at(layout_key(500)));
+}
+
+FATAL_TEST(flat_hash_map, move_assignment_allocator) {
+  using allocator = arena_allocator<std::pair<std::string const, int>>;
+  using map_type = flat_hash_map<
+    std::string, int,
+    detail::flat_hash_map_impl::default_hasher<std::string>,
+    detail::flat_hash_map_impl::default_key_equal<std::string>,
+    allocator
+  >;
+
+  monotonic_arena lhs_arena;
+  monotonic_arena rhs_arena;
+  map_type lhs(0, map_type::hasher(), map_type::key_equal(),
+    allocator(lhs_arena)
+  );
+  map_type rhs(0, map_type::hasher(), map_type::key_equal(),
+    allocator(rhs_arena)
+  );
+
+  for (int i = 0; i < 100; ++i) {
+    rhs[std::to_string(i)] = i;
+  }
+
+  auto const expected = sorted(rhs);
+
+  // arena allocators aren't propagated, so the elements are moved into the
+  // memory of `lhs`
+  lhs["x"] = 10;
+  lhs = std::move(rhs);
+  FATAL_EXPECT_EQ(expected, sorted(lhs));
+  FATAL_EXPECT_EQ(&lhs_arena, &lhs.get_allocator().arena());
+  FATAL_EXPECT_EQ(0, lhs.count("x"));
+
+  // same arena, so the table is taken over
+  map_type other(0, map_type::hasher(), map_type::key_equal(),
+    allocator(lhs_arena)
+  );
+  auto const slot = &*lhs.find("10");
+  other = std::move(lhs);
+  FATAL_EXPECT_EQ(expected, sorted(other));
+  FATAL_EXPECT_EQ(slot, &*other.find("10"));
+}
+
+FATAL_TEST(flat_hash_map, lifetime) {
+  using refc = ref_counter<>;
+  refc::guard guard;
+
+  {
+    flat_hash_map<int, refc> map;
+
+    for (int i = 0; i < 100; ++i) {
+      map.try_emplace(i);
+    }
+
+    FATAL_EXPECT_EQ(100, refc::alive());
+
+    for (int i = 0; i < 100; i += 2) {
+      map.erase(i);
+    }
+
+    FATAL_EXPECT_EQ(50, refc::alive());
+
+    auto copy(map);
+    FATAL_EXPECT_EQ(100, refc::alive());
+
+    copy.clear();
+    FATAL_EXPECT_EQ(50, refc::alive());
+  }
+
+  FATAL_EXPECT_EQ(0, refc::alive());
+  FATAL_EXPECT_EQ(0, refc::valid());
+}
+
+} // namespace fatal {
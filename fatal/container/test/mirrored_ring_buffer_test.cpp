@@ -0,0 +1,172 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/container/mirrored_ring_buffer.h>
+
+#include <fatal/string/tokenizer.h>
+
+#include <fatal/test/driver.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cstring>
+
+#include <unistd.h>
+
+namespace fatal {
+
+FATAL_TEST(mirrored_ring_buffer, capacity) {
+  auto const page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+
+  FATAL_EXPECT_EQ(page, mirrored_ring_buffer(0).capacity());
+  FATAL_EXPECT_EQ(page, mirrored_ring_buffer(1).capacity());
+  FATAL_EXPECT_EQ(page, mirrored_ring_buffer(page).capacity());
+  FATAL_EXPECT_EQ(page * 2, mirrored_ring_buffer(page + 1).capacity());
+
+  mirrored_ring_buffer buffer(1);
+  FATAL_EXPECT_TRUE(buffer.empty());
+  FATAL_EXPECT_FALSE(buffer.full());
+  FATAL_EXPECT_EQ(0, buffer.size());
+  FATAL_EXPECT_EQ(page, buffer.available());
+  FATAL_EXPECT_EQ(0, buffer.readable().size());
+}
+
+FATAL_TEST(mirrored_ring_buffer, write_consume) {
+  mirrored_ring_buffer buffer(1);
+  auto const capacity = buffer.capacity();
+
+  FATAL_EXPECT_EQ(5, buffer.write("hello"));
+  FATAL_EXPECT_EQ("hello", buffer.readable());
+
+  buffer.consume(2);
+  FATAL_EXPECT_EQ("llo", buffer.readable());
+  FATAL_EXPECT_EQ(capacity - 3, buffer.available());
+
+  // only as much as fits
+  std::string const filler(capacity, 'x');
+  FATAL_EXPECT_EQ(capacity - 3, buffer.write(string_view(filler)));
+  FATAL_EXPECT_TRUE(buffer.full());
+  FATAL_EXPECT_EQ(0, buffer.write("y"));
+  FATAL_EXPECT_EQ("llo" + filler.substr(3), buffer.readable());
+
+  buffer.consume(buffer.size());
+  FATAL_EXPECT_TRUE(buffer.empty());
+
+  buffer.write("abc");
+  buffer.clear();
+  FATAL_EXPECT_TRUE(buffer.empty());
+  FATAL_EXPECT_EQ(capacity, buffer.available());
+}
+
+FATAL_TEST(mirrored_ring_buffer, contiguous_wrap_around) {
+  mirrored_ring_buffer buffer(1);
+  auto const capacity = buffer.capacity();
+
+  // moves the head close to the end of the buffer
+  std::string const filler(capacity - 3, '.');
+  FATAL_ASSERT_EQ(filler.size(), buffer.write(string_view(filler)));
+  buffer.consume(filler.size());
+  FATAL_ASSERT_TRUE(buffer.empty());
+
+  // written across the end of the buffer, yet read back contiguously
+  FATAL_EXPECT_EQ(10, buffer.write("0123456789"));
+  FATAL_EXPECT_EQ("0123456789", buffer.readable());
+
+  // and the writable region is contiguous as well
+  auto const available = buffer.available();
+  std::memset(buffer.writable(), 'z', available);
+  buffer.commit(available);
+  FATAL_EXPECT_TRUE(buffer.full());
+  FATAL_EXPECT_EQ(
+    "0123456789" + std::string(available, 'z'),
+    buffer.readable()
+  );
+
+  buffer.consume(10);
+  FATAL_EXPECT_EQ(std::string(available, 'z'), buffer.readable());
+}
+
+FATAL_TEST(mirrored_ring_buffer, move) {
+  mirrored_ring_buffer buffer(1);
+  buffer.write("abc");
+
+  mirrored_ring_buffer moved(std::move(buffer));
+  FATAL_EXPECT_EQ("abc", moved.readable());
+
+  mirrored_ring_buffer other(1);
+  other.write("xyz");
+  other = std::move(moved);
+  FATAL_EXPECT_EQ("abc", other.readable());
+
+  swap(other, moved);
+  FATAL_EXPECT_EQ("abc", moved.readable());
+  FATAL_EXPECT_EQ("xyz", other.readable());
+}
+
+FATAL_TEST(mirrored_ring_buffer, consume_tokens) {
+  mirrored_ring_buffer buffer(1);
+  std::vector<std::string> tokens;
+  auto const collect = [&](string_view token) {
+    tokens.emplace_back(token.data(), token.size());
+  };
+
+  buffer.write("a\nbc\n\nde");
+  FATAL_EXPECT_EQ(3, buffer.consume_tokens<line_tokenizer>(collect));
+  FATAL_EXPECT_EQ((std::vector<std::string>{"a", "bc", ""}), tokens);
+  FATAL_EXPECT_EQ("de", buffer.readable());
+
+  // no complete tokens
+  FATAL_EXPECT_EQ(0, buffer.consume_tokens<line_tokenizer>(collect));
+  FATAL_EXPECT_EQ("de", buffer.readable());
+
+  // a token completed by a later write, across the end of the buffer
+  std::string const filler(buffer.available() - 2, '.');
+  buffer.write(string_view(filler));
+  buffer.write("f\n");
+  tokens.clear();
+  FATAL_EXPECT_EQ(1, buffer.consume_tokens<line_tokenizer>(collect));
+  FATAL_EXPECT_EQ((std::vector<std::string>{"de" + filler + "f"}), tokens);
+  FATAL_EXPECT_TRUE(buffer.empty());
+
+  buffer.write("g\nh");
+  tokens.clear();
+  FATAL_EXPECT_EQ(1, buffer.consume_tokens<line_tokenizer>(collect));
+  FATAL_EXPECT_EQ((std::vector<std::string>{"g"}), tokens);
+  FATAL_EXPECT_EQ("h", buffer.readable());
+}
+
+FATAL_TEST(mirrored_ring_buffer, consume_nested_tokens) {
+  using table = std::vector<std::vector<std::string>>;
+
+  mirrored_ring_buffer buffer(1);
+  table rows;
+  buffer.write("a,b\nc,d\ne,");
+
+  auto const count = buffer.consume_tokens<csv_tokenizer>(
+    [](comma_tokenizer const &row, table &out) {
+      out.emplace_back();
+
+      for (auto const &field: row) {
+        out.back().emplace_back(field.data(), field.size());
+      }
+    },
+    rows
+  );
+
+  FATAL_EXPECT_EQ(2, count);
+  FATAL_EXPECT_EQ(
+    (table{{"a", "b"}, {"c", "d"}}),
+    rows
+  );
+  FATAL_EXPECT_EQ("e,", buffer.readable());
+}
+
+} // namespace fatal {
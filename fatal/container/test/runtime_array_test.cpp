@@ -9,11 +9,15 @@
 
 #include <fatal/container/runtime_array.h>
 
+#include <fatal/container/arena.h>
+
 #include <fatal/test/ref_counter.h>
 
 #include <fatal/test/driver.h>
 
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace fatal {
 
@@ -146,6 +150,24 @@ FATAL_TEST(runtime_array, move_ctor) {
 
 #undef TEST_IMPL
 
+FATAL_TEST(runtime_array, move_only) {
+  runtime_array<std::unique_ptr<int>, 2> small(2);
+  small[0].reset(new int(10));
+  small[1].reset(new int(20));
+
+  auto moved(std::move(small));
+  FATAL_ASSERT_EQ(2, moved.size());
+  FATAL_EXPECT_EQ(10, *moved[0]);
+  FATAL_EXPECT_EQ(20, *moved[1]);
+
+  // relocates the elements to the heap
+  moved.resize(5);
+  FATAL_ASSERT_EQ(5, moved.size());
+  FATAL_EXPECT_EQ(10, *moved[0]);
+  FATAL_EXPECT_EQ(20, *moved[1]);
+  FATAL_EXPECT_TRUE(!moved[4]);
+}
+
 #define TEST_IMPL(Const, Fn, CheckOverflow, UseSmallBuffer) \
   do { \
     using type = runtime_array<int, UseSmallBuffer ? 10 : 0>; \
@@ -290,4 +312,193 @@ FATAL_TEST(runtime_array, empty) {
   FATAL_EXPECT_TRUE(v8.empty());
 }
 
+// counts the allocations made through it
+template <typename T>
+struct counting_allocator: std::allocator<T> {
+  template <typename U>
+  struct rebind { using other = counting_allocator<U>; };
+
+  counting_allocator() = default;
+
+  template <typename U>
+  counting_allocator(counting_allocator<U> const &) noexcept {}
+
+  T *allocate(std::size_t n) {
+    ++allocations();
+    return std::allocator<T>::allocate(n);
+  }
+
+  static std::size_t &allocations() {
+    static std::size_t instance = 0;
+    return instance;
+  }
+};
+
+FATAL_TEST(runtime_array, value_ctor) {
+  runtime_array<std::string, 2> small(2, "x");
+  FATAL_EXPECT_EQ(2, small.size());
+  FATAL_EXPECT_EQ("x", small[0]);
+  FATAL_EXPECT_EQ("x", small[1]);
+
+  runtime_array<int, 2> big(10, 7);
+  FATAL_EXPECT_EQ(10, big.size());
+  for (auto i: big) {
+    FATAL_EXPECT_EQ(7, i);
+  }
+}
+
+FATAL_TEST(runtime_array, resize) {
+  using refc = ref_counter<>;
+  refc::guard guard;
+
+  {
+    runtime_array<refc, 4> v(2);
+    FATAL_EXPECT_EQ(4, v.capacity());
+    FATAL_EXPECT_EQ(2, refc::alive());
+
+    // within the small buffer
+    auto const small = v.data();
+    v.resize(4);
+    FATAL_EXPECT_EQ(small, v.data());
+    FATAL_EXPECT_EQ(4, v.size());
+    FATAL_EXPECT_EQ(4, refc::alive());
+
+    v.resize(1);
+    FATAL_EXPECT_EQ(small, v.data());
+    FATAL_EXPECT_EQ(1, refc::alive());
+
+    // moves to the heap
+    v.resize(10);
+    FATAL_EXPECT_NE(small, v.data());
+    FATAL_EXPECT_EQ(10, v.size());
+    FATAL_EXPECT_EQ(10, v.capacity());
+    FATAL_EXPECT_EQ(10, refc::alive());
+    FATAL_EXPECT_EQ(10, refc::valid());
+
+    // reuses the heap storage
+    auto const heap = v.data();
+    v.resize(3);
+    v.resize(8);
+    FATAL_EXPECT_EQ(heap, v.data());
+    FATAL_EXPECT_EQ(8, refc::alive());
+
+    v.clear();
+    FATAL_EXPECT_TRUE(v.empty());
+    FATAL_EXPECT_EQ(10, v.capacity());
+    FATAL_EXPECT_EQ(0, refc::alive());
+  }
+
+  FATAL_EXPECT_EQ(0, refc::alive());
+  FATAL_EXPECT_EQ(0, refc::valid());
+
+  runtime_array<std::string, 2> v(1, "a");
+  v.resize(3, "b");
+  v.resize(5, v[0]);
+  FATAL_EXPECT_EQ(
+    (std::vector<std::string>{"a", "b", "b", "a", "a"}),
+    std::vector<std::string>(v.begin(), v.end())
+  );
+}
+
+FATAL_TEST(runtime_array, assign) {
+  using allocator = counting_allocator<int>;
+  allocator::allocations() = 0;
+
+  runtime_array<int, 2, allocator> v(0);
+  v.assign(3, 5);
+  FATAL_EXPECT_EQ(1, allocator::allocations());
+  FATAL_EXPECT_EQ(3, v.size());
+
+  int const values[] = {1, 2, 3, 4, 5, 6};
+  v.assign(values, values + 6);
+  FATAL_EXPECT_EQ(2, allocator::allocations());
+  FATAL_EXPECT_EQ(6, v.size());
+  FATAL_EXPECT_TRUE(std::equal(v.begin(), v.end(), values));
+
+  // within capacity
+  std::vector<long> const other{9, 8};
+  v.assign(other.begin(), other.end());
+  v.assign(4, 1);
+  v.reserve(6);
+  FATAL_EXPECT_EQ(2, allocator::allocations());
+  FATAL_EXPECT_EQ(4, v.size());
+  for (auto i: v) {
+    FATAL_EXPECT_EQ(1, i);
+  }
+
+  runtime_array<std::string, 1> s(0);
+  std::vector<std::string> const strings{"a", "b", "c"};
+  s.assign(strings.begin(), strings.end());
+  s.assign(strings.begin() + 1, strings.end());
+  FATAL_EXPECT_EQ(
+    (std::vector<std::string>{"b", "c"}),
+    std::vector<std::string>(s.begin(), s.end())
+  );
+}
+
+FATAL_TEST(runtime_array, assignment_operator) {
+  using refc = ref_counter<>;
+  refc::guard guard;
+
+  {
+    runtime_array<refc, 2> small(2);
+    runtime_array<refc, 2> big(5);
+    FATAL_EXPECT_EQ(7, refc::alive());
+
+    runtime_array<refc, 2> v(0);
+    v = big;
+    FATAL_EXPECT_EQ(5, v.size());
+    FATAL_EXPECT_EQ(12, refc::alive());
+
+    v = small;
+    FATAL_EXPECT_EQ(2, v.size());
+    FATAL_EXPECT_EQ(9, refc::alive());
+
+    // steals the heap storage
+    auto const data = big.data();
+    v = std::move(big);
+    FATAL_EXPECT_EQ(data, v.data());
+    FATAL_EXPECT_EQ(5, v.size());
+    FATAL_EXPECT_TRUE(big.empty());
+    FATAL_EXPECT_EQ(7, refc::alive());
+    FATAL_EXPECT_EQ(7, refc::valid());
+
+    v = std::move(small);
+    FATAL_EXPECT_EQ(2, v.size());
+    FATAL_EXPECT_EQ(4, refc::alive());
+    FATAL_EXPECT_EQ(2, refc::valid());
+  }
+
+  FATAL_EXPECT_EQ(0, refc::alive());
+  FATAL_EXPECT_EQ(0, refc::valid());
+}
+
+FATAL_TEST(runtime_array, arena_allocator) {
+  using allocator = arena_allocator<std::string>;
+  using type = runtime_array<std::string, 1, allocator>;
+
+  char buffer[1024];
+  monotonic_arena arena(buffer, sizeof(buffer));
+
+  {
+    type v(4, "x", allocator(arena));
+    FATAL_EXPECT_EQ(4 * sizeof(std::string), arena.allocated());
+    FATAL_EXPECT_EQ(0, arena.blocks());
+
+    v.resize(2);
+    v.resize(4, "y");
+    FATAL_EXPECT_EQ(4 * sizeof(std::string), arena.allocated());
+
+    type copy(v);
+    FATAL_EXPECT_EQ(8 * sizeof(std::string), arena.allocated());
+    FATAL_EXPECT_EQ("y", copy[3]);
+
+    type moved(std::move(copy));
+    FATAL_EXPECT_EQ(8 * sizeof(std::string), arena.allocated());
+    FATAL_EXPECT_EQ("x", moved[0]);
+  }
+
+  FATAL_EXPECT_EQ(0, arena.blocks());
+}
+
 } // namespace fatal {
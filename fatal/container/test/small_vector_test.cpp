@@ -0,0 +1,398 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/container/small_vector.h>
+
+#include <fatal/container/arena.h>
+
+#include <fatal/test/driver.h>
+#include <fatal/test/ref_counter.h>
+
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+
+namespace fatal {
+
+// moved around with `std::memcpy`
+struct relocatable_string {
+  relocatable_string(char const *s = ""): s_(new std::string(s)) {}
+  relocatable_string(relocatable_string const &rhs):
+    s_(new std::string(*rhs.s_))
+  {}
+  relocatable_string(relocatable_string &&rhs) noexcept: s_(rhs.s_) {
+    rhs.s_ = nullptr;
+  }
+
+  relocatable_string &operator =(relocatable_string rhs) noexcept {
+    std::swap(s_, rhs.s_);
+    return *this;
+  }
+
+  ~relocatable_string() { delete s_; }
+
+  bool operator ==(relocatable_string const &rhs) const {
+    return *s_ == *rhs.s_;
+  }
+
+private:
+  std::string *s_;
+};
+
+template <>
+struct is_trivially_relocatable<relocatable_string>: std::true_type {};
+
+// throws when copied after `copies` drops to 0
+struct throwing {
+  explicit throwing(int value): value_(value) {}
+  throwing(throwing const &rhs): value_(rhs.value_) {
+    if (!copies--) {
+      throw std::runtime_error("copy");
+    }
+  }
+
+  throwing &operator =(throwing const &) = default;
+
+  bool operator ==(throwing const &rhs) const { return value_ == rhs.value_; }
+
+  static int copies;
+
+private:
+  int value_;
+};
+
+int throwing::copies = 0;
+
+template <typename T, std::size_t N>
+void check(small_vector<T, N> const &actual, std::vector<T> const &expected) {
+  FATAL_ASSERT_EQ(expected.size(), actual.size());
+  FATAL_EXPECT_EQ(expected.empty(), actual.empty());
+  FATAL_EXPECT_LE(actual.size(), actual.capacity());
+
+  if (actual.size() > N) {
+    FATAL_EXPECT_FALSE(actual.is_inline());
+  }
+
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    FATAL_ASSERT_TRUE(expected[i] == actual[i]);
+    FATAL_ASSERT_EQ(actual.data() + i, std::addressof(actual[i]));
+  }
+}
+
+FATAL_TEST(small_vector, inline) {
+  small_vector<int, 4> v;
+  FATAL_EXPECT_TRUE(v.empty());
+  FATAL_EXPECT_TRUE(v.is_inline());
+  FATAL_EXPECT_EQ(4, v.capacity());
+  FATAL_EXPECT_TRUE(v.begin() == v.end());
+
+  for (int i = 0; i < 4; ++i) {
+    v.push_back(i);
+  }
+
+  check(v, {0, 1, 2, 3});
+  FATAL_EXPECT_TRUE(v.is_inline());
+
+  // everything moves to the heap
+  v.push_back(4);
+  check(v, {0, 1, 2, 3, 4});
+  FATAL_EXPECT_FALSE(v.is_inline());
+  FATAL_EXPECT_EQ(0, v.front());
+  FATAL_EXPECT_EQ(4, v.back());
+  FATAL_EXPECT_EQ(4, v.at(4));
+
+  FATAL_EXPECT_THROW(std::out_of_range) {
+    v.at(5);
+  };
+
+  v.pop_back();
+  v.pop_back();
+  v.shrink_to_fit();
+  FATAL_EXPECT_TRUE(v.is_inline());
+  check(v, {0, 1, 2});
+
+  v.reserve(100);
+  FATAL_EXPECT_LE(100, v.capacity());
+  check(v, {0, 1, 2});
+
+  v.shrink_to_fit();
+  FATAL_EXPECT_TRUE(v.is_inline());
+
+  small_vector<int, 0> none{1, 2};
+  FATAL_EXPECT_FALSE(none.is_inline());
+  FATAL_EXPECT_EQ(2, none.size());
+  none.clear();
+  none.shrink_to_fit();
+  FATAL_EXPECT_TRUE(none.is_inline());
+  FATAL_EXPECT_EQ(0, none.capacity());
+}
+
+// inserting anywhere grows the capacity geometrically, so that it only
+// changes a logarithmic number of times
+template <typename T, typename Insert>
+void check_growth(Insert &&insert) {
+  small_vector<T, 4> v;
+  std::size_t reallocations = 0;
+
+  for (auto i = 0; i < 1000; ++i) {
+    auto const capacity = v.capacity();
+    insert(v, static_cast<std::size_t>(i));
+    reallocations += capacity != v.capacity();
+  }
+
+  FATAL_EXPECT_EQ(1000, v.size());
+  FATAL_EXPECT_LE(reallocations, 10);
+}
+
+template <typename T>
+void check_growth(T const &value) {
+  using vector = small_vector<T, 4>;
+
+  check_growth<T>([&](vector &v, std::size_t) { v.push_back(value); });
+  check_growth<T>([&](vector &v, std::size_t) { v.insert(v.begin(), value); });
+  check_growth<T>([&](vector &v, std::size_t) { v.emplace(v.begin(), value); });
+  check_growth<T>([&](vector &v, std::size_t i) {
+    v.insert(v.begin() + static_cast<std::ptrdiff_t>(i / 2), value);
+  });
+}
+
+FATAL_TEST(small_vector, growth) {
+  check_growth(10);
+  check_growth(std::string("not relocatable"));
+  check_growth(relocatable_string("relocatable"));
+}
+
+template <typename T>
+void random_operations(std::vector<T> const &values) {
+  std::mt19937 rng(5);
+  small_vector<T, 6> actual;
+  std::vector<T> expected;
+
+  auto const value = [&]() { return values[rng() % values.size()]; };
+  auto const position = [&](std::size_t extra) {
+    return rng() % (expected.size() + extra);
+  };
+
+  for (auto i = 0; i < 3000; ++i) {
+    switch (rng() % 10) {
+      case 0:
+      case 1: {
+        auto const v = value();
+        actual.push_back(v);
+        expected.push_back(v);
+        break;
+      }
+
+      case 2: {
+        auto const p = position(1);
+        auto const v = value();
+        auto const j = actual.insert(actual.begin() + p, v);
+        FATAL_ASSERT_EQ(actual.begin() + p, j);
+        expected.insert(expected.begin() + p, v);
+        break;
+      }
+
+      case 3: {
+        auto const p = position(1);
+        auto const n = rng() % 8;
+        auto const v = value();
+        actual.insert(actual.begin() + p, n, v);
+        expected.insert(expected.begin() + p, n, v);
+        break;
+      }
+
+      case 4: {
+        auto const p = position(1);
+        std::vector<T> range(rng() % 8, value());
+        actual.insert(actual.begin() + p, range.begin(), range.end());
+        expected.insert(expected.begin() + p, range.begin(), range.end());
+        break;
+      }
+
+      case 5:
+        if (!expected.empty()) {
+          auto const p = position(0);
+          actual.erase(actual.begin() + p);
+          expected.erase(expected.begin() + p);
+        }
+        break;
+
+      case 6: {
+        auto const first = position(1);
+        auto const last = first + rng() % (expected.size() - first + 1);
+        actual.erase(actual.begin() + first, actual.begin() + last);
+        expected.erase(expected.begin() + first, expected.begin() + last);
+        break;
+      }
+
+      // the inserted element is one of the elements being moved
+      case 7:
+        if (!expected.empty()) {
+          auto const p = position(0);
+          auto const from = position(0);
+          actual.insert(actual.begin() + p, actual[from]);
+          expected.insert(expected.begin() + p, T(expected[from]));
+          actual.push_back(actual.front());
+          expected.push_back(T(expected.front()));
+        }
+        break;
+
+      case 8: {
+        auto const size = rng() % 20;
+        auto const v = value();
+        actual.resize(size, v);
+        expected.resize(size, v);
+        break;
+      }
+
+      case 9:
+        if (rng() % 4 == 0) {
+          actual.shrink_to_fit();
+        }
+        break;
+    }
+
+    check(actual, expected);
+  }
+}
+
+FATAL_TEST(small_vector, random_operations) {
+  random_operations<int>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
+  random_operations<std::string>({
+    "", "a", "short", "a string long enough to be allocated by std::string"
+  });
+  random_operations<relocatable_string>({"x", "y", "z"});
+}
+
+FATAL_TEST(small_vector, constructors) {
+  using vector = small_vector<std::string, 3>;
+
+  check(vector(2), {"", ""});
+  check(vector(5, "x"), {"x", "x", "x", "x", "x"});
+  check(vector{"a", "b"}, {"a", "b"});
+
+  std::vector<std::string> const source{"a", "b", "c", "d"};
+  vector v(source.begin(), source.end());
+  check(v, source);
+
+  for (auto size: {0, 2, 4}) {
+    vector const original(source.begin(), source.begin() + size);
+
+    auto copy(original);
+    check(copy, {source.begin(), source.begin() + size});
+
+    auto moved(std::move(copy));
+    check(moved, {source.begin(), source.begin() + size});
+    FATAL_EXPECT_TRUE(copy.empty());
+
+    // assignment between every combination of inline and heap storage
+    for (auto other: {0, 2, 4}) {
+      vector lhs(source.begin(), source.begin() + other);
+      lhs = original;
+      FATAL_EXPECT_TRUE(lhs == original);
+
+      vector rhs(source.begin(), source.begin() + other);
+      lhs = std::move(rhs);
+      check(lhs, {source.begin(), source.begin() + other});
+      FATAL_EXPECT_TRUE(rhs.empty());
+
+      vector a(original);
+      vector b(source.rbegin(), source.rbegin() + other);
+      swap(a, b);
+      check(a, {source.rbegin(), source.rbegin() + other});
+      FATAL_EXPECT_TRUE(b == original);
+    }
+  }
+
+  v = {"z"};
+  check(v, {"z"});
+  v.assign(4, "y");
+  check(v, {"y", "y", "y", "y"});
+  v.assign(source.rbegin(), source.rend() - 1);
+  check(v, {"d", "c", "b"});
+
+  FATAL_EXPECT_TRUE(vector{"a"} < vector({"a", "b"}));
+  FATAL_EXPECT_TRUE(vector{"a"} != vector({"b"}));
+}
+
+FATAL_TEST(small_vector, lifetime) {
+  using refc = ref_counter<>;
+  refc::guard guard;
+
+  {
+    small_vector<refc, 4> v;
+
+    for (int i = 0; i < 10; ++i) {
+      v.emplace_back();
+    }
+
+    FATAL_EXPECT_EQ(10, refc::alive());
+
+    v.erase(v.begin() + 2, v.begin() + 5);
+    FATAL_EXPECT_EQ(7, refc::alive());
+
+    v.insert(v.begin() + 1, 3, refc());
+    FATAL_EXPECT_EQ(10, refc::alive());
+
+    v.resize(2);
+    v.shrink_to_fit();
+    FATAL_EXPECT_TRUE(v.is_inline());
+    FATAL_EXPECT_EQ(2, refc::alive());
+
+    auto copy(v);
+    FATAL_EXPECT_EQ(4, refc::alive());
+  }
+
+  FATAL_EXPECT_EQ(0, refc::alive());
+  FATAL_EXPECT_EQ(0, refc::valid());
+}
+
+FATAL_TEST(small_vector, exception_safety) {
+  small_vector<throwing, 2> v;
+  v.emplace_back(1);
+  v.emplace_back(2);
+
+  // growing copies the elements since `throwing` has no move constructor
+  throwing::copies = 1;
+  FATAL_EXPECT_THROW(std::runtime_error) {
+    v.push_back(throwing(3));
+  };
+  FATAL_EXPECT_EQ(2, v.size());
+  FATAL_EXPECT_TRUE(v.is_inline());
+
+  throwing::copies = 100;
+  v.push_back(throwing(3));
+
+  throwing::copies = 2;
+  FATAL_EXPECT_THROW(std::runtime_error) {
+    v.insert(v.begin(), 4, throwing(0));
+  };
+  FATAL_EXPECT_EQ(3, v.size());
+  FATAL_EXPECT_TRUE(throwing(1) == v[0]);
+  FATAL_EXPECT_TRUE(throwing(3) == v[2]);
+}
+
+FATAL_TEST(small_vector, allocator) {
+  monotonic_arena arena;
+  small_vector<int, 2, arena_allocator<int>> v{arena_allocator<int>(arena)};
+
+  v.push_back(1);
+  v.push_back(2);
+  FATAL_EXPECT_EQ(0, arena.allocated());
+
+  v.push_back(3);
+  FATAL_EXPECT_LE(3 * sizeof(int), arena.allocated());
+  FATAL_EXPECT_FALSE(v.is_inline());
+  FATAL_EXPECT_EQ(3, v[2]);
+}
+
+} // namespace fatal {
@@ -11,10 +11,12 @@
 
 #include <fatal/test/driver.h>
 
+#include <fatal/container/arena.h>
 #include <fatal/container/optional.h>
 #include <fatal/portability.h>
 
 #include <algorithm>
+#include <array>
 #include <initializer_list>
 #include <map>
 #include <memory>
@@ -1147,6 +1149,116 @@ FATAL_TEST(variant, visit) {
   v.visit(type_checker_visitor<double>(5.0));
 }
 
+template <typename> struct indexed_variant;
+
+template <std::size_t... Indexes>
+struct indexed_variant<index_sequence<Indexes...>> {
+  using type = test_variant<std::integral_constant<std::size_t, Indexes>...>;
+};
+
+struct index_visitor {
+  template <std::size_t Index>
+  void operator ()(
+    std::integral_constant<std::size_t, Index> const &,
+    std::size_t &out
+  ) const {
+    out = Index;
+  }
+};
+
+template <std::size_t Index, typename Variant>
+void check_visit_index(Variant &v) {
+  v = std::integral_constant<std::size_t, Index>();
+  FATAL_ASSERT_EQ(Index, v.tag());
+
+  std::size_t actual = 0;
+  FATAL_EXPECT_TRUE(v.visit(index_visitor(), actual));
+  FATAL_EXPECT_EQ(Index, actual);
+
+  actual = 0;
+  auto const &c = v;
+  FATAL_EXPECT_TRUE(c.visit(index_visitor(), actual));
+  FATAL_EXPECT_EQ(Index, actual);
+}
+
+template <std::size_t... Indexes>
+void check_visit_many_types(index_sequence<Indexes...>) {
+  using var = typename indexed_variant<index_sequence<Indexes...>>::type;
+  var v(allocator);
+
+  std::size_t actual = 0;
+  FATAL_EXPECT_FALSE(v.visit(index_visitor(), actual));
+
+  auto const ignore = { (check_visit_index<Indexes>(v), 0)... };
+  (void) ignore;
+}
+
+FATAL_TEST(variant, visit_many_types) {
+  check_visit_many_types(make_index_sequence<2>());
+  check_visit_many_types(make_index_sequence<40>());
+  check_visit_many_types(make_index_sequence<64>());
+}
+
+struct multi_type_visitor {
+  template <typename... T>
+  void operator ()(T &&...) {
+    types = { &typeid(typename std::decay<T>::type)... };
+  }
+
+  std::vector<std::type_info const *> types;
+};
+
+struct multi_sum_visitor {
+  template <typename T, typename U>
+  void operator ()(T const &lhs, U const &rhs) { result = lhs + rhs; }
+
+  template <typename T>
+  void operator ()(T const &, test_string const &) { result = -1; }
+
+  template <typename U>
+  void operator ()(test_string const &, U const &) { result = -2; }
+
+  void operator ()(test_string const &, test_string const &) { result = -3; }
+
+  double result = 0;
+};
+
+FATAL_TEST(variant, multi_visit) {
+  using var = test_variant<int, test_string, double>;
+
+  var a(allocator);
+  var const b(allocator, 5.5);
+  multi_type_visitor types;
+
+  FATAL_EXPECT_FALSE(multi_visit(types, a, b));
+  FATAL_EXPECT_FALSE(multi_visit(types, b, a));
+  FATAL_EXPECT_TRUE(types.types.empty());
+
+  a = 10;
+  FATAL_EXPECT_TRUE(multi_visit(types, a));
+  FATAL_EXPECT_EQ(1, types.types.size());
+  FATAL_EXPECT_TRUE(&typeid(int) == types.types[0]);
+
+  test_variant<double, test_string> c(allocator, test_string("c", allocator));
+  FATAL_EXPECT_TRUE(multi_visit(types, b, c, a));
+  FATAL_EXPECT_EQ(3, types.types.size());
+  FATAL_EXPECT_TRUE(&typeid(double) == types.types[0]);
+  FATAL_EXPECT_TRUE(&typeid(test_string) == types.types[1]);
+  FATAL_EXPECT_TRUE(&typeid(int) == types.types[2]);
+
+  multi_sum_visitor sum;
+  FATAL_EXPECT_TRUE(multi_visit(sum, a, b));
+  FATAL_EXPECT_EQ(15.5, sum.result);
+  FATAL_EXPECT_TRUE(multi_visit(sum, a, c));
+  FATAL_EXPECT_EQ(-1, sum.result);
+  FATAL_EXPECT_TRUE(multi_visit(sum, c, var(allocator, 1)));
+  FATAL_EXPECT_EQ(-2, sum.result);
+
+  c = 0.5;
+  FATAL_EXPECT_TRUE(multi_visit(sum, c, b));
+  FATAL_EXPECT_EQ(6, sum.result);
+}
+
 FATAL_TEST(variant, tag) {
   test_variant<int, test_string, double> v(allocator);
   FATAL_EXPECT_EQ(3, v.tag());
@@ -1789,6 +1901,113 @@ FATAL_TEST(variant, arena_allocator) {
   FATAL_EXPECT_TRUE(v.empty());
 }
 
+struct block_reuse_tag {};
+
+// always throws when constructed, has the same block size as `std::string`
+struct throwing_block {
+  explicit throwing_block(int) { throw std::runtime_error("throwing_block"); }
+
+  char data[sizeof(std::string)];
+};
+
+FATAL_TEST(variant, block_reuse_storage_policy) {
+  using counters = allocation_counters<block_reuse_tag>;
+  using policy = block_reuse_storage_policy<
+    std::allocator<void>, dynamic_allocation_policy, true, counters
+  >;
+
+  FATAL_EXPECT_EQ(1, policy::block_size<int>());
+  FATAL_EXPECT_EQ(
+    policy::block_size<std::string>(),
+    policy::block_size<throwing_block>()
+  );
+  FATAL_EXPECT_LE(
+    sizeof(std::string),
+    policy::block_size<std::string>() * sizeof(policy::block)
+  );
+
+  std::allocator<void> alloc;
+  counters::reset();
+
+  {
+    using var = variant<
+      policy, int, double, std::string, std::array<char, 100>, throwing_block
+    >;
+    var v(alloc);
+
+    v = std::string("hello, world");
+    FATAL_EXPECT_EQ(1, counters::allocations());
+    FATAL_EXPECT_EQ(0, counters::reuses());
+
+    // same type
+    v = std::string("hey");
+    FATAL_EXPECT_EQ(1, counters::allocations());
+    FATAL_EXPECT_EQ("hey", v.get<std::string>());
+
+    // different block size
+    v = 10;
+    FATAL_EXPECT_EQ(2, counters::allocations());
+    FATAL_EXPECT_EQ(1, counters::deallocations());
+    FATAL_EXPECT_EQ(10, v.get<int>());
+
+    // same block size
+    v = 5.6;
+    FATAL_EXPECT_EQ(2, counters::allocations());
+    FATAL_EXPECT_EQ(1, counters::reuses());
+    FATAL_EXPECT_EQ(5.6, v.get<double>());
+
+    v = 7;
+    FATAL_EXPECT_EQ(2, counters::allocations());
+    FATAL_EXPECT_EQ(2, counters::reuses());
+    FATAL_EXPECT_EQ(7, v.get<int>());
+
+    v = std::array<char, 100>();
+    FATAL_EXPECT_EQ(3, counters::allocations());
+    FATAL_EXPECT_EQ(2, counters::deallocations());
+
+    // the block is handed back when the new value fails to construct
+    v = std::string("hello, world");
+    FATAL_EXPECT_THROW(std::runtime_error) {
+      v.emplace<throwing_block>(0);
+    };
+    FATAL_EXPECT_TRUE(v.empty());
+    FATAL_EXPECT_EQ(3, counters::reuses());
+    FATAL_EXPECT_EQ(4, counters::deallocations());
+
+    v = std::string("hello, world");
+    var copy(v);
+    FATAL_EXPECT_EQ(6, counters::allocations());
+    FATAL_EXPECT_EQ("hello, world", copy.get<std::string>());
+  }
+
+  FATAL_EXPECT_EQ(counters::allocations(), counters::deallocations());
+}
+
+FATAL_TEST(variant, arena_variant) {
+  monotonic_arena arena;
+  arena_allocator<void> alloc(arena);
+
+  arena_variant<std::string, std::vector<int>, std::array<char, 100>> v(
+    alloc
+  );
+
+  v = std::string("hello, world");
+  auto const allocated = arena.allocated();
+  FATAL_EXPECT_LT(0, allocated);
+
+  // `std::string` and `std::vector` share the same block size
+  for (int i = 0; i < 100; ++i) {
+    v = std::vector<int>{1, 2, 3};
+    v = std::string("hello, world");
+  }
+
+  FATAL_EXPECT_EQ("hello, world", v.get<std::string>());
+  FATAL_EXPECT_EQ(allocated, arena.allocated());
+
+  v = std::array<char, 100>();
+  FATAL_EXPECT_LT(allocated, arena.allocated());
+}
+
 template <typename StoragePolicy = test_policy> struct t_nested_vector;
 template <typename StoragePolicy = test_policy>
 using t_nested_variant = variant<StoragePolicy, int, t_nested_vector<>>;
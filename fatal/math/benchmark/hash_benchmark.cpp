@@ -0,0 +1,274 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/math/hash.h>
+
+#include <fatal/benchmark/driver.h>
+
+#include <random>
+#include <string>
+
+#include <cstddef>
+
+namespace fatal {
+
+// how many keys are hashed by each iteration, each starting one byte after
+// the previous one so that most reads are unaligned
+using keys = std::integral_constant<std::size_t, 64>;
+
+std::string make_data() {
+  std::mt19937 rng(0);
+  std::string result(4096 + keys::value, '\0');
+
+  for (auto &c: result) {
+    c = static_cast<char>(rng());
+  }
+
+  return result;
+}
+
+// built before the benchmarks run, so that it's not accounted for
+std::string const benchmark_data(make_data());
+
+// read through a volatile pointer so that hashes aren't hoisted out of the
+// benchmark loops
+std::string const *volatile source = &benchmark_data;
+
+// keeps the hashes alive
+std::size_t volatile sink;
+
+template <typename Hasher>
+std::size_t hash(std::size_t size) {
+  std::size_t result = 0;
+  auto const data = source->data();
+
+  for (std::size_t i = 0; i < keys::value; ++i) {
+    result += *Hasher()(data + i, size);
+  }
+
+  return result;
+}
+
+////////////
+// size_1 //
+////////////
+
+FATAL_BENCHMARK(size_1, legacy_bytes_hasher, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += hash<legacy_bytes_hasher<>>(1);
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(size_1, bytes_hasher, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += hash<bytes_hasher<>>(1);
+  }
+
+  sink = result;
+}
+
+////////////
+// size_4 //
+////////////
+
+FATAL_BENCHMARK(size_4, legacy_bytes_hasher, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += hash<legacy_bytes_hasher<>>(4);
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(size_4, bytes_hasher, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += hash<bytes_hasher<>>(4);
+  }
+
+  sink = result;
+}
+
+////////////
+// size_8 //
+////////////
+
+FATAL_BENCHMARK(size_8, legacy_bytes_hasher, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += hash<legacy_bytes_hasher<>>(8);
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(size_8, bytes_hasher, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += hash<bytes_hasher<>>(8);
+  }
+
+  sink = result;
+}
+
+/////////////
+// size_16 //
+/////////////
+
+FATAL_BENCHMARK(size_16, legacy_bytes_hasher, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += hash<legacy_bytes_hasher<>>(16);
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(size_16, bytes_hasher, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += hash<bytes_hasher<>>(16);
+  }
+
+  sink = result;
+}
+
+/////////////
+// size_32 //
+/////////////
+
+FATAL_BENCHMARK(size_32, legacy_bytes_hasher, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += hash<legacy_bytes_hasher<>>(32);
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(size_32, bytes_hasher, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += hash<bytes_hasher<>>(32);
+  }
+
+  sink = result;
+}
+
+/////////////
+// size_64 //
+/////////////
+
+FATAL_BENCHMARK(size_64, legacy_bytes_hasher, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += hash<legacy_bytes_hasher<>>(64);
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(size_64, bytes_hasher, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += hash<bytes_hasher<>>(64);
+  }
+
+  sink = result;
+}
+
+//////////////
+// size_256 //
+//////////////
+
+FATAL_BENCHMARK(size_256, legacy_bytes_hasher, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += hash<legacy_bytes_hasher<>>(256);
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(size_256, bytes_hasher, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += hash<bytes_hasher<>>(256);
+  }
+
+  sink = result;
+}
+
+///////////////
+// size_1024 //
+///////////////
+
+FATAL_BENCHMARK(size_1024, legacy_bytes_hasher, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += hash<legacy_bytes_hasher<>>(1024);
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(size_1024, bytes_hasher, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += hash<bytes_hasher<>>(1024);
+  }
+
+  sink = result;
+}
+
+///////////////
+// size_4096 //
+///////////////
+
+FATAL_BENCHMARK(size_4096, legacy_bytes_hasher, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += hash<legacy_bytes_hasher<>>(4096);
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(size_4096, bytes_hasher, n) {
+  std::size_t result = 0;
+
+  while (n--) {
+    result += hash<bytes_hasher<>>(4096);
+  }
+
+  sink = result;
+}
+
+} // namespace fatal {
@@ -0,0 +1,121 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/math/quantile_sketch.h>
+
+#include <fatal/benchmark/driver.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <cstddef>
+
+namespace fatal {
+
+// how many samples are accumulated by each iteration
+using samples = std::integral_constant<std::size_t, 1 << 20>;
+
+std::vector<double> make_data() {
+  std::mt19937 rng(0);
+  std::exponential_distribution<double> distribution(.01);
+  std::vector<double> result;
+  result.reserve(samples::value);
+
+  for (auto i = samples::value; i--; ) {
+    result.push_back(distribution(rng));
+  }
+
+  return result;
+}
+
+// built before the benchmarks run, so that it's not accounted for
+std::vector<double> const benchmark_data(make_data());
+
+// read through a volatile pointer so that the accumulation isn't hoisted out
+// of the benchmark loops
+std::vector<double> const *volatile source = &benchmark_data;
+
+// keeps the results alive
+double volatile sink;
+
+// the percentiles usually tracked by service level objectives
+double const percentiles[] = {.5, .99, .999};
+
+// keeps all the samples around, selecting each percentile when queried
+FATAL_BENCHMARK(percentiles, vector_nth_element, n) {
+  double result = 0;
+
+  while (n--) {
+    std::vector<double> all;
+
+    for (auto i: *source) {
+      all.push_back(i);
+    }
+
+    for (auto q: percentiles) {
+      auto const i = all.begin() + static_cast<std::ptrdiff_t>(
+        q * static_cast<double>(all.size() - 1)
+      );
+      std::nth_element(all.begin(), i, all.end());
+      result += *i;
+    }
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(percentiles, quantile_sketch, n) {
+  double result = 0;
+
+  while (n--) {
+    quantile_sketch<> sketch;
+
+    for (auto i: *source) {
+      sketch.add(i);
+    }
+
+    sketch.compress();
+
+    for (auto q: percentiles) {
+      result += sketch.quantile(q);
+    }
+  }
+
+  sink = result;
+}
+
+// each of 8 producers accumulates an eighth of the samples into its own
+// sketch, which are then merged
+FATAL_BENCHMARK(percentiles, quantile_sketch_merge, n) {
+  double result = 0;
+
+  while (n--) {
+    std::vector<quantile_sketch<>> partial(8);
+    auto const &data = *source;
+
+    for (std::size_t i = 0; i < data.size(); ++i) {
+      partial[i % partial.size()].add(data[i]);
+    }
+
+    quantile_sketch<> sketch;
+
+    for (auto const &i: partial) {
+      sketch.merge(i);
+    }
+
+    for (auto q: percentiles) {
+      result += sketch.quantile(q);
+    }
+  }
+
+  sink = result;
+}
+
+} // namespace fatal {
@@ -0,0 +1,86 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/math/statistical_moments.h>
+
+#include <fatal/benchmark/driver.h>
+
+#include <random>
+#include <vector>
+
+#include <cstddef>
+
+namespace fatal {
+
+// how many samples are accumulated by each iteration
+using samples = std::integral_constant<std::size_t, 1 << 20>;
+
+std::vector<double> make_data() {
+  std::mt19937 rng(0);
+  std::exponential_distribution<double> distribution(.01);
+  std::vector<double> result;
+  result.reserve(samples::value);
+
+  for (auto i = samples::value; i--; ) {
+    result.push_back(distribution(rng));
+  }
+
+  return result;
+}
+
+// built before the benchmarks run, so that it's not accounted for
+std::vector<double> const benchmark_data(make_data());
+
+// read through a volatile pointer so that the accumulation isn't hoisted out
+// of the benchmark loops
+std::vector<double> const *volatile source = &benchmark_data;
+
+// keeps the results alive
+double volatile sink;
+
+FATAL_BENCHMARK(accumulate, add, n) {
+  double result = 0;
+
+  while (n--) {
+    statistical_moments<> moments;
+
+    for (auto i: *source) {
+      moments.add(i);
+    }
+
+    result += moments.kurtosis();
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(accumulate, add_range, n) {
+  double result = 0;
+
+  while (n--) {
+    statistical_moments<> moments;
+    moments.add_range(source->begin(), source->end());
+    result += moments.kurtosis();
+  }
+
+  sink = result;
+}
+
+FATAL_BENCHMARK(accumulate, parallel_accumulate, n) {
+  double result = 0;
+
+  while (n--) {
+    auto const moments = parallel_accumulate(source->begin(), source->end());
+    result += moments.kurtosis();
+  }
+
+  sink = result;
+}
+
+} // namespace fatal {
@@ -12,17 +12,23 @@
 
 #include <fatal/math/numerics.h>
 
+#include <algorithm>
 #include <iterator>
 #include <limits>
+#include <memory>
 #include <type_traits>
 
 #include <cassert>
+#include <cstdint>
+#include <cstring>
 
 namespace fatal {
 namespace detail  {
 
-template <typename T, std::size_t = sizeof(T)>
-struct bytes_hasher_impl {
+// the original algorithm, which mixes in one byte at a time
+template <typename T>
+class legacy_bytes_hasher_impl {
+public:
   using result_type = T;
 
 private:
@@ -40,6 +46,16 @@ private:
   using prime = std::integral_constant<result_type, 223>;
 
 public:
+  explicit legacy_bytes_hasher_impl(result_type seed): state_(seed) {}
+
+  void update(char const data) { state_ = hash(state_, data); }
+
+  void update(char const *begin, char const *end) {
+    state_ = hash(state_, begin, end);
+  }
+
+  result_type digest() const { return state_; }
+
   static result_type hash(result_type state, char const data) {
     return state ^ (state * prime::value + data);
   }
@@ -88,66 +104,574 @@ public:
 
     return state;
   }
+
+  // the same as `hash(state, data, data + size)`, usable at compile time
+  static constexpr result_type hash(
+    result_type state,
+    char const *data,
+    std::size_t size
+  ) {
+    return size
+      ? hash(
+        static_cast<result_type>(state ^ (state * prime::value + *data)),
+        data + 1,
+        size - 1
+      )
+      : state;
+  }
+
+private:
+  result_type state_;
+};
+
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 hash_uint128;
+
+constexpr std::uint64_t fold_product(hash_uint128 product) {
+  return static_cast<std::uint64_t>(product)
+    ^ static_cast<std::uint64_t>(product >> 64);
+}
+
+// multiplies two 64 bits words into a 128 bits product, and folds its upper
+// half into the lower one
+constexpr std::uint64_t multiply_fold(std::uint64_t lhs, std::uint64_t rhs) {
+  return fold_product(static_cast<hash_uint128>(lhs) * rhs);
+}
+#else // defined(__SIZEOF_INT128__)
+constexpr std::uint64_t fold_halves(
+  std::uint64_t lo_lo,
+  std::uint64_t hi_lo,
+  std::uint64_t hi_hi,
+  std::uint64_t middle
+) {
+  return ((middle << 32) | (lo_lo & 0xffffffff))
+    ^ (hi_hi + (hi_lo >> 32) + (middle >> 32));
+}
+
+constexpr std::uint64_t fold_partial_products(
+  std::uint64_t lo_lo,
+  std::uint64_t hi_lo,
+  std::uint64_t lo_hi,
+  std::uint64_t hi_hi
+) {
+  return fold_halves(
+    lo_lo, hi_lo, hi_hi,
+    (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi
+  );
+}
+
+// multiplies two 64 bits words into a 128 bits product, and folds its upper
+// half into the lower one
+constexpr std::uint64_t multiply_fold(std::uint64_t lhs, std::uint64_t rhs) {
+  return fold_partial_products(
+    (lhs & 0xffffffff) * (rhs & 0xffffffff),
+    (lhs >> 32) * (rhs & 0xffffffff),
+    (lhs & 0xffffffff) * (rhs >> 32),
+    (lhs >> 32) * (rhs >> 32)
+  );
+}
+#endif // defined(__SIZEOF_INT128__)
+
+// little endian load of 8 bytes, from a possibly unaligned address
+inline std::uint64_t load_word(char const *data) {
+  std::uint64_t word;
+  std::memcpy(std::addressof(word), data, sizeof(word));
+# if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  word = __builtin_bswap64(word);
+# endif
+  return word;
+}
+
+// little endian load of less than 8 bytes, zero extended, reading none of
+// the bytes past `size`
+inline std::uint64_t load_partial_word(char const *data, std::size_t size) {
+  assert(size < sizeof(std::uint64_t));
+  std::uint64_t word = 0;
+  std::size_t offset = 0;
+
+  if (size & 4) {
+    std::uint32_t piece;
+    std::memcpy(std::addressof(piece), data, sizeof(piece));
+#   if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    piece = __builtin_bswap32(piece);
+#   endif
+    word = piece;
+    offset += sizeof(piece);
+  }
+
+  if (size & 2) {
+    auto const piece = static_cast<std::uint64_t>(
+      static_cast<unsigned char>(data[offset])
+        | static_cast<unsigned char>(data[offset + 1]) << 8
+    );
+    word |= piece << (offset * 8);
+    offset += 2;
+  }
+
+  if (size & 1) {
+    auto const piece = static_cast<unsigned char>(data[offset]);
+    word |= static_cast<std::uint64_t>(piece) << (offset * 8);
+  }
+
+  return word;
+}
+
+// little endian store of 8 bytes, to a possibly unaligned address
+inline void store_word(char *data, std::uint64_t word) {
+# if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  word = __builtin_bswap64(word);
+# endif
+  std::memcpy(data, std::addressof(word), sizeof(word));
+}
+
+// hashes a 64 bits word at a time, mixing words with `multiply_fold`.
+//
+// The input is split into 32 bytes blocks, counted from the beginning of the
+// stream, and each block is mixed into two independent lanes of 16 bytes so
+// that consecutive multiplications don't depend on each other. Incomplete
+// blocks are buffered, meaning the result doesn't depend on how the input is
+// split across calls to `update`. The buffer is kept zero-padded, so that
+// the tail can be mixed in place.
+class word_hasher_impl {
+  using block = std::integral_constant<std::size_t, 32>;
+
+  using secret0 = std::integral_constant<std::uint64_t, 0xa0761d6478bd642f>;
+  using secret1 = std::integral_constant<std::uint64_t, 0xe7037ed1a0b428db>;
+  using secret2 = std::integral_constant<std::uint64_t, 0x8ebc6af09c88c6e3>;
+  using secret3 = std::integral_constant<std::uint64_t, 0x589965cc75374cc3>;
+
+public:
+  explicit word_hasher_impl(std::uint64_t seed):
+    lanes_{seed ^ secret0::value, seed ^ secret1::value},
+    size_(0),
+    buffer_{}
+  {}
+
+  void update(char const data) {
+    buffer_[size_ % block::value] = data;
+
+    if (++size_ % block::value == 0) {
+      flush();
+    }
+  }
+
+  void update(char const *begin, char const *end) {
+    assert(begin <= end);
+    auto size = static_cast<std::size_t>(std::distance(begin, end));
+    auto const buffered = static_cast<std::size_t>(size_ % block::value);
+    size_ += size;
+
+    if (buffered) {
+      auto const missing = std::min(block::value - buffered, size);
+      std::memcpy(buffer_ + buffered, begin, missing);
+
+      if (buffered + missing < block::value) {
+        return;
+      }
+
+      flush();
+      begin += missing;
+      size -= missing;
+    }
+
+    for (; size >= block::value; begin += block::value, size -= block::value) {
+      mix(lanes_, begin);
+    }
+
+    // whole words are buffered at once, so that `digest` can load them back
+    // without stalling on several narrower stores
+    auto buffer = buffer_;
+
+    for (; size >= 8; begin += 8, buffer += 8, size -= 8) {
+      store_word(buffer, load_word(begin));
+    }
+
+    if (size) {
+      store_word(buffer, load_partial_word(begin, size));
+    }
+  }
+
+  std::uint64_t digest() const {
+    auto result = fold_lanes(size_, lanes_[0], lanes_[1]);
+
+    // the tail is padded with zeros, which are told apart from actual zeros
+    // by mixing in the size of the input
+    result = multiply_fold(
+      load_word(buffer_) ^ secret0::value,
+      load_word(buffer_ + 8) ^ result
+    );
+
+    if (size_ % block::value > block::value / 2) {
+      result = multiply_fold(
+        load_word(buffer_ + 16) ^ secret1::value,
+        load_word(buffer_ + 24) ^ result
+      );
+    }
+
+    return finish(size_, result);
+  }
+
+  // the same as `hash()`, but faster when the bytes are only known at
+  // runtime since words are read straight from `data`, without buffering
+  static std::uint64_t hash_range(
+    std::uint64_t seed,
+    char const *data,
+    std::size_t size
+  ) {
+    std::uint64_t lanes[2] = {seed ^ secret0::value, seed ^ secret1::value};
+    auto const total = size;
+
+    for (; size >= block::value; data += block::value, size -= block::value) {
+      mix(lanes, data);
+    }
+
+    auto result = fold_lanes(total, lanes[0], lanes[1]);
+
+    result = multiply_fold(
+      load_tail(data, size, 0, total) ^ secret0::value,
+      load_tail(data, size, 8, total) ^ result
+    );
+
+    if (size > block::value / 2) {
+      result = multiply_fold(
+        load_tail(data, size, 16, total) ^ secret1::value,
+        load_tail(data, size, 24, total) ^ result
+      );
+    }
+
+    return finish(total, result);
+  }
+
+  // the same as `digest()` after a single call to `update(data, data + size)`
+  // on a new hasher, usable at compile time
+  static constexpr std::uint64_t hash(
+    std::uint64_t seed,
+    char const *data,
+    std::size_t size
+  ) {
+    return hash_blocks(
+      data, size, size,
+      seed ^ secret0::value,
+      seed ^ secret1::value
+    );
+  }
+
+private:
+  // mixes a full buffer, and zeroes it so that the bytes past the ones still
+  // being buffered are always zero
+  void flush() {
+    mix(lanes_, buffer_);
+    std::memset(buffer_, 0, sizeof(buffer_));
+  }
+
+  // inputs shorter than a block are never mixed into the lanes, which still
+  // hold the seed as given to the constructor, so the first lane is taken as
+  // is rather than spending a multiplication on it
+  static constexpr std::uint64_t fold_lanes(
+    std::uint64_t size,
+    std::uint64_t lane0,
+    std::uint64_t lane1
+  ) {
+    return size < block::value
+      ? lane0
+      : multiply_fold(lane0 ^ secret2::value, lane1 ^ secret3::value);
+  }
+
+  static constexpr std::uint64_t finish(
+    std::uint64_t size,
+    std::uint64_t result
+  ) {
+    return multiply_fold(result ^ secret2::value, size ^ secret3::value);
+  }
+
+  // little endian load of the bytes in the range [offset, offset + 8), of
+  // `data`, ignoring the ones past `size`
+  static constexpr std::uint64_t load_constant(
+    char const *data,
+    std::size_t size,
+    std::size_t offset
+  ) {
+    return offset < size
+      ? load_bytes(data + offset, size - offset < 8 ? size - offset : 8)
+      : 0;
+  }
+
+  static constexpr std::uint64_t load_bytes(
+    char const *data,
+    std::size_t size
+  ) {
+    return size
+      ? static_cast<unsigned char>(*data)
+        | (load_bytes(data + 1, size - 1) << 8)
+      : 0;
+  }
+
+  static constexpr std::uint64_t hash_blocks(
+    char const *data,
+    std::size_t size,
+    std::uint64_t total,
+    std::uint64_t lane0,
+    std::uint64_t lane1
+  ) {
+    return size >= block::value
+      ? hash_blocks(
+        data + block::value,
+        size - block::value,
+        total,
+        multiply_fold(
+          load_constant(data, size, 0) ^ secret2::value,
+          load_constant(data, size, 8) ^ lane0
+        ),
+        multiply_fold(
+          load_constant(data, size, 16) ^ secret3::value,
+          load_constant(data, size, 24) ^ lane1
+        )
+      )
+      : hash_tail(
+        data, size, total,
+        multiply_fold(
+          load_constant(data, size, 0) ^ secret0::value,
+          load_constant(data, size, 8) ^ fold_lanes(total, lane0, lane1)
+        )
+      );
+  }
+
+  static constexpr std::uint64_t hash_tail(
+    char const *data,
+    std::size_t size,
+    std::uint64_t total,
+    std::uint64_t result
+  ) {
+    return finish(
+      total,
+      size > block::value / 2
+        ? multiply_fold(
+          load_constant(data, size, 16) ^ secret1::value,
+          load_constant(data, size, 24) ^ result
+        )
+        : result
+    );
+  }
+
+  // little endian load of the bytes in the range [offset, offset + 8), of
+  // `data`, ignoring the ones past `size`. When at least 8 bytes were hashed
+  // in total, a partial word is loaded as the last 8 bytes of the input with
+  // the extra ones shifted out, avoiding branches on the size of the tail
+  static std::uint64_t load_tail(
+    char const *data,
+    std::size_t size,
+    std::size_t offset,
+    std::size_t total
+  ) {
+    return offset + sizeof(std::uint64_t) <= size
+      ? load_word(data + offset)
+      : offset < size
+        ? total >= sizeof(std::uint64_t)
+          ? load_word(data + size - sizeof(std::uint64_t))
+            >> ((sizeof(std::uint64_t) - (size - offset)) * 8)
+          : load_partial_word(data + offset, size - offset)
+        : 0;
+  }
+
+  static void mix(std::uint64_t *lanes, char const *data) {
+    lanes[0] = multiply_fold(
+      load_word(data) ^ secret2::value,
+      load_word(data + 8) ^ lanes[0]
+    );
+    lanes[1] = multiply_fold(
+      load_word(data + 16) ^ secret3::value,
+      load_word(data + 24) ^ lanes[1]
+    );
+  }
+
+  std::uint64_t lanes_[2];
+  std::uint64_t size_;
+  char buffer_[block::value];
 };
 
-/* TODO
+// result types of sizes other than 32 and 64 bits use the original algorithm
+template <typename T, std::size_t = sizeof(T)>
+struct bytes_hasher_impl:
+  public legacy_bytes_hasher_impl<T>
+{
+  using legacy_bytes_hasher_impl<T>::legacy_bytes_hasher_impl;
+};
+
+// signed result types are hashed as their unsigned counterparts
 template <typename T>
-struct bytes_hasher_impl<T, 4> {
-  static T hash(T state, char const *data, std::size_t size) {
-    // TODO: IMPLEMENT USING fnv32
+struct bytes_hasher_impl<T, 4>:
+  public word_hasher_impl
+{
+  using result_type = T;
+
+private:
+  using unsigned_type = typename std::make_unsigned<result_type>::type;
+
+public:
+  explicit bytes_hasher_impl(result_type seed):
+    word_hasher_impl(static_cast<unsigned_type>(seed))
+  {}
+
+  result_type digest() const { return fold(word_hasher_impl::digest()); }
+
+  static constexpr result_type hash(
+    result_type seed,
+    char const *data,
+    std::size_t size
+  ) {
+    return fold(
+      word_hasher_impl::hash(static_cast<unsigned_type>(seed), data, size)
+    );
+  }
+
+private:
+  static constexpr result_type fold(std::uint64_t result) {
+    return static_cast<result_type>(
+      static_cast<unsigned_type>(result ^ (result >> 32))
+    );
   }
 };
 
 template <typename T>
-struct bytes_hasher_impl<T, 8> {
-  static T hash(T state, char const *data, std::size_t size) {
-    // TODO: IMPLEMENT USING fnv64
+struct bytes_hasher_impl<T, 8>:
+  public word_hasher_impl
+{
+  using result_type = T;
+
+private:
+  using unsigned_type = typename std::make_unsigned<result_type>::type;
+
+public:
+  explicit bytes_hasher_impl(result_type seed):
+    word_hasher_impl(static_cast<unsigned_type>(seed))
+  {}
+
+  result_type digest() const {
+    return static_cast<result_type>(word_hasher_impl::digest());
+  }
+
+  static constexpr result_type hash(
+    result_type seed,
+    char const *data,
+    std::size_t size
+  ) {
+    return static_cast<result_type>(
+      word_hasher_impl::hash(static_cast<unsigned_type>(seed), data, size)
+    );
   }
 };
-*/
 
 // TODO: SPECIALIZE FOR POWERS OF TWO ABOVE 64bits: USE HASH COMBIME
 
+template <typename T>
+using bytes_hasher_seed = largest_mersenne_prime_under<
+  data_bits<T>::value / 2 + 1
+>;
+
 } // namespace detail {
 
-template <typename T = std::size_t>
+/**
+ * Hashes a sequence of bytes, which can be fed in any number of pieces: the
+ * result only depends on the bytes themselves, not on how they're split
+ * across calls.
+ *
+ * For 32 and 64 bits result types, 8 bytes are mixed at a time using a
+ * 64 x 64 -> 128 bits multiplication. Other result types use the original
+ * byte-at-a-time algorithm, which remains available for every result type
+ * as `legacy_bytes_hasher`, for when hashes must be stable across versions.
+ *
+ * Words are read in little endian order, so results are the same across
+ * platforms regardless of their byte order.
+ *
+ * Example:
+ *
+ *  bytes_hasher<> hasher;
+ *  hasher("hello, ", 7)("world", 5)('!');
+ *
+ *  // yields the same as `*bytes_hasher<>()("hello, world!", 13)`
+ *  auto const result = *hasher;
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+template <
+  typename T = std::size_t,
+  typename Impl = detail::bytes_hasher_impl<T>
+>
 class bytes_hasher {
-  using impl = detail::bytes_hasher_impl<T>;
-
 public:
-  using result_type = typename impl::result_type;
+  using result_type = typename Impl::result_type;
 
 private:
-  using default_seed = largest_mersenne_prime_under<
-    data_bits<result_type>::value / 2 + 1
-  >;
+  using default_seed = detail::bytes_hasher_seed<result_type>;
 
 public:
-  explicit bytes_hasher(result_type seed = default_seed::value): hash_(seed) {}
+  explicit bytes_hasher(result_type seed = default_seed::value): impl_(seed) {}
 
   bytes_hasher &operator ()(char const *const begin, char const *end) {
     assert(begin <= end);
-    hash_ = impl::hash(hash_, begin, end);
+    impl_.update(begin, end);
     return *this;
   }
 
   bytes_hasher &operator ()(char const *const data, std::size_t const size) {
-    hash_ = impl::hash(hash_, data, std::next(data, size));
+    impl_.update(data, std::next(data, size));
     return *this;
   }
 
   bytes_hasher &operator ()(char const data) {
-    hash_ = impl::hash(hash_, data);
+    impl_.update(data);
     return *this;
   }
 
-  result_type operator *() const { return hash_; }
-  explicit operator result_type() const { return hash_; }
+  result_type operator *() const { return impl_.digest(); }
+  explicit operator result_type() const { return impl_.digest(); }
 
 private:
-  result_type hash_;
+  Impl impl_;
 };
 
-} // namespace fatail {
+/**
+ * A `bytes_hasher` which always uses the original byte-at-a-time algorithm,
+ * regardless of the result type, for when hashes must not change.
+ *
+ * Example:
+ *
+ *  auto const result = *legacy_bytes_hasher<>()("hello", 5);
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+template <typename T = std::size_t>
+using legacy_bytes_hasher = bytes_hasher<
+  T,
+  detail::legacy_bytes_hasher_impl<T>
+>;
+
+/**
+ * Computes, at compile time, the same hash that `bytes_hasher` computes at
+ * runtime for the `size` bytes starting at `data`.
+ *
+ * The recursion depth grows linearly with `size`, so this is meant for short
+ * strings like identifiers and keywords.
+ *
+ * Example:
+ *
+ *  constexpr char const hello[] = "hello";
+ *  constexpr auto hash = bytes_hash(hello, 5);
+ *
+ *  // yields `true`
+ *  hash == *bytes_hasher<>()("hello", 5);
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+template <typename T = std::size_t>
+constexpr T bytes_hash(
+  char const *data,
+  std::size_t size,
+  T seed = detail::bytes_hasher_seed<T>::value
+) {
+  return detail::bytes_hasher_impl<T>::hash(seed, data, size);
+}
+
+} // namespace fatal {
 
 #endif // FATAL_INCLUDE_fatal_math_hash_h
@@ -0,0 +1,640 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef FATAL_INCLUDE_fatal_math_hyperloglog_h
+#define FATAL_INCLUDE_fatal_math_hyperloglog_h
+
+#include <fatal/math/hash.h>
+#include <fatal/math/numerics.h>
+#include <fatal/portability.h>
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if FATAL_HAS_SIMD_AVX2
+# include <immintrin.h>
+#elif FATAL_HAS_SIMD_SSE2
+# include <emmintrin.h>
+#endif // FATAL_HAS_SIMD_AVX2
+
+namespace fatal {
+
+/**
+ * Estimates the number of distinct elements (the cardinality) of a stream,
+ * using a fixed amount of memory regardless of how many there are.
+ *
+ * This is a HyperLogLog++ sketch: elements are hashed with the 64 bits
+ * `bytes_hasher`, and the first `precision` bits of the hash pick one of
+ * `2^precision` registers, which keeps the longest run of leading zeros seen
+ * in the remaining bits. The standard error of the estimate is about
+ * `1.04 / sqrt(2^precision)` - 0.8% for the default precision of 14, using
+ * 16KB of registers.
+ *
+ * Small cardinalities use a sparse representation instead: a sorted list of
+ * the hashes seen, truncated to 25 bits, which is nearly exact and much
+ * smaller. The sketch switches to the registers once the list would take as
+ * much memory as they do.
+ *
+ * Rather than relying on empirically measured bias corrections, estimates
+ * are computed with the improved estimator by Otmar Ertl, which is unbiased
+ * across the whole range of cardinalities.
+ *
+ * Sketches of the same precision can be merged, yielding the estimate for the
+ * union of their elements, and serialized through `state()`.
+ *
+ * See: S. Heule, M. Nunkesser, A. Hall - "HyperLogLog in Practice"
+ * See: O. Ertl - "New cardinality estimation algorithms for HyperLogLog
+ * sketches"
+ *
+ * Example:
+ *
+ *  hyperloglog unique_users;
+ *
+ *  for (std::string user; std::cin >> user; ) {
+ *    unique_users.add(user.data(), user.size());
+ *  }
+ *
+ *  std::cout << "about " << unique_users.estimate() << " unique users"
+ *    << std::endl;
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+class hyperloglog {
+  using hash_bits = std::integral_constant<std::size_t, 64>;
+
+  // the precision of the hashes kept by the sparse representation
+  using sparse_precision = std::integral_constant<std::size_t, 25>;
+
+  // how many bits of an entry of the sparse representation hold the length
+  // of the run of leading zeros
+  using rank_bits = std::integral_constant<std::size_t, 6>;
+
+public:
+  /**
+   * The type representing the number of elements.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  using size_type = std::size_t;
+
+  /**
+   * The type of the hashes of the elements.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  using hash_type = std::uint64_t;
+
+  /**
+   * The type of the registers of the dense representation.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  using register_type = std::uint8_t;
+
+  /**
+   * The type of the entries of the sparse representation.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  using entry_type = std::uint32_t;
+
+  /**
+   * The range of supported precisions.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  using min_precision = std::integral_constant<size_type, 4>;
+  using max_precision = std::integral_constant<size_type, 18>;
+
+  /**
+   * Constructors.
+   *
+   * Throws `std::invalid_argument` if the precision is not supported.
+   */
+  explicit hyperloglog(size_type precision = 14): precision_(precision) {
+    validate_precision(precision_);
+  }
+
+  hyperloglog(hyperloglog const &rhs) = default;
+  hyperloglog(hyperloglog &&rhs) = default;
+
+  hyperloglog &operator =(hyperloglog const &rhs) = default;
+  hyperloglog &operator =(hyperloglog &&rhs) = default;
+
+  /**
+   * Adds the element represented by the `size` bytes starting at `data`.
+   *
+   * The element is hashed the same way as by `bytes_hasher<std::uint64_t>`.
+   *
+   * Example:
+   *
+   *  hyperloglog sketch;
+   *
+   *  std::string const key("hello");
+   *  sketch.add(key.data(), key.size());
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  void add(char const *data, size_type size) {
+    add_hash(detail::word_hasher_impl::hash_range(
+      detail::bytes_hasher_seed<hash_type>::value,
+      data,
+      size
+    ));
+  }
+
+  /**
+   * Adds an element given its 64 bits hash, for elements that are already
+   * hashed or that are better hashed some other way.
+   *
+   * The hash is expected to be uniformly distributed across all 64 bits.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  void add_hash(hash_type hash) {
+    if (!registers_.empty()) {
+      update(index_of(hash), rank_of(hash));
+      return;
+    }
+
+    buffer_.push_back(encode(hash));
+
+    if (buffer_.size() >= buffer_capacity()) {
+      flush();
+    }
+  }
+
+  /**
+   * Merges the elements from the given sketch `rhs` into this one.
+   *
+   * Throws `std::invalid_argument` if the precisions are different.
+   *
+   * Example:
+   *
+   *  // each thread accumulates into its own sketch, without locking
+   *  std::vector<hyperloglog> partial(threads);
+   *
+   *  // ...
+   *
+   *  hyperloglog all;
+   *
+   *  for (auto const &i: partial) {
+   *    all.merge(i);
+   *  }
+   *
+   *  std::cout << "about " << all.estimate() << " unique elements"
+   *    << std::endl;
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  hyperloglog &merge(hyperloglog const &rhs) {
+    if (rhs.precision_ != precision_) {
+      throw std::invalid_argument("merge(): sketches have different precision");
+    }
+
+    // merging is idempotent
+    if (&rhs == this) {
+      return *this;
+    }
+
+    if (!rhs.registers_.empty()) {
+      to_dense();
+
+      merge_registers(
+        registers_.data(), rhs.registers_.data(), registers_.size()
+      );
+      return *this;
+    }
+
+    if (!registers_.empty()) {
+      for (auto i: rhs.sparse_) {
+        update_from(i);
+      }
+
+      for (auto i: rhs.buffer_) {
+        update_from(i);
+      }
+
+      return *this;
+    }
+
+    buffer_.insert(buffer_.end(), rhs.sparse_.begin(), rhs.sparse_.end());
+    buffer_.insert(buffer_.end(), rhs.buffer_.begin(), rhs.buffer_.end());
+    flush();
+
+    return *this;
+  }
+
+  /**
+   * Estimates how many distinct elements have been added so far.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  size_type estimate() const {
+    if (!buffer_.empty()) {
+      auto copy(*this);
+      copy.flush();
+      return copy.estimate();
+    }
+
+    return static_cast<size_type>(std::llround(
+      registers_.empty() ? sparse_estimate() : dense_estimate()
+    ));
+  }
+
+  /**
+   * True if no element has been added so far, false otherwise.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  bool empty() const {
+    return registers_.empty() && sparse_.empty() && buffer_.empty();
+  }
+
+  /**
+   * True while the sketch uses the sparse representation.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  bool sparse() const { return registers_.empty(); }
+
+  /**
+   * The precision given at construction.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  size_type precision() const { return precision_; }
+
+  /**
+   * Clears the internal state as if no element had been added so far,
+   * returning to the sparse representation.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  void clear() {
+    sparse_.clear();
+    buffer_.clear();
+    registers_.clear();
+    registers_.shrink_to_fit();
+  }
+
+  bool operator != (hyperloglog const &rhs) const {
+    return !(*this == rhs);
+  }
+
+  /**
+   * Two sketches are equal when they have the same `state()`, regardless of
+   * which hashes are still buffered.
+   *
+   * Note that a sparse sketch never equals a dense one, even if converting
+   * it would yield the same registers.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  bool operator == (hyperloglog const &rhs) const {
+    return rhs.precision_ == precision_ && rhs.state() == state();
+  }
+
+  /**
+   * A representation of the internal state: the precision, the entries of
+   * the sparse representation and the registers of the dense one - only one
+   * of which is ever non-empty.
+   *
+   * Each entry of the sparse representation holds the first 25 bits of a
+   * hash followed by 6 bits with the length, plus one, of the run of leading
+   * zeros in the remaining bits. Entries are sorted, and there's only one per
+   * distinct 25 bits prefix.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  using internal_state = std::tuple<
+    size_type,
+    std::vector<entry_type>,
+    std::vector<register_type>
+  >;
+
+  /**
+   * Gets the representation of the internal state.
+   *
+   * Useful for serialization.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  internal_state state() const {
+    if (!buffer_.empty()) {
+      auto copy(*this);
+      copy.flush();
+      return copy.state();
+    }
+
+    return internal_state(precision_, sparse_, registers_);
+  }
+
+FATAL_DIAGNOSTIC_PUSH
+FATAL_GCC_DIAGNOSTIC_IGNORED_SHADOW_IF_BROKEN
+
+  /**
+   * Constructs an instance by restoring the given internal state.
+   *
+   * Useful for deserialization. Throws `std::invalid_argument` if the state
+   * is not valid.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  explicit hyperloglog(internal_state const &state):
+    precision_(std::get<0>(state)),
+    sparse_(std::get<1>(state)),
+    registers_(std::get<2>(state))
+  {
+    validate_precision(precision_);
+
+    if (!registers_.empty()) {
+      if (registers_.size() != register_count() || !sparse_.empty()) {
+        throw std::invalid_argument("hyperloglog: invalid registers");
+      }
+
+      for (auto i: registers_) {
+        if (i > max_rank(precision_)) {
+          throw std::invalid_argument("hyperloglog: invalid register");
+        }
+      }
+    }
+
+    for (auto i = sparse_.begin(); i != sparse_.end(); ++i) {
+      auto const rank = *i & rank_mask();
+
+      if (
+        !rank
+          || rank > max_rank(sparse_precision::value)
+          || *i >> (sparse_precision::value + rank_bits::value)
+          || (i != sparse_.begin() && entry_index(*i) <= entry_index(*(i - 1)))
+      ) {
+        throw std::invalid_argument("hyperloglog: invalid sparse entry");
+      }
+    }
+  }
+
+FATAL_DIAGNOSTIC_POP
+
+private:
+  static void validate_precision(size_type precision) {
+    if (precision < min_precision::value || precision > max_precision::value) {
+      throw std::invalid_argument("hyperloglog: unsupported precision");
+    }
+  }
+
+  size_type register_count() const { return size_type(1) << precision_; }
+
+  // the sparse representation is abandoned once it'd take as much memory as
+  // the registers
+  size_type sparse_capacity() const {
+    return register_count() * sizeof(register_type) / sizeof(entry_type);
+  }
+
+  // entries are buffered and sorted into the sparse representation in batches
+  size_type buffer_capacity() const { return sparse_capacity() / 4; }
+
+  static constexpr entry_type rank_mask() {
+    return (entry_type(1) << rank_bits::value) - 1;
+  }
+
+  // the largest rank that fits the bits after the first `precision` ones
+  static constexpr size_type max_rank(size_type precision) {
+    return hash_bits::value - precision + 1;
+  }
+
+  size_type index_of(hash_type hash) const {
+    return static_cast<size_type>(hash >> (hash_bits::value - precision_));
+  }
+
+  // the length, plus one, of the run of leading zeros after the first
+  // `precision` bits
+  register_type rank_of(hash_type hash) const {
+    auto const rest = hash << precision_;
+
+    return static_cast<register_type>(
+      rest ? count_leading_zeros(rest) + 1 : max_rank(precision_)
+    );
+  }
+
+  static size_type entry_index(entry_type entry) {
+    return entry >> rank_bits::value;
+  }
+
+  static entry_type encode(hash_type hash) {
+    auto const index = hash >> (hash_bits::value - sparse_precision::value);
+    auto const rest = hash << sparse_precision::value;
+    auto const rank = rest
+      ? count_leading_zeros(rest) + 1
+      : max_rank(sparse_precision::value);
+
+    return static_cast<entry_type>((index << rank_bits::value) | rank);
+  }
+
+  void update(size_type index, register_type rank) {
+    auto &r = registers_[index];
+
+    if (r < rank) {
+      r = rank;
+    }
+  }
+
+  // updates the registers from an entry of the sparse representation, the
+  // same way as if its whole hash had been added
+  void update_from(entry_type entry) {
+    auto const width = sparse_precision::value - precision_;
+    auto const index = entry_index(entry);
+    auto const bits = index & ((size_type(1) << width) - 1);
+
+    update(
+      index >> width,
+      static_cast<register_type>(
+        bits
+          ? count_leading_zeros(static_cast<hash_type>(bits))
+            - (hash_bits::value - width) + 1
+          : width + (entry & rank_mask())
+      )
+    );
+  }
+
+  // sorts the buffer into the sparse representation, keeping only the
+  // largest rank for each index
+  void flush() {
+    std::sort(buffer_.begin(), buffer_.end());
+
+    std::vector<entry_type> merged;
+    merged.reserve(sparse_.size() + buffer_.size());
+    std::merge(
+      sparse_.begin(),
+      sparse_.end(),
+      buffer_.begin(),
+      buffer_.end(),
+      std::back_inserter(merged)
+    );
+    buffer_.clear();
+
+    // entries of the same index are sorted by rank, so the last one is kept
+    auto out = merged.begin();
+
+    for (auto i = merged.begin(); i != merged.end(); ++i) {
+      auto const next = std::next(i);
+
+      if (next == merged.end() || entry_index(*next) != entry_index(*i)) {
+        *out++ = *i;
+      }
+    }
+
+    merged.erase(out, merged.end());
+    sparse_.swap(merged);
+
+    if (sparse_.size() > sparse_capacity()) {
+      to_dense();
+    }
+  }
+
+  void to_dense() {
+    if (!registers_.empty()) {
+      return;
+    }
+
+    registers_.assign(register_count(), 0);
+
+    for (auto i: sparse_) {
+      update_from(i);
+    }
+
+    for (auto i: buffer_) {
+      update_from(i);
+    }
+
+    sparse_.clear();
+    sparse_.shrink_to_fit();
+    buffer_.clear();
+    buffer_.shrink_to_fit();
+  }
+
+  // sets each register of `lhs` to the largest between it and its
+  // counterpart in `rhs`
+  static void merge_registers(
+    register_type *lhs,
+    register_type const *rhs,
+    size_type size
+  ) {
+    size_type i = 0;
+
+#if FATAL_HAS_SIMD_AVX2
+    for (; size - i >= 32; i += 32) {
+      auto const to = reinterpret_cast<__m256i *>(lhs + i);
+      auto const from = reinterpret_cast<__m256i const *>(rhs + i);
+      _mm256_storeu_si256(
+        to, _mm256_max_epu8(_mm256_loadu_si256(to), _mm256_loadu_si256(from))
+      );
+    }
+#endif // FATAL_HAS_SIMD_AVX2
+
+#if FATAL_HAS_SIMD_SSE2
+    for (; size - i >= 16; i += 16) {
+      auto const to = reinterpret_cast<__m128i *>(lhs + i);
+      auto const from = reinterpret_cast<__m128i const *>(rhs + i);
+      _mm_storeu_si128(
+        to, _mm_max_epu8(_mm_loadu_si128(to), _mm_loadu_si128(from))
+      );
+    }
+#endif // FATAL_HAS_SIMD_SSE2
+
+    for (; i < size; ++i) {
+      lhs[i] = std::max(lhs[i], rhs[i]);
+    }
+  }
+
+  // linear counting over the `2^25` buckets of the sparse representation
+  double sparse_estimate() const {
+    auto const buckets = static_cast<double>(
+      size_type(1) << sparse_precision::value
+    );
+
+    return buckets * std::log(
+      buckets / (buckets - static_cast<double>(sparse_.size()))
+    );
+  }
+
+  double dense_estimate() const {
+    auto const ranks = max_rank(precision_);
+    std::vector<size_type> histogram(ranks + 1);
+
+    for (auto i: registers_) {
+      ++histogram[i];
+    }
+
+    auto const m = static_cast<double>(register_count());
+    auto z = m * tau(1 - static_cast<double>(histogram[ranks]) / m);
+
+    for (auto k = ranks - 1; k; --k) {
+      z = (z + static_cast<double>(histogram[k])) / 2;
+    }
+
+    z += m * sigma(static_cast<double>(histogram[0]) / m);
+
+    return m * m / (2 * std::log(2.) * z);
+  }
+
+  static double sigma(double x) {
+    if (x == 1) {
+      return std::numeric_limits<double>::infinity();
+    }
+
+    double y = 1;
+    double z = x;
+
+    for (double previous = -1; z != previous; y += y) {
+      previous = z;
+      x *= x;
+      z += x * y;
+    }
+
+    return z;
+  }
+
+  static double tau(double x) {
+    if (x == 0 || x == 1) {
+      return 0;
+    }
+
+    double y = 1;
+    double z = 1 - x;
+
+    for (double previous = -1; z != previous; ) {
+      previous = z;
+      x = std::sqrt(x);
+      y /= 2;
+      z -= (1 - x) * (1 - x) * y;
+    }
+
+    return z / 3;
+  }
+
+  size_type precision_;
+  std::vector<entry_type> sparse_;
+  std::vector<entry_type> buffer_;
+  std::vector<register_type> registers_;
+};
+
+} // namespace fatal {
+
+#endif // FATAL_INCLUDE_fatal_math_hyperloglog_h
@@ -98,6 +98,87 @@ struct data_bits_filter {
   >;
 };
 
+template <typename T>
+struct bit_ops {
+  static_assert(std::is_unsigned<T>::value, "only unsigned integrals allowed");
+
+  static unsigned ctz(T value) noexcept {
+    assert(value);
+    unsigned result = 0;
+    for (; !(value & 1); value >>= 1) { ++result; }
+    return result;
+  }
+
+  static unsigned clz(T value) noexcept {
+    assert(value);
+    unsigned result = 0;
+    for (T mask = T(T(1) << (data_bits<T>::value - 1)); !(value & mask); ) {
+      value = T(value << 1);
+      ++result;
+    }
+    return result;
+  }
+
+  static unsigned popcount(T value) noexcept {
+    unsigned result = 0;
+    for (; value; value &= T(value - 1)) { ++result; }
+    return result;
+  }
+};
+
+#if __clang__ || __GNUC__
+template <>
+struct bit_ops<unsigned> {
+  static unsigned ctz(unsigned value) noexcept {
+    assert(value);
+    return static_cast<unsigned>(__builtin_ctz(value));
+  }
+
+  static unsigned clz(unsigned value) noexcept {
+    assert(value);
+    return static_cast<unsigned>(__builtin_clz(value));
+  }
+
+  static unsigned popcount(unsigned value) noexcept {
+    return static_cast<unsigned>(__builtin_popcount(value));
+  }
+};
+
+template <>
+struct bit_ops<unsigned long> {
+  static unsigned ctz(unsigned long value) noexcept {
+    assert(value);
+    return static_cast<unsigned>(__builtin_ctzl(value));
+  }
+
+  static unsigned clz(unsigned long value) noexcept {
+    assert(value);
+    return static_cast<unsigned>(__builtin_clzl(value));
+  }
+
+  static unsigned popcount(unsigned long value) noexcept {
+    return static_cast<unsigned>(__builtin_popcountl(value));
+  }
+};
+
+template <>
+struct bit_ops<unsigned long long> {
+  static unsigned ctz(unsigned long long value) noexcept {
+    assert(value);
+    return static_cast<unsigned>(__builtin_ctzll(value));
+  }
+
+  static unsigned clz(unsigned long long value) noexcept {
+    assert(value);
+    return static_cast<unsigned>(__builtin_clzll(value));
+  }
+
+  static unsigned popcount(unsigned long long value) noexcept {
+    return static_cast<unsigned>(__builtin_popcountll(value));
+  }
+};
+#endif // __clang__ || __GNUC__
+
 template <std::size_t BitCount>
 struct sff {
   template <typename T>
@@ -23,6 +23,7 @@
 #include <limits>
 #include <stdexcept>
 
+#include <cassert>
 #include <cstdint>
 #include <climits>
 
@@ -223,6 +224,64 @@ using pop_count = std::integral_constant<
   i_num::pop_count_impl(Value)
 >;
 
+//////////////////////////
+// runtime bit counting //
+//////////////////////////
+
+/**
+ * Returns the number of trailing zero bits of the given unsigned integral.
+ *
+ * Uses the compiler's intrinsic, when available, so that it compiles down to
+ * a single instruction on platforms that support it.
+ *
+ * The behavior is undefined when `value` is `0`.
+ *
+ * Example:
+ *
+ *  // yields `3`
+ *  auto result = count_trailing_zeros(0x28u);
+ *
+ * @author: Marcelo Juchem <marcelo@fb.com>
+ */
+template <typename T>
+inline unsigned count_trailing_zeros(T value) noexcept {
+  return i_num::bit_ops<T>::ctz(value);
+}
+
+/**
+ * Returns the number of leading zero bits of the given unsigned integral.
+ *
+ * The behavior is undefined when `value` is `0`.
+ *
+ * Example:
+ *
+ *  // yields `26`
+ *  auto result = count_leading_zeros(std::uint32_t(0x28));
+ *
+ * @author: Marcelo Juchem <marcelo@fb.com>
+ */
+template <typename T>
+inline unsigned count_leading_zeros(T value) noexcept {
+  return i_num::bit_ops<T>::clz(value);
+}
+
+/**
+ * Returns the number of bits set in the given unsigned integral.
+ *
+ * This is the runtime counterpart of `pop_count`.
+ *
+ * Example:
+ *
+ *  // yields `2`
+ *  auto result = population_count(0x28u);
+ *
+ * @author: Marcelo Juchem <marcelo@fb.com>
+ */
+template <typename T>
+inline unsigned population_count(T value) noexcept {
+  return i_num::bit_ops<T>::popcount(value);
+}
+
 ////////////////////
 // known integers //
 ////////////////////
@@ -0,0 +1,514 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef FATAL_INCLUDE_fatal_math_quantile_sketch_h
+#define FATAL_INCLUDE_fatal_math_quantile_sketch_h
+
+#include <algorithm>
+#include <iterator>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+
+#include <fatal/portability.h>
+
+namespace fatal {
+
+/**
+ * Online estimation of quantiles (percentiles, median, ...) from a stream of
+ * samples, using bounded memory.
+ *
+ * This is a merging t-digest: samples are buffered and periodically merged
+ * into a sorted list of centroids - a mean and the number of samples it
+ * represents. Centroids near the tails represent fewer samples than the ones
+ * in the middle, so extreme quantiles like the 99.9th percentile are
+ * estimated more accurately than the median, where a small error in the rank
+ * matters less.
+ *
+ * The `compression` given at construction bounds the memory used: there are
+ * never more than `compression` centroids, nor more than `5 * compression`
+ * buffered samples. Higher values trade memory and speed for accuracy.
+ *
+ * Instances can be merged, which allows, for instance, having each thread
+ * accumulate samples into its own instance, without any synchronization, and
+ * periodically merging them into an aggregate one. The partial results can
+ * also be queried at any given time.
+ *
+ * See: T. Dunning, O. Ertl - "Computing Extremely Accurate Quantiles Using
+ * t-Digests"
+ *
+ * Example:
+ *
+ *  quantile_sketch<> latencies;
+ *
+ *  for (double sample; std::cin >> sample; ) {
+ *    latencies.add(sample);
+ *  }
+ *
+ *  std::cout << "p50: " << latencies.quantile(.5)
+ *    << " p99: " << latencies.quantile(.99)
+ *    << " p999: " << latencies.quantile(.999)
+ *    << std::endl;
+ *
+ * @author: Marcelo Juchem <marcelo@fb.com>
+ */
+template <typename T = double>
+struct quantile_sketch {
+  /**
+   * The type of the samples.
+   *
+   * @author: Marcelo Juchem <marcelo@fb.com>
+   */
+  using value_type = T;
+
+  /**
+   * The type representing the number of samples seen at any given moment.
+   *
+   * @author: Marcelo Juchem <marcelo@fb.com>
+   */
+  using size_type = std::size_t;
+
+  /**
+   * A centroid: the mean of the samples it represents, and how many of them
+   * there are.
+   *
+   * @author: Marcelo Juchem <marcelo@fb.com>
+   */
+  using centroid = std::pair<value_type, size_type>;
+
+  /**
+   * Constructors.
+   */
+  explicit quantile_sketch(size_type compression = 100):
+    compression_(compression)
+  {
+    assert(compression_ > 0);
+    buffer_.reserve(buffer_capacity());
+  }
+
+  quantile_sketch(quantile_sketch const &rhs) = default;
+  quantile_sketch(quantile_sketch &&rhs) = default;
+
+  quantile_sketch &operator =(quantile_sketch const &rhs) = default;
+  quantile_sketch &operator =(quantile_sketch &&rhs) = default;
+
+  /**
+   * Adds a new sample from the stream.
+   *
+   * Example:
+   *
+   *  quantile_sketch<> sketch;
+   *
+   *  for (decltype(sketch)::value_type sample; std::cin >> sample; ) {
+   *    sketch.add(sample);
+   *  }
+   *
+   *  std::cout << "samples observed: " << sketch.size()
+   *    << " median: " << sketch.quantile(.5)
+   *    << std::endl;
+   *
+   * @author: Marcelo Juchem <marcelo@fb.com>
+   */
+  void add(value_type const &sample) {
+    if (buffer_.size() >= buffer_capacity()) {
+      compress();
+    }
+
+    buffer_.push_back(sample);
+    observe(sample, sample, 1);
+  }
+
+  /**
+   * Adds all the samples in the range [begin, end).
+   *
+   * Example:
+   *
+   *  std::vector<double> latencies = get_latencies();
+   *
+   *  quantile_sketch<> sketch;
+   *  sketch.add_range(latencies.begin(), latencies.end());
+   *
+   * @author: Marcelo Juchem <marcelo@fb.com>
+   */
+  template <typename Iterator>
+  void add_range(Iterator begin, Iterator end) {
+    for (; begin != end; ++begin) {
+      add(*begin);
+    }
+  }
+
+  /**
+   * Merges the samples from the given instance `rhs` into this one.
+   *
+   * The compression of this instance is kept.
+   *
+   * Example:
+   *
+   *  // each thread accumulates into its own sketch, without locking
+   *  std::vector<quantile_sketch<>> partial(threads);
+   *
+   *  // ...
+   *
+   *  // then, periodically, the partial results are combined
+   *  quantile_sketch<> all;
+   *
+   *  for (auto const &i: partial) {
+   *    all.merge(i);
+   *  }
+   *
+   *  std::cout << "p99: " << all.quantile(.99) << std::endl;
+   *
+   * @author: Marcelo Juchem <marcelo@fb.com>
+   */
+  quantile_sketch &merge(quantile_sketch const &rhs) {
+    if (rhs.empty()) {
+      return *this;
+    }
+
+    if (&rhs == this) {
+      auto const copy(rhs);
+      return merge(copy);
+    }
+
+    buffer_.insert(buffer_.end(), rhs.buffer_.begin(), rhs.buffer_.end());
+    observe(rhs.min_, rhs.max_, rhs.samples_);
+
+    auto const &centroids = rhs.centroids_;
+    absorb(centroids.data(), centroids.data() + centroids.size());
+
+    return *this;
+  }
+
+  /**
+   * Estimates the value below which the given fraction `q` of the samples
+   * lies. For instance, `quantile(.99)` estimates the 99th percentile.
+   *
+   * `q` is clamped to the range [0, 1]. The extremes give the smallest and
+   * the largest samples, which are tracked exactly.
+   *
+   * There must be at least one sample.
+   *
+   * Samples added since the last time the centroids were merged are taken
+   * into account on a temporary copy, so calling `compress` beforehand makes
+   * repeated queries cheaper.
+   *
+   * @author: Marcelo Juchem <marcelo@fb.com>
+   */
+  value_type quantile(value_type q) const {
+    assert(!empty());
+
+    if (!buffer_.empty()) {
+      auto copy(*this);
+      copy.compress();
+      return copy.quantile(q);
+    }
+
+    if (!(q > 0)) {
+      return min_;
+    }
+
+    if (!(q < 1)) {
+      return max_;
+    }
+
+    // the rank being looked for, where the rank of a centroid is the middle
+    // of the samples it represents
+    auto const index = q * static_cast<value_type>(samples_);
+
+    auto const &first = centroids_.front();
+    value_type const first_half = static_cast<value_type>(first.second) / 2;
+
+    if (index < first_half) {
+      return interpolate(min_, first.first, index / first_half);
+    }
+
+    value_type rank = first_half;
+
+    for (size_type i = 1; i < centroids_.size(); ++i) {
+      auto const &left = centroids_[i - 1];
+      auto const &right = centroids_[i];
+      value_type const gap = static_cast<value_type>(
+        left.second + right.second
+      ) / 2;
+
+      if (index < rank + gap) {
+        return interpolate(left.first, right.first, (index - rank) / gap);
+      }
+
+      rank += gap;
+    }
+
+    auto const &last = centroids_.back();
+    value_type const last_half = static_cast<value_type>(last.second) / 2;
+
+    return interpolate(
+      last.first,
+      max_,
+      std::min<value_type>((index - rank) / last_half, 1)
+    );
+  }
+
+  /**
+   * The smallest sample added so far.
+   *
+   * @author: Marcelo Juchem <marcelo@fb.com>
+   */
+  value_type const &min() const { return min_; }
+
+  /**
+   * The largest sample added so far.
+   *
+   * @author: Marcelo Juchem <marcelo@fb.com>
+   */
+  value_type const &max() const { return max_; }
+
+  /**
+   * Tells how many samples have been added so far.
+   *
+   * @author: Marcelo Juchem <marcelo@fb.com>
+   */
+  size_type size() const { return samples_; }
+
+  /**
+   * True if no sample has been added so far, false otherwise.
+   *
+   * @author: Marcelo Juchem <marcelo@fb.com>
+   */
+  bool empty() const { return !samples_; }
+
+  /**
+   * The compression given at construction.
+   *
+   * @author: Marcelo Juchem <marcelo@fb.com>
+   */
+  size_type compression() const { return compression_; }
+
+  /**
+   * Clears the internal state as if no sample had been added so far.
+   *
+   * @author: Marcelo Juchem <marcelo@fb.com>
+   */
+  void clear() {
+    samples_ = 0;
+    min_ = 0;
+    max_ = 0;
+    centroids_.clear();
+    buffer_.clear();
+  }
+
+  /**
+   * Merges the buffered samples into the centroids.
+   *
+   * This happens automatically whenever the buffer is full, or when merging
+   * other instances.
+   *
+   * @author: Marcelo Juchem <marcelo@fb.com>
+   */
+  void compress() {
+    if (!buffer_.empty()) {
+      absorb(nullptr, nullptr);
+    }
+  }
+
+  bool operator != (quantile_sketch const &rhs) const {
+    return !(*this == rhs);
+  }
+
+  /**
+   * Two sketches are equal when they have the same `state()`, regardless of
+   * which samples are still buffered.
+   *
+   * Note that sketches of the same samples can still differ, since the
+   * centroids depend on the order in which samples are merged into them.
+   *
+   * @author: Marcelo Juchem <marcelo@fb.com>
+   */
+  bool operator == (quantile_sketch const &rhs) const {
+    return rhs.samples_ == samples_ && rhs.state() == state();
+  }
+
+  /**
+   * A representation of the internal state: the compression, the smallest
+   * and largest samples, and the centroids.
+   *
+   * @author: Marcelo Juchem <marcelo@fb.com>
+   */
+  using internal_state = std::tuple<
+    size_type,
+    value_type,
+    value_type,
+    std::vector<centroid>
+  >;
+
+  /**
+   * Gets the representation of the internal state, with the buffered samples
+   * merged into the centroids.
+   *
+   * Useful for serialization.
+   *
+   * @author: Marcelo Juchem <marcelo@fb.com>
+   */
+  internal_state state() const {
+    if (!buffer_.empty()) {
+      auto copy(*this);
+      copy.compress();
+      return copy.state();
+    }
+
+    return internal_state(compression_, min_, max_, centroids_);
+  }
+
+FATAL_DIAGNOSTIC_PUSH
+FATAL_GCC_DIAGNOSTIC_IGNORED_SHADOW_IF_BROKEN
+
+  /**
+   * Constructs an instance by restoring the given internal state.
+   *
+   * Useful for deserialization.
+   *
+   * @author: Marcelo Juchem <marcelo@fb.com>
+   */
+  explicit quantile_sketch(internal_state const &state):
+    compression_(std::get<0>(state)),
+    min_(std::get<1>(state)),
+    max_(std::get<2>(state)),
+    centroids_(std::get<3>(state))
+  {
+    assert(compression_ > 0);
+    buffer_.reserve(buffer_capacity());
+
+    for (auto const &i: centroids_) {
+      samples_ += i.second;
+    }
+  }
+
+FATAL_DIAGNOSTIC_POP
+
+private:
+  size_type buffer_capacity() const { return 5 * compression_; }
+
+  void observe(value_type const &min, value_type const &max, size_type count) {
+    if (empty()) {
+      min_ = min;
+      max_ = max;
+    } else {
+      if (min < min_) {
+        min_ = min;
+      }
+
+      if (max_ < max) {
+        max_ = max;
+      }
+    }
+
+    samples_ += count;
+  }
+
+  // merges the buffered samples and the centroids in the sorted range
+  // [begin, end) into this instance's centroids
+  void absorb(centroid const *begin, centroid const *end) {
+    auto const by_mean = [](centroid const &lhs, centroid const &rhs) {
+      return lhs.first < rhs.first;
+    };
+
+    if (begin != end) {
+      scratch_.clear();
+      std::merge(
+        centroids_.begin(),
+        centroids_.end(),
+        begin,
+        end,
+        std::back_inserter(scratch_),
+        by_mean
+      );
+      centroids_.swap(scratch_);
+    }
+
+    // only the samples need sorting since the centroids already are
+    std::sort(buffer_.begin(), buffer_.end());
+    scratch_.clear();
+
+    auto c = centroids_.begin();
+
+    for (auto const &sample: buffer_) {
+      for (; c != centroids_.end() && c->first < sample; ++c) {
+        scratch_.push_back(*c);
+      }
+
+      scratch_.emplace_back(sample, 1);
+    }
+
+    scratch_.insert(scratch_.end(), c, centroids_.end());
+    buffer_.clear();
+    centroids_.clear();
+
+    auto const total = static_cast<value_type>(samples_);
+
+    // the amount of samples before the current centroid
+    value_type before = 0;
+    auto limit = total * next_limit(0);
+    auto current = scratch_.front();
+
+    for (auto i = std::next(scratch_.begin()); i != scratch_.end(); ++i) {
+      auto const weight = current.second + i->second;
+
+      if (before + static_cast<value_type>(weight) <= limit) {
+        current.first += (i->first - current.first)
+          * static_cast<value_type>(i->second)
+          / static_cast<value_type>(weight);
+        current.second = weight;
+      } else {
+        before += static_cast<value_type>(current.second);
+        centroids_.push_back(current);
+        limit = total * next_limit(before / total);
+        current = *i;
+      }
+    }
+
+    centroids_.push_back(current);
+  }
+
+  // the quantile up to which a centroid starting at quantile `q` can grow:
+  // its size, measured by the scale function `k(q) = compression * asin(2q -
+  // 1) / 2pi`, can't exceed 1 - meaning centroids are smaller at the tails
+  value_type next_limit(value_type q) const {
+    value_type const pi = 3.14159265358979323846;
+    auto const scale = static_cast<value_type>(compression_) / (2 * pi);
+    auto const k = scale * std::asin(2 * q - 1) + 1;
+
+    // `k(1)` is `compression / 4`
+    return k * 4 < static_cast<value_type>(compression_)
+      ? (std::sin(k / scale) + 1) / 2
+      : 1;
+  }
+
+  static value_type interpolate(
+    value_type const &from,
+    value_type const &to,
+    value_type const &fraction
+  ) {
+    return from + (to - from) * fraction;
+  }
+
+  size_type compression_;
+  size_type samples_ = 0;
+  value_type min_ = 0;
+  value_type max_ = 0;
+  std::vector<centroid> centroids_;
+  std::vector<value_type> buffer_;
+  std::vector<centroid> scratch_;
+};
+
+} // namespace fatal {
+
+#endif // FATAL_INCLUDE_fatal_math_quantile_sketch_h
@@ -11,8 +11,13 @@
 
 #include <fatal/test/driver.h>
 
+#include <algorithm>
 #include <iterator>
+#include <random>
+#include <string>
+#include <unordered_set>
 
+#include <cstdint>
 #include <cstring>
 
 namespace fatal {
@@ -38,4 +43,151 @@ FATAL_TEST(bytes_hasher, sanity_check_2) {
   FATAL_EXPECT_EQ(r, u);
 }
 
+// feeds `data` to `Hasher` in random pieces, some of them one char at a time
+template <typename Hasher>
+typename Hasher::result_type hash_pieces(
+  std::string const &data,
+  std::mt19937 &rng
+) {
+  Hasher hasher;
+
+  for (std::size_t i = 0; i < data.size(); ) {
+    auto const size = std::min<std::size_t>(rng() % 40, data.size() - i);
+
+    if (size == 1) {
+      hasher(data[i]);
+    } else {
+      hasher(data.data() + i, size);
+    }
+
+    i += size;
+  }
+
+  return *hasher;
+}
+
+template <typename Hasher>
+void check_pieces() {
+  std::mt19937 rng(7);
+  std::string data;
+
+  for (std::size_t size = 0; size < 300; ++size) {
+    auto const expected = *Hasher()(data.data(), data.size());
+
+    for (auto i = 0; i < 5; ++i) {
+      FATAL_ASSERT_EQ(expected, hash_pieces<Hasher>(data, rng));
+    }
+
+    data.push_back(static_cast<char>(rng()));
+  }
+}
+
+FATAL_TEST(bytes_hasher, pieces) {
+  check_pieces<bytes_hasher<std::uint64_t>>();
+  check_pieces<bytes_hasher<std::uint32_t>>();
+  check_pieces<bytes_hasher<std::uint16_t>>();
+  check_pieces<bytes_hasher<std::int64_t>>();
+  check_pieces<bytes_hasher<std::int32_t>>();
+  check_pieces<legacy_bytes_hasher<std::uint64_t>>();
+  check_pieces<legacy_bytes_hasher<std::uint32_t>>();
+}
+
+FATAL_TEST(bytes_hasher, legacy) {
+  // the hashes of the original algorithm must not change
+  FATAL_EXPECT_EQ(
+    0x49a006b4f883036fu,
+    *legacy_bytes_hasher<std::uint64_t>()("hello", 5)
+  );
+  FATAL_EXPECT_EQ(
+    0xf883036fu,
+    *legacy_bytes_hasher<std::uint32_t>()("hello", 5)
+  );
+  FATAL_EXPECT_EQ(
+    *bytes_hasher<std::uint16_t>()("hello", 5),
+    *legacy_bytes_hasher<std::uint16_t>()("hello", 5)
+  );
+}
+
+template <typename T>
+void check_collisions() {
+  std::unordered_set<T> hashes;
+  std::size_t keys = 0;
+
+  // strings of zeros of every size, which only differ by the size
+  for (std::size_t size = 0; size <= 100; ++size, ++keys) {
+    std::string const data(size, '\0');
+    hashes.insert(*bytes_hasher<T>()(data.data(), data.size()));
+  }
+
+  // flipping any single bit of the input yields a different hash
+  std::string data("a string which spans a couple of 32 bytes blocks");
+
+  for (std::size_t i = 0; i < data.size() * 8; ++i, ++keys) {
+    data[i / 8] ^= static_cast<char>(1 << (i % 8));
+    hashes.insert(*bytes_hasher<T>()(data.data(), data.size()));
+    data[i / 8] ^= static_cast<char>(1 << (i % 8));
+  }
+
+  FATAL_EXPECT_EQ(keys, hashes.size());
+
+  // different seeds yield different hashes, for inputs shorter than a block
+  // as well
+  FATAL_EXPECT_NE(
+    *bytes_hasher<T>(1)(data.data(), data.size()),
+    *bytes_hasher<T>(2)(data.data(), data.size())
+  );
+  FATAL_EXPECT_NE(*bytes_hasher<T>(1)('a'), *bytes_hasher<T>(2)('a'));
+  FATAL_EXPECT_NE(*bytes_hasher<T>(1), *bytes_hasher<T>(2));
+}
+
+FATAL_TEST(bytes_hasher, collisions) {
+  check_collisions<std::uint64_t>();
+  check_collisions<std::uint32_t>();
+  check_collisions<std::int64_t>();
+  check_collisions<std::int32_t>();
+}
+
+constexpr char const constant_text[] =
+  "a string spanning a few 32 bytes blocks, hashed at compile time";
+
+template <typename T>
+void check_bytes_hash() {
+  for (std::size_t size = 0; size < sizeof(constant_text); ++size) {
+    FATAL_ASSERT_EQ(
+      *bytes_hasher<T>()(constant_text, size),
+      bytes_hash<T>(constant_text, size)
+    );
+    FATAL_ASSERT_EQ(
+      *bytes_hasher<T>(7)(constant_text, size),
+      bytes_hash<T>(constant_text, size, 7)
+    );
+  }
+}
+
+FATAL_TEST(bytes_hash, hash_range) {
+  for (std::size_t size = 0; size < sizeof(constant_text); ++size) {
+    FATAL_ASSERT_EQ(
+      *bytes_hasher<std::uint64_t>(3)(constant_text, size),
+      detail::word_hasher_impl::hash_range(3, constant_text, size)
+    );
+  }
+}
+
+FATAL_TEST(bytes_hash, matches_bytes_hasher) {
+  using hash = std::integral_constant<
+    std::uint64_t,
+    bytes_hash<std::uint64_t>(constant_text, sizeof(constant_text) - 1)
+  >;
+  FATAL_EXPECT_EQ(
+    *bytes_hasher<std::uint64_t>()(constant_text, sizeof(constant_text) - 1),
+    hash::value
+  );
+
+  check_bytes_hash<std::uint64_t>();
+  check_bytes_hash<std::uint32_t>();
+  check_bytes_hash<std::uint16_t>();
+  check_bytes_hash<std::int64_t>();
+  check_bytes_hash<std::int32_t>();
+}
+
 } // namespace fatal {
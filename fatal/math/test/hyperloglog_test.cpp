@@ -0,0 +1,264 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/math/hyperloglog.h>
+
+#include <fatal/test/driver.h>
+
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace fatal {
+
+// distinct keys, as long as `index` is
+std::string key(std::size_t index) {
+  return "key_" + std::to_string(index);
+}
+
+void add_keys(hyperloglog &sketch, std::size_t begin, std::size_t end) {
+  for (; begin != end; ++begin) {
+    auto const k = key(begin);
+    sketch.add(k.data(), k.size());
+  }
+}
+
+// the estimate must be within `sigmas` standard errors of `expected`
+void check_estimate(
+  hyperloglog const &sketch,
+  std::size_t expected,
+  double sigmas = 4
+) {
+  auto const registers = static_cast<double>(
+    std::size_t(1) << sketch.precision()
+  );
+  auto const error = 1.04 / std::sqrt(registers);
+  auto const actual = static_cast<double>(sketch.estimate());
+  auto const margin = sigmas * error * static_cast<double>(expected);
+
+  FATAL_EXPECT_LE(std::abs(actual - static_cast<double>(expected)), margin);
+}
+
+FATAL_TEST(hyperloglog, empty) {
+  hyperloglog sketch;
+  FATAL_EXPECT_TRUE(sketch.empty());
+  FATAL_EXPECT_TRUE(sketch.sparse());
+  FATAL_EXPECT_EQ(14, sketch.precision());
+  FATAL_EXPECT_EQ(0, sketch.estimate());
+
+  sketch.add("", 0);
+  FATAL_EXPECT_FALSE(sketch.empty());
+  FATAL_EXPECT_EQ(1, sketch.estimate());
+
+  sketch.clear();
+  FATAL_EXPECT_TRUE(sketch.empty());
+  FATAL_EXPECT_EQ(hyperloglog(), sketch);
+
+  FATAL_EXPECT_THROW(std::invalid_argument) {
+    hyperloglog(3);
+  };
+
+  FATAL_EXPECT_THROW(std::invalid_argument) {
+    hyperloglog(19);
+  };
+}
+
+FATAL_TEST(hyperloglog, sparse) {
+  hyperloglog sketch;
+
+  // duplicates don't count
+  for (auto round = 0; round < 3; ++round) {
+    add_keys(sketch, 0, 3000);
+  }
+
+  FATAL_EXPECT_TRUE(sketch.sparse());
+  FATAL_EXPECT_EQ(3000, std::get<1>(sketch.state()).size());
+
+  // collisions of 25 bits hashes are unlikely for so few keys
+  FATAL_EXPECT_LE(std::abs(static_cast<int>(sketch.estimate()) - 3000), 3);
+
+  // the sparse representation is dropped when it'd take more memory than
+  // the registers
+  add_keys(sketch, 3000, 5000);
+  FATAL_EXPECT_FALSE(sketch.sparse());
+  FATAL_EXPECT_TRUE(std::get<1>(sketch.state()).empty());
+  FATAL_EXPECT_EQ(1 << 14, std::get<2>(sketch.state()).size());
+  check_estimate(sketch, 5000);
+}
+
+FATAL_TEST(hyperloglog, accuracy) {
+  for (auto precision: {4, 10, 14, 16}) {
+    hyperloglog sketch(precision);
+    std::size_t added = 0;
+
+    for (std::size_t size = 1; size <= 1000000; size *= 10) {
+      add_keys(sketch, added, size);
+      added = size;
+      check_estimate(sketch, size);
+    }
+  }
+}
+
+FATAL_TEST(hyperloglog, hashes) {
+  std::mt19937_64 rng(0);
+  hyperloglog sketch(12);
+  std::unordered_set<std::uint64_t> exact;
+
+  while (exact.size() < 200000) {
+    auto const hash = rng();
+    sketch.add_hash(hash);
+    exact.insert(hash);
+  }
+
+  check_estimate(sketch, exact.size());
+}
+
+// converting the sparse representation yields the same registers as adding
+// every hash straight into them
+FATAL_TEST(hyperloglog, conversion) {
+  for (auto precision: {4, 11, 18}) {
+    hyperloglog all(precision);
+    add_keys(all, 0, 300000);
+    FATAL_ASSERT_FALSE(all.sparse());
+
+    hyperloglog merged(precision);
+
+    for (std::size_t i = 0; i < 300000; i += 1000) {
+      hyperloglog part(precision);
+      add_keys(part, i, i + 1000);
+      merged.merge(part);
+    }
+
+    FATAL_EXPECT_EQ(all.state(), merged.state());
+  }
+}
+
+FATAL_TEST(hyperloglog, merge) {
+  using sizes = std::pair<std::size_t, std::size_t>;
+
+  // every combination of sparse and dense sketches
+  for (auto size: {sizes(100, 200), sizes(100, 50000), sizes(50000, 100),
+    sizes(50000, 70000)
+  }) {
+    hyperloglog lhs;
+    hyperloglog rhs;
+
+    // half of the keys of the smallest sketch overlap
+    auto const overlap = std::min(size.first, size.second) / 2;
+    add_keys(lhs, 0, size.first);
+    add_keys(rhs, size.first - overlap, size.first - overlap + size.second);
+
+    auto const expected = size.first + size.second - overlap;
+
+    auto lhs_rhs(lhs);
+    lhs_rhs.merge(rhs);
+    check_estimate(lhs_rhs, expected);
+
+    auto rhs_lhs(rhs);
+    rhs_lhs.merge(lhs);
+    FATAL_EXPECT_EQ(lhs_rhs.state(), rhs_lhs.state());
+
+    // merging is idempotent
+    lhs_rhs.merge(rhs);
+    lhs_rhs.merge(lhs_rhs);
+    FATAL_EXPECT_EQ(rhs_lhs.state(), lhs_rhs.state());
+
+    auto const before = lhs.state();
+    lhs.merge(hyperloglog());
+    FATAL_EXPECT_EQ(before, lhs.state());
+  }
+
+  hyperloglog lhs(10);
+  hyperloglog rhs(11);
+
+  FATAL_EXPECT_THROW(std::invalid_argument) {
+    lhs.merge(rhs);
+  };
+}
+
+FATAL_TEST(hyperloglog, equality) {
+  for (auto size: {10, 1000, 100000}) {
+    hyperloglog sketch(12);
+    add_keys(sketch, 0, size);
+
+    FATAL_EXPECT_EQ(sketch, hyperloglog(sketch.state()));
+
+    hyperloglog merged(12);
+    merged.merge(sketch);
+    FATAL_EXPECT_EQ(sketch, merged);
+
+    hyperloglog other(12);
+    add_keys(other, size, 2 * size);
+    FATAL_EXPECT_NE(sketch, other);
+  }
+
+  FATAL_EXPECT_NE(hyperloglog(12), hyperloglog(13));
+}
+
+FATAL_TEST(hyperloglog, state) {
+  for (auto size: {0, 10, 1000, 100000}) {
+    hyperloglog sketch(12);
+    add_keys(sketch, 0, size);
+
+    hyperloglog copy(sketch.state());
+    FATAL_EXPECT_EQ(sketch.state(), copy.state());
+    FATAL_EXPECT_EQ(sketch.estimate(), copy.estimate());
+
+    // the restored sketch keeps working
+    add_keys(sketch, size, size + 100);
+    add_keys(copy, size, size + 100);
+    FATAL_EXPECT_EQ(sketch.state(), copy.state());
+  }
+
+  using state = hyperloglog::internal_state;
+  using entries = std::vector<hyperloglog::entry_type>;
+  using registers = std::vector<hyperloglog::register_type>;
+
+  FATAL_EXPECT_THROW(std::invalid_argument) {
+    hyperloglog(state(20, entries(), registers()));
+  };
+
+  // wrong number of registers
+  FATAL_EXPECT_THROW(std::invalid_argument) {
+    hyperloglog(state(4, entries(), registers(15)));
+  };
+
+  // register out of range
+  FATAL_EXPECT_THROW(std::invalid_argument) {
+    hyperloglog(state(4, entries(), registers(16, 62)));
+  };
+
+  // both representations
+  FATAL_EXPECT_THROW(std::invalid_argument) {
+    hyperloglog(state(4, entries{1}, registers(16)));
+  };
+
+  // entries out of order
+  FATAL_EXPECT_THROW(std::invalid_argument) {
+    hyperloglog(state(4, entries{(2 << 6) | 1, (1 << 6) | 1}, registers()));
+  };
+
+  // rank out of range
+  FATAL_EXPECT_THROW(std::invalid_argument) {
+    hyperloglog(state(4, entries{(1 << 6) | 41}, registers()));
+  };
+
+  hyperloglog valid(
+    state(4, entries{(1 << 6) | 1, (2 << 6) | 40}, registers())
+  );
+  FATAL_EXPECT_EQ(2, valid.estimate());
+}
+
+} // namespace fatal {
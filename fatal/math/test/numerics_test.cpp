@@ -530,6 +530,47 @@ FATAL_TEST(numerics, most_significant_bit) {
   FATAL_EXPECT_EQ(17, most_significant_bit<65536ull>::value);
 }
 
+//////////////////////////
+// runtime bit counting //
+//////////////////////////
+
+FATAL_TEST(numerics, count_trailing_zeros) {
+  FATAL_EXPECT_EQ(0, count_trailing_zeros(std::uint8_t(1)));
+  FATAL_EXPECT_EQ(7, count_trailing_zeros(std::uint8_t(0x80)));
+  FATAL_EXPECT_EQ(3, count_trailing_zeros(std::uint16_t(0x28)));
+  FATAL_EXPECT_EQ(0, count_trailing_zeros(1u));
+  FATAL_EXPECT_EQ(3, count_trailing_zeros(0x28u));
+  FATAL_EXPECT_EQ(31, count_trailing_zeros(std::uint32_t(1) << 31));
+  FATAL_EXPECT_EQ(0, count_trailing_zeros(std::uint64_t(1)));
+  FATAL_EXPECT_EQ(40, count_trailing_zeros(std::uint64_t(1) << 40));
+  FATAL_EXPECT_EQ(63, count_trailing_zeros(std::uint64_t(1) << 63));
+}
+
+FATAL_TEST(numerics, count_leading_zeros) {
+  FATAL_EXPECT_EQ(7, count_leading_zeros(std::uint8_t(1)));
+  FATAL_EXPECT_EQ(0, count_leading_zeros(std::uint8_t(0x80)));
+  FATAL_EXPECT_EQ(10, count_leading_zeros(std::uint16_t(0x28)));
+  FATAL_EXPECT_EQ(31, count_leading_zeros(std::uint32_t(1)));
+  FATAL_EXPECT_EQ(26, count_leading_zeros(std::uint32_t(0x28)));
+  FATAL_EXPECT_EQ(63, count_leading_zeros(std::uint64_t(1)));
+  FATAL_EXPECT_EQ(23, count_leading_zeros(std::uint64_t(1) << 40));
+  FATAL_EXPECT_EQ(0, count_leading_zeros(std::uint64_t(1) << 63));
+}
+
+FATAL_TEST(numerics, population_count) {
+  FATAL_EXPECT_EQ(0, population_count(std::uint8_t(0)));
+  FATAL_EXPECT_EQ(8, population_count(std::uint8_t(0xff)));
+  FATAL_EXPECT_EQ(2, population_count(std::uint16_t(0x28)));
+  FATAL_EXPECT_EQ(0, population_count(0u));
+  FATAL_EXPECT_EQ(2, population_count(0x28u));
+  FATAL_EXPECT_EQ(32, population_count(std::uint32_t(~0u)));
+  FATAL_EXPECT_EQ(64, population_count(~std::uint64_t(0)));
+  FATAL_EXPECT_EQ(
+    pop_count<0xdeadbeefcafebabeull>::value,
+    population_count(std::uint64_t(0xdeadbeefcafebabeull))
+  );
+}
+
 /////////////////////////////////
 // smallest integral & friends //
 /////////////////////////////////
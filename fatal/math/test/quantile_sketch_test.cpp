@@ -0,0 +1,221 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/math/quantile_sketch.h>
+
+#include <fatal/test/driver.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <cmath>
+#include <cstddef>
+
+namespace fatal {
+
+// the number of samples for each randomized test
+using samples = std::integral_constant<std::size_t, 200000>;
+
+// how many sketches the samples are split across when testing merges
+using partitions = std::integral_constant<std::size_t, 4>;
+
+// the quantiles checked by the randomized tests
+double const quantiles[] = {.001, .01, .1, .25, .5, .75, .9, .99, .999};
+
+// the fraction of the samples below the given value
+double rank_of(std::vector<double> const &sorted, double value) {
+  auto const below = std::lower_bound(sorted.begin(), sorted.end(), value);
+  return static_cast<double>(below - sorted.begin())
+    / static_cast<double>(sorted.size());
+}
+
+// a centroid near the quantile `q` covers about `2pi / compression *
+// sqrt(q * (1 - q))` of the samples, so estimates shouldn't be off by more
+// than half of that
+void check_accuracy(
+  quantile_sketch<> const &sketch,
+  std::vector<double> const &sorted
+) {
+  FATAL_ASSERT_EQ(sorted.size(), sketch.size());
+  FATAL_EXPECT_EQ(sorted.front(), sketch.min());
+  FATAL_EXPECT_EQ(sorted.back(), sketch.max());
+  FATAL_EXPECT_EQ(sorted.front(), sketch.quantile(0));
+  FATAL_EXPECT_EQ(sorted.back(), sketch.quantile(1));
+
+  for (auto q: quantiles) {
+    auto const error = std::abs(rank_of(sorted, sketch.quantile(q)) - q);
+    auto const pi = std::acos(-1.);
+    auto const compression = static_cast<double>(sketch.compression());
+    FATAL_EXPECT_LE(error, pi / compression * std::sqrt(q * (1 - q)));
+  }
+
+  // memory is bounded regardless of the amount of samples
+  FATAL_EXPECT_LE(std::get<3>(sketch.state()).size(), sketch.compression());
+}
+
+template <typename Distribution>
+void test_accuracy(Distribution &&distribution) {
+  std::mt19937_64 rng(samples::value);
+  std::vector<double> data;
+  data.reserve(samples::value);
+
+  for (auto i = samples::value; i--; ) {
+    data.push_back(distribution(rng));
+  }
+
+  quantile_sketch<> sketch;
+  std::vector<quantile_sketch<>> partial(partitions::value);
+
+  for (std::size_t i = 0; i < data.size(); ++i) {
+    sketch.add(data[i]);
+    partial[i % partitions::value].add(data[i]);
+  }
+
+  quantile_sketch<> merged;
+
+  for (auto const &i: partial) {
+    merged.merge(i);
+  }
+
+  quantile_sketch<> range;
+  range.add_range(data.begin(), data.end());
+  FATAL_EXPECT_EQ(sketch, range);
+
+  std::sort(data.begin(), data.end());
+  check_accuracy(sketch, data);
+  check_accuracy(merged, data);
+}
+
+FATAL_TEST(quantile_sketch, uniform_distribution) {
+  test_accuracy(std::uniform_real_distribution<double>(-1000, 1000));
+}
+
+FATAL_TEST(quantile_sketch, normal_distribution) {
+  test_accuracy(std::normal_distribution<double>(0, 10));
+}
+
+FATAL_TEST(quantile_sketch, exponential_distribution) {
+  test_accuracy(std::exponential_distribution<double>(.01));
+}
+
+FATAL_TEST(quantile_sketch, lognormal_distribution) {
+  test_accuracy(std::lognormal_distribution<double>(0, 2));
+}
+
+FATAL_TEST(quantile_sketch, few_samples) {
+  quantile_sketch<> sketch;
+  FATAL_EXPECT_TRUE(sketch.empty());
+  FATAL_EXPECT_EQ(0, sketch.size());
+
+  sketch.add(7);
+  FATAL_EXPECT_FALSE(sketch.empty());
+  FATAL_EXPECT_EQ(1, sketch.size());
+
+  for (auto q: {0., .1, .5, .9, 1.}) {
+    FATAL_EXPECT_EQ(7, sketch.quantile(q));
+  }
+
+  // samples are kept apart while there are only a few of them
+  for (auto i = 1; i <= 9; ++i) {
+    sketch.add(i * 10);
+  }
+
+  FATAL_EXPECT_EQ(10, sketch.size());
+  FATAL_EXPECT_EQ(7, sketch.min());
+  FATAL_EXPECT_EQ(90, sketch.max());
+  FATAL_EXPECT_EQ(10, std::get<3>(sketch.state()).size());
+  FATAL_EXPECT_EQ(50, sketch.quantile(.55));
+  FATAL_EXPECT_EQ(7, quantile_sketch<>().merge(sketch).quantile(-1));
+
+  sketch.clear();
+  FATAL_EXPECT_TRUE(sketch.empty());
+  FATAL_EXPECT_EQ(quantile_sketch<>(), sketch);
+}
+
+FATAL_TEST(quantile_sketch, merge) {
+  quantile_sketch<> lhs;
+  quantile_sketch<> rhs;
+
+  for (auto i = 0; i < 1000; ++i) {
+    lhs.add(i);
+    rhs.add(i + 1000);
+  }
+
+  auto const copy(lhs);
+  lhs.merge(quantile_sketch<>());
+  FATAL_EXPECT_EQ(copy, lhs);
+
+  quantile_sketch<> empty;
+  empty.merge(lhs);
+  FATAL_EXPECT_EQ(lhs.state(), empty.state());
+
+  auto doubled(rhs);
+  doubled.merge(doubled);
+  FATAL_EXPECT_EQ(2000, doubled.size());
+  FATAL_EXPECT_EQ(1000, doubled.min());
+  FATAL_EXPECT_LT(std::abs(doubled.quantile(.5) - 1500), 10);
+
+  lhs.merge(rhs);
+  FATAL_EXPECT_EQ(2000, lhs.size());
+  FATAL_EXPECT_EQ(0, lhs.min());
+  FATAL_EXPECT_EQ(1999, lhs.max());
+  FATAL_EXPECT_LT(std::abs(lhs.quantile(.5) - 1000), 10);
+  FATAL_EXPECT_LT(std::abs(lhs.quantile(.99) - 1980), 2);
+}
+
+FATAL_TEST(quantile_sketch, state) {
+  std::mt19937_64 rng(0);
+  std::exponential_distribution<double> distribution(1);
+
+  quantile_sketch<> sketch(50);
+  quantile_sketch<> empty_copy(sketch.state());
+  FATAL_EXPECT_EQ(sketch, empty_copy);
+
+  for (auto i = 0; i < 10000; ++i) {
+    sketch.add(distribution(rng));
+
+    if (i % 1000 == 0) {
+      quantile_sketch<> copy(sketch.state());
+      FATAL_EXPECT_EQ(sketch.state(), copy.state());
+      FATAL_EXPECT_EQ(50, copy.compression());
+      FATAL_EXPECT_EQ(sketch.size(), copy.size());
+
+      for (auto q: quantiles) {
+        FATAL_EXPECT_EQ(sketch.quantile(q), copy.quantile(q));
+      }
+    }
+  }
+
+  sketch.compress();
+  FATAL_EXPECT_EQ(sketch, quantile_sketch<>(sketch.state()));
+}
+
+FATAL_TEST(quantile_sketch, equality) {
+  quantile_sketch<> lhs;
+  quantile_sketch<> rhs;
+
+  for (auto i = 0; i < 1000; ++i) {
+    lhs.add(i);
+    rhs.add(i);
+  }
+
+  // buffered samples compare the same as merged ones
+  rhs.compress();
+  FATAL_EXPECT_EQ(lhs, rhs);
+
+  lhs.add(1000);
+  FATAL_EXPECT_NE(lhs, rhs);
+
+  rhs.add(1000);
+  FATAL_EXPECT_EQ(lhs, rhs);
+  FATAL_EXPECT_NE(lhs, quantile_sketch<>(50).merge(lhs));
+}
+
+} // namespace fatal {
@@ -12,8 +12,10 @@
 
 #include <fatal/test/driver.h>
 
+#include <iterator>
 #include <random>
 #include <ratio>
+#include <stdexcept>
 #include <vector>
 
 namespace fatal {
@@ -217,6 +219,25 @@ void statistical_moments_test_round(
   merged_subsets.merge(moments2);
   TEST_ALL_IMPL(TEST_IMPL, moments, merged_subsets);
 
+  // tests adding ranges of samples
+  statistical_moments<case_value_type> range;
+  range.add_range(v1.begin(), v1.end());
+  range.add_range(v2.begin(), v2.end());
+  FATAL_EXPECT_EQ(case_samples, range.size());
+  TEST_ALL_IMPL(TEST_IMPL, moments, range);
+
+  // tests accumulating with several threads
+  auto all(v1);
+  all.insert(all.end(), v2.begin(), v2.end());
+
+  for (auto threads: {1, 3, 4}) {
+    auto const parallel = parallel_accumulate<case_value_type>(
+      all.begin(), all.end(), threads, case_samples / 8
+    );
+    FATAL_EXPECT_EQ(case_samples, parallel.size());
+    TEST_ALL_IMPL(TEST_IMPL, moments, parallel);
+  }
+
 # undef TEST_IMPL
 # undef TEST_ALL_IMPL
 }
@@ -285,6 +306,127 @@ FATAL_TEST(statistical_moments, exponential_distribution) {
   );
 }
 
+FATAL_TEST(statistical_moments, uneven_subsets) {
+  test_statistical_moments<value_type>(
+    samples::value + 1,
+    random_data(),
+    std::normal_distribution<value_type>(
+      to_scalar<normal_mean, long double>(),
+      to_scalar<normal_stddev, long double>()
+    )
+  );
+}
+
+FATAL_TEST(statistical_moments, small_ranges) {
+  std::vector<value_type> const values{1, 2, 4, 8, 16, 32, 64, 128, 256, 512};
+
+  for (auto size = values.size(); size; --size) {
+    statistical_moments<value_type> expected;
+
+    for (std::size_t i = 0; i < size; ++i) {
+      expected.add(values[i]);
+    }
+
+    statistical_moments<value_type> actual;
+    actual.add_range(values.begin(), values.begin() + size);
+    FATAL_EXPECT_EQ(expected.size(), actual.size());
+    FATAL_EXPECT_LT(std::abs(expected.mean() - actual.mean()), 1e-9);
+    FATAL_EXPECT_LT(std::abs(expected.variance() - actual.variance()), 1e-9);
+  }
+
+  statistical_moments<value_type> nothing;
+  nothing.add_range(values.end(), values.end());
+  FATAL_EXPECT_TRUE(nothing.empty());
+
+  auto const parallel = parallel_accumulate<value_type>(
+    values.end(), values.end(), 4, 1
+  );
+  FATAL_EXPECT_TRUE(parallel.empty());
+
+  auto const unbounded = parallel_accumulate<value_type>(
+    values.begin(), values.end(), 4, 0
+  );
+  FATAL_EXPECT_EQ(values.size(), unbounded.size());
+}
+
+// a forward iterator over the indexes [0, n) that throws when dereferenced at
+// the index `bad`
+struct throwing_iterator {
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using pointer = value_type const *;
+  using reference = value_type;
+
+  throwing_iterator(std::size_t index, std::size_t bad):
+    index_(index),
+    bad_(bad)
+  {}
+
+  value_type operator *() const {
+    if (index_ == bad_) {
+      throw std::runtime_error("bad sample");
+    }
+
+    return index_;
+  }
+
+  throwing_iterator &operator ++() {
+    ++index_;
+    return *this;
+  }
+
+  bool operator ==(throwing_iterator const &rhs) const {
+    return index_ == rhs.index_;
+  }
+
+  bool operator !=(throwing_iterator const &rhs) const {
+    return !(*this == rhs);
+  }
+
+private:
+  std::size_t index_;
+  std::size_t bad_;
+};
+
+FATAL_TEST(statistical_moments, parallel_exceptions) {
+  std::size_t const size = 1000;
+
+  // in the chunk of the calling thread, and in the chunk of the last thread
+  for (auto bad: {std::size_t(0), size - 1}) {
+    FATAL_EXPECT_THROW(std::runtime_error) {
+      parallel_accumulate<value_type>(
+        throwing_iterator(0, bad), throwing_iterator(size, bad), 4, 1
+      );
+    };
+  }
+
+  auto const moments = parallel_accumulate<value_type>(
+    throwing_iterator(0, size), throwing_iterator(size, size), 4, 1
+  );
+  FATAL_EXPECT_EQ(size, moments.size());
+}
+
+// merges two halves of 2^33 samples each, drawn from the unit normal
+// distributions centered at 0 and 2, whose counts overflow `std::size_t` when
+// multiplied together
+FATAL_TEST(statistical_moments, large_counts) {
+  using state = statistical_moments<value_type>::internal_state;
+  std::size_t const half = std::size_t(1) << 33;
+  value_type const count = half;
+
+  statistical_moments<value_type> moments(state(half, 0, count, 0, 3 * count));
+  moments.merge(
+    statistical_moments<value_type>(state(half, 2, count, 0, 3 * count))
+  );
+
+  FATAL_EXPECT_EQ(2 * half, moments.size());
+  FATAL_EXPECT_LT(std::abs(moments.mean() - 1), 1e-9);
+  FATAL_EXPECT_LT(std::abs(moments.variance() - 2), 1e-9);
+  FATAL_EXPECT_LT(std::abs(moments.skewness()), 1e-9);
+  FATAL_EXPECT_LT(std::abs(moments.kurtosis() + .5), 1e-9);
+}
+
 FATAL_TEST(statistical_moments, state) {
   random_data rng;
   std::normal_distribution<value_type> distribution(
@@ -77,4 +77,89 @@
 # define FATAL_ATTR_VISIBILITY_HIDDEN
 #endif
 
+/////////////////////////////
+// FATAL_IS_TRIVIALLY_*(T) //
+/////////////////////////////
+
+/**
+ * Portable versions of `std::is_trivially_copyable<T>::value` and
+ * `std::is_trivially_default_constructible<T>::value`, which are missing
+ * from the standard library shipped with GCC 4.x. Falls back to the compiler
+ * builtins when that's the case.
+ *
+ * Expands to a constant expression, and `<type_traits>` must be included.
+ *
+ * Example:
+ *
+ *  template <typename T>
+ *  using is_memcpyable = std::integral_constant<
+ *    bool, FATAL_IS_TRIVIALLY_COPYABLE(T)
+ *  >;
+ *
+ * @author: Marcelo Juchem <marcelo@fb.com>
+ */
+
+#if __clang__
+# define FATAL_IS_TRIVIALLY_COPYABLE(...) __is_trivially_copyable(__VA_ARGS__)
+# define FATAL_IS_TRIVIALLY_DEFAULT_CONSTRUCTIBLE(...) \
+  __is_trivially_constructible(__VA_ARGS__)
+#elif __GNUC__ && __GNUC__ < 5
+# define FATAL_IS_TRIVIALLY_COPYABLE(...) \
+  (__has_trivial_copy(__VA_ARGS__) && __has_trivial_destructor(__VA_ARGS__))
+# define FATAL_IS_TRIVIALLY_DEFAULT_CONSTRUCTIBLE(...) \
+  __has_trivial_constructor(__VA_ARGS__)
+#else
+# define FATAL_IS_TRIVIALLY_COPYABLE(...) \
+  ::std::is_trivially_copyable<__VA_ARGS__>::value
+# define FATAL_IS_TRIVIALLY_DEFAULT_CONSTRUCTIBLE(...) \
+  ::std::is_trivially_default_constructible<__VA_ARGS__>::value
+#endif
+
+//////////////////////
+// FATAL_HAS_SIMD_* //
+//////////////////////
+
+/**
+ * Compile-time detection of the SIMD instruction sets available to the
+ * translation unit. Each macro expands to `1` when the instruction set can be
+ * used and `0` otherwise.
+ *
+ * Defining `FATAL_DISABLE_SIMD` before including any Fatal header forces all
+ * of them to `0`, selecting the portable scalar code paths.
+ *
+ * Example:
+ *
+ *  #if FATAL_HAS_SIMD_SSE2
+ *  // use _mm_* intrinsics
+ *  #else
+ *  // scalar fallback
+ *  #endif
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+
+#if !defined(FATAL_DISABLE_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+# define FATAL_HAS_SIMD_SSE2 1
+#else
+# define FATAL_HAS_SIMD_SSE2 0
+#endif
+
+#if FATAL_HAS_SIMD_SSE2 && defined(__SSSE3__)
+# define FATAL_HAS_SIMD_SSSE3 1
+#else
+# define FATAL_HAS_SIMD_SSSE3 0
+#endif
+
+#if FATAL_HAS_SIMD_SSSE3 && defined(__AVX2__)
+# define FATAL_HAS_SIMD_AVX2 1
+#else
+# define FATAL_HAS_SIMD_AVX2 0
+#endif
+
+#if !defined(FATAL_DISABLE_SIMD) && defined(__BMI2__)
+# define FATAL_HAS_SIMD_BMI2 1
+#else
+# define FATAL_HAS_SIMD_BMI2 0
+#endif
+
 #endif
@@ -0,0 +1,99 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/string/rope.h>
+
+#include <fatal/container/arena.h>
+
+#include <fatal/benchmark/driver.h>
+
+#include <string>
+#include <utility>
+
+namespace fatal {
+
+using ropes = std::integral_constant<std::size_t, 100000>;
+
+std::string const method("GET");
+std::string const path("/index.html?query=something&other=thing");
+
+// a small, request-scoped rope with an owned piece and enough pieces to spill
+// past the small buffer
+template <typename Rope>
+void build(Rope &r, std::size_t i) {
+  r.append(method);
+  r.push_back(' ');
+  r.append(path);
+  r.append(std::string("&id=") + std::to_string(i));
+  r.append(" HTTP/1.1\r\n");
+  r.append("host: localhost\r\n");
+  r.append("accept: */*\r\n");
+  r.append(std::string("x-request-id: long enough to not fit the sso\r\n"));
+  r.append("\r\n");
+  r.append(path);
+}
+
+FATAL_BENCHMARK(build_100k_ropes, std_allocator, n) {
+  std::size_t size = 0;
+
+  while (n--) {
+    for (std::size_t i = 0; i < ropes::value; ++i) {
+      rope<> r;
+      build(r, i);
+      size += r.size();
+    }
+  }
+
+  prevent_optimization(size);
+}
+
+FATAL_BENCHMARK(build_100k_ropes, monotonic_arena, n) {
+  using arena_rope = rope<8, arena_allocator<char>>;
+
+  std::size_t size = 0;
+  monotonic_arena arena;
+
+  while (n--) {
+    for (std::size_t i = 0; i < ropes::value; ++i) {
+      {
+        arena_rope r(std::allocator_arg, arena_allocator<char>(arena));
+        build(r, i);
+        size += r.size();
+      }
+
+      arena.release();
+    }
+  }
+
+  prevent_optimization(size);
+}
+
+FATAL_BENCHMARK(build_100k_ropes, stack_arena, n) {
+  using arena_rope = rope<8, arena_allocator<char>>;
+
+  std::size_t size = 0;
+  alignas(16) char buffer[1024];
+  monotonic_arena arena(buffer, sizeof(buffer));
+
+  while (n--) {
+    for (std::size_t i = 0; i < ropes::value; ++i) {
+      {
+        arena_rope r(std::allocator_arg, arena_allocator<char>(arena));
+        build(r, i);
+        size += r.size();
+      }
+
+      arena.release();
+    }
+  }
+
+  prevent_optimization(size);
+}
+
+} // namespace fatal {
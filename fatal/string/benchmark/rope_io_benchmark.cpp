@@ -0,0 +1,75 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/string/rope_io.h>
+
+#include <fatal/string/rope.h>
+
+#include <fatal/benchmark/driver.h>
+
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace fatal {
+
+struct null_device {
+  null_device(): fd_(::open("/dev/null", O_WRONLY)) {}
+  ~null_device() { ::close(fd_); }
+
+  int fd() const { return fd_; }
+
+private:
+  int const fd_;
+};
+
+null_device const sink;
+
+std::string const piece(64, 'x');
+
+rope<> make_rope(std::size_t pieces) {
+  rope<> result;
+
+  for (std::size_t i = 0; i < pieces; ++i) {
+    result.append(string_view(piece));
+  }
+
+  return result;
+}
+
+rope<> const small_rope(make_rope(16));
+rope<> const large_rope(make_rope(16 * 1024));
+
+#define BENCHMARK_WRITE(Name, Rope) \
+  FATAL_BENCHMARK(write, Name##_to_string_write, n) { \
+    std::size_t written = 0; \
+    while (n--) { \
+      auto const s = Rope.to_string(); \
+      written += static_cast<std::size_t>( \
+        ::write(sink.fd(), s.data(), s.size()) \
+      ); \
+    } \
+    prevent_optimization(written); \
+  } \
+  \
+  FATAL_BENCHMARK(write, Name##_write_rope, n) { \
+    std::size_t written = 0; \
+    while (n--) { \
+      written += write_rope(sink.fd(), Rope); \
+    } \
+    prevent_optimization(written); \
+  }
+
+BENCHMARK_WRITE(small, small_rope)
+BENCHMARK_WRITE(large, large_rope)
+
+#undef BENCHMARK_WRITE
+
+} // namespace fatal {
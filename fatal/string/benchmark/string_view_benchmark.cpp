@@ -0,0 +1,164 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/string/string_view.h>
+
+#include <fatal/benchmark/driver.h>
+
+#include <algorithm>
+#include <string>
+
+namespace fatal {
+
+// haystacks are made of lowercase letters, with the needle only at the end
+std::string make_haystack(std::size_t size) {
+  std::string result(size, 'a');
+
+  for (std::size_t i = 0; i < size; ++i) {
+    result[i] = static_cast<char>('a' + (i * 7) % 26);
+  }
+
+  if (size) {
+    result.back() = ',';
+  }
+
+  return result;
+}
+
+// blanks are made of spaces and tabs, ending in a letter
+std::string make_blanks(std::size_t size) {
+  std::string result(size, ' ');
+
+  for (std::size_t i = 0; i < size; i += 3) {
+    result[i] = '\t';
+  }
+
+  if (size) {
+    result.back() = 'x';
+  }
+
+  return result;
+}
+
+std::string const short_haystack(make_haystack(24));
+std::string const long_haystack(make_haystack(1 << 20));
+
+std::string const short_blanks(make_blanks(24));
+std::string const long_blanks(make_blanks(1 << 20));
+
+char_set const blank(" \t");
+
+char const set[] = " \t\r\n,";
+char_set const delimiters(set);
+
+std::string const substring("yfm,");
+
+#define BENCHMARK_FIND(Name, Haystack, Blanks, Iterations) \
+  FATAL_BENCHMARK(find, Name##_std_find, n) { \
+    string_view const v(Haystack); \
+    std::size_t count = 0; \
+    while (n--) { \
+      for (std::size_t i = Iterations; i--; ) { \
+        count += std::find(v.begin(), v.end(), ',') - v.begin(); \
+      } \
+    } \
+    prevent_optimization(count); \
+  } \
+  \
+  FATAL_BENCHMARK(find, Name##_string_view, n) { \
+    string_view const v(Haystack); \
+    std::size_t count = 0; \
+    while (n--) { \
+      for (std::size_t i = Iterations; i--; ) { \
+        count += v.find(',') - v.begin(); \
+      } \
+    } \
+    prevent_optimization(count); \
+  } \
+  \
+  FATAL_BENCHMARK(find_any_of, Name##_std_find_first_of, n) { \
+    string_view const v(Haystack); \
+    std::size_t count = 0; \
+    while (n--) { \
+      for (std::size_t i = Iterations; i--; ) { \
+        count += std::find_first_of( \
+          v.begin(), v.end(), set, set + sizeof(set) - 1 \
+        ) - v.begin(); \
+      } \
+    } \
+    prevent_optimization(count); \
+  } \
+  \
+  FATAL_BENCHMARK(find_any_of, Name##_string_view, n) { \
+    string_view const v(Haystack); \
+    std::size_t count = 0; \
+    while (n--) { \
+      for (std::size_t i = Iterations; i--; ) { \
+        count += v.find_any_of(delimiters) - v.begin(); \
+      } \
+    } \
+    prevent_optimization(count); \
+  } \
+  \
+  FATAL_BENCHMARK(find_first_not_of, Name##_std_find_if, n) { \
+    string_view const v(Blanks); \
+    std::size_t count = 0; \
+    while (n--) { \
+      for (std::size_t i = Iterations; i--; ) { \
+        count += std::find_if( \
+          v.begin(), v.end(), \
+          [](char c) { return c != ' ' && c != '\t'; } \
+        ) - v.begin(); \
+      } \
+    } \
+    prevent_optimization(count); \
+  } \
+  \
+  FATAL_BENCHMARK(find_first_not_of, Name##_string_view, n) { \
+    string_view const v(Blanks); \
+    std::size_t count = 0; \
+    while (n--) { \
+      for (std::size_t i = Iterations; i--; ) { \
+        count += v.find_first_not_of(blank) - v.begin(); \
+      } \
+    } \
+    prevent_optimization(count); \
+  } \
+  \
+  FATAL_BENCHMARK(find_substring, Name##_std_search, n) { \
+    string_view const v(Haystack); \
+    std::size_t count = 0; \
+    while (n--) { \
+      for (std::size_t i = Iterations; i--; ) { \
+        count += std::search( \
+          v.begin(), v.end(), substring.begin(), substring.end() \
+        ) - v.begin(); \
+      } \
+    } \
+    prevent_optimization(count); \
+  } \
+  \
+  FATAL_BENCHMARK(find_substring, Name##_string_view, n) { \
+    string_view const v(Haystack); \
+    string_view const needle(substring); \
+    std::size_t count = 0; \
+    while (n--) { \
+      for (std::size_t i = Iterations; i--; ) { \
+        count += v.find(needle) - v.begin(); \
+      } \
+    } \
+    prevent_optimization(count); \
+  }
+
+BENCHMARK_FIND(short, short_haystack, short_blanks, 4096)
+BENCHMARK_FIND(long, long_haystack, long_blanks, 1)
+
+#undef BENCHMARK_FIND
+
+} // namespace fatal {
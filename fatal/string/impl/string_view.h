@@ -0,0 +1,443 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef FATAL_INCLUDE_fatal_string_impl_string_view_h
+#define FATAL_INCLUDE_fatal_string_impl_string_view_h
+
+#include <fatal/math/numerics.h>
+#include <fatal/portability.h>
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#if FATAL_HAS_SIMD_SSE2
+# include <emmintrin.h>
+#endif // FATAL_HAS_SIMD_SSE2
+
+#if FATAL_HAS_SIMD_AVX2
+# include <immintrin.h>
+#endif // FATAL_HAS_SIMD_AVX2
+
+namespace fatal {
+namespace i_sv {
+
+////////////////////////
+// char_set internals //
+////////////////////////
+
+// maximum amount of characters in a set that the SIMD kernels compare against
+// directly, larger sets fall back to the 256-bit lookup table
+using packed_set_size = std::integral_constant<std::size_t, 16>;
+
+constexpr std::uint64_t cs_bit(char c, std::size_t word) noexcept {
+  return static_cast<std::size_t>(static_cast<unsigned char>(c) >> 6) == word
+    ? std::uint64_t(1) << (static_cast<unsigned char>(c) & 63)
+    : 0;
+}
+
+constexpr std::uint64_t cs_word(
+  char const *s,
+  std::size_t size,
+  std::size_t word
+) noexcept {
+  return size
+    ? cs_bit(*s, word) | cs_word(s + 1, size - 1, word)
+    : 0;
+}
+
+// pads the packed representation with the first character so that SIMD
+// kernels can unconditionally compare against all `packed_set_size` entries
+constexpr char cs_at(
+  char const *s,
+  std::size_t size,
+  std::size_t i
+) noexcept {
+  return i < size ? s[i] : size ? s[0] : '\0';
+}
+
+////////////////////
+// scalar kernels //
+////////////////////
+
+struct scalar_search {
+  static char const *find(char const *begin, char const *end, char needle) {
+    assert(begin <= end);
+    auto const result = std::memchr(
+      begin, needle, static_cast<std::size_t>(end - begin)
+    );
+    return result ? static_cast<char const *>(result) : end;
+  }
+
+  template <typename Set>
+  static char const *find_any_of(
+    char const *begin,
+    char const *end,
+    Set const &set
+  ) {
+    assert(begin <= end);
+    while (begin != end && !set.contains(*begin)) { ++begin; }
+    return begin;
+  }
+
+  static char const *find_first_not_of(
+    char const *begin,
+    char const *end,
+    char needle
+  ) {
+    assert(begin <= end);
+    while (begin != end && *begin == needle) { ++begin; }
+    return begin;
+  }
+
+  template <typename Set>
+  static char const *find_first_not_of(
+    char const *begin,
+    char const *end,
+    Set const &set
+  ) {
+    assert(begin <= end);
+    while (begin != end && set.contains(*begin)) { ++begin; }
+    return begin;
+  }
+
+  static char const *find(
+    char const *begin,
+    char const *end,
+    char const *needle,
+    std::size_t size
+  ) {
+    assert(begin <= end);
+
+    if (!size) {
+      return begin;
+    }
+
+    if (static_cast<std::size_t>(end - begin) < size) {
+      return end;
+    }
+
+    auto const last = end - (size - 1);
+
+    for (;;) {
+      begin = find(begin, last, *needle);
+
+      if (begin == last) {
+        return end;
+      }
+
+      if (!std::memcmp(begin + 1, needle + 1, size - 1)) {
+        return begin;
+      }
+
+      ++begin;
+    }
+  }
+};
+
+//////////////////
+// SIMD kernels //
+//////////////////
+
+#if FATAL_HAS_SIMD_SSE2
+
+struct sse2_block {
+  using type = __m128i;
+  using size = std::integral_constant<std::size_t, 16>;
+
+  static type load(char const *p) {
+    return _mm_loadu_si128(reinterpret_cast<type const *>(p));
+  }
+
+  static type splat(char c) { return _mm_set1_epi8(c); }
+  static type eq(type lhs, type rhs) { return _mm_cmpeq_epi8(lhs, rhs); }
+  static type any(type lhs, type rhs) { return _mm_or_si128(lhs, rhs); }
+  static type all(type lhs, type rhs) { return _mm_and_si128(lhs, rhs); }
+
+  static std::uint32_t mask(type v) {
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(v));
+  }
+
+  static std::uint32_t invert(std::uint32_t mask) {
+    return ~mask & 0xffffu;
+  }
+};
+
+# if FATAL_HAS_SIMD_AVX2
+struct avx2_block {
+  using type = __m256i;
+  using size = std::integral_constant<std::size_t, 32>;
+
+  static type load(char const *p) {
+    return _mm256_loadu_si256(reinterpret_cast<type const *>(p));
+  }
+
+  static type splat(char c) { return _mm256_set1_epi8(c); }
+  static type eq(type lhs, type rhs) { return _mm256_cmpeq_epi8(lhs, rhs); }
+  static type any(type lhs, type rhs) { return _mm256_or_si256(lhs, rhs); }
+  static type all(type lhs, type rhs) { return _mm256_and_si256(lhs, rhs); }
+
+  static std::uint32_t mask(type v) {
+    return static_cast<std::uint32_t>(_mm256_movemask_epi8(v));
+  }
+
+  static std::uint32_t invert(std::uint32_t mask) { return ~mask; }
+};
+
+using wide_block = avx2_block;
+# else // FATAL_HAS_SIMD_AVX2
+using wide_block = sse2_block;
+# endif // FATAL_HAS_SIMD_AVX2
+
+template <typename Block, bool Negate>
+struct byte_matcher {
+  explicit byte_matcher(char needle): needle_(Block::splat(needle)) {}
+
+  std::uint32_t operator ()(char const *p) const {
+    auto const mask = Block::mask(Block::eq(Block::load(p), needle_));
+    return Negate ? Block::invert(mask) : mask;
+  }
+
+private:
+  typename Block::type needle_;
+};
+
+template <typename Block, bool Negate>
+struct set_matcher {
+  template <typename Set>
+  explicit set_matcher(Set const &set): size_(set.size()) {
+    assert(size_ && size_ <= packed_set_size::value);
+    for (std::size_t i = 0; i < size_; ++i) {
+      needles_[i] = Block::splat(set.packed()[i]);
+    }
+  }
+
+  std::uint32_t operator ()(char const *p) const {
+    auto const data = Block::load(p);
+    auto match = Block::eq(data, needles_[0]);
+    for (std::size_t i = 1; i < size_; ++i) {
+      match = Block::any(match, Block::eq(data, needles_[i]));
+    }
+    auto const mask = Block::mask(match);
+    return Negate ? Block::invert(mask) : mask;
+  }
+
+private:
+  typename Block::type needles_[packed_set_size::value];
+  std::size_t const size_;
+};
+
+// scans `[begin, end)` one block at a time, looking for the first position
+// flagged by `Matcher`, returning `end` if none is found
+//
+// the trailing partial block is handled by a final, overlapping load that ends
+// exactly at `end`, so memory outside the range is never touched
+template <template <typename, bool> class Matcher, bool Negate, typename... Args>
+char const *scan(
+  char const *begin,
+  char const *end,
+  char const *(*tail)(char const *, char const *, Args const &...),
+  Args const &...args
+) {
+  assert(begin <= end);
+  auto const size = static_cast<std::size_t>(end - begin);
+
+  if (size < sse2_block::size::value) {
+    return tail(begin, end, args...);
+  }
+
+# if FATAL_HAS_SIMD_AVX2
+  if (size >= avx2_block::size::value) {
+    Matcher<avx2_block, Negate> const match(args...);
+    for (; static_cast<std::size_t>(end - begin) >= avx2_block::size::value;
+      begin += avx2_block::size::value
+    ) {
+      if (auto const mask = match(begin)) {
+        return begin + count_trailing_zeros(mask);
+      }
+    }
+  }
+# endif // FATAL_HAS_SIMD_AVX2
+
+  Matcher<sse2_block, Negate> const match(args...);
+
+  for (; static_cast<std::size_t>(end - begin) >= sse2_block::size::value;
+    begin += sse2_block::size::value
+  ) {
+    if (auto const mask = match(begin)) {
+      return begin + count_trailing_zeros(mask);
+    }
+  }
+
+  if (begin != end) {
+    auto const remaining = static_cast<std::size_t>(end - begin);
+    auto const mask = match(end - sse2_block::size::value)
+      >> (sse2_block::size::value - remaining);
+
+    if (mask) {
+      return begin + count_trailing_zeros(mask);
+    }
+  }
+
+  return end;
+}
+
+template <typename Block>
+char const *find_substring(
+  char const *begin,
+  char const *end,
+  char const *needle,
+  std::size_t size
+) {
+  assert(size > 1);
+
+  auto const first = Block::splat(needle[0]);
+  auto const last = Block::splat(needle[size - 1]);
+
+  for (;
+    static_cast<std::size_t>(end - begin) >= size - 1 + Block::size::value;
+    begin += Block::size::value
+  ) {
+    auto mask = Block::mask(
+      Block::all(
+        Block::eq(Block::load(begin), first),
+        Block::eq(Block::load(begin + size - 1), last)
+      )
+    );
+
+    for (; mask; mask &= mask - 1) {
+      auto const candidate = begin + count_trailing_zeros(mask);
+
+      if (!std::memcmp(candidate + 1, needle + 1, size - 2)) {
+        return candidate;
+      }
+    }
+  }
+
+  return begin;
+}
+
+struct simd_search {
+  template <typename Set>
+  static char const *find_any_of_tail(
+    char const *begin,
+    char const *end,
+    Set const &set
+  ) {
+    return scalar_search::find_any_of(begin, end, set);
+  }
+
+  template <typename Set>
+  static char const *find_first_not_of_tail(
+    char const *begin,
+    char const *end,
+    Set const &set
+  ) {
+    return scalar_search::find_first_not_of(begin, end, set);
+  }
+
+  static char const *find_byte_tail(
+    char const *begin,
+    char const *end,
+    char const &needle
+  ) {
+    return scalar_search::find(begin, end, needle);
+  }
+
+  static char const *find_not_byte_tail(
+    char const *begin,
+    char const *end,
+    char const &needle
+  ) {
+    return scalar_search::find_first_not_of(begin, end, needle);
+  }
+
+  static char const *find(char const *begin, char const *end, char needle) {
+    return scan<byte_matcher, false, char>(
+      begin, end, &find_byte_tail, needle
+    );
+  }
+
+  template <typename Set>
+  static char const *find_any_of(
+    char const *begin,
+    char const *end,
+    Set const &set
+  ) {
+    if (!set.packable()) {
+      return scalar_search::find_any_of(begin, end, set);
+    }
+
+    return set.size() == 1
+      ? find(begin, end, set.packed()[0])
+      : scan<set_matcher, false, Set>(
+        begin, end, &find_any_of_tail<Set>, set
+      );
+  }
+
+  static char const *find_first_not_of(
+    char const *begin,
+    char const *end,
+    char needle
+  ) {
+    return scan<byte_matcher, true, char>(
+      begin, end, &find_not_byte_tail, needle
+    );
+  }
+
+  template <typename Set>
+  static char const *find_first_not_of(
+    char const *begin,
+    char const *end,
+    Set const &set
+  ) {
+    if (!set.packable()) {
+      return scalar_search::find_first_not_of(begin, end, set);
+    }
+
+    return set.size() == 1
+      ? find_first_not_of(begin, end, set.packed()[0])
+      : scan<set_matcher, true, Set>(
+        begin, end, &find_first_not_of_tail<Set>, set
+      );
+  }
+
+  static char const *find(
+    char const *begin,
+    char const *end,
+    char const *needle,
+    std::size_t size
+  ) {
+    assert(begin <= end);
+
+    if (size < 2) {
+      return size ? find(begin, end, *needle) : begin;
+    }
+
+    begin = find_substring<wide_block>(begin, end, needle, size);
+#   if FATAL_HAS_SIMD_AVX2
+    begin = find_substring<sse2_block>(begin, end, needle, size);
+#   endif // FATAL_HAS_SIMD_AVX2
+
+    return scalar_search::find(begin, end, needle, size);
+  }
+};
+
+using search = simd_search;
+
+#else // FATAL_HAS_SIMD_SSE2
+
+using search = scalar_search;
+
+#endif // FATAL_HAS_SIMD_SSE2
+
+} // namespace i_sv {
+} // namespace fatal {
+
+#endif // FATAL_INCLUDE_fatal_string_impl_string_view_h
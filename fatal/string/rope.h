@@ -10,7 +10,7 @@
 #ifndef FATAL_INCLUDE_fatal_string_rope_h
 #define FATAL_INCLUDE_fatal_string_rope_h
 
-#include <fatal/container/uninitialized.h>
+#include <fatal/container/small_vector.h>
 #include <fatal/math/hash.h>
 #include <fatal/portability.h>
 #include <fatal/string/string_view.h>
@@ -19,7 +19,6 @@
 #include <fatal/type/traits.h>
 
 #include <algorithm>
-#include <array>
 #include <functional>
 #include <iterator>
 #include <memory>
@@ -32,6 +31,7 @@
 #include <vector>
 
 #include <cassert>
+#include <cstdint>
 
 FATAL_DIAGNOSTIC_PUSH
 FATAL_GCC_DIAGNOSTIC_IGNORED_SHADOW_IF_BROKEN
@@ -45,13 +45,14 @@ namespace rope_impl {
 ////////////////////////////
 
 // optimized for rope
-template <typename TData>
+template <typename TData, typename TString = std::string>
 class variant {
   enum class id_type: unsigned char { string, reference, character };
 
 public:
   using size_type = std::size_t;
   using payload_type = TData;
+  using string_type = TString;
 
   template <id_type V>
   using id_constant = std::integral_constant<id_type, V>;
@@ -59,7 +60,7 @@ public:
   template <typename T>
   using id = fatal::pair_get<
     fatal::list<
-      fatal::pair<std::string, id_constant<id_type::string>>,
+      fatal::pair<string_type, id_constant<id_type::string>>,
       fatal::pair<string_view, id_constant<id_type::reference>>,
       fatal::pair<char, id_constant<id_type::character>>
     >,
@@ -69,13 +70,13 @@ public:
   variant(variant const &rhs) = delete;
 
   variant(variant &&rhs)
-    noexcept(noexcept(std::string(std::declval<std::string &&>()))):
+    noexcept(noexcept(string_type(std::declval<string_type &&>()))):
     payload_(std::move(rhs.payload_)),
     which_(rhs.which_)
   {
     switch (which_) {
       case id_type::string:
-        new (std::addressof(value_.s)) std::string(std::move(rhs.value_.s));
+        new (std::addressof(value_.s)) string_type(std::move(rhs.value_.s));
         break;
 
       case id_type::reference:
@@ -89,7 +90,7 @@ public:
   }
 
   template <typename... Args>
-  explicit variant(std::string &&s, Args &&...args):
+  explicit variant(string_type &&s, Args &&...args):
     payload_(std::forward<Args>(args)...),
     value_(std::move(s)),
     which_(id_type::string)
@@ -112,8 +113,7 @@ public:
   ~variant() {
     switch (which_) {
       case id_type::string:
-        using string_t = std::string;
-        value_.s.~string_t();
+        value_.s.~string_type();
         break;
 
       default:
@@ -208,19 +208,19 @@ private:
     union_t(union_t const &) = delete;
     union_t(union_t &&) = delete;
 
-    explicit union_t(std::string &&s_): s(std::move(s_)) {}
+    explicit union_t(string_type &&s_): s(std::move(s_)) {}
     explicit union_t(string_view s_): ref(s_) {}
     explicit union_t(char c_): c(c_) {}
 
     ~union_t() {}
 
-    std::string s;
+    string_type s;
     string_view ref;
     char c;
   };
 
-  std::string const &get(tag<std::string>) const { return value_.s; }
-  std::string const *try_get(tag<std::string>) const {
+  string_type const &get(tag<string_type>) const { return value_.s; }
+  string_type const *try_get(tag<string_type>) const {
     return std::addressof(value_.s);
   }
 
@@ -237,86 +237,82 @@ private:
   id_type which_;
 };
 
-// optimized for rope
-template <typename T, std::size_t SmallBufferSize = 8>
-struct vector {
-  using value_type = T;
-  using const_reference = value_type const &;
-  using rvalue_reference = value_type &&;
-  using const_pointer = value_type const *;
-  using size_type = std::size_t;
-  using small_buffer_size = std::integral_constant<size_type, SmallBufferSize>;
+template <typename...>
+struct is_allocator_arg: std::false_type {};
 
-  vector() = default;
-  vector(vector const &) = delete;
-  vector(vector &&rhs):
-    size_(std::move(rhs.size_)),
-    buffer_(std::move(rhs.buffer_))
-  {
-    for (auto i = std::min(size_, rhs.small_.size()); i--; ) {
-      small_[i].steal(std::move(rhs.small_[i]));
-    }
-  }
+template <typename T, typename... Args>
+struct is_allocator_arg<T, Args...>:
+  std::is_same<typename std::decay<T>::type, std::allocator_arg_t>
+{};
 
-  ~vector() { clear(); }
+// polynomial hash modulo the mersenne prime 2^61 - 1, which can be computed
+// independently for each piece and later combined without touching the bytes:
+//
+//  h(a + b) = h(a) * base^size(b) + h(b)
+struct polynomial_hash {
+  using value_type = std::uint64_t;
+  using modulus = std::integral_constant<value_type, (value_type(1) << 61) - 1>;
+  using base = std::integral_constant<value_type, 0x16a09e667f3bcc9>;
 
-  template <typename... Args>
-  void emplace_back(Args &&...args) {
-    if (size_ < small_.size()) {
-      small_[size_].construct(std::forward<Args>(args)...);
-    } else {
-      if (size_ == small_.size()) {
-        buffer_.reserve(small_.size());
-      }
-      buffer_.emplace_back(std::forward<Args>(args)...);
-    }
+  static_assert(base::value < modulus::value, "base must be under modulus");
 
-    ++size_;
-  }
+  polynomial_hash() = default;
 
-  void clear() {
-    buffer_.clear();
-
-    for (auto i = std::min(size_, small_.size()); i--; ) {
-      small_[i].destroy();
+  explicit polynomial_hash(string_view s) {
+    for (auto c: s) {
+      hash_ = reduce(
+        multiply(hash_, base::value) + static_cast<unsigned char>(c) + 1
+      );
     }
 
-    size_ = 0;
+    power_ = pow(base::value, s.size());
   }
 
-  void reserve(size_type size) {
-    if (size > small_.size()) {
-      buffer_.reserve(size - small_.size());
-    }
+  polynomial_hash &operator +=(polynomial_hash const &rhs) {
+    hash_ = reduce(multiply(hash_, rhs.power_) + rhs.hash_);
+    power_ = multiply(power_, rhs.power_);
+    return *this;
   }
 
-  size_type capacity() const { return small_.size() + buffer_.capacity(); }
+  value_type operator *() const { return hash_; }
 
-  size_type size() const { return size_; }
+private:
+  static value_type reduce(value_type x) {
+    x = (x & modulus::value) + (x >> 61);
+    return x >= modulus::value ? x - modulus::value : x;
+  }
 
-  bool empty() const { return !size_; }
+  // (lhs * rhs) mod 2^61 - 1 using 32x32 bit multiplications, given that both
+  // `lhs` and `rhs` are under 2^61, relying on `2^61 = 1 (mod 2^61 - 1)`
+  static value_type multiply(value_type lhs, value_type rhs) {
+    auto const lhi = lhs >> 32;
+    auto const llo = lhs & 0xffffffff;
+    auto const rhi = rhs >> 32;
+    auto const rlo = rhs & 0xffffffff;
 
-  const_reference operator [](size_type i) const {
-    assert(i < size_);
-    return i < small_.size()
-      ? *small_[i]
-      : buffer_[i - small_.size()];
+    auto const middle = lhi * rlo + llo * rhi;
+
+    return reduce(
+      ((lhi * rhi) << 3)
+        + (middle >> 29) + ((middle & 0x1fffffff) << 32)
+        + reduce(llo * rlo)
+    );
   }
 
-  rvalue_reference move(size_type i) {
-    assert(i < size_);
-    if (i < small_.size()) {
-      return std::move(*small_[i]);
+  static value_type pow(value_type x, std::size_t exponent) {
+    value_type result = 1;
+
+    for (; exponent; exponent >>= 1, x = multiply(x, x)) {
+      if (exponent & 1) {
+        result = multiply(result, x);
+      }
     }
 
-    return std::move(buffer_[i - small_.size()]);
+    return result;
   }
 
-private:
-  size_type size_ = 0;
-  std::array<uninitialized<value_type, false>, small_buffer_size::value> small_;
-  // TODO: use something other than std::vector ??
-  std::vector<value_type> buffer_;
+  value_type hash_ = 0;
+  value_type power_ = 1;
 };
 
 } // namespace rope_impl {
@@ -424,10 +420,34 @@ private:
  *  // prints "hello, world! this is a test."
  *  std::cout << r << std::endl;
  *
+ * Up to `SmallBufferSize` pieces are kept inline, in a `small_vector`. All
+ * memory allocated by the rope - owned strings, the pieces once they don't
+ * fit in the small buffer and cached hashes - comes from `Allocator`, which
+ * is rebound as needed. This allows, for instance, building short-lived ropes
+ * out of a `monotonic_arena` that is released all at once. Note that strings
+ * appended as r-values are copied into the allocator's memory whenever their
+ * allocator differs from `Allocator`.
+ *
+ * Example 4:
+ *
+ *  monotonic_arena arena;
+ *  using arena_rope = rope<8, arena_allocator<char>>;
+ *
+ *  arena_rope r(std::allocator_arg, arena_allocator<char>(arena), "hello");
+ *
+ *  // the contents of the temporary are copied into the arena
+ *  r.append(std::string(", world!"));
+ *
+ * `hash()` caches the hashes of the pieces, hence it's not safe to call it
+ * concurrently on the same rope. Use `hasher` for concurrent access instead.
+ *
  * @author: Marcelo Juchem
  */
 
-template <std::size_t SmallBufferSize = 8>
+template <
+  std::size_t SmallBufferSize = 8,
+  typename Allocator = std::allocator<char>
+>
 struct rope {
   // TODO: switch `char` piece with array+size, taking up the same space as the
   // other pieces
@@ -457,12 +477,27 @@ struct rope {
    */
   using difference_type = typename std::make_signed<size_type>::type;
 
+  /**
+   * The allocator used by this rope.
+   *
+   * @author: Marcelo Juchem
+   */
+  using allocator_type = Allocator;
+
 private:
-  using piece_type = detail::rope_impl::variant<size_type>;
-  using container_type = detail::rope_impl::vector<
-    piece_type, SmallBufferSize
+  template <typename T>
+  using rebind_alloc = typename std::allocator_traits<allocator_type>
+    ::template rebind_alloc<T>;
+
+  using string_type = std::basic_string<
+    char, std::char_traits<char>, rebind_alloc<char>
+  >;
+  using piece_type = detail::rope_impl::variant<size_type, string_type>;
+  using container_type = small_vector<
+    piece_type, SmallBufferSize, rebind_alloc<piece_type>
   >;
   using small_buffer_size = typename container_type::small_buffer_size;
+  using hash_type = detail::rope_impl::polynomial_hash;
 
 public:
   /**
@@ -494,6 +529,35 @@ public:
    */
   rope(rope &&) = default;
 
+  /**
+   * Constructs a rope that uses the given allocator, out of the given pieces.
+   *
+   * This is equivalent to constructing an empty rope with the given allocator,
+   * then calling `append()` on each piece given.
+   *
+   * Example:
+   *
+   *  monotonic_arena arena;
+   *  arena_allocator<char> allocator(arena);
+   *
+   *  rope<8, arena_allocator<char>> hello(
+   *    std::allocator_arg, allocator, "hello, ", std::string("world"), '!'
+   *  );
+   *
+   * @author: Marcelo Juchem
+   */
+  template <typename... Args>
+  rope(
+    std::allocator_arg_t,
+    allocator_type const &allocator,
+    Args &&...args
+  ):
+    pieces_(allocator),
+    hashes_(allocator)
+  {
+    multi_append(std::forward<Args>(args)...);
+  }
+
   /**
    * Constructs a rope ouf of the given pieces.
    *
@@ -507,7 +571,13 @@ public:
    *
    * @author: Marcelo Juchem
    */
-  template <typename... Args, typename = safe_overload<rope, Args...>>
+  template <
+    typename... Args,
+    typename = safe_overload<rope, Args...>,
+    typename = typename std::enable_if<
+      !detail::rope_impl::is_allocator_arg<Args...>::value
+    >::type
+  >
   explicit rope(Args &&...args) {
     multi_append(std::forward<Args>(args)...);
   }
@@ -571,6 +641,33 @@ public:
     return pieces_.size();
   }
 
+  /**
+   * Calls `visitor(piece)` for each piece of this rope, in order.
+   *
+   * The visitor may return `false` to stop the iteration early, in which case
+   * this function also returns `false`. Otherwise, returns `true`.
+   *
+   * Example:
+   *
+   *  std::string s;
+   *  r.for_each_piece([&](string_view piece) {
+   *    s.append(piece.data(), piece.size());
+   *    return true;
+   *  });
+   *
+   * @author: Marcelo Juchem
+   */
+  template <typename Visitor>
+  bool for_each_piece(Visitor &&visitor) const {
+    for (piece_index i = 0, pieces = pieces_.size(); i < pieces; ++i) {
+      if (!visitor(pieces_[i].ref())) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
   /**
    * Returns the first character of the string represented by this rope.
    *
@@ -909,7 +1006,7 @@ public:
    * TODO: BIKE-SHED
    */
   rope mimic() const {
-    rope result;
+    rope result(std::allocator_arg, get_allocator());
 
     auto const pieces = pieces_.size();
 
@@ -919,6 +1016,9 @@ public:
       result.append(pieces_[i].ref());
     }
 
+    result.hashes_ = hashes_;
+    result.hash_ = hash_;
+
     return result;
   }
 
@@ -962,7 +1062,7 @@ public:
       return;
     }
 
-    pieces_.emplace_back(std::move(s), size_);
+    pieces_.emplace_back(own(std::move(s)), size_);
     size_ += size;
   }
 
@@ -1049,10 +1149,16 @@ public:
 
     reserve(pieces, true);
 
+    auto const hashed = hashes_.size() == pieces_.size();
+
     // TODO: copy pieces which are single characters
     for (piece_index i = 0; i < pieces; ++i) {
       append(rhs.pieces_[i].ref());
     }
+
+    if (hashed) {
+      concat_hashes(rhs.hashes_, rhs.hash_);
+    }
   }
 
   /**
@@ -1075,12 +1181,18 @@ public:
 
     reserve(pieces, true);
 
+    auto const hashed = hashes_.size() == pieces_.size();
+
     for (piece_index i = 0; i < pieces; ++i) {
-      pieces_.emplace_back(rhs.pieces_.move(i));
+      pieces_.emplace_back(std::move(rhs.pieces_[i]));
     }
 
     size_ += rhs.size_;
 
+    if (hashed) {
+      concat_hashes(rhs.hashes_, rhs.hash_);
+    }
+
     rhs.clear();
   }
 
@@ -1190,12 +1302,12 @@ public:
    */
   template <
     typename Traits = std::char_traits<char>,
-    typename Allocator = std::allocator<char>
+    typename StringAllocator = std::allocator<char>
   >
-  std::basic_string<char, Traits, Allocator> to_string(
-    Allocator const &allocator = Allocator()
+  std::basic_string<char, Traits, StringAllocator> to_string(
+    StringAllocator const &allocator = StringAllocator()
   ) const {
-    std::string s(allocator);
+    std::basic_string<char, Traits, StringAllocator> s(allocator);
     append_to(s);
     return s;
   }
@@ -1249,6 +1361,19 @@ public:
    */
   size_type capacity() const { return pieces_.capacity(); }
 
+  ///////////////////
+  // get_allocator //
+  ///////////////////
+
+  /**
+   * Returns a copy of the allocator used by this rope.
+   *
+   * @author: Marcelo Juchem
+   */
+  allocator_type get_allocator() const {
+    return allocator_type(pieces_.get_allocator());
+  }
+
   //////////
   // size //
   //////////
@@ -1285,6 +1410,55 @@ public:
   void clear() {
     pieces_.clear();
     size_ = 0;
+    hashes_.clear();
+    hash_ = hash_type();
+  }
+
+  //////////
+  // hash //
+  //////////
+
+  /**
+   * Returns a hash of the string represented by this rope.
+   *
+   * The hash is independent of how the string is split into pieces, so two
+   * ropes representing the same string always have the same hash, regardless
+   * of their pieces.
+   *
+   * Each piece is hashed at most once: the hash of every piece is cached and
+   * combined with the others without reading the bytes again. Pieces appended
+   * after a call to `hash()` are only hashed by the next call, and pieces
+   * concatenated from another rope reuse the hashes cached by that rope.
+   *
+   * Since pieces may only be referenced by this rope, changing the contents
+   * of a referenced string after it has been hashed leaves a stale hash.
+   *
+   * This function updates a cache, therefore it is not safe to call it
+   * concurrently on the same rope, even though it's `const`. Use `hasher`,
+   * which never updates the cache, for concurrent access.
+   *
+   * Example:
+   *
+   *  rope<> r("hello", ", ");
+   *  auto const h1 = r.hash();
+   *
+   *  // only "world" is hashed, "hello" and ", " are not read again
+   *  r.append("world");
+   *  auto const h2 = r.hash();
+   *
+   *  assert(h2 == rope<>("hello, world").hash());
+   *
+   * @author: Marcelo Juchem
+   */
+  std::size_t hash() const {
+    auto const pieces = pieces_.size();
+
+    for (auto i = hashes_.size(); i < pieces; ++i) {
+      hashes_.emplace_back(pieces_[i].ref());
+      hash_ += hashes_.back();
+    }
+
+    return static_cast<std::size_t>(*hash_);
   }
 
   /////////////
@@ -1639,20 +1813,26 @@ public:
     return compare(std::forward<T>(rhs)) > 0;
   }
 
+  /**
+   * A hasher for ropes, yielding the same value as `hash()`.
+   *
+   * Unlike `hash()`, it doesn't update the rope's cache: the hashes already
+   * cached are reused, but pieces that haven't been hashed yet are hashed on
+   * every call. This makes it safe to hash the same rope concurrently, as
+   * long as no thread calls `hash()` or modifies the rope at the same time.
+   *
+   * Example:
+   *
+   *  std::unordered_set<rope<>, rope<>::hasher> set;
+   *
+   * @author: Marcelo Juchem
+   */
   struct hasher {
     using argument = rope;
     using result_type = std::size_t;
 
     result_type operator ()(rope const &r) const {
-      bytes_hasher<result_type> inner_hasher;
-
-      for (piece_index i = 0, pieces = r.pieces(); i < pieces; ++i) {
-        auto piece = r.piece(i);
-
-        inner_hasher(piece.begin(), piece.end());
-      }
-
-      return *inner_hasher;
+      return static_cast<result_type>(*r.uncached_hash());
     }
   };
 
@@ -1713,8 +1893,56 @@ private:
 
   void multi_append_impl() {}
 
+  // moves the string into the rope if it uses the same allocator,
+  // otherwise copies its contents using the rope's allocator
+  string_type own(std::string &&s) const {
+    return own(std::move(s), std::is_same<string_type, std::string>());
+  }
+
+  static string_type own(std::string &&s, std::true_type) {
+    return std::move(s);
+  }
+
+  string_type own(std::string &&s, std::false_type) const {
+    return string_type(s.data(), s.size(), pieces_.get_allocator());
+  }
+
+  // combines the cached hashes with the hashes of the remaining pieces,
+  // without updating the cache
+  hash_type uncached_hash() const {
+    auto result = hash_;
+
+    for (auto i = hashes_.size(), pieces = pieces_.size(); i < pieces; ++i) {
+      result += hash_type(pieces_[i].ref());
+    }
+
+    return result;
+  }
+
+  // appends the cached hashes of a rope's pieces, given that the hashes of
+  // all of this rope's pieces, prior to the concatenation, are also cached
+  //
+  // `hashes` may alias `hashes_` when concatenating a rope to itself
+  void concat_hashes(
+    std::vector<hash_type, rebind_alloc<hash_type>> const &hashes,
+    hash_type hash
+  ) {
+    auto const size = hashes.size();
+    hashes_.reserve(hashes_.size() + size);
+
+    for (std::size_t i = 0; i < size; ++i) {
+      hashes_.push_back(hashes[i]);
+    }
+
+    hash_ += hash;
+  }
+
   container_type pieces_;
   size_type size_ = 0;
+
+  // `hash_` is the combined hash of the first `hashes_.size()` pieces
+  mutable std::vector<hash_type, rebind_alloc<hash_type>> hashes_;
+  mutable hash_type hash_;
 };
 
 /////////////////
@@ -1724,9 +1952,10 @@ private:
 template <
   typename T,
   std::size_t SmallBufferSize,
-  typename = safe_overload<rope<SmallBufferSize>, T>
+  typename Allocator,
+  typename = safe_overload<rope<SmallBufferSize, Allocator>, T>
 >
-bool operator ==(T const &lhs, rope<SmallBufferSize> const &rhs) {
+bool operator ==(T const &lhs, rope<SmallBufferSize, Allocator> const &rhs) {
   return rhs == lhs;
 }
 
@@ -1737,9 +1966,10 @@ bool operator ==(T const &lhs, rope<SmallBufferSize> const &rhs) {
 template <
   typename T,
   std::size_t SmallBufferSize,
-  typename = safe_overload<rope<SmallBufferSize>, T>
+  typename Allocator,
+  typename = safe_overload<rope<SmallBufferSize, Allocator>, T>
 >
-bool operator <(T const &lhs, rope<SmallBufferSize> const &rhs) {
+bool operator <(T const &lhs, rope<SmallBufferSize, Allocator> const &rhs) {
   return rhs > lhs;
 }
 
@@ -1750,9 +1980,10 @@ bool operator <(T const &lhs, rope<SmallBufferSize> const &rhs) {
 template <
   typename T,
   std::size_t SmallBufferSize,
-  typename = safe_overload<rope<SmallBufferSize>, T>
+  typename Allocator,
+  typename = safe_overload<rope<SmallBufferSize, Allocator>, T>
 >
-bool operator >(T const &lhs, rope<SmallBufferSize> const &rhs) {
+bool operator >(T const &lhs, rope<SmallBufferSize, Allocator> const &rhs) {
   return rhs < lhs;
 }
 
@@ -1760,17 +1991,18 @@ bool operator >(T const &lhs, rope<SmallBufferSize> const &rhs) {
 // operator != //
 /////////////////
 
-template <typename T, std::size_t SmallBufferSize>
-bool operator !=(rope<SmallBufferSize> const &lhs, T const &rhs) {
+template <typename T, std::size_t SmallBufferSize, typename Allocator>
+bool operator !=(rope<SmallBufferSize, Allocator> const &lhs, T const &rhs) {
   return !(lhs == rhs);
 }
 
 template <
   typename T,
   std::size_t SmallBufferSize,
-  typename = safe_overload<rope<SmallBufferSize>, T>
+  typename Allocator,
+  typename = safe_overload<rope<SmallBufferSize, Allocator>, T>
 >
-bool operator !=(T const &lhs, rope<SmallBufferSize> const &rhs) {
+bool operator !=(T const &lhs, rope<SmallBufferSize, Allocator> const &rhs) {
   return !(rhs == lhs);
 }
 
@@ -1778,17 +2010,18 @@ bool operator !=(T const &lhs, rope<SmallBufferSize> const &rhs) {
 // operator <= //
 /////////////////
 
-template <typename T, std::size_t SmallBufferSize>
-bool operator <=(rope<SmallBufferSize> const &lhs, T const &rhs) {
+template <typename T, std::size_t SmallBufferSize, typename Allocator>
+bool operator <=(rope<SmallBufferSize, Allocator> const &lhs, T const &rhs) {
   return !(lhs > rhs);
 }
 
 template <
   typename T,
   std::size_t SmallBufferSize,
-  typename = safe_overload<rope<SmallBufferSize>, T>
+  typename Allocator,
+  typename = safe_overload<rope<SmallBufferSize, Allocator>, T>
 >
-bool operator <=(T const &lhs, rope<SmallBufferSize> const &rhs) {
+bool operator <=(T const &lhs, rope<SmallBufferSize, Allocator> const &rhs) {
   return !(rhs < lhs);
 }
 
@@ -1796,17 +2029,18 @@ bool operator <=(T const &lhs, rope<SmallBufferSize> const &rhs) {
 // operator >= //
 /////////////////
 
-template <typename T, std::size_t SmallBufferSize>
-bool operator >=(rope<SmallBufferSize> const &lhs, T const &rhs) {
+template <typename T, std::size_t SmallBufferSize, typename Allocator>
+bool operator >=(rope<SmallBufferSize, Allocator> const &lhs, T const &rhs) {
   return !(lhs < rhs);
 }
 
 template <
   typename T,
   std::size_t SmallBufferSize,
-  typename = safe_overload<rope<SmallBufferSize>, T>
+  typename Allocator,
+  typename = safe_overload<rope<SmallBufferSize, Allocator>, T>
 >
-bool operator >=(T const &lhs, rope<SmallBufferSize> const &rhs) {
+bool operator >=(T const &lhs, rope<SmallBufferSize, Allocator> const &rhs) {
   return !(rhs > lhs);
 }
 
@@ -1814,12 +2048,17 @@ bool operator >=(T const &lhs, rope<SmallBufferSize> const &rhs) {
 // operator <<(std::basic_ostream) //
 /////////////////////////////////////
 
-template <typename C, typename T, std::size_t SmallBufferSize>
+template <
+  typename C,
+  typename T,
+  std::size_t SmallBufferSize,
+  typename Allocator
+>
 std::ostream &operator <<(
   std::basic_ostream<C, T> &out,
-  rope<SmallBufferSize> const &r
+  rope<SmallBufferSize, Allocator> const &r
 ) {
-  using piece_index = typename rope<SmallBufferSize>::piece_index;
+  using piece_index = typename rope<SmallBufferSize, Allocator>::piece_index;
 
   for (piece_index i = 0, pieces = r.pieces(); i < pieces; ++i) {
     auto piece = r.piece(i);
@@ -0,0 +1,194 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef FATAL_INCLUDE_fatal_string_rope_io_h
+#define FATAL_INCLUDE_fatal_string_rope_io_h
+
+#include <fatal/string/string_view.h>
+
+#include <array>
+#include <system_error>
+#include <type_traits>
+
+#include <cassert>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace fatal {
+namespace detail {
+namespace rope_io_impl {
+
+#ifdef IOV_MAX
+using iov_max = std::integral_constant<std::size_t, IOV_MAX>;
+#else // IOV_MAX
+// POSIX guarantees at least 16, Linux and most BSDs support 1024
+using iov_max = std::integral_constant<std::size_t, 1024>;
+#endif // IOV_MAX
+
+// keeps the batch small enough to live on the stack, while still amortizing
+// the cost of a system call over plenty of pieces
+using batch_size = std::integral_constant<
+  std::size_t, (iov_max::value < 64 ? iov_max::value : 64)
+>;
+
+// writes all of `[begin, end)` using `writer(iov, count)`, which must behave
+// like `writev()`, resuming after partial writes
+template <typename Writer>
+std::size_t write_all(Writer &&writer, iovec *begin, iovec *end) {
+  std::size_t total = 0;
+
+  for (;;) {
+    while (begin != end && !begin->iov_len) {
+      ++begin;
+    }
+
+    if (begin == end) {
+      break;
+    }
+
+    assert(end - begin <= static_cast<std::ptrdiff_t>(iov_max::value));
+    auto const written = writer(begin, static_cast<int>(end - begin));
+
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      throw std::system_error(errno, std::system_category(), "writev");
+    }
+
+    // no progress despite pending bytes, retrying would spin forever
+    if (!written) {
+      throw std::system_error(
+        std::make_error_code(std::errc::io_error),
+        "writev wrote no bytes"
+      );
+    }
+
+    auto remaining = static_cast<std::size_t>(written);
+    total += remaining;
+
+    for (; begin != end && remaining >= begin->iov_len; ++begin) {
+      remaining -= begin->iov_len;
+    }
+
+    if (begin != end) {
+      begin->iov_base = static_cast<char *>(begin->iov_base) + remaining;
+      begin->iov_len -= remaining;
+    }
+  }
+
+  return total;
+}
+
+inline std::size_t write_all(int fd, iovec *begin, iovec *end) {
+  return write_all(
+    [fd](iovec const *iov, int count) { return ::writev(fd, iov, count); },
+    begin,
+    end
+  );
+}
+
+} // namespace rope_io_impl {
+} // namespace detail {
+
+/**
+ * The maximum number of `iovec` entries handed out in a single batch by
+ * `for_each_iovec_batch`. It never exceeds the maximum accepted by `writev()`
+ * and it's small enough for the batch to be kept on the stack.
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+using iovec_batch_size = detail::rope_io_impl::batch_size;
+
+/**
+ * Exposes the pieces of a rope (any class providing `for_each_piece()`, like
+ * `rope` and `shared_rope`) as arrays of `struct iovec`, without copying their
+ * contents.
+ *
+ * Calls `visitor(iov, count)` for consecutive batches of up to
+ * `iovec_batch_size` entries, where `iov` points to `count` entries. The
+ * entries are only valid for the duration of the call, and they may be
+ * modified by the visitor, for instance, to handle partial writes.
+ *
+ * Returns the number of batches visited.
+ *
+ * Example:
+ *
+ *  for_each_iovec_batch(r, [&](iovec *iov, std::size_t count) {
+ *    ::vmsplice(pipe, iov, count, 0);
+ *  });
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+template <typename Rope, typename Visitor>
+std::size_t for_each_iovec_batch(Rope const &r, Visitor &&visitor) {
+  std::array<iovec, iovec_batch_size::value> batch;
+  std::size_t count = 0;
+  std::size_t batches = 0;
+
+  r.for_each_piece([&](string_view piece) {
+    if (count == batch.size()) {
+      visitor(batch.data(), count);
+      ++batches;
+      count = 0;
+    }
+
+    batch[count].iov_base = const_cast<char *>(piece.data());
+    batch[count].iov_len = piece.size();
+    ++count;
+
+    return true;
+  });
+
+  if (count) {
+    visitor(batch.data(), count);
+    ++batches;
+  }
+
+  return batches;
+}
+
+/**
+ * Writes the contents of a rope (any class providing `for_each_piece()`, like
+ * `rope` and `shared_rope`) to the file descriptor `fd` using `writev()`, so
+ * that the rope never needs to be flattened into a contiguous buffer.
+ *
+ * Blocks until everything is written, resuming after partial writes and
+ * retrying when interrupted by a signal. Throws `std::system_error` if
+ * `writev()` fails or stops making progress.
+ *
+ * Returns the number of bytes written, which equals `r.size()`.
+ *
+ * Example:
+ *
+ *  rope<> response("HTTP/1.1 200 OK\r\n", headers, "\r\n", body);
+ *  write_rope(socket, response);
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+template <typename Rope>
+std::size_t write_rope(int fd, Rope const &r) {
+  std::size_t total = 0;
+
+  for_each_iovec_batch(r, [fd, &total](iovec *iov, std::size_t count) {
+    total += detail::rope_io_impl::write_all(fd, iov, iov + count);
+  });
+
+  assert(total == r.size());
+  return total;
+}
+
+} // namespace fatal {
+
+#endif // FATAL_INCLUDE_fatal_string_rope_io_h
@@ -0,0 +1,820 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef FATAL_INCLUDE_fatal_string_shared_rope_h
+#define FATAL_INCLUDE_fatal_string_shared_rope_h
+
+#include <fatal/math/hash.h>
+#include <fatal/portability.h>
+#include <fatal/string/string_view.h>
+#include <fatal/type/traits.h>
+
+#include <algorithm>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <cassert>
+#include <cstring>
+
+FATAL_DIAGNOSTIC_PUSH
+FATAL_GCC_DIAGNOSTIC_IGNORED_SHADOW_IF_BROKEN
+
+namespace fatal {
+namespace detail {
+namespace shared_rope_impl {
+
+////////////////////////////
+// IMPLEMENTATION DETAILS //
+////////////////////////////
+
+// an immutable node of a height-balanced concatenation tree
+//
+// leaves have no children and reference a piece of a string, optionally owned
+// (and shared) through `owner`. Internal nodes always have two children.
+struct node {
+  using size_type = std::size_t;
+  using height_type = unsigned;
+  using pointer = std::shared_ptr<node const>;
+  using owner_type = std::shared_ptr<std::string const>;
+
+  node(owner_type owner, string_view piece):
+    size(piece.size()),
+    pieces(1),
+    height(0),
+    owner(std::move(owner)),
+    piece(piece)
+  {
+    assert(size);
+  }
+
+  node(pointer l, pointer r):
+    size(l->size + r->size),
+    pieces(l->pieces + r->pieces),
+    height(1 + std::max(l->height, r->height)),
+    left(std::move(l)),
+    right(std::move(r))
+  {}
+
+  bool leaf() const { return !left; }
+
+  size_type const size;
+  size_type const pieces;
+  height_type const height;
+
+  pointer const left;
+  pointer const right;
+
+  owner_type const owner;
+  string_view const piece;
+};
+
+inline node::height_type height(node::pointer const &n) {
+  return n ? n->height : 0;
+}
+
+inline node::pointer make_leaf(node::owner_type owner, string_view piece) {
+  return piece.empty()
+    ? node::pointer()
+    : std::make_shared<node const>(std::move(owner), piece);
+}
+
+inline node::pointer make_leaf(std::string &&s) {
+  if (s.empty()) {
+    return node::pointer();
+  }
+
+  auto owner = std::make_shared<std::string const>(std::move(s));
+  string_view const piece(*owner);
+  return std::make_shared<node const>(std::move(owner), piece);
+}
+
+inline node::pointer make_node(node::pointer l, node::pointer r) {
+  assert(l);
+  assert(r);
+  return std::make_shared<node const>(std::move(l), std::move(r));
+}
+
+// creates a node out of two balanced siblings, coalescing small adjacent
+// leaves to keep the tree shallow when appending many tiny pieces
+//
+// merging two leaves yields another leaf, so this is only used where
+// replacing a leaf by another one can't break the balance of the tree
+template <std::size_t MergeThreshold>
+node::pointer make_joined(node::pointer l, node::pointer r) {
+  assert(l);
+  assert(r);
+
+  if (l->leaf() && r->leaf() && l->size + r->size <= MergeThreshold) {
+    std::string merged;
+    merged.reserve(l->size + r->size);
+    merged.append(l->piece.data(), l->piece.size());
+    merged.append(r->piece.data(), r->piece.size());
+    return make_leaf(std::move(merged));
+  }
+
+  return make_node(std::move(l), std::move(r));
+}
+
+inline node::pointer rotate_left(node::pointer const &n) {
+  assert(n && !n->leaf() && !n->right->leaf());
+  return make_node(make_node(n->left, n->right->left), n->right->right);
+}
+
+inline node::pointer rotate_right(node::pointer const &n) {
+  assert(n && !n->leaf() && !n->left->leaf());
+  return make_node(n->left->left, make_node(n->left->right, n->right));
+}
+
+// joins `l` and `r`, where `l` is more than one level taller than `r`
+template <std::size_t MergeThreshold>
+node::pointer join_right(node::pointer const &l, node::pointer const &r) {
+  assert(height(l) > height(r) + 1);
+  auto const &ll = l->left;
+  auto const &lr = l->right;
+
+  if (height(lr) <= height(r) + 1) {
+    auto const joined = make_joined<MergeThreshold>(lr, r);
+
+    if (height(joined) <= height(ll) + 1) {
+      return make_node(ll, joined);
+    }
+
+    return rotate_left(make_node(ll, rotate_right(joined)));
+  }
+
+  auto const joined = join_right<MergeThreshold>(lr, r);
+  auto result = make_node(ll, joined);
+
+  return height(joined) <= height(ll) + 1 ? result : rotate_left(result);
+}
+
+// joins `l` and `r`, where `r` is more than one level taller than `l`
+template <std::size_t MergeThreshold>
+node::pointer join_left(node::pointer const &l, node::pointer const &r) {
+  assert(height(r) > height(l) + 1);
+  auto const &rl = r->left;
+  auto const &rr = r->right;
+
+  if (height(rl) <= height(l) + 1) {
+    auto const joined = make_joined<MergeThreshold>(l, rl);
+
+    if (height(joined) <= height(rr) + 1) {
+      return make_node(joined, rr);
+    }
+
+    return rotate_right(make_node(rotate_left(joined), rr));
+  }
+
+  auto const joined = join_left<MergeThreshold>(l, rl);
+  auto result = make_node(joined, rr);
+
+  return height(joined) <= height(rr) + 1 ? result : rotate_right(result);
+}
+
+template <std::size_t MergeThreshold>
+node::pointer join(node::pointer const &l, node::pointer const &r) {
+  if (!l) { return r; }
+  if (!r) { return l; }
+
+  if (height(l) > height(r) + 1) {
+    return join_right<MergeThreshold>(l, r);
+  }
+
+  if (height(r) > height(l) + 1) {
+    return join_left<MergeThreshold>(l, r);
+  }
+
+  return make_joined<MergeThreshold>(l, r);
+}
+
+// splits `n` into the first `offset` characters and the remaining ones
+template <std::size_t MergeThreshold>
+std::pair<node::pointer, node::pointer> split(
+  node::pointer const &n,
+  node::size_type offset
+) {
+  using result_type = std::pair<node::pointer, node::pointer>;
+
+  if (!n || !offset) {
+    return result_type(node::pointer(), n);
+  }
+
+  if (offset >= n->size) {
+    return result_type(n, node::pointer());
+  }
+
+  if (n->leaf()) {
+    return result_type(
+      make_leaf(n->owner, n->piece.slice(0, offset)),
+      make_leaf(n->owner, n->piece.slice(offset, n->size))
+    );
+  }
+
+  auto const left = n->left->size;
+
+  if (offset == left) {
+    return result_type(n->left, n->right);
+  }
+
+  if (offset < left) {
+    auto parts = split<MergeThreshold>(n->left, offset);
+    return result_type(
+      std::move(parts.first),
+      join<MergeThreshold>(parts.second, n->right)
+    );
+  }
+
+  auto parts = split<MergeThreshold>(n->right, offset - left);
+  return result_type(
+    join<MergeThreshold>(n->left, parts.first),
+    std::move(parts.second)
+  );
+}
+
+template <typename Visitor>
+bool visit_pieces(node const *n, Visitor &visitor) {
+  while (!n->leaf()) {
+    if (!visit_pieces(n->left.get(), visitor)) {
+      return false;
+    }
+
+    n = n->right.get();
+  }
+
+  return visitor(n->piece);
+}
+
+} // namespace shared_rope_impl {
+} // namespace detail {
+
+/////////////////
+// shared_rope //
+/////////////////
+
+/**
+ * A rope whose pieces are kept as the leaves of a height-balanced binary tree
+ * of immutable, reference-counted nodes.
+ *
+ * As opposed to `rope`, inserting or erasing characters anywhere in the
+ * middle of the string, as well as obtaining a substring, take O(log n) time,
+ * where n is the number of pieces.
+ *
+ * Since nodes are never modified once created, copying a `shared_rope` is
+ * O(1): both copies share the whole tree, and any later modification only
+ * allocates the O(log n) nodes along the modified path, leaving the other
+ * copy untouched (copy-on-write). This makes it suitable for building
+ * strings out of fragments shared across many instances, like templated
+ * messages. The reference counts are thread-safe, so immutable instances can
+ * be shared across threads.
+ *
+ * Like `rope`, pieces can either be owned or referenced:
+ *
+ * 1. string_view: a reference to a portion of an existing string, which must
+ *    outlive all ropes referencing it. Results from appending or inserting a
+ *    string literal, a `string_view` or an lvalue `std::string`.
+ *
+ * 2. std::string: temporaries / rvalues are moved into a reference-counted
+ *    buffer owned by the rope and shared among all of its copies and
+ *    substrings.
+ *
+ * 3. char: single characters are copied into an owned piece.
+ *
+ * Adjacent pieces whose combined size doesn't exceed `MergeThreshold` are
+ * coalesced into an owned piece when they meet, so that appending many tiny
+ * pieces doesn't degrade the tree. Pass `0` to disable coalescing.
+ *
+ * Example:
+ *
+ *  shared_rope<> header("HTTP/1.1 200 OK\r\n");
+ *
+ *  // O(1), shares all pieces of `header`
+ *  auto response = header;
+ *  response.append(std::string("content-length: 5\r\n\r\nhello"));
+ *
+ *  // O(log n), `header` is left untouched
+ *  response.insert(9, "404 Not Found\r\n");
+ *  response.erase(24, 8);
+ *
+ *  // prints "HTTP/1.1 404 Not Found"
+ *  std::cout << response.substr(0, 22);
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+template <std::size_t MergeThreshold = 64>
+struct shared_rope {
+  using value_type = char;
+  using size_type = std::size_t;
+
+  /**
+   * The type used to represent the number of pieces stored in this rope.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  using piece_index = size_type;
+
+  using merge_threshold = std::integral_constant<size_type, MergeThreshold>;
+
+private:
+  using node = detail::shared_rope_impl::node;
+  using node_pointer = node::pointer;
+
+  explicit shared_rope(node_pointer root): root_(std::move(root)) {}
+
+public:
+  shared_rope() = default;
+
+  /**
+   * O(1): the copy shares all nodes with `rhs`.
+   */
+  shared_rope(shared_rope const &) = default;
+  shared_rope(shared_rope &&) = default;
+
+  /**
+   * Constructs a rope out of the given pieces.
+   *
+   * This is equivalent to default-constructing a rope, then calling
+   * `append()` on each of the given pieces.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  template <typename... Args, typename = safe_overload<shared_rope, Args...>>
+  explicit shared_rope(Args &&...args) {
+    multi_append(std::forward<Args>(args)...);
+  }
+
+  shared_rope &operator =(shared_rope const &) = default;
+  shared_rope &operator =(shared_rope &&) = default;
+
+  ///////////////
+  // accessors //
+  ///////////////
+
+  size_type size() const { return root_ ? root_->size : 0; }
+
+  bool empty() const { return !root_; }
+
+  /**
+   * The number of pieces contained in this rope.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  piece_index pieces() const { return root_ ? root_->pieces : 0; }
+
+  /**
+   * The height of the underlying tree. Useful for diagnostics.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  size_type height() const { return root_ ? root_->height : 0; }
+
+  /**
+   * Returns the `i-th` piece contained in this rope, in O(log n).
+   *
+   * Prefer `for_each_piece()` to iterate over all pieces.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  string_view piece(piece_index i) const {
+    assert(i < pieces());
+    auto n = root_.get();
+
+    while (!n->leaf()) {
+      auto const left = n->left->pieces;
+
+      if (i < left) {
+        n = n->left.get();
+      } else {
+        i -= left;
+        n = n->right.get();
+      }
+    }
+
+    assert(!i);
+    return n->piece;
+  }
+
+  /**
+   * Calls `visitor(piece)` for each piece of this rope, in order.
+   *
+   * The visitor may return `false` to stop the iteration early, in which case
+   * this function also returns `false`. Otherwise, returns `true`.
+   *
+   * Example:
+   *
+   *  std::string s;
+   *  r.for_each_piece([&](string_view piece) {
+   *    s.append(piece.data(), piece.size());
+   *    return true;
+   *  });
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  template <typename Visitor>
+  bool for_each_piece(Visitor &&visitor) const {
+    return !root_ || detail::shared_rope_impl::visit_pieces(
+      root_.get(), visitor
+    );
+  }
+
+  /**
+   * Returns the `i-th` character of the string represented by this rope, in
+   * O(log n).
+   *
+   * No bounds checking is performed.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  value_type operator [](size_type i) const {
+    assert(i < size());
+    auto n = root_.get();
+
+    while (!n->leaf()) {
+      auto const left = n->left->size;
+
+      if (i < left) {
+        n = n->left.get();
+      } else {
+        i -= left;
+        n = n->right.get();
+      }
+    }
+
+    return n->piece[i];
+  }
+
+  /**
+   * Returns the `i-th` character of the string represented by this rope, in
+   * O(log n).
+   *
+   * Throws `std::out_of_range` if `i` represents an invalid index.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  value_type at(size_type i) const {
+    if (i >= size()) {
+      throw std::out_of_range("at(): index out of bounds");
+    }
+
+    return (*this)[i];
+  }
+
+  value_type front() const { return (*this)[0]; }
+  value_type back() const { return (*this)[size() - 1]; }
+
+  ////////////
+  // append //
+  ////////////
+
+  /**
+   * Appends the given piece to the end of this rope, in O(log n).
+   *
+   * Temporary strings are owned by the rope, `string_view`s and lvalue
+   * strings are referenced and characters are copied.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  void append(std::string &&s) {
+    append_node(detail::shared_rope_impl::make_leaf(std::move(s)));
+  }
+
+  void append(string_view s) {
+    append_node(detail::shared_rope_impl::make_leaf(nullptr, s));
+  }
+
+  void append(char c) { append(std::string(1, c)); }
+
+  template <typename... Args, typename = safe_overload<shared_rope, Args...>>
+  void append(Args &&...args) {
+    append(string_view(std::forward<Args>(args)...));
+  }
+
+  /**
+   * Appends all pieces of `rhs` to the end of this rope, in O(log n).
+   *
+   * Pieces are shared, rather than copied.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  void append(shared_rope const &rhs) { append_node(rhs.root_); }
+
+  void push_back(char c) { append(c); }
+
+  /**
+   * Appends each of the given pieces to the end of this rope.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  template <typename... Args>
+  void multi_append(Args &&...args) {
+    multi_append_impl(std::forward<Args>(args)...);
+  }
+
+  ////////////
+  // insert //
+  ////////////
+
+  /**
+   * Inserts the given piece before the character at `offset`, in O(log n).
+   *
+   * Accepts the same kinds of pieces as `append()`, with the same ownership
+   * semantics.
+   *
+   * Throws `std::out_of_range` if `offset > size()`.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  void insert(size_type offset, std::string &&s) {
+    insert_node(offset, detail::shared_rope_impl::make_leaf(std::move(s)));
+  }
+
+  void insert(size_type offset, string_view s) {
+    insert_node(offset, detail::shared_rope_impl::make_leaf(nullptr, s));
+  }
+
+  void insert(size_type offset, char c) {
+    insert(offset, std::string(1, c));
+  }
+
+  template <typename T, typename = safe_overload<shared_rope, T>>
+  void insert(size_type offset, T &&s) {
+    insert(offset, string_view(std::forward<T>(s)));
+  }
+
+  void insert(size_type offset, shared_rope const &rhs) {
+    insert_node(offset, rhs.root_);
+  }
+
+  ///////////
+  // erase //
+  ///////////
+
+  /**
+   * Erases up to `count` characters, starting at `offset`, in O(log n).
+   *
+   * Throws `std::out_of_range` if `offset > size()`.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  void erase(size_type offset, size_type count = npos()) {
+    check_offset(offset, "erase(): offset out of bounds");
+    auto head = split(root_, offset);
+    root_ = join(head.first, split(head.second, count).second);
+  }
+
+  ////////////
+  // substr //
+  ////////////
+
+  /**
+   * Returns a rope representing up to `count` characters of this rope,
+   * starting at `offset`, in O(log n).
+   *
+   * The result shares its pieces with this rope.
+   *
+   * Throws `std::out_of_range` if `offset > size()`.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  shared_rope substr(size_type offset, size_type count = npos()) const {
+    check_offset(offset, "substr(): offset out of bounds");
+    return shared_rope(split(split(root_, offset).second, count).first);
+  }
+
+  ///////////
+  // clear //
+  ///////////
+
+  void clear() { root_.reset(); }
+
+  //////////
+  // copy //
+  //////////
+
+  /**
+   * Copies as much as possible of this rope's contents to the output
+   * range `[begin, end)`.
+   *
+   * Returns the pointer `e`, which is one element past the last one
+   * written, such that the written range lies within `[begin, e)`.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  char *copy(char *begin, char *end) const {
+    for_each_piece([&](string_view piece) {
+      piece.limit(static_cast<size_type>(end - begin));
+      begin = std::copy(piece.begin(), piece.end(), begin);
+      return begin != end;
+    });
+
+    return begin;
+  }
+
+  ////////////
+  // string //
+  ////////////
+
+  std::string to_string() const {
+    std::string s;
+    append_to(s);
+    return s;
+  }
+
+  template <typename String>
+  String &append_to(String &out) const {
+    out.reserve(out.size() + size());
+
+    for_each_piece([&out](string_view piece) {
+      out.append(piece.begin(), piece.end());
+      return true;
+    });
+
+    return out;
+  }
+
+  /////////////
+  // compare //
+  /////////////
+
+  /**
+   * Lexicographically compares the string represented by `rhs` to the string
+   * represented by this rope. Returns a negative integer when this rope is
+   * lexicographically smaller than `rhs`, a positive integer when this rope is
+   * lexicographically greater than `rhs` or 0 when they're equal.
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  int compare(string_view rhs) const {
+    int result = 0;
+
+    for_each_piece([&](string_view piece) {
+      auto const length = std::min(piece.size(), rhs.size());
+
+      if (length) {
+        result = std::memcmp(piece.data(), rhs.data(), length);
+      }
+
+      if (!result && length < piece.size()) {
+        result = 1;
+      }
+
+      rhs += length;
+      return !result;
+    });
+
+    return result ? result : -!rhs.empty();
+  }
+
+  template <typename T, typename = safe_overload<shared_rope, T>>
+  int compare(T &&rhs) const {
+    return compare(string_view(std::forward<T>(rhs)));
+  }
+
+  bool operator ==(string_view rhs) const {
+    return size() == rhs.size() && !compare(rhs);
+  }
+
+  bool operator ==(shared_rope const &rhs) const {
+    if (root_ == rhs.root_) {
+      return true;
+    }
+
+    if (size() != rhs.size()) {
+      return false;
+    }
+
+    std::vector<string_view> pieces;
+    pieces.reserve(rhs.pieces());
+    rhs.for_each_piece([&pieces](string_view piece) {
+      pieces.push_back(piece);
+      return true;
+    });
+
+    auto i = pieces.begin();
+    string_view right;
+
+    return for_each_piece([&](string_view left) {
+      while (left) {
+        if (!right) {
+          assert(i != pieces.end());
+          right = *i++;
+        }
+
+        auto const length = std::min(left.size(), right.size());
+
+        if (std::memcmp(left.data(), right.data(), length)) {
+          return false;
+        }
+
+        left += length;
+        right += length;
+      }
+
+      return true;
+    });
+  }
+
+  template <typename T, typename = safe_overload<shared_rope, T>>
+  bool operator ==(T &&rhs) const {
+    return *this == string_view(std::forward<T>(rhs));
+  }
+
+  template <typename T>
+  bool operator !=(T &&rhs) const { return !(*this == std::forward<T>(rhs)); }
+
+  struct hasher {
+    using argument = shared_rope;
+    using result_type = std::size_t;
+
+    result_type operator ()(shared_rope const &r) const {
+      bytes_hasher<result_type> inner_hasher;
+
+      r.for_each_piece([&inner_hasher](string_view piece) {
+        inner_hasher(piece.begin(), piece.end());
+        return true;
+      });
+
+      return *inner_hasher;
+    }
+  };
+
+private:
+  ////////////////////////////
+  // IMPLEMENTATION DETAILS //
+  ////////////////////////////
+
+  static constexpr size_type npos() { return ~size_type(0); }
+
+  static node_pointer join(node_pointer const &l, node_pointer const &r) {
+    return detail::shared_rope_impl::join<MergeThreshold>(l, r);
+  }
+
+  static std::pair<node_pointer, node_pointer> split(
+    node_pointer const &n,
+    size_type offset
+  ) {
+    return detail::shared_rope_impl::split<MergeThreshold>(n, offset);
+  }
+
+  void check_offset(size_type offset, char const *message) const {
+    if (offset > size()) {
+      throw std::out_of_range(message);
+    }
+  }
+
+  void append_node(node_pointer const &n) { root_ = join(root_, n); }
+
+  void insert_node(size_type offset, node_pointer const &n) {
+    check_offset(offset, "insert(): offset out of bounds");
+
+    if (!n) {
+      return;
+    }
+
+    auto parts = split(root_, offset);
+    root_ = join(join(parts.first, n), parts.second);
+  }
+
+  template <typename T, typename... Args>
+  void multi_append_impl(T &&s, Args &&...args) {
+    append(std::forward<T>(s));
+    multi_append_impl(std::forward<Args>(args)...);
+  }
+
+  void multi_append_impl() {}
+
+  node_pointer root_;
+};
+
+/////////////////////////////////////
+// operator <<(std::basic_ostream) //
+/////////////////////////////////////
+
+template <typename C, typename T, std::size_t MergeThreshold>
+std::ostream &operator <<(
+  std::basic_ostream<C, T> &out,
+  shared_rope<MergeThreshold> const &r
+) {
+  r.for_each_piece([&out](string_view piece) {
+    out.write(piece.data(), piece.size());
+    return true;
+  });
+
+  return out;
+}
+
+} // namespace fatal {
+
+FATAL_DIAGNOSTIC_POP
+
+#endif // FATAL_INCLUDE_fatal_string_shared_rope_h
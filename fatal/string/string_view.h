@@ -12,6 +12,7 @@
 
 #include <fatal/math/hash.h>
 #include <fatal/portability.h>
+#include <fatal/string/impl/string_view.h>
 #include <fatal/type/array.h>
 #include <fatal/type/call_traits.h>
 #include <fatal/type/size.h>
@@ -51,6 +52,125 @@ using safe_overload = typename std::enable_if<
 
 } // namespace detail {
 
+/**
+ * A set of characters, represented as a 256-bit lookup table, meant to be used
+ * with `string_view`'s `find_any_of` and `find_first_not_of`.
+ *
+ * The set can be built at compile time. Small sets (up to 16 characters) are
+ * additionally kept in a packed form so that searches can compare against all
+ * of them at once using SIMD instructions, when available.
+ *
+ * Example:
+ *
+ *  constexpr char_set whitespace(" \t\r\n");
+ *
+ *  // yields `true`
+ *  whitespace.contains('\t')
+ *
+ *  string_view v("hello,\tworld");
+ *
+ *  // yields a pointer to '\t'
+ *  v.find_any_of(whitespace)
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+struct char_set {
+  constexpr char_set(): char_set("", 0) {}
+
+  constexpr char_set(char const *s, std::size_t size):
+    bits_{
+      i_sv::cs_word(s, size, 0), i_sv::cs_word(s, size, 1),
+      i_sv::cs_word(s, size, 2), i_sv::cs_word(s, size, 3)
+    },
+    packed_{
+      i_sv::cs_at(s, size, 0), i_sv::cs_at(s, size, 1),
+      i_sv::cs_at(s, size, 2), i_sv::cs_at(s, size, 3),
+      i_sv::cs_at(s, size, 4), i_sv::cs_at(s, size, 5),
+      i_sv::cs_at(s, size, 6), i_sv::cs_at(s, size, 7),
+      i_sv::cs_at(s, size, 8), i_sv::cs_at(s, size, 9),
+      i_sv::cs_at(s, size, 10), i_sv::cs_at(s, size, 11),
+      i_sv::cs_at(s, size, 12), i_sv::cs_at(s, size, 13),
+      i_sv::cs_at(s, size, 14), i_sv::cs_at(s, size, 15)
+    },
+    size_(size)
+  {}
+
+  template <std::size_t N>
+  constexpr char_set(char const (&s)[N]):
+    char_set(s, N - (s[N - 1] == 0))
+  {}
+
+  constexpr bool contains(char c) const {
+    return (bits_[static_cast<unsigned char>(c) >> 6]
+      >> (static_cast<unsigned char>(c) & 63)) & 1;
+  }
+
+  /**
+   * The amount of characters the set was built from, including duplicates.
+   */
+  constexpr std::size_t size() const { return size_; }
+
+  constexpr bool empty() const { return !size_; }
+
+  /**
+   * Whether the set is small enough to be kept in its packed form.
+   */
+  constexpr bool packable() const {
+    return size_ && size_ <= i_sv::packed_set_size::value;
+  }
+
+  /**
+   * The packed form of the set. Only meaningful when `packable()` is `true`.
+   */
+  constexpr char const *packed() const { return packed_; }
+
+  /**
+   * Returns a copy of this set with the character `c` added to it.
+   *
+   * Example:
+   *
+   *  constexpr char_set delimiters(" ,");
+   *  constexpr auto special = delimiters.with('"');
+   *
+   *  // yields `true`
+   *  special.contains('"')
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  constexpr char_set with(char c) const { return char_set(*this, c); }
+
+private:
+  constexpr char_set(char_set const &base, char c):
+    bits_{
+      base.bits_[0] | i_sv::cs_bit(c, 0), base.bits_[1] | i_sv::cs_bit(c, 1),
+      base.bits_[2] | i_sv::cs_bit(c, 2), base.bits_[3] | i_sv::cs_bit(c, 3)
+    },
+    packed_{
+      base.packed_at(c, 0), base.packed_at(c, 1),
+      base.packed_at(c, 2), base.packed_at(c, 3),
+      base.packed_at(c, 4), base.packed_at(c, 5),
+      base.packed_at(c, 6), base.packed_at(c, 7),
+      base.packed_at(c, 8), base.packed_at(c, 9),
+      base.packed_at(c, 10), base.packed_at(c, 11),
+      base.packed_at(c, 12), base.packed_at(c, 13),
+      base.packed_at(c, 14), base.packed_at(c, 15)
+    },
+    size_(base.size_ + 1)
+  {}
+
+  // the packed form of this set with `c` appended to it
+  constexpr char packed_at(char c, std::size_t i) const {
+    return i < size_ ? packed_[i]
+      : i == size_ ? c
+      : size_ ? packed_[0]
+      : c;
+  }
+
+  std::uint64_t bits_[4];
+  char packed_[i_sv::packed_set_size::value];
+  std::size_t size_;
+};
+
 struct string_view {
   using value_type = char;
   using size_type = std::size_t;
@@ -137,6 +257,25 @@ struct string_view {
     return string_view(begin_ + offset, begin_ + end);
   }
 
+  /**
+   * Returns an iterator to the first occurrence of `needle` at or after
+   * `offset` (defaults to the beginning of the view), or `end()` if there's no
+   * such occurrence.
+   *
+   * Uses SIMD instructions when available.
+   *
+   * Example:
+   *
+   *  string_view v("hello, world");
+   *
+   *  // yields `v.begin() + 2`
+   *  v.find('l');
+   *
+   *  // yields `v.begin() + 10`
+   *  v.find('l', v.begin() + 4);
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
   const_iterator find(value_type needle) const {
     return find(needle, begin_);
   }
@@ -146,7 +285,107 @@ struct string_view {
     assert(begin_ <= offset);
     assert(offset <= end_);
 #   endif // __cplusplus > 201400
-    return std::find(offset, end_, needle);
+    return i_sv::search::find(offset, end_, needle);
+  }
+
+  /**
+   * Returns an iterator to the beginning of the first occurrence of the
+   * substring `needle` at or after `offset` (defaults to the beginning of the
+   * view), or `end()` if there's no such occurrence.
+   *
+   * An empty `needle` is found at `offset`.
+   *
+   * Example:
+   *
+   *  string_view v("hello, world");
+   *
+   *  // yields `v.begin() + 5`
+   *  v.find(", ");
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  const_iterator find(string_view needle) const {
+    return find(needle, begin_);
+  }
+
+  const_iterator find(string_view needle, const_iterator offset) const {
+    assert(begin_ <= offset);
+    assert(offset <= end_);
+    return i_sv::search::find(offset, end_, needle.data(), needle.size());
+  }
+
+  /**
+   * Returns an iterator to the first character at or after `offset` (defaults
+   * to the beginning of the view) that belongs to the given set, or `end()`
+   * if there's no such character.
+   *
+   * Example:
+   *
+   *  string_view v("hello, world");
+   *
+   *  // yields `v.begin() + 4`
+   *  v.find_any_of(" ,o");
+   *
+   * See also: `char_set`
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  const_iterator find_any_of(char_set const &set) const {
+    return find_any_of(set, begin_);
+  }
+
+  const_iterator find_any_of(
+    char_set const &set,
+    const_iterator offset
+  ) const {
+    assert(begin_ <= offset);
+    assert(offset <= end_);
+    return i_sv::search::find_any_of(offset, end_, set);
+  }
+
+  /**
+   * Returns an iterator to the first character at or after `offset` (defaults
+   * to the beginning of the view) that is different from `needle` or doesn't
+   * belong to the given set, or `end()` if there's no such character.
+   *
+   * Example:
+   *
+   *  string_view v("  \t hello");
+   *
+   *  // yields `v.begin() + 2`
+   *  v.find_first_not_of(' ');
+   *
+   *  // yields `v.begin() + 4`
+   *  v.find_first_not_of(" \t");
+   *
+   * See also: `char_set`
+   *
+   * @author: Marcelo Juchem <juchem@gmail.com>
+   */
+  const_iterator find_first_not_of(value_type needle) const {
+    return find_first_not_of(needle, begin_);
+  }
+
+  const_iterator find_first_not_of(
+    value_type needle,
+    const_iterator offset
+  ) const {
+    assert(begin_ <= offset);
+    assert(offset <= end_);
+    return i_sv::search::find_first_not_of(offset, end_, needle);
+  }
+
+  const_iterator find_first_not_of(char_set const &set) const {
+    return find_first_not_of(set, begin_);
+  }
+
+  const_iterator find_first_not_of(
+    char_set const &set,
+    const_iterator offset
+  ) const {
+    assert(begin_ <= offset);
+    assert(offset <= end_);
+    return i_sv::search::find_first_not_of(offset, end_, set);
   }
 
   /**
@@ -180,6 +419,8 @@ struct string_view {
    * Finds the first occurence of `delimiter`, removes all characters up to (and
    * including) such occurence and returns a reference to the view itself.
    *
+   * `delimiter` can either be a single character or a substring.
+   *
    * Example:
    *
    *  string_view v("hello, world");
@@ -198,10 +439,10 @@ struct string_view {
    * @author: Marcelo Juchem <juchem@gmail.com>
    */
   template <typename U>
-  string_view &skip_past(U &&delimiter) {
-    begin_ = find(std::forward<U>(delimiter));
+  string_view &skip_past(U const &delimiter) {
+    begin_ = find(delimiter);
     assert(begin_ <= end_);
-    if (begin_ != end_) { ++begin_; }
+    if (begin_ != end_) { begin_ += delimiter_size(delimiter); }
     return *this;
   }
 
@@ -238,6 +479,8 @@ struct string_view {
    * including) such occurence and returns the removed part (not including the
    * delimiter) as a separate view.
    *
+   * `delimiter` can either be a single character or a substring.
+   *
    * Example:
    *
    *  string_view v("hello, world");
@@ -254,9 +497,11 @@ struct string_view {
    * @author: Marcelo Juchem <juchem@gmail.com>
    */
   template <typename U>
-  string_view seek_past(U &&delimiter) {
-    string_view result(begin_, find(std::forward<U>(delimiter)));
-    begin_ = result.end() == end_ ? end_ : std::next(result.end());
+  string_view seek_past(U const &delimiter) {
+    string_view result(begin_, find(delimiter));
+    begin_ = result.end() == end_
+      ? end_
+      : std::next(result.end(), delimiter_size(delimiter));
     assert(begin_ <= end_);
     return result;
   }
@@ -514,6 +759,11 @@ struct string_view {
   };
 
 private:
+  static constexpr size_type delimiter_size(value_type) { return 1; }
+  static constexpr size_type delimiter_size(string_view delimiter) {
+    return delimiter.size();
+  }
+
   const_iterator begin_;
   const_iterator end_;
 };
@@ -531,6 +781,23 @@ string_view as_string_view() noexcept {
   return string_view(z_data<String>(), size<String>::value);
 }
 
+/**
+ * Builds a `char_set` out of the characters of a compile-time string, like the
+ * ones declared with `FATAL_S`.
+ *
+ * Example:
+ *
+ *  FATAL_S(whitespace, " \t\r\n");
+ *
+ *  constexpr auto set = as_char_set<whitespace>();
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+template <typename String>
+constexpr char_set as_char_set() noexcept {
+  return char_set(z_data<String>(), size<String>::value);
+}
+
 /////////////////
 // operator == //
 /////////////////
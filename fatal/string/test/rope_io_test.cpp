@@ -0,0 +1,191 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/string/rope_io.h>
+
+#include <fatal/string/rope.h>
+#include <fatal/string/shared_rope.h>
+
+#include <fatal/test/driver.h>
+
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <cstdio>
+
+#include <unistd.h>
+
+namespace fatal {
+
+struct temporary_file {
+  temporary_file(): file_(std::tmpfile()) {
+    FATAL_ASSERT_TRUE(file_ != nullptr);
+  }
+
+  temporary_file(temporary_file const &) = delete;
+
+  ~temporary_file() { std::fclose(file_); }
+
+  int fd() const { return fileno(file_); }
+
+  std::string contents() const {
+    FATAL_ASSERT_EQ(0, ::lseek(fd(), 0, SEEK_SET));
+
+    std::string result;
+    char buffer[4096];
+
+    for (ssize_t n; (n = ::read(fd(), buffer, sizeof(buffer))) > 0; ) {
+      result.append(buffer, static_cast<std::size_t>(n));
+    }
+
+    return result;
+  }
+
+private:
+  std::FILE *file_;
+};
+
+template <typename Rope>
+std::string gather(Rope const &r) {
+  std::string result;
+
+  for_each_iovec_batch(r, [&](iovec const *iov, std::size_t count) {
+    FATAL_EXPECT_LT(0, count);
+    FATAL_EXPECT_LE(count, iovec_batch_size::value);
+
+    for (auto i = iov, end = iov + count; i != end; ++i) {
+      result.append(static_cast<char const *>(i->iov_base), i->iov_len);
+    }
+  });
+
+  return result;
+}
+
+FATAL_TEST(rope_io, for_each_iovec_batch) {
+  std::string const world("world");
+  rope<> r("hello", ',', ' ', world, std::string("!"));
+
+  FATAL_EXPECT_EQ("hello, world!", gather(r));
+  FATAL_EXPECT_EQ(
+    1,
+    for_each_iovec_batch(r, [](iovec const *, std::size_t count) {
+      FATAL_EXPECT_LT(0, count);
+    })
+  );
+
+  rope<> empty;
+  FATAL_EXPECT_EQ("", gather(empty));
+  FATAL_EXPECT_EQ(
+    0,
+    for_each_iovec_batch(empty, [](iovec const *, std::size_t) {})
+  );
+}
+
+FATAL_TEST(rope_io, write_rope) {
+  std::string const world("world");
+  rope<> r("hello", ',', ' ', world, std::string("!"));
+
+  temporary_file file;
+  FATAL_EXPECT_EQ(r.size(), write_rope(file.fd(), r));
+  FATAL_EXPECT_EQ("hello, world!", file.contents());
+}
+
+FATAL_TEST(rope_io, more_pieces_than_batch_size) {
+  auto const pieces = iovec_batch_size::value * 2 + 17;
+  std::string const piece("0123456789");
+
+  rope<> r;
+  std::string expected;
+
+  for (std::size_t i = 0; i < pieces; ++i) {
+    r.append(string_view(piece.data(), i % piece.size() + 1));
+    expected.append(piece.data(), i % piece.size() + 1);
+  }
+
+  FATAL_EXPECT_EQ(pieces, r.pieces());
+  FATAL_EXPECT_EQ(expected, gather(r));
+  FATAL_EXPECT_EQ(
+    3,
+    for_each_iovec_batch(r, [](iovec const *, std::size_t) {})
+  );
+
+  temporary_file file;
+  FATAL_EXPECT_EQ(expected.size(), write_rope(file.fd(), r));
+  FATAL_EXPECT_EQ(expected, file.contents());
+}
+
+FATAL_TEST(rope_io, write_all_skips_empty_entries) {
+  char const data[] = "hello";
+  iovec iov[] = {
+    {nullptr, 0},
+    {const_cast<char *>(data), 5},
+    {nullptr, 0}
+  };
+
+  std::size_t calls = 0;
+  auto const writer = [&](iovec const *i, int count) -> ssize_t {
+    ++calls;
+    FATAL_EXPECT_TRUE(i->iov_base == data);
+    FATAL_EXPECT_EQ(2, count);
+    return 5;
+  };
+
+  FATAL_EXPECT_EQ(
+    5,
+    detail::rope_io_impl::write_all(writer, iov, iov + 3)
+  );
+  FATAL_EXPECT_EQ(1, calls);
+
+  // nothing but empty entries never calls the writer
+  FATAL_EXPECT_EQ(
+    0,
+    detail::rope_io_impl::write_all(writer, iov, iov + 1)
+  );
+  FATAL_EXPECT_EQ(1, calls);
+}
+
+FATAL_TEST(rope_io, write_all_without_progress) {
+  char data[] = "hello";
+  iovec iov[] = {{data, 5}};
+
+  std::size_t calls = 0;
+  auto const writer = [&](iovec const *, int) -> ssize_t {
+    return calls++ ? 0 : 2;
+  };
+
+  FATAL_EXPECT_THROW(std::system_error) {
+    detail::rope_io_impl::write_all(writer, iov, iov + 1);
+  };
+  FATAL_EXPECT_EQ(2, calls);
+}
+
+FATAL_TEST(rope_io, shared_rope) {
+  shared_rope<0> r(std::string("HTTP/1.1 200 OK\r\n"));
+  std::string expected(r.to_string());
+
+  for (std::size_t i = 0; i < 2000; ++i) {
+    auto header = "x-header-" + std::to_string(i) + ": value\r\n";
+    expected.append(header);
+    r.append(std::move(header));
+  }
+
+  FATAL_EXPECT_EQ(expected, gather(r));
+
+  temporary_file file;
+  FATAL_EXPECT_EQ(expected.size(), write_rope(file.fd(), r));
+  FATAL_EXPECT_EQ(expected, file.contents());
+}
+
+FATAL_TEST(rope_io, error) {
+  rope<> r("hello");
+  FATAL_EXPECT_THROW(std::system_error) { write_rope(-1, r); };
+}
+
+} // namespace fatal {
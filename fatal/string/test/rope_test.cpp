@@ -9,6 +9,8 @@
 
 #include <fatal/string/rope.h>
 
+#include <fatal/container/arena.h>
+
 #include <fatal/test/driver.h>
 
 #include <fatal/utility/timed_iterations.h>
@@ -1920,6 +1922,138 @@ FATAL_TEST(rope, hasher) {
 # undef TEST_IMPL
 }
 
+FATAL_TEST(rope, hash) {
+# define TEST_IMPL(...) \
+  do { \
+    rope<> r1(__VA_ARGS__); \
+    rope<> r2(to_string(__VA_ARGS__)); \
+    FATAL_EXPECT_EQ(r1.hash(), r2.hash()); \
+    FATAL_EXPECT_EQ(r1.hash(), r1.mimic().hash()); \
+    rope<> r3; \
+    r3.concat(r1); \
+    FATAL_EXPECT_EQ(r1.hash(), r3.hash()); \
+  } while (false)
+
+  TEST_IMPL_SINGLE_STRING(TEST_IMPL);
+
+# undef TEST_IMPL
+
+  std::string const hello("hello");
+  std::string const world("world");
+
+  rope<> empty;
+  FATAL_EXPECT_EQ(empty.hash(), rope<>().hash());
+  FATAL_EXPECT_NE(empty.hash(), rope<>('\0').hash());
+  FATAL_EXPECT_NE(rope<>('\0').hash(), rope<>('\0', '\0').hash());
+  FATAL_EXPECT_NE(rope<>("ab").hash(), rope<>("ba").hash());
+  FATAL_EXPECT_NE(rope<>(hello).hash(), rope<>(world).hash());
+
+  rope<> incremental(hello);
+  incremental.hash();
+  incremental.append(", ");
+  incremental.hash();
+  incremental.append(world);
+  FATAL_EXPECT_EQ(rope<>("hello, world").hash(), incremental.hash());
+
+  rope<> lhs(hello, ", ");
+  rope<> rhs(world, '!');
+  lhs.hash();
+  rhs.hash();
+  lhs.concat(std::move(rhs));
+  FATAL_EXPECT_EQ(rope<>("hello, world!").hash(), lhs.hash());
+  FATAL_EXPECT_EQ(rope<>().hash(), rhs.hash());
+
+  lhs.concat(lhs);
+  FATAL_EXPECT_EQ(
+    rope<>("hello, world!hello, world!").hash(),
+    lhs.hash()
+  );
+
+  lhs.clear();
+  FATAL_EXPECT_EQ(rope<>().hash(), lhs.hash());
+  lhs.append(world);
+  FATAL_EXPECT_EQ(rope<>(world).hash(), lhs.hash());
+}
+
+FATAL_TEST(rope, hash_is_cached) {
+  std::string s("hello");
+  rope<> r(s, ", world");
+
+  auto const expected = r.hash();
+
+  // the piece isn't hashed again, so the change goes unnoticed
+  s[0] = 'j';
+  FATAL_EXPECT_EQ(expected, r.hash());
+  FATAL_EXPECT_NE(expected, rope<>("jello, world").hash());
+
+  // concatenated pieces reuse the cached hashes from the source rope
+  rope<> other;
+  other.hash();
+  other.concat(r);
+  FATAL_EXPECT_EQ(expected, other.hash());
+}
+
+FATAL_TEST(rope, hasher_is_not_cached) {
+  using hasher = rope<>::hasher;
+
+  std::string s("hello");
+  rope<> const r(s, ", world");
+
+  auto const before = hasher()(r);
+  FATAL_EXPECT_EQ(rope<>("hello, world").hash(), before);
+
+  // the hasher didn't cache the piece, so the change is noticed
+  s[0] = 'j';
+  FATAL_EXPECT_EQ(rope<>("jello, world").hash(), hasher()(r));
+  FATAL_EXPECT_EQ(hasher()(r), r.hash());
+
+  // the hasher reuses the hashes cached by `hash()`
+  s[0] = 'h';
+  FATAL_EXPECT_EQ(rope<>("jello, world").hash(), hasher()(r));
+}
+
+///////////
+// arena //
+///////////
+
+FATAL_TEST(rope, arena) {
+  using arena_rope = rope<3, arena_allocator<char>>;
+
+  std::string const world("world");
+  monotonic_arena arena;
+  arena_allocator<char> allocator(arena);
+
+  {
+    arena_rope r(std::allocator_arg, allocator, "hello", ',', ' ');
+    FATAL_EXPECT_TRUE(r.get_allocator() == allocator);
+    FATAL_EXPECT_EQ(0, arena.allocated());
+
+    // spills past the small buffer
+    r.append(world);
+    FATAL_EXPECT_LT(0, arena.allocated());
+
+    auto const before = arena.allocated();
+    r.append(std::string(100, '!'));
+    FATAL_EXPECT_LE(before + 100, arena.allocated());
+
+    auto const expected = "hello, world" + std::string(100, '!');
+    FATAL_EXPECT_EQ(expected, r.to_string());
+    FATAL_EXPECT_EQ(rope<>(expected).hash(), r.hash());
+
+    auto copy = r.mimic();
+    FATAL_EXPECT_TRUE(copy.get_allocator() == allocator);
+    FATAL_EXPECT_TRUE(copy == r);
+
+    arena_rope other(std::allocator_arg, allocator);
+    other.concat(std::move(copy));
+    FATAL_EXPECT_TRUE(other == expected);
+    FATAL_EXPECT_TRUE(copy.empty());
+  }
+
+  arena.release();
+  FATAL_EXPECT_EQ(0, arena.allocated());
+}
+
 /////////////
 // ostream //
 /////////////
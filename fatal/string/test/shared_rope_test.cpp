@@ -0,0 +1,253 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/string/shared_rope.h>
+
+#include <fatal/test/driver.h>
+
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace fatal {
+
+template <std::size_t MergeThreshold>
+void check_balance(shared_rope<MergeThreshold> const &r) {
+  auto const pieces = r.pieces();
+  std::size_t log2 = 0;
+
+  for (auto n = pieces; n > 1; n >>= 1) {
+    ++log2;
+  }
+
+  // an AVL tree with n leaves has height at most ~1.44 lg n
+  FATAL_EXPECT_LE(r.height(), (log2 + 1) * 3 / 2 + 1);
+}
+
+template <std::size_t MergeThreshold>
+std::string piecewise(shared_rope<MergeThreshold> const &r) {
+  std::string result;
+
+  for (std::size_t i = 0; i < r.pieces(); ++i) {
+    auto const piece = r.piece(i);
+    result.append(piece.data(), piece.size());
+  }
+
+  return result;
+}
+
+FATAL_TEST(shared_rope, sanity_check) {
+  std::string const world("world");
+  shared_rope<> r(std::string("hello"), ", ", world, '!');
+  std::string const expected("hello, world!");
+
+  FATAL_EXPECT_EQ(expected.size(), r.size());
+  FATAL_EXPECT_FALSE(r.empty());
+  FATAL_EXPECT_EQ(expected, r.to_string());
+  FATAL_EXPECT_EQ(expected, piecewise(r));
+  FATAL_EXPECT_TRUE(r == expected);
+  FATAL_EXPECT_TRUE(r == "hello, world!");
+  FATAL_EXPECT_TRUE(r != "hello, world");
+  FATAL_EXPECT_EQ('h', r.front());
+  FATAL_EXPECT_EQ('!', r.back());
+  FATAL_EXPECT_EQ('w', r[7]);
+  FATAL_EXPECT_EQ('w', r.at(7));
+  FATAL_EXPECT_THROW(std::out_of_range) { r.at(expected.size()); };
+
+  std::ostringstream ss;
+  ss << r;
+  FATAL_EXPECT_EQ(expected, ss.str());
+
+  shared_rope<> empty;
+  FATAL_EXPECT_TRUE(empty.empty());
+  FATAL_EXPECT_EQ(0, empty.size());
+  FATAL_EXPECT_EQ(0, empty.pieces());
+  FATAL_EXPECT_TRUE(empty == "");
+}
+
+FATAL_TEST(shared_rope, copy_on_write) {
+  shared_rope<0> header("HTTP/1.1 200 OK\r\n");
+
+  auto response = header;
+  FATAL_EXPECT_TRUE(response == header);
+
+  response.append(std::string("content-length: 5\r\n\r\nhello"));
+  response.insert(9, "404 Not Found\r\n");
+  response.erase(24, 8);
+
+  FATAL_EXPECT_EQ("HTTP/1.1 200 OK\r\n", header.to_string());
+  FATAL_EXPECT_EQ(
+    "HTTP/1.1 404 Not Found\r\ncontent-length: 5\r\n\r\nhello",
+    response.to_string()
+  );
+  FATAL_EXPECT_EQ("HTTP/1.1 404 Not Found", response.substr(0, 22).to_string());
+  FATAL_EXPECT_FALSE(response == header);
+
+  // referenced pieces are shared, not copied
+  FATAL_EXPECT_TRUE(header.piece(0).data() == response.piece(0).data());
+}
+
+FATAL_TEST(shared_rope, owned_pieces_outlive_source) {
+  shared_rope<> r;
+
+  {
+    shared_rope<> source(std::string("temporary string that will go away"));
+    r = source.substr(10, 6);
+    r.append(source.substr(0, 9));
+  }
+
+  FATAL_EXPECT_EQ("stringtemporary", r.to_string());
+}
+
+FATAL_TEST(shared_rope, out_of_bounds) {
+  shared_rope<> r("abc");
+  FATAL_EXPECT_THROW(std::out_of_range) { r.insert(4, "x"); };
+  FATAL_EXPECT_THROW(std::out_of_range) { r.erase(4); };
+  FATAL_EXPECT_THROW(std::out_of_range) { r.substr(4); };
+
+  r.insert(3, "d");
+  r.erase(1, 100);
+  FATAL_EXPECT_EQ("a", r.to_string());
+  FATAL_EXPECT_EQ("", r.substr(1).to_string());
+}
+
+FATAL_TEST(shared_rope, merge_small_pieces) {
+  shared_rope<> merged;
+  shared_rope<0> unmerged;
+
+  for (std::size_t i = 0; i < 1000; ++i) {
+    auto const c = static_cast<char>('a' + i % 26);
+    merged.push_back(c);
+    unmerged.push_back(c);
+  }
+
+  FATAL_EXPECT_TRUE(merged == unmerged.to_string());
+  FATAL_EXPECT_EQ(1000, unmerged.pieces());
+  FATAL_EXPECT_LT(merged.pieces(), 100);
+  check_balance(merged);
+  check_balance(unmerged);
+}
+
+template <std::size_t MergeThreshold>
+void randomized_test() {
+  std::mt19937 rng(42);
+  std::string const source("the quick brown fox jumps over the lazy dog");
+
+  shared_rope<MergeThreshold> r;
+  std::string expected;
+
+  for (std::size_t i = 0; i < 2000; ++i) {
+    auto const offset = rng() % (expected.size() + 1);
+    auto const length = rng() % source.size();
+    string_view const piece(source.data(), length);
+
+    switch (rng() % 6) {
+      case 0:
+        r.append(piece);
+        expected.append(piece.data(), piece.size());
+        break;
+
+      case 1:
+        r.insert(offset, std::string(piece.data(), piece.size()));
+        expected.insert(offset, piece.data(), piece.size());
+        break;
+
+      case 2:
+        r.insert(offset, piece);
+        expected.insert(offset, piece.data(), piece.size());
+        break;
+
+      case 3:
+        r.erase(offset, length);
+        expected.erase(offset, length);
+        break;
+
+      case 4: {
+        auto const sub = r.substr(offset, length);
+        FATAL_EXPECT_EQ(expected.substr(offset, length), sub.to_string());
+        auto const at = rng() % (expected.size() + 1);
+        r.insert(at, sub);
+        expected.insert(at, expected.substr(offset, length));
+        break;
+      }
+
+      case 5: {
+        auto copy = r;
+        copy.erase(0, offset);
+        FATAL_EXPECT_EQ(expected, r.to_string());
+        r = copy;
+        expected.erase(0, offset);
+        break;
+      }
+    }
+
+    FATAL_ASSERT_EQ(expected.size(), r.size());
+
+    if (i % 100 == 0) {
+      FATAL_EXPECT_EQ(expected, r.to_string());
+      FATAL_EXPECT_EQ(expected, piecewise(r));
+      check_balance(r);
+
+      if (!expected.empty()) {
+        auto const at = rng() % expected.size();
+        FATAL_EXPECT_EQ(expected[at], r[at]);
+      }
+    }
+
+    if (expected.size() > 4096) {
+      r.erase(0, 2048);
+      expected.erase(0, 2048);
+    }
+  }
+
+  FATAL_EXPECT_EQ(expected, r.to_string());
+  check_balance(r);
+}
+
+FATAL_TEST(shared_rope, randomized) {
+  randomized_test<0>();
+  randomized_test<8>();
+  randomized_test<64>();
+}
+
+FATAL_TEST(shared_rope, compare) {
+  shared_rope<0> r("abc", "def");
+  FATAL_EXPECT_EQ(0, r.compare("abcdef"));
+  FATAL_EXPECT_LT(r.compare("abcdeg"), 0);
+  FATAL_EXPECT_GT(r.compare("abcdee"), 0);
+  FATAL_EXPECT_GT(r.compare("abcde"), 0);
+  FATAL_EXPECT_LT(r.compare("abcdefg"), 0);
+
+  shared_rope<0> other("ab", "cd", "ef");
+  FATAL_EXPECT_TRUE(r == other);
+  other.erase(5);
+  FATAL_EXPECT_FALSE(r == other);
+  other.push_back('g');
+  FATAL_EXPECT_FALSE(r == other);
+}
+
+FATAL_TEST(shared_rope, copy) {
+  shared_rope<0> r("hello", ", ", "world");
+  char buffer[8];
+  auto const end = r.copy(buffer, buffer + sizeof(buffer));
+  FATAL_EXPECT_EQ(sizeof(buffer), std::distance(buffer, end));
+  FATAL_EXPECT_EQ("hello, w", std::string(buffer, end));
+}
+
+FATAL_TEST(shared_rope, hasher) {
+  shared_rope<0> a("hello", ", ", "world");
+  shared_rope<0> b("hel", "lo, wor", "ld");
+  using hasher = shared_rope<0>::hasher;
+  FATAL_EXPECT_EQ(hasher()(a), hasher()(b));
+}
+
+} // namespace fatal {
@@ -11,6 +11,9 @@
 
 #include <fatal/test/driver.h>
 
+#include <algorithm>
+#include <string>
+
 namespace fatal {
 
 #define TEST_IMPL(Haystack, Result, Remaining, Operation, ...) \
@@ -32,6 +35,11 @@ FATAL_TEST(string_view, seek_past) {
   TEST_IMPL("hello, world", "he", "lo, world", seek_past, 'l');
   TEST_IMPL("hello, world", "", "ello, world", seek_past, 'h');
   TEST_IMPL("hello, world", "hello, worl", "", seek_past, 'd');
+
+  TEST_IMPL("hello, world", "hello", "world", seek_past, ", ");
+  TEST_IMPL("hello, world", "hello, world", "", seek_past, "xyz");
+  TEST_IMPL("hello, world", "", "llo, world", seek_past, "he");
+  TEST_IMPL("hello, world", "hello, wor", "", seek_past, "ld");
 }
 
 FATAL_TEST(string_view, seek_for) {
@@ -81,6 +89,10 @@ FATAL_TEST(string_view, skip_past) {
   TEST_IMPL("hello, world", "lo, world", skip_past, 'l');
   TEST_IMPL("hello, world", "ello, world", skip_past, 'h');
   TEST_IMPL("hello, world", "", skip_past, 'd');
+
+  TEST_IMPL("hello, world", "world", skip_past, ", ");
+  TEST_IMPL("hello, world", "", skip_past, "xyz");
+  TEST_IMPL("hello, world", "o, world", skip_past, "ll");
 }
 
 FATAL_TEST(string_view, skip_to) {
@@ -110,4 +122,188 @@ FATAL_TEST(string_view, skip) {
 
 #undef TEST_IMPL
 
+////////////
+// search //
+////////////
+
+namespace {
+
+std::string search_haystack(std::size_t size) {
+  std::string result;
+  result.reserve(size);
+
+  for (std::size_t i = 0; i < size; ++i) {
+    result.push_back(static_cast<char>('a' + (i * 7 + i / 5) % 23));
+  }
+
+  return result;
+}
+
+template <typename Search>
+void check_search_kernels() {
+  char const set[] = "xyz,";
+  char_set const cs(set);
+  char_set const wide("ABCDEFGHIJKLMNOPQRSTUVWXYZ");
+
+  for (std::size_t size = 0; size < 200; ++size) {
+    auto const base = search_haystack(size);
+
+    for (std::size_t at = 0; at <= size; ++at) {
+      auto s = base;
+      if (at < size) {
+        s[at] = 'x';
+      }
+      auto const b = s.data();
+      auto const e = b + s.size();
+
+      FATAL_EXPECT_EQ(
+        std::distance(b, std::find(b, e, 'x')),
+        std::distance(b, Search::find(b, e, 'x'))
+      );
+
+      FATAL_EXPECT_EQ(
+        std::distance(b, std::find_first_of(b, e, set, set + 4)),
+        std::distance(b, Search::find_any_of(b, e, cs))
+      );
+
+      FATAL_EXPECT_EQ(
+        std::distance(b, std::find_first_of(b, e, set, set + 4)),
+        std::distance(b, Search::find_any_of(b, e, char_set("x")))
+      );
+
+      FATAL_EXPECT_EQ(0, std::distance(e, Search::find_any_of(b, e, wide)));
+
+      std::string run(size, ' ');
+      if (at < size) {
+        run[at] = '\t';
+      }
+
+      FATAL_EXPECT_EQ(
+        static_cast<std::ptrdiff_t>(at),
+        std::distance(
+          run.data(),
+          Search::find_first_not_of(run.data(), run.data() + size, ' ')
+        )
+      );
+
+      std::string mixed(size, ' ');
+      for (std::size_t i = 0; i < size; i += 3) {
+        mixed[i] = '\r';
+      }
+      if (at < size) {
+        mixed[at] = '!';
+      }
+
+      FATAL_EXPECT_EQ(
+        static_cast<std::ptrdiff_t>(at),
+        std::distance(
+          mixed.data(),
+          Search::find_first_not_of(
+            mixed.data(), mixed.data() + size, char_set(" \r")
+          )
+        )
+      );
+
+      for (std::size_t length = 0; length <= 5 && at + length <= size;
+        ++length
+      ) {
+        auto const needle = s.substr(at, length);
+        FATAL_EXPECT_EQ(
+          s.find(needle),
+          static_cast<std::size_t>(
+            std::distance(
+              b, Search::find(b, e, needle.data(), needle.size())
+            )
+          )
+        );
+      }
+
+      FATAL_EXPECT_EQ(
+        std::string::npos == s.find("xq") ? size : s.find("xq"),
+        static_cast<std::size_t>(
+          std::distance(b, Search::find(b, e, "xq", 2))
+        )
+      );
+    }
+  }
+}
+
+} // namespace {
+
+FATAL_TEST(string_view, char_set) {
+  constexpr char_set cs(" \t,");
+  static_assert(cs.contains(' '), "");
+  static_assert(cs.contains('\t'), "");
+  static_assert(cs.contains(','), "");
+  static_assert(!cs.contains('\n'), "");
+  static_assert(cs.packable(), "");
+  FATAL_EXPECT_EQ(3, cs.size());
+
+  constexpr auto quoted = cs.with('"');
+  static_assert(quoted.contains('"'), "");
+  static_assert(quoted.contains(','), "");
+  static_assert(!cs.contains('"'), "");
+  FATAL_EXPECT_EQ(4, quoted.size());
+  FATAL_EXPECT_EQ('"', quoted.packed()[3]);
+
+  constexpr auto single = char_set().with('x');
+  static_assert(single.contains('x'), "");
+  static_assert(single.packable(), "");
+  FATAL_EXPECT_EQ('x', single.packed()[0]);
+  FATAL_EXPECT_EQ('x', single.packed()[15]);
+
+  char_set const high("\xff\x80");
+  FATAL_EXPECT_TRUE(high.contains('\xff'));
+  FATAL_EXPECT_TRUE(high.contains('\x80'));
+  FATAL_EXPECT_FALSE(high.contains('\x7f'));
+  FATAL_EXPECT_FALSE(high.contains('\0'));
+
+  char_set const empty("");
+  FATAL_EXPECT_TRUE(empty.empty());
+  FATAL_EXPECT_FALSE(empty.packable());
+  FATAL_EXPECT_FALSE(empty.contains('\0'));
+
+  char_set const big("abcdefghijklmnopqrstuvwxyz");
+  FATAL_EXPECT_FALSE(big.packable());
+  FATAL_EXPECT_TRUE(big.contains('q'));
+  FATAL_EXPECT_FALSE(big.contains('Q'));
+}
+
+FATAL_TEST(string_view, find) {
+  string_view v("hello, world");
+  FATAL_EXPECT_EQ(2, std::distance(v.begin(), v.find('l')));
+  FATAL_EXPECT_EQ(10, std::distance(v.begin(), v.find('l', v.begin() + 4)));
+  FATAL_EXPECT_EQ(v.end(), v.find('z'));
+  FATAL_EXPECT_EQ(5, std::distance(v.begin(), v.find(", ")));
+  FATAL_EXPECT_EQ(v.end(), v.find("world!"));
+  FATAL_EXPECT_EQ(v.begin() + 3, v.find("", v.begin() + 3));
+}
+
+FATAL_TEST(string_view, find_any_of) {
+  string_view v("hello, world");
+  FATAL_EXPECT_EQ(4, std::distance(v.begin(), v.find_any_of(" ,o")));
+  FATAL_EXPECT_EQ(6, std::distance(v.begin(), v.find_any_of(char_set(" "))));
+  FATAL_EXPECT_EQ(
+    8, std::distance(v.begin(), v.find_any_of(" ,o", v.begin() + 7))
+  );
+  FATAL_EXPECT_EQ(v.end(), v.find_any_of("xyz"));
+  FATAL_EXPECT_EQ(v.end(), v.find_any_of(""));
+}
+
+FATAL_TEST(string_view, find_first_not_of) {
+  string_view v("  \t hello");
+  FATAL_EXPECT_EQ(2, std::distance(v.begin(), v.find_first_not_of(' ')));
+  FATAL_EXPECT_EQ(4, std::distance(v.begin(), v.find_first_not_of(" \t")));
+  FATAL_EXPECT_EQ(v.begin(), v.find_first_not_of(""));
+  FATAL_EXPECT_EQ(v.end(), v.find_first_not_of(" \thelo"));
+}
+
+FATAL_TEST(string_view, scalar_search_kernels) {
+  check_search_kernels<i_sv::scalar_search>();
+}
+
+FATAL_TEST(string_view, search_kernels) {
+  check_search_kernels<i_sv::search>();
+}
+
 } // namespace fatal {
@@ -9,8 +9,11 @@
 
 #include <fatal/string/tokenizer.h>
 
+#include <fatal/type/sequence.h>
+
 #include <fatal/test/driver.h>
 
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -95,4 +98,125 @@ FATAL_TEST(tokenizer, csv) {
   );
 }
 
+FATAL_S(stream_delimiters, " \t,");
+
+template <typename Tokenizer>
+std::vector<std::string> stream_tokenize(
+  std::string const &data,
+  std::vector<std::size_t> const &splits
+) {
+  std::vector<std::string> result;
+  auto const visitor = [&result](string_view token) {
+    result.emplace_back(token.data(), token.size());
+  };
+
+  Tokenizer tokenizer;
+  std::size_t offset = 0;
+
+  for (auto split: splits) {
+    tokenizer(string_view(data.data() + offset, split - offset), visitor);
+    offset = split;
+  }
+
+  tokenizer(string_view(data.data() + offset, data.size() - offset), visitor);
+  tokenizer.finish(visitor);
+
+  return result;
+}
+
+template <typename Tokenizer>
+void stream_tokenizer_test(
+  std::string const &data,
+  std::vector<std::string> const &expected
+) {
+  FATAL_EXPECT_EQ(expected, stream_tokenize<Tokenizer>(data, {}));
+
+  for (std::size_t i = 0; i <= data.size(); ++i) {
+    FATAL_EXPECT_EQ(expected, stream_tokenize<Tokenizer>(data, {i}));
+
+    for (std::size_t j = i; j <= data.size(); ++j) {
+      FATAL_EXPECT_EQ(expected, stream_tokenize<Tokenizer>(data, {i, j}));
+    }
+  }
+
+  std::vector<std::size_t> bytes;
+  for (std::size_t i = 0; i <= data.size(); ++i) {
+    bytes.push_back(i);
+  }
+  FATAL_EXPECT_EQ(expected, stream_tokenize<Tokenizer>(data, bytes));
+}
+
+FATAL_TEST(stream_tokenizer, delimiters) {
+  using tokenizer = stream_tokenizer<stream_delimiters>;
+
+  stream_tokenizer_test<tokenizer>("", {});
+  stream_tokenizer_test<tokenizer>("a", {"a"});
+  stream_tokenizer_test<tokenizer>("a,", {"a"});
+  stream_tokenizer_test<tokenizer>(",", {""});
+  stream_tokenizer_test<tokenizer>(
+    "1,2 3\t4,,5 \"6,7\" 8\\,9",
+    {"1", "2", "3", "4", "", "5", "\"6", "7\"", "8\\", "9"}
+  );
+  stream_tokenizer_test<tokenizer>(
+    "the quick\tbrown fox,jumps over the lazy dog and keeps on running",
+    {
+      "the", "quick", "brown", "fox", "jumps", "over", "the", "lazy", "dog",
+      "and", "keeps", "on", "running"
+    }
+  );
+}
+
+FATAL_TEST(stream_tokenizer, quote) {
+  using tokenizer = stream_tokenizer<stream_delimiters, '"'>;
+
+  stream_tokenizer_test<tokenizer>("\"\"", {"\"\""});
+  stream_tokenizer_test<tokenizer>("\"a,b\"", {"\"a,b\""});
+  stream_tokenizer_test<tokenizer>(
+    "1,\"2 3\"\t\"4,,5\" x\"6,7\"y \\\"8,9",
+    {"1", "\"2 3\"", "\"4,,5\"", "x\"6,7\"y", "\\\"8,9"}
+  );
+}
+
+FATAL_TEST(stream_tokenizer, quote and escape) {
+  using tokenizer = stream_tokenizer<stream_delimiters, '"', '\\'>;
+
+  stream_tokenizer_test<tokenizer>("\\", {"\\"});
+  stream_tokenizer_test<tokenizer>("a\\,b,c", {"a\\,b", "c"});
+  stream_tokenizer_test<tokenizer>(
+    "1,\"2 \\\" 3\"\t\\\"4,5 \\\\,6",
+    {"1", "\"2 \\\" 3\"", "\\\"4", "5", "\\\\", "6"}
+  );
+}
+
+FATAL_TEST(stream_tokenizer, unescape) {
+  using tokenizer = stream_tokenizer<stream_delimiters, '"', '\\'>;
+
+  std::string out;
+  tokenizer::unescape("\"a, b\" \\\"c\\\"", out);
+  FATAL_EXPECT_EQ("a, b \"c\"", out);
+
+  out.clear();
+  tokenizer::unescape("\\\\x\\", out);
+  FATAL_EXPECT_EQ("\\x", out);
+}
+
+FATAL_TEST(stream_tokenizer, reuse) {
+  using tokenizer = stream_tokenizer<stream_delimiters, '"'>;
+
+  std::vector<std::string> actual;
+  auto const visitor = [&actual](string_view token) {
+    actual.emplace_back(token.data(), token.size());
+  };
+
+  tokenizer t;
+  t("ab", visitor);
+  FATAL_EXPECT_TRUE(t.pending());
+  t("\"c", visitor);
+  t.finish(visitor);
+  FATAL_EXPECT_FALSE(t.pending());
+  t("d,", visitor);
+
+  FATAL_EXPECT_EQ((std::vector<std::string>{"ab\"c", "d"}), actual);
+}
+
 } // namespace fatal {
@@ -14,6 +14,7 @@
 #include <fatal/string/string_view.h>
 #include <fatal/type/traits.h>
 
+#include <string>
 #include <type_traits>
 #include <utility>
 
@@ -99,6 +100,209 @@ private:
   string_view data_;
 };
 
+/**
+ * A tokenizer meant to be fed with arbitrarily split chunks of input, like the
+ * ones obtained from a `read()` loop, without first copying them into a
+ * contiguous buffer.
+ *
+ * Any character in the compile-time string `Delimiters` (e.g.: declared with
+ * `FATAL_S`) terminates a token. Optionally, a `Quote` character can be given
+ * so that delimiters between a pair of quotes are not considered, as well as
+ * an `Escape` character which prevents the character following it from being
+ * interpreted as a delimiter or a quote. Passing `'\0'` for `Quote` or
+ * `Escape` disables them.
+ *
+ * Tokens are handed to a visitor as a `string_view` with quotes and escapes
+ * still in place (see `unescape` to decode them). A token that lies entirely
+ * within a chunk points directly into that chunk. Only tokens that span chunk
+ * boundaries are stitched together into an internal buffer, whose capacity is
+ * reused across tokens so that, at steady state, no allocations happen.
+ *
+ * Every delimiter terminates a token, so consecutive delimiters yield empty
+ * tokens. Call `finish()` at the end of the input to flush the last token, in
+ * case it's not followed by a delimiter.
+ *
+ * Example:
+ *
+ *  FATAL_S(delimiters, " \t,");
+ *
+ *  stream_tokenizer<delimiters, '"', '\\'> tokenizer;
+ *  auto const print = [](string_view token) { std::cout << token << '\n'; };
+ *
+ *  // prints "hello" and "big"
+ *  tokenizer("hello,big wo", print);
+ *
+ *  // prints "world" and "\"a, b\""
+ *  tokenizer("rld \"a, b\"", print);
+ *
+ *  tokenizer.finish(print);
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+template <typename Delimiters, char Quote = '\0', char Escape = '\0'>
+struct stream_tokenizer {
+  using delimiters = Delimiters;
+  using quote = std::integral_constant<char, Quote>;
+  using escape = std::integral_constant<char, Escape>;
+
+  /**
+   * Tokenizes the given chunk, calling `visitor(token, args...)` for every
+   * token terminated in it.
+   *
+   * Characters following the last delimiter in the chunk are retained until
+   * the next call, or until `finish()` is called.
+   */
+  template <typename Visitor, typename... Args>
+  void operator ()(string_view chunk, Visitor &&visitor, Args &&...args) {
+    auto const end = chunk.end();
+    auto token = chunk.begin();
+    auto i = token;
+
+    if (escaped_) {
+      if (i == end) {
+        return;
+      }
+
+      escaped_ = false;
+      ++i;
+    }
+
+    for (;;) {
+      i = chunk.find_any_of(quoted_ ? quoted_set : special_set, i);
+
+      if (i == end) {
+        break;
+      }
+
+      if (escape::value && *i == escape::value) {
+        if (++i == end) {
+          escaped_ = true;
+          break;
+        }
+
+        ++i;
+        continue;
+      }
+
+      if (quote::value && *i == quote::value) {
+        quoted_ = !quoted_;
+        ++i;
+        continue;
+      }
+
+      emit(token, i, visitor, args...);
+      token = ++i;
+    }
+
+    if (token != end) {
+      buffer_.append(token, end);
+      partial_ = true;
+    }
+  }
+
+  /**
+   * Signals the end of the input, flushing the trailing token, if any.
+   *
+   * The tokenizer is ready to be used again afterwards.
+   */
+  template <typename Visitor, typename... Args>
+  void finish(Visitor &&visitor, Args &&...args) {
+    if (partial_) {
+      visitor(string_view(buffer_.data(), buffer_.size()), args...);
+    }
+
+    reset();
+  }
+
+  /**
+   * Whether characters of an unterminated token are being retained.
+   */
+  bool pending() const { return partial_; }
+
+  /**
+   * Discards any retained state without changing the buffer's capacity.
+   */
+  void reset() {
+    buffer_.clear();
+    partial_ = false;
+    quoted_ = false;
+    escaped_ = false;
+  }
+
+  /**
+   * Appends the given token to `out`, removing quotes and escapes.
+   *
+   * Example:
+   *
+   *  FATAL_S(delimiters, ",");
+   *  using tokenizer = stream_tokenizer<delimiters, '"', '\\'>;
+   *
+   *  std::string out;
+   *  tokenizer::unescape("\"a, b\" \\\"c\\\"", out);
+   *
+   *  // prints `a, b "c"`
+   *  std::cout << out;
+   */
+  static void unescape(string_view token, std::string &out) {
+    for (auto i = token.begin(), end = token.end(); i != end; ++i) {
+      if (escape::value && *i == escape::value) {
+        if (++i == end) {
+          break;
+        }
+      } else if (quote::value && *i == quote::value) {
+        continue;
+      }
+
+      out.push_back(*i);
+    }
+  }
+
+private:
+  template <typename Visitor, typename... Args>
+  void emit(
+    string_view::const_iterator begin,
+    string_view::const_iterator end,
+    Visitor &visitor,
+    Args &...args
+  ) {
+    if (!partial_) {
+      visitor(string_view(begin, end), args...);
+      return;
+    }
+
+    buffer_.append(begin, end);
+    visitor(string_view(buffer_.data(), buffer_.size()), args...);
+    buffer_.clear();
+    partial_ = false;
+  }
+
+  static constexpr char_set with_optional(char_set set, char c) {
+    return c ? set.with(c) : set;
+  }
+
+  // characters of interest outside quotes
+  static constexpr char_set special_set = with_optional(
+    with_optional(as_char_set<delimiters>(), Quote),
+    Escape
+  );
+
+  // characters of interest inside quotes
+  static constexpr char_set quoted_set = with_optional(
+    with_optional(char_set(), Quote),
+    Escape
+  );
+
+  std::string buffer_;
+  bool partial_ = false;
+  bool quoted_ = false;
+  bool escaped_ = false;
+};
+
+template <typename Delimiters, char Quote, char Escape>
+constexpr char_set stream_tokenizer<Delimiters, Quote, Escape>::special_set;
+
+template <typename Delimiters, char Quote, char Escape>
+constexpr char_set stream_tokenizer<Delimiters, Quote, Escape>::quoted_set;
 
 using colon_tokenizer = tokenizer<string_view, ':'>;
 using comma_tokenizer = tokenizer<string_view, ','>;
@@ -7,6 +7,7 @@
  *  of patent rights can be found in the PATENTS file in the same directory.
  */
 
+#include <fatal/type/perfect_hash.h>
 #include <fatal/type/trie.h>
 #include <fatal/type/sequence.h>
 
@@ -77,6 +78,21 @@ struct benchmark_impl {
     prevent_optimization(count);
   }
 
+  template <typename Controller>
+  static void perfect_hash_benchmark(Controller &benchmark) {
+    unsigned count = 0;
+
+    FATAL_BENCHMARK_SUSPEND {}
+
+    for (auto const &s: str) {
+      perfect_hash_find<list<Strings...>>(
+        s.begin(), s.end(), visitor{}, s, count
+      );
+    }
+
+    prevent_optimization(count);
+  }
+
   template <typename Controller>
   static void sequential_ifs_benchmark(Controller &benchmark) {
     unsigned count = 0;
@@ -199,6 +215,10 @@ std::array<std::string, sizeof...(Strings)> const benchmark_impl<
     prevent_optimization(Name##_warmup); \
     Name##_impl::trie_benchmark(benchmark); \
   } \
+  FATAL_BENCHMARK(Name, perfect_hash) { \
+    prevent_optimization(Name##_warmup); \
+    Name##_impl::perfect_hash_benchmark(benchmark); \
+  } \
   FATAL_BENCHMARK(Name, sorted_std_array) { \
     prevent_optimization(Name##_warmup); \
     Name##_impl::sorted_std_array_benchmark(benchmark); \
@@ -0,0 +1,612 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef FATAL_INCLUDE_fatal_type_impl_perfect_hash_h
+#define FATAL_INCLUDE_fatal_type_impl_perfect_hash_h
+
+#include <fatal/math/hash.h>
+#include <fatal/type/array.h>
+#include <fatal/type/list.h>
+#include <fatal/type/scalar.h>
+#include <fatal/type/sequence.h>
+#include <fatal/type/size.h>
+#include <fatal/type/tag.h>
+
+#include <type_traits>
+#include <utility>
+
+#include <cstdint>
+#include <cstring>
+
+namespace fatal {
+namespace i_ph {
+
+// the layout is a hash and displace scheme: keys are spread across as many
+// buckets as there are keys, and each bucket gets a displacement which is
+// added to the offset of its keys, modulo the number of keys, to get their
+// slot in the table. Displacements are picked greedily, largest buckets
+// first, so that every slot ends up with exactly one key.
+
+using npos = std::integral_constant<std::size_t, ~std::size_t(0)>;
+
+// maps the lower 32 bits of `value` to the range [0, size) without a division
+constexpr std::size_t reduce(std::uint64_t value, std::size_t size) {
+  return static_cast<std::size_t>(((value & 0xffffffff) * size) >> 32);
+}
+
+constexpr std::size_t bucket_of(std::uint64_t hash, std::size_t size) {
+  return reduce(hash >> 32, size);
+}
+
+constexpr std::size_t offset_of(std::uint64_t hash, std::size_t size) {
+  return reduce(hash, size);
+}
+
+// `(offset + displacement) % size`, given both are less than `size`
+constexpr std::size_t wrap(std::size_t value, std::size_t size) {
+  return value >= size ? value - size : value;
+}
+
+constexpr bool all() { return true; }
+
+template <typename... Args>
+constexpr bool all(bool head, Args... tail) { return head && all(tail...); }
+
+constexpr bool none_equal(std::size_t) { return true; }
+
+template <typename... Args>
+constexpr bool none_equal(std::size_t value, std::size_t head, Args... tail) {
+  return value != head && none_equal(value, tail...);
+}
+
+constexpr bool distinct() { return true; }
+
+template <typename... Args>
+constexpr bool distinct(std::size_t head, Args... tail) {
+  return none_equal(head, tail...) && distinct(tail...);
+}
+
+// how many keys in the range [begin, end) fall into `bucket`
+constexpr std::size_t count(
+  std::uint64_t const *hashes,
+  std::size_t size,
+  std::size_t bucket,
+  std::size_t begin,
+  std::size_t end
+) {
+  return end - begin == 1
+    ? bucket_of(hashes[begin], size) == bucket
+    : end == begin
+      ? 0
+      : count(hashes, size, bucket, begin, begin + (end - begin) / 2)
+        + count(hashes, size, bucket, begin + (end - begin) / 2, end);
+}
+
+constexpr std::size_t member(
+  std::uint64_t const *hashes, std::size_t size, std::size_t bucket,
+  std::size_t index, std::size_t begin, std::size_t end
+);
+
+constexpr std::size_t member_pick(
+  std::uint64_t const *hashes, std::size_t size, std::size_t bucket,
+  std::size_t index, std::size_t begin, std::size_t middle, std::size_t end,
+  std::size_t left
+) {
+  return index < left
+    ? member(hashes, size, bucket, index, begin, middle)
+    : member(hashes, size, bucket, index - left, middle, end);
+}
+
+// the index of the `index`-th key in the range [begin, end) that falls into
+// `bucket`
+constexpr std::size_t member(
+  std::uint64_t const *hashes, std::size_t size, std::size_t bucket,
+  std::size_t index, std::size_t begin, std::size_t end
+) {
+  return end - begin == 1
+    ? begin
+    : member_pick(
+      hashes, size, bucket, index,
+      begin, begin + (end - begin) / 2, end,
+      count(hashes, size, bucket, begin, begin + (end - begin) / 2)
+    );
+}
+
+// how many buckets in the range [begin, end) are placed before `bucket`:
+// larger buckets first, ties broken by index
+constexpr std::size_t rank(
+  std::size_t const *sizes,
+  std::size_t bucket,
+  std::size_t begin,
+  std::size_t end
+) {
+  return end - begin == 1
+    ? sizes[begin] > sizes[bucket]
+      || (sizes[begin] == sizes[bucket] && begin < bucket)
+    : rank(sizes, bucket, begin, begin + (end - begin) / 2)
+      + rank(sizes, bucket, begin + (end - begin) / 2, end);
+}
+
+constexpr std::size_t find(
+  std::size_t const *values, std::size_t value,
+  std::size_t begin, std::size_t end
+);
+
+constexpr std::size_t find_pick(
+  std::size_t const *values, std::size_t value,
+  std::size_t found, std::size_t middle, std::size_t end
+) {
+  return found != npos::value ? found : find(values, value, middle, end);
+}
+
+// the index of the first element in the range [begin, end) equal to `value`
+constexpr std::size_t find(
+  std::size_t const *values, std::size_t value,
+  std::size_t begin, std::size_t end
+) {
+  return end - begin == 1
+    ? values[begin] == value ? begin : npos::value
+    : find_pick(
+      values, value,
+      find(values, value, begin, begin + (end - begin) / 2),
+      begin + (end - begin) / 2, end
+    );
+}
+
+// the hashes of the keys `T...` for a given seed
+template <std::uint64_t Seed, typename Filter, typename... T>
+struct h {
+  static constexpr std::uint64_t data[sizeof...(T)] = {
+    bytes_hash<std::uint64_t>(
+      z_data<typename Filter::template apply<T>, char>(),
+      size<typename Filter::template apply<T>>::value,
+      Seed
+    )...
+  };
+};
+
+template <std::uint64_t Seed, typename Filter, typename... T>
+constexpr std::uint64_t const h<Seed, Filter, T...>::data[sizeof...(T)];
+
+// the buckets, and the order in which they're placed
+template <typename, typename> struct b;
+
+template <typename Hashes, std::size_t... Indexes>
+struct b<Hashes, index_sequence<Indexes...>> {
+  using hashes = Hashes;
+  using size = size_constant<sizeof...(Indexes)>;
+
+  // how many keys fall into each bucket
+  static constexpr std::size_t sizes[sizeof...(Indexes)] = {
+    count(Hashes::data, size::value, Indexes, 0, size::value)...
+  };
+
+  // the position of each bucket in the placement order
+  static constexpr std::size_t ranks[sizeof...(Indexes)] = {
+    rank(sizes, Indexes, 0, size::value)...
+  };
+
+  // the buckets in placement order
+  static constexpr std::size_t order[sizeof...(Indexes)] = {
+    find(ranks, Indexes, 0, size::value)...
+  };
+};
+
+template <typename Hashes, std::size_t... Indexes>
+constexpr std::size_t const b<
+  Hashes, index_sequence<Indexes...>
+>::sizes[sizeof...(Indexes)];
+
+template <typename Hashes, std::size_t... Indexes>
+constexpr std::size_t const b<
+  Hashes, index_sequence<Indexes...>
+>::ranks[sizeof...(Indexes)];
+
+template <typename Hashes, std::size_t... Indexes>
+constexpr std::size_t const b<
+  Hashes, index_sequence<Indexes...>
+>::order[sizeof...(Indexes)];
+
+// the occupied slots, as a bitmap
+template <std::uint64_t... Words>
+struct o {
+  static constexpr std::uint64_t data[sizeof...(Words)] = {Words...};
+};
+
+template <std::uint64_t... Words>
+constexpr std::uint64_t const o<Words...>::data[sizeof...(Words)];
+
+constexpr bool is_free(std::uint64_t const *words, std::size_t slot) {
+  return !((words[slot / 64] >> (slot % 64)) & 1);
+}
+
+constexpr std::uint64_t mask(std::size_t) { return 0; }
+
+// the bits of the word `word` set by the given slots
+template <typename... Args>
+constexpr std::uint64_t mask(std::size_t word, std::size_t slot, Args... tail) {
+  return (slot / 64 == word ? std::uint64_t(1) << (slot % 64) : 0)
+    | mask(word, tail...);
+}
+
+// the displacement of a bucket whose keys have the given offsets
+template <typename Words, std::size_t Size, std::size_t... Offsets>
+struct d {
+  static constexpr bool fits(std::size_t displacement) {
+    return all(is_free(Words::data, wrap(Offsets + displacement, Size))...);
+  }
+
+  static constexpr std::size_t pick(
+    std::size_t found,
+    std::size_t middle,
+    std::size_t end
+  ) {
+    return found != npos::value ? found : search(middle, end);
+  }
+
+  // the first displacement in the range [begin, end) which fits
+  static constexpr std::size_t search(std::size_t begin, std::size_t end) {
+    return end - begin == 1
+      ? fits(begin) ? begin : npos::value
+      : pick(
+        search(begin, begin + (end - begin) / 2),
+        begin + (end - begin) / 2,
+        end
+      );
+  }
+
+};
+
+template <typename Words, std::size_t Size, std::size_t... Offsets>
+struct D {
+  // keys sharing an offset can't be told apart by any displacement
+  using value = size_constant<
+    distinct(Offsets...)
+      ? d<Words, Size, Offsets...>::search(0, Size)
+      : npos::value
+  >;
+
+  template <std::size_t Word>
+  using set = std::integral_constant<
+    std::uint64_t,
+    mask(Word, wrap(Offsets + value::value, Size)...)
+  >;
+};
+
+// places the bucket of rank `Rank`, then the remaining ones
+template <
+  typename Buckets,
+  std::size_t Rank,
+  bool Done,
+  typename Words,
+  typename Displacements
+>
+struct p;
+
+// every non-empty bucket has been placed
+template <
+  typename Buckets,
+  std::size_t Rank,
+  typename Words,
+  typename... Placed
+>
+struct p<Buckets, Rank, true, Words, list<Placed...>> {
+  using failed = std::false_type;
+  using displacements = list<Placed...>;
+};
+
+template <typename, typename, typename, typename> struct P;
+
+template <
+  typename Buckets,
+  std::size_t Rank,
+  std::uint64_t... Words,
+  std::size_t... WordIndexes,
+  std::size_t... Indexes,
+  typename... Placed
+>
+struct P<
+  Buckets,
+  std::integral_constant<std::size_t, Rank>,
+  list<o<Words...>, index_sequence<WordIndexes...>, list<Placed...>>,
+  index_sequence<Indexes...>
+> {
+  using size = typename Buckets::size;
+  using bucket = std::integral_constant<
+    std::size_t,
+    Buckets::order[Rank]
+  >;
+
+  using displacement = D<
+    o<Words...>,
+    size::value,
+    offset_of(
+      Buckets::hashes::data[
+        member(
+          Buckets::hashes::data, size::value, bucket::value,
+          Indexes, 0, size::value
+        )
+      ],
+      size::value
+    )...
+  >;
+
+  using next = p<
+    Buckets,
+    Rank + 1,
+    Rank + 1 == size::value || !Buckets::sizes[Buckets::order[Rank + 1]],
+    o<
+      (Words | displacement::template set<WordIndexes>::value)...
+    >,
+    list<Placed..., typename displacement::value>
+  >;
+};
+
+// gives up on the current seed when a bucket can't be placed
+template <
+  typename Current,
+  bool = Current::displacement::value::value == npos::value
+>
+struct n: Current::next {};
+
+template <typename Current>
+struct n<Current, true> {
+  using failed = std::true_type;
+  using displacements = list<>;
+};
+
+template <
+  typename Buckets,
+  std::size_t Rank,
+  std::uint64_t... Words,
+  typename... Placed
+>
+struct p<Buckets, Rank, false, o<Words...>, list<Placed...>>:
+  n<
+    P<
+      Buckets,
+      std::integral_constant<std::size_t, Rank>,
+      list<
+        o<Words...>,
+        make_index_sequence<sizeof...(Words)>,
+        list<Placed...>
+      >,
+      make_index_sequence<Buckets::sizes[Buckets::order[Rank]]>
+    >
+  >
+{};
+
+// all words of the bitmap start cleared
+template <typename> struct w;
+
+template <std::size_t... Indexes>
+struct w<index_sequence<Indexes...>> {
+  using type = o<(Indexes & 0)...>;
+};
+
+// the layout of the table for a given seed
+template <typename, typename, typename> struct l;
+
+template <typename Buckets, typename... Placed, std::size_t... Indexes>
+struct l<Buckets, list<Placed...>, index_sequence<Indexes...>> {
+  using size = typename Buckets::size;
+  using placed = size_constant<sizeof...(Placed)>;
+
+  static constexpr std::size_t by_rank[sizeof...(Placed) + 1] = {
+    Placed::value..., 0
+  };
+
+  // the displacement of each bucket
+  static constexpr std::size_t displacements[sizeof...(Indexes)] = {
+    (
+      Buckets::ranks[Indexes] < placed::value
+        ? by_rank[Buckets::ranks[Indexes]]
+        : 0
+    )...
+  };
+
+  // the slot of each key
+  static constexpr std::size_t slots[sizeof...(Indexes)] = {
+    wrap(
+      offset_of(Buckets::hashes::data[Indexes], size::value)
+        + displacements[
+          bucket_of(Buckets::hashes::data[Indexes], size::value)
+        ],
+      size::value
+    )...
+  };
+
+  // the key in each slot
+  using keys = index_sequence<find(slots, Indexes, 0, size::value)...>;
+};
+
+template <typename Buckets, typename... Placed, std::size_t... Indexes>
+constexpr std::size_t const l<
+  Buckets, list<Placed...>, index_sequence<Indexes...>
+>::by_rank[sizeof...(Placed) + 1];
+
+template <typename Buckets, typename... Placed, std::size_t... Indexes>
+constexpr std::size_t const l<
+  Buckets, list<Placed...>, index_sequence<Indexes...>
+>::displacements[sizeof...(Indexes)];
+
+template <typename Buckets, typename... Placed, std::size_t... Indexes>
+constexpr std::size_t const l<
+  Buckets, list<Placed...>, index_sequence<Indexes...>
+>::slots[sizeof...(Indexes)];
+
+// matches the needle against the key `T`
+template <typename Filter, typename T>
+struct m {
+  template <typename Visitor, typename... VArgs>
+  static bool f(
+    char const *data,
+    std::size_t const size,
+    Visitor &&visitor,
+    VArgs &&...args
+  ) {
+    using key = typename Filter::template apply<T>;
+    using key_size = fatal::size<key>;
+
+    if (
+      size != key_size::value
+        || (
+          key_size::value
+            && std::memcmp(data, z_data<key, char>(), key_size::value)
+        )
+    ) {
+      return false;
+    }
+
+    visitor(tag<T>(), std::forward<VArgs>(args)...);
+    return true;
+  }
+};
+
+// the lookup, given the seed and layout found for the keys `T...`
+template <
+  std::uint64_t, typename, typename, typename, typename, typename
+> struct t;
+
+template <
+  std::uint64_t Seed,
+  typename Filter,
+  typename... T,
+  typename Layout,
+  std::size_t... Indexes,
+  std::size_t... Keys
+>
+struct t<
+  Seed, Filter, list<T...>, Layout,
+  index_sequence<Indexes...>, index_sequence<Keys...>
+> {
+  using slots = size_constant<sizeof...(T)>;
+
+  static constexpr std::uint32_t displacements[sizeof...(T)] = {
+    static_cast<std::uint32_t>(Layout::displacements[Indexes])...
+  };
+
+  template <typename Visitor, typename... VArgs>
+  static bool f(
+    char const *data,
+    std::size_t const size,
+    Visitor &&visitor,
+    VArgs &&...args
+  ) {
+    using thunk = bool (*)(char const *, std::size_t, Visitor &&, VArgs &&...);
+
+    // the key in each slot
+    static constexpr thunk table[sizeof...(Keys)] = {
+      &m<Filter, at<list<T...>, Keys>>::template f<Visitor, VArgs...>...
+    };
+
+    // the same as `*bytes_hasher<std::uint64_t>(Seed)(data, size)`
+    auto const hash = detail::word_hasher_impl::hash_range(Seed, data, size);
+    auto const slot = wrap(
+      offset_of(hash, slots::value)
+        + displacements[bucket_of(hash, slots::value)],
+      slots::value
+    );
+
+    return table[slot](
+      data,
+      size,
+      std::forward<Visitor>(visitor),
+      std::forward<VArgs>(args)...
+    );
+  }
+};
+
+template <
+  std::uint64_t Seed,
+  typename Filter,
+  typename... T,
+  typename Layout,
+  std::size_t... Indexes,
+  std::size_t... Keys
+>
+constexpr std::uint32_t const t<
+  Seed, Filter, list<T...>, Layout,
+  index_sequence<Indexes...>, index_sequence<Keys...>
+>::displacements[sizeof...(T)];
+
+// how many seeds are tried before giving up
+using max_attempts = std::integral_constant<std::size_t, 64>;
+
+// tries one seed after the other until all keys can be placed
+template <std::size_t, typename, typename> struct s;
+
+template <std::size_t Attempt, typename Filter, typename... T>
+struct s<Attempt, Filter, list<T...>> {
+  static_assert(
+    Attempt < max_attempts::value,
+    "unable to build a perfect hash for the given keys: are they unique?"
+  );
+
+  using indexes = make_index_sequence<sizeof...(T)>;
+  using buckets = b<h<Attempt, Filter, T...>, indexes>;
+  using placement = p<
+    buckets,
+    0,
+    !buckets::sizes[buckets::order[0]],
+    typename w<make_index_sequence<sizeof...(T) / 64 + 1>>::type,
+    list<>
+  >;
+};
+
+template <
+  std::size_t Attempt,
+  typename Filter,
+  typename T,
+  bool = s<Attempt, Filter, T>::placement::failed::value
+>
+struct S;
+
+template <std::size_t Attempt, typename Filter, typename... T>
+struct S<Attempt, Filter, list<T...>, true>:
+  S<Attempt + 1, Filter, list<T...>>
+{};
+
+template <std::size_t Attempt, typename Filter, typename... T>
+struct S<Attempt, Filter, list<T...>, false> {
+  using current = s<Attempt, Filter, list<T...>>;
+  using layout = l<
+    typename current::buckets,
+    typename current::placement::displacements,
+    typename current::indexes
+  >;
+
+  using type = t<
+    Attempt, Filter, list<T...>, layout,
+    typename current::indexes, typename layout::keys
+  >;
+};
+
+// no keys to look for
+struct e {
+  template <typename... Args>
+  static constexpr bool f(Args &&...) { return false; }
+};
+
+template <typename, typename> struct E;
+
+template <typename Filter, template <typename...> class List, typename... T>
+struct E<Filter, List<T...>> {
+  using type = typename S<0, Filter, list<T...>>::type;
+};
+
+template <typename Filter, template <typename...> class List>
+struct E<Filter, List<>> {
+  using type = e;
+};
+
+} // namespace i_ph {
+} // namespace fatal {
+
+#endif // FATAL_INCLUDE_fatal_type_impl_perfect_hash_h
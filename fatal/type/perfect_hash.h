@@ -0,0 +1,109 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#ifndef FATAL_INCLUDE_fatal_type_perfect_hash_h
+#define FATAL_INCLUDE_fatal_type_perfect_hash_h
+
+#include <fatal/functional/no_op.h>
+#include <fatal/type/identity.h>
+
+#include <iterator>
+#include <memory>
+#include <utility>
+
+#include <cassert>
+
+#include <fatal/type/impl/perfect_hash.h>
+
+namespace fatal {
+
+/**
+ * Looks up the string represented by the range [begin, end) among the
+ * strings in the list `T`, calling the visitor with `tag<Match>` followed by
+ * `args` when found. The strings are sequences of `char`, like the ones
+ * declared with `FATAL_S`, optionally obtained from the elements of `T`
+ * through `Filter`.
+ *
+ * This is a drop-in alternative to `trie_find`. A minimal perfect hash for
+ * the strings is built at compile time, so that a lookup costs one hash of
+ * the needle (the same hash computed by `bytes_hasher`), one load from a
+ * table of displacements, one jump through a table with as many entries as
+ * strings, and a single `std::memcmp`.
+ *
+ * The range must be contiguous, like the ones from `std::string` or
+ * `string_view`. Compilation fails if `T` contains repeated strings.
+ *
+ * Returns `true` when the string was found, `false` otherwise.
+ *
+ * Example:
+ *
+ *  FATAL_S(get, "get");
+ *  FATAL_S(put, "put");
+ *  FATAL_S(remove, "remove");
+ *
+ *  struct visitor {
+ *    template <typename String>
+ *    void operator ()(tag<String>, int &out) const {
+ *      out = size<String>::value;
+ *    }
+ *  };
+ *
+ *  std::string const needle("remove");
+ *  int out = 0;
+ *
+ *  // yields `true` and sets `out` to `6`
+ *  perfect_hash_find<list<get, put, remove>>(
+ *    needle.begin(), needle.end(), visitor(), out
+ *  );
+ *
+ * @author: Marcelo Juchem <juchem@gmail.com>
+ */
+template <
+  typename T,
+  typename Filter = get_identity,
+  typename Begin,
+  typename End,
+  typename Visitor,
+  typename... VArgs
+>
+static inline bool perfect_hash_find(
+  Begin &&begin,
+  End &&end,
+  Visitor &&visitor,
+  VArgs &&...args
+) {
+  assert(begin <= end);
+  auto const size = static_cast<std::size_t>(std::distance(begin, end));
+  char const *const data = size ? std::addressof(*begin) : "";
+
+  return i_ph::E<Filter, T>::type::f(
+    data,
+    size,
+    std::forward<Visitor>(visitor),
+    std::forward<VArgs>(args)...
+  );
+}
+
+template <
+  typename T,
+  typename Filter = get_identity,
+  typename Begin,
+  typename End
+>
+static inline bool perfect_hash_find(Begin &&begin, End &&end) {
+  return perfect_hash_find<T, Filter>(
+    std::forward<Begin>(begin),
+    std::forward<End>(end),
+    fn::no_op()
+  );
+}
+
+} // namespace fatal {
+
+#endif // FATAL_INCLUDE_fatal_type_perfect_hash_h
@@ -0,0 +1,184 @@
+/*
+ *  Copyright (c) 2016, Facebook, Inc.
+ *  All rights reserved.
+ *
+ *  This source code is licensed under the BSD-style license found in the
+ *  LICENSE file in the root directory of this source tree. An additional grant
+ *  of patent rights can be found in the PATENTS file in the same directory.
+ */
+
+#include <fatal/type/perfect_hash.h>
+
+#include <fatal/type/convert.h>
+#include <fatal/type/get_type.h>
+#include <fatal/type/list.h>
+#include <fatal/type/sequence.h>
+#include <fatal/type/transform.h>
+
+#include <fatal/test/driver.h>
+#include <fatal/test/words.h>
+
+#include <string>
+#include <type_traits>
+
+namespace fatal {
+
+FATAL_S(h, "h");
+FATAL_S(ha, "ha");
+FATAL_S(hat, "hat");
+FATAL_S(hi, "hi");
+FATAL_S(hit, "hit");
+FATAL_S(hint, "hint");
+FATAL_S(ho, "ho");
+FATAL_S(hot, "hot");
+
+using hs_list = list<h, ha, hat, hi, hint, hit, ho, hot>;
+
+FATAL_S(nothing, "");
+FATAL_S(x, "x");
+
+template <typename T>
+struct wrapper {
+  using value = T;
+};
+
+template <typename Expected, typename Filter>
+struct check_visitor {
+  template <typename Match>
+  void operator ()(
+    tag<Match>,
+    std::string const &needle,
+    std::size_t &matches
+  ) {
+    using actual = typename Filter::template apply<Match>;
+    FATAL_EXPECT_SAME<Expected, actual>();
+    FATAL_EXPECT_EQ((to_instance<std::string, actual>()), needle);
+    ++matches;
+  }
+};
+
+template <typename Filter>
+struct check_visitor<void, Filter> {
+  template <typename Match, typename... VArgs>
+  void operator ()(tag<Match>, VArgs &&...) {
+    using actual = typename Filter::template apply<Match>;
+    FATAL_EXPECT_EQ(
+      "no match expected",
+      to_string("got '", to_instance<std::string, actual>(), '\'')
+    );
+  }
+};
+
+template <typename Expected, typename List, typename Filter>
+void check_find_impl(std::string const &needle) {
+  check_visitor<Expected, Filter> visitor;
+
+  std::size_t matches = 0;
+  bool const result = perfect_hash_find<List, Filter>(
+    needle.begin(), needle.end(), visitor, needle, matches
+  );
+
+  bool const expected = !std::is_same<void, Expected>::value;
+  FATAL_EXPECT_EQ(expected, result);
+  FATAL_EXPECT_EQ(expected, matches);
+}
+
+template <typename List, typename Expected = void>
+void check_find(std::string const &needle) {
+  check_find_impl<Expected, List, get_identity>(needle);
+  check_find_impl<
+    Expected,
+    transform<List, applier<wrapper>>,
+    get_type::value
+  >(needle);
+}
+
+FATAL_TEST(perfect_hash_find, variations) {
+  check_find<hs_list>("");
+  check_find<hs_list, h>("h");
+  check_find<hs_list>("H");
+  check_find<hs_list, ha>("ha");
+  check_find<hs_list>("hA");
+  check_find<hs_list, hat>("hat");
+  check_find<hs_list>("haT");
+  check_find<hs_list, hi>("hi");
+  check_find<hs_list>("hI");
+  check_find<hs_list, hint>("hint");
+  check_find<hs_list>("hinT");
+  check_find<hs_list>("hints");
+  check_find<hs_list, hit>("hit");
+  check_find<hs_list>("hiT");
+  check_find<hs_list, ho>("ho");
+  check_find<hs_list>("hO");
+  check_find<hs_list, hot>("hot");
+  check_find<hs_list>("hoT");
+  check_find<hs_list>("hut");
+
+  check_find<list<>>("");
+  check_find<list<>>("x");
+  check_find<list<nothing>, nothing>("");
+  check_find<list<nothing>>("x");
+  check_find<list<nothing, x>, nothing>("");
+  check_find<list<nothing, x>, x>("x");
+  check_find<list<nothing, x>>("xx");
+}
+
+FATAL_TEST(perfect_hash_find, lists) {
+  using fast = sequence<char, 'f', 'a', 's', 't'>;
+  using fat = sequence<char, 'f', 'a', 't'>;
+  using keys = list<as_list<fast>, as_list<fat>>;
+
+  std::string const needles[] = {"fast", "fat", "far", "fasts", ""};
+  bool const expected[] = {true, true, false, false, false};
+
+  for (std::size_t i = 0; i < 5; ++i) {
+    auto const &needle = needles[i];
+    FATAL_EXPECT_EQ(
+      expected[i],
+      perfect_hash_find<keys>(needle.begin(), needle.end())
+    );
+  }
+}
+
+struct words_visitor {
+  template <typename String>
+  void operator ()(tag<String>, std::string const &needle, bool &found) {
+    FATAL_EXPECT_EQ((to_instance<std::string, String>()), needle);
+    found = true;
+  }
+};
+
+template <typename> struct check_words;
+
+template <typename... Words>
+struct check_words<list<Words...>> {
+  static void check() {
+    std::string const words[] = {to_instance<std::string, Words>()...};
+
+    for (auto const &word: words) {
+      bool found = false;
+      FATAL_EXPECT_TRUE(
+        perfect_hash_find<list<Words...>>(
+          word.begin(), word.end(), words_visitor(), word, found
+        )
+      );
+      FATAL_EXPECT_TRUE(found);
+
+      auto const longer = word + word;
+      FATAL_EXPECT_FALSE(
+        perfect_hash_find<list<Words...>>(longer.begin(), longer.end())
+      );
+
+      auto const other = '!' + word.substr(1);
+      FATAL_EXPECT_FALSE(
+        perfect_hash_find<list<Words...>>(other.begin(), other.end())
+      );
+    }
+  }
+};
+
+FATAL_TEST(perfect_hash_find, many) {
+  check_words<random_250_words<list, sequence>>::check();
+}
+
+} // namespace fatal {